@@ -52,6 +52,90 @@ namespace gtl {
 	};
 
 
+	//---------------------------------------------------------------------------------------------------------------------------------
+	// CThumbnailWorkerPool : process-wide work-stealing pool for thumbnail jobs
+	//
+	class GTL__CLASS CThumbnailWorkerPool {
+	public:
+		using clock_t = std::chrono::steady_clock;
+		struct sJob {
+			enum class eSTATE : int { queued, running, done, cancelled, };
+
+			void const* owner{};
+			std::atomic<int> priority{};	// changed only with the queue holding the job locked. (SetPriority())
+			uint64_t seq{};
+			clock_t::time_point tSubmitted;
+			std::function<void()> func;
+			std::atomic<eSTATE> state{eSTATE::queued};
+
+			/// @brief true if cancelled before running. (running or done job can't be cancelled)
+			bool Cancel() { auto e = eSTATE::queued; return state.compare_exchange_strong(e, eSTATE::cancelled); }
+		};
+		using P_JOB = std::shared_ptr<sJob>;
+
+		struct sMetrics {
+			int nWorker{};
+			size_t nQueued{};						// current queue depth
+			size_t nQueuedMax{};					// max queue depth
+			uint64_t nDone{};
+			uint64_t nCancelled{};
+			uint64_t nStolen{};
+			std::chrono::nanoseconds tLatencyAverage{};	// submit to start
+			std::chrono::nanoseconds tLatencyMax{};
+		};
+
+	protected:
+		struct sQueue {
+			std::mutex mtx;
+			std::map<std::pair<int, uint64_t>, P_JOB> jobs;	// key : (-priority, seq). higher priority, older first
+		};
+		std::vector<std::unique_ptr<sQueue>> m_queues;	// one for each worker
+		std::vector<std::jthread> m_workers;
+
+		std::mutex m_mtx;
+		std::condition_variable_any m_cv;
+		std::map<void const*, size_t> m_pending;			// queued + running jobs of owner. (m_mtx)
+		std::atomic<size_t> m_nQueued{};
+		std::atomic<uint64_t> m_seq{};
+		std::atomic<size_t> m_iNextQueue{};
+
+		// metrics
+		size_t m_nQueuedMax{};	// (m_mtx)
+		std::atomic<uint64_t> m_nDone{}, m_nCancelled{}, m_nStolen{}, m_nStarted{};
+		std::atomic<int64_t> m_tLatencySum{}, m_tLatencyMax{};
+
+	public:
+		/// @brief nWorker 0 for std::thread::hardware_concurrency()
+		explicit CThumbnailWorkerPool(int nWorker = 0);
+		CThumbnailWorkerPool(CThumbnailWorkerPool const&) = delete;
+		~CThumbnailWorkerPool();
+
+		/// @brief pool shared by all C2dMatArray
+		static CThumbnailWorkerPool& GetInstance();
+
+		/// @brief jobs are run in order of priority (higher first) and submission. workers steal jobs from other workers when idle.
+		/// @param owner : key for Cancel(), Wait()
+		P_JOB Submit(void const* owner, int priority, std::function<void()> func);
+		/// @brief re-keys a queued job. (running, done or cancelled job is not changed)
+		/// @return false if job is not in queue
+		bool SetPriority(P_JOB const& job, int priority);
+		/// @brief cancels all queued jobs of owner. running jobs are not stopped. (see Wait())
+		/// @return number of jobs cancelled here
+		size_t Cancel(void const* owner);
+		/// @brief waits until all jobs of owner are done (or cancelled)
+		void Wait(void const* owner);
+		size_t GetPending(void const* owner);
+
+		sMetrics GetMetrics();
+		void ResetMetrics();
+
+	protected:
+		void Worker(std::stop_token token, int iWorker);
+		P_JOB Pop(int iWorker);
+		void Done(void const* owner);
+	};
+
+
 	//---------------------------------------------------------------------------------------------------------------------------------
 	// C2dMatArray : Thumbnail Cache
 	//
@@ -62,7 +146,9 @@ namespace gtl {
 			cv::Mat img;
 			mutable TCopyTransparent<std::recursive_mutex> mtxThumbnail;
 			//mutable bool bTumbnail = false;
-			std::vector<cv::Mat> thumbnails;
+			mutable std::vector<cv::Mat> thumbnails;			// made on demand in pyramid mode
+			mutable std::vector<uint64_t> thumbnailsAccessed;	// LRU tick of each thumbnail
+			mutable CThumbnailWorkerPool::P_JOB jobThumbnail;	// pending job in CThumbnailWorkerPool. cancelled when image is replaced
 		};
 		using P_ITEM = T_ITEM*;
 		using T_THUMBNAIL_SIZES = std::vector<std::pair<int, int>>;
@@ -72,10 +158,14 @@ namespace gtl {
 		std::mutex m_mtxSet;
 		std::vector<T_ITEM> m_set;
 		cv::Mat m_imgWhole;
+		xSize2i m_sizePiece;	// piece size of m_imgWhole
 		xSize2i m_sizeArray;
 		xSize2i m_sizeImage;
+		std::vector<int> m_colOffsets;	// prefix sum of tile widths. (m_sizeArray.cx + 1)
+		std::vector<int> m_rowOffsets;	// prefix sum of tile heights. (m_sizeArray.cy + 1)
 	protected:
 		F_NOTIFIER m_funcNotifier;
+		int m_nNotifierInterval{4};
 
 	public:
 		C2dMatArray() = default;
@@ -89,20 +179,37 @@ namespace gtl {
 		C2dMatArray& operator = (const C2dMatArray& B);
 
 		bool Create(const xSize2i& size);																						// 아무것도 없이 그냥 배열만 생성. 데이터 없음.
-		bool Create(const cv::Mat& imgWhole, const xSize2i& sizePieceImage, const xSize2i& size);								// imgWhole 을 연결하여 생성.
+		bool Create(const cv::Mat& imgWhole, const xSize2i& sizePieceImage, const xSize2i& size);								// imgWhole 을 연결하여 생성. (복사 없음. 각 조각은 imgWhole 의 ROI)
+		/// @brief tiles are ROIs of imgWhole on external buffer (ex, memory-mapped file). owner is kept alive until the last tile (or ROI) is released.
+		bool Create(const cv::Mat& imgWhole, const xSize2i& sizePieceImage, const xSize2i& size, std::shared_ptr<void const> owner);
 		void Destroy();
 
-		bool SetThumbnailMaker(const T_THUMBNAIL_SIZES& sizesThumbnail = { {1, 8}, {1, 16}, }, int nThreadThumbnailMaker = 0);	// Thumbnail Maker 가 동작중일때는 변경 안됨
+		bool SetThumbnailMaker(const T_THUMBNAIL_SIZES& sizesThumbnail = { {1, 8}, {1, 16}, }, int nThreadThumbnailMaker = 0);	// Thumbnail Maker 가 동작중일때는 변경 안됨. nThreadThumbnailMaker > 0 : 백그라운드 생성 (CThumbnailWorkerPool 공유)
+		/// @brief power of two pyramid (1/2, 1/4, ... 1/2^nLevel) as thumbnails. each level is made from the next finer level,
+		/// and missing (or evicted) levels are made on demand, so any scale is served from the nearest level.
+		bool SetPyramid(int nLevel = 8, int nThreadThumbnailMaker = 0);
+		bool IsPyramid() const { return m_bPyramid; }
+		/// @brief max bytes of all thumbnails (not including tile images). least recently used thumbnails are evicted. 0 for no limit.
+		void SetThumbnailMemoryBudget(size_t nBytes) { m_nThumbnailMemoryBudget = nBytes; EvictThumbnails(); }
+		size_t GetThumbnailMemoryBudget() const { return m_nThumbnailMemoryBudget; }
+		size_t GetThumbnailMemory() const { return m_nThumbnailMemory; }
+		/// @brief priority of thumbnail jobs of this array in CThumbnailWorkerPool. tiles intersecting rcVisible go first. (empty rcVisible : all tiles)
+		void SetThumbnailPriority(int nPriority, cv::Rect const& rcVisible = {});
 		bool StartThumbnailMaker();
 		bool StopThumbnailMaker();
-		bool IsThumbnailMakerRunning() const { return m_threadsThumbnailWorker.size() ? true : false; }
+		bool IsThumbnailMakerRunning() const { return m_bThumbnailMakerRunning; }
+		/// @brief waits until all queued thumbnails are made
+		void WaitThumbnailMaker() { m_pThumbnailPool->Wait(this); }
 		bool UpdateThumbnail(bool bThumbnailInBkgnd);
 		bool UpdateThumbnail() { return UpdateThumbnail(IsThumbnailMakerRunning()); }
 
 		const xSize2i& GetArraySize() const { return m_sizeArray; }
+		/// @brief whole image given to Create(). empty if made of separate tiles.
+		cv::Mat const& GetWholeImage() const { return m_imgWhole; }
 		bool SetPartialImage(const xPoint2i& pos, const cv::Mat& img, bool bCopy = false, bool bUpdateThumbnail = true, bool bThumbnailInBkgnd = true);
 
-		void SetNotifier(F_NOTIFIER funcNotifier) { m_funcNotifier = funcNotifier; }
+		/// @brief funcNotifier is called (from worker thread) every nThumbnailInterval thumbnails made in background, and when all queued thumbnails are made.
+		void SetNotifier(F_NOTIFIER funcNotifier, int nThumbnailInterval = 4) { m_funcNotifier = funcNotifier; m_nNotifierInterval = std::max(1, nThumbnailInterval); }
 		void ResetNotifier()	{ m_funcNotifier = nullptr; }
 
 	public:
@@ -122,25 +229,43 @@ namespace gtl {
 		const T_ITEM& GetItem(const xPoint2i& pos) const;
 
 	public:
-		cv::Mat GetMergedImage() const { cv::Rect rc(cv::Point(0, 0), size()); return GetROI(rc); }
+		cv::Mat GetMergedImage() const { if (!m_imgWhole.empty()) return m_imgWhole; cv::Rect rc(cv::Point(0, 0), size()); return GetROI(rc); }
 		cv::Mat GetROI(cv::Rect& rc) const override { return GetResizedImage(rc, 0.0, -1, -1); }
 		cv::Mat GetResizedImage(cv::Rect& rc, double dScale, int eScaleDownMethod = -1, int eScaleUpMethod = -1) const override;
 
 	protected:
-		std::atomic<bool> m_bImageReady{};
-		std::stop_source m_stopThumbnail;
-		std::mutex m_mtxThumbnail;
-		std::condition_variable m_cvThumbnail;
-		//bool m_bStopThumbnailMaker = false;
 		T_THUMBNAIL_SIZES m_sizesThumbnail;
 		int m_nThreadThumbnailMaker = 0;
-		std::mutex m_mtxThumbnailWork;
-		std::vector<std::unique_ptr<std::jthread>> m_threadsThumbnailWorker;
-		std::deque<std::unique_ptr<std::pair<xPoint2i, P_ITEM>>> m_dequeThumbnailWork;
-		void ThumbnailMaker(std::stop_token token);
+		bool m_bThumbnailMakerRunning{};
+		int m_nThumbnailPriority{};
+		cv::Rect m_rcThumbnailVisible;
+		CThumbnailWorkerPool* m_pThumbnailPool{&CThumbnailWorkerPool::GetInstance()};
+		std::atomic<size_t> m_nThumbnailPending{};	// queued in pool, for notifier
+		std::atomic<size_t> m_nThumbnailMade{};		// made in background, for notifier
+		/// @brief priority of thumbnail job of tile at pos. (visible tiles first)
+		int GetThumbnailJobPriority(xPoint2i const& pos) const;
+		/// @brief queues thumbnail job of item (cancelling previous one).
+		/// @param bCounted : already added to m_nThumbnailPending (as a batch, by UpdateThumbnail())
+		void QueueThumbnail(xPoint2i const& pos, T_ITEM& item, bool bCounted = false);
+		void OnThumbnailMade(xPoint2i pos, T_ITEM& item);
 		bool MakeThumbnail(T_ITEM& item);
 
-		bool Resize(cv::Mat& imgSrc, cv::Mat& imgDest, const cv::Size& size, int eResizingMethod);
+		// thumbnail cache (pyramid, LRU)
+		bool m_bPyramid{};
+		size_t m_nThumbnailMemoryBudget{};
+		mutable std::atomic<size_t> m_nThumbnailMemory{};
+		mutable std::atomic<uint64_t> m_tickThumbnail{};
+		mutable std::mutex m_mtxEvictThumbnail;
+		/// @brief thumbnail of item. (made if not ready in pyramid mode)
+		cv::Mat GetThumbnail(T_ITEM const& item, int iThumbnail) const;
+		/// @brief item.mtxThumbnail must be locked.
+		bool MakeThumbnail(T_ITEM const& item, int iThumbnail) const;
+		void ClearThumbnails(T_ITEM const& item) const;
+		void EvictThumbnails() const;
+
+		bool Resize(cv::Mat const& imgSrc, cv::Mat& imgDest, const cv::Size& size, int eResizingMethod) const;
+		/// @brief rebuilds m_colOffsets, m_rowOffsets. width (height) of a column (row) is the one of its first non-empty tile.
+		void UpdateTileOffsets();
 	};
 
 	#pragma pack(pop)
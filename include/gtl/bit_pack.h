@@ -0,0 +1,37 @@
+﻿#pragma once
+
+//////////////////////////////////////////////////////////////////////
+//
+// bit_pack.h: packs / unpacks pixels of 1, 2, 4, 8 bpp (BMP row layout. first pixel on MSB)
+//
+// PWH
+// 2026.10.17.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "gtl/_lib_gtl.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace gtl {
+
+	//-----------------------------------------------------------------------------
+	// SSE2 / AVX2 (as compiled. /arch:AVX2) kernels, scalar for the remaining pixels (or bSIMD == false)
+	//
+	// src, dst : one byte per pixel.
+	// packed : (nPixel * nBPP + 7) / 8 bytes. unused bits of last byte are zero.
+	//
+
+	/// @brief packs pixels (lower nBPP bits are used). false if nBPP is not one of 1, 2, 4, 8
+	GTL__API bool PackBits(int nBPP, uint8_t const* src, size_t nPixel, uint8_t* packed, bool bSIMD = true);
+	/// @brief palette index mode : lut[pixel] is packed. lut : 256 entries (pixel value -> palette index)
+	GTL__API bool PackBitsLUT(int nBPP, uint8_t const* src, size_t nPixel, uint8_t const* lut, uint8_t* packed, bool bSIMD = true);
+	/// @brief threshold to 1 bpp : (pixel >= threshold) ? 1 : 0
+	GTL__API void PackBitsThreshold(uint8_t const* src, size_t nPixel, uint8_t threshold, uint8_t* packed, bool bSIMD = true);
+
+	/// @brief unpacks to palette indices. false if nBPP is not one of 1, 2, 4, 8
+	GTL__API bool UnpackBits(int nBPP, uint8_t const* packed, size_t nPixel, uint8_t* dst, bool bSIMD = true);
+	/// @brief unpacks to lut[index]. lut : (1 << nBPP) entries (palette index -> pixel value)
+	GTL__API bool UnpackBitsLUT(int nBPP, uint8_t const* packed, size_t nPixel, uint8_t const* lut, uint8_t* dst, bool bSIMD = true);
+
+}
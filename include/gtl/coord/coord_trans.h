@@ -196,6 +196,37 @@ namespace gtl {
 		virtual [[nodiscard]] std::optional<double> TransInverse(double dLength) const = 0;
 
 		virtual [[nodiscard]] bool IsRightHanded() const = 0;
+
+		/// @brief 4x4 homogeneous matrix (for 3d points), if the transform is linear or perspective. used to flatten xCoordTransChain.
+		virtual [[nodiscard]] std::optional<cv::Matx44d> GetHomogeneousMatrix() const { return {}; }
+
+		//-------------------------------------------------------------------------
+		// Batch Operation
+		//
+		/// @brief pts -> ptsTarget. (virtual call once per batch, not per point)
+		/// @param pts : source points
+		/// @param ptsTarget : target points. must be the same size as pts. can be the same buffer as pts (in-place).
+		virtual void Trans(std::span<point2_t const> pts, std::span<point2_t> ptsTarget) const {
+			CheckBatchSize(pts.size(), ptsTarget.size());
+			for (size_t i{}; i < pts.size(); i++)
+				ptsTarget[i] = Trans(pts[i]);
+		}
+		virtual void Trans(std::span<point3_t const> pts, std::span<point3_t> ptsTarget) const {
+			CheckBatchSize(pts.size(), ptsTarget.size());
+			for (size_t i{}; i < pts.size(); i++)
+				ptsTarget[i] = Trans(pts[i]);
+		}
+		/// @brief in-place
+		void Trans(std::span<point2_t> pts) const { Trans(std::span<point2_t const>{pts}, pts); }
+		void Trans(std::span<point3_t> pts) const { Trans(std::span<point3_t const>{pts}, pts); }
+
+	protected:
+		static void CheckBatchSize(size_t nSource, size_t nTarget) {
+			if (nSource != nTarget) {
+				[[unlikely]]
+				throw std::invalid_argument{ GTL__FUNCSIG "size of source and target are different." };
+			}
+		}
 	};
 
 
@@ -208,6 +239,17 @@ namespace gtl {
 	protected:
 		boost::ptr_deque<ICoordTrans> chain_;	// 마지막 Back() CT부터 Front() 까지 Transform() 적용.
 
+		/// @brief flattened chain. consecutive links with homogeneous matrix are fused into one matrix.
+		/// rebuilt (Compile()) whenever chain_ is modified.
+		struct compiled_link_t {
+			cv::Matx44d mat2;	// for 2d points. (z is reset to 0 between links, as Trans(point2_t) does)
+			cv::Matx44d mat3;	// for 3d points.
+			int iLink{-1};		// index of chain_, if the link has no homogeneous matrix. (mat2, mat3 are not used)
+		};
+		std::vector<compiled_link_t> compiled_;		// in order of applying. (Back() -> Front())
+		std::vector<compiled_link_t> compiledI_;	// inverse (GetInverse() of links). in order of applying. (Front() -> Back())
+		bool bCompiledI3_{};						// compiledI_ can be used for 3d points. (false if a link drops z. ex, xCoordTransP33)
+
 	public:
 		//friend class boost::serialization::access;
 		template < typename Archive >
@@ -215,6 +257,7 @@ namespace gtl {
 			//ar & boost::serialization::base_object<base_t>(ct);
 			ar & (base_t&)ct;
 			ar & ct.chain_;
+			ct.Compile();
 		}
 
 		GTL__DYNAMIC_VIRTUAL_DERIVED(xCoordTransChain);
@@ -225,15 +268,20 @@ namespace gtl {
 		//virtual ~TCoordTransChain() { }
 		xCoordTransChain(xCoordTransChain const& B) = default;
 		xCoordTransChain& operator = (xCoordTransChain const& B) = default;
-		auto operator <=> (xCoordTransChain const&) const = default;
+		auto operator <=> (xCoordTransChain const& B) const {	// compiled_ is not compared
+			return std::lexicographical_compare_three_way(chain_.begin(), chain_.end(), B.chain_.begin(), B.chain_.end());
+		}
+		bool operator == (xCoordTransChain const& B) const { return chain_ == B.chain_; }
 
 		xCoordTransChain& operator *= (xCoordTransChain const& B)	{
-			for (auto const& ct : chain_) 
+			for (auto const& ct : B.chain_) 
 				chain_.push_back(std::move(ct.NewClone()));
+			Compile();
 			return *this;
 		}
 		xCoordTransChain& operator *= (ICoordTrans const& B) {
 			chain_.push_back(std::move(B.NewClone()));
+			Compile();
 			return *this;
 		}
 		[[nodiscard]] xCoordTransChain operator * (xCoordTransChain const& B) const {
@@ -244,6 +292,7 @@ namespace gtl {
 			for (auto const& ct : B.chain_) {
 				newChain.chain_.push_back(std::move(ct.NewClone()));
 			}
+			newChain.Compile();
 			return newChain;
 		}
 
@@ -253,6 +302,7 @@ namespace gtl {
 				newChain.chain_.push_back(std::move(ct.NewClone()));
 			}
 			newChain.chain_.push_back(std::move(B.NewClone()));
+			newChain.Compile();
 			return newChain;
 		}
 
@@ -262,6 +312,7 @@ namespace gtl {
 			for (auto const& ct : B.chain_) {
 				newChain.chain_.push_back(std::move(ct.NewClone()));
 			}
+			newChain.Compile();
 			return newChain;
 		}
 
@@ -275,22 +326,102 @@ namespace gtl {
 					return {};
 				}
 			}
+			inv->Compile();
 			return std::move(inv);
 		}
 		bool GetInv(xCoordTransChain& ctI) const {
-			ctI.chain_.clear();
+			ctI.clear();
 			for (auto iter = chain_.rbegin(); iter != chain_.rend(); iter++) {
 				if (auto r = iter->GetInverse(); r) {
 					ctI.chain_.push_back(std::move(r));
 				} else {
+					ctI.Compile();
 					return false;
 				}
 			}
+			ctI.Compile();
 			return true;
 		}
 
 
-		void clear() { chain_.clear(); }
+		void clear() { chain_.clear(); compiled_.clear(); compiledI_.clear(); bCompiledI3_ = false; }
+
+		/// @brief number of steps after flattening. 1 if all links are linear/perspective.
+		[[nodiscard]] size_t GetCompiledSize() const { return compiled_.size(); }
+
+	protected:
+		/// @brief fuses consecutive links with homogeneous matrix. (forward and inverse)
+		void Compile() {
+			compiled_.clear();
+			for (int i = (int)chain_.size()-1; i >= 0; i--)
+				CompileLink(compiled_, chain_[i].GetHomogeneousMatrix(), i);
+
+			compiledI_.clear();
+			bCompiledI3_ = true;
+			for (int i{}; i < (int)chain_.size(); i++) {
+				auto ctI = chain_[i].GetInverse();
+				auto mat = ctI ? ctI->GetHomogeneousMatrix() : std::nullopt;
+				if ( mat and ((*mat)(2, 0) == 0.) and ((*mat)(2, 1) == 0.) and ((*mat)(2, 2) == 0.) and ((*mat)(2, 3) == 0.) )
+					bCompiledI3_ = false;	// z is dropped. TransInverse(point3_t) of the link fails if z != 0
+				CompileLink(compiledI_, mat, i);
+			}
+		}
+		static void CompileLink(std::vector<compiled_link_t>& compiled, std::optional<cv::Matx44d> const& mat, int iLink) {
+			// z -> 0
+			static cv::Matx44d const matZ0{1., 0., 0., 0., /**/ 0., 1., 0., 0., /**/ 0., 0., 0., 0., /**/ 0., 0., 0., 1.};
+
+			if (!mat) {
+				compiled.push_back({ .iLink = iLink });
+			}
+			else if (!compiled.empty() and (compiled.back().iLink < 0)) {
+				auto& c = compiled.back();
+				c.mat2 = *mat * matZ0 * c.mat2;
+				c.mat3 = *mat * c.mat3;
+			}
+			else {
+				compiled.push_back({ .mat2 = *mat, .mat3 = *mat });
+			}
+		}
+
+		/// @brief homogeneous transform. (same as xCoordTransP44)
+		template < typename tpoint >
+		static void TransH(cv::Matx44d const& m, std::span<tpoint const> pts, std::span<tpoint> ptsTarget) {
+			constexpr bool b3d = std::is_same_v<tpoint, point3_t>;
+			double const m00 = m(0, 0), m01 = m(0, 1), m02 = m(0, 2), m03 = m(0, 3);
+			double const m10 = m(1, 0), m11 = m(1, 1), m12 = m(1, 2), m13 = m(1, 3);
+			double const m20 = m(2, 0), m21 = m(2, 1), m22 = m(2, 2), m23 = m(2, 3);
+			double const m30 = m(3, 0), m31 = m(3, 1), m32 = m(3, 2), m33 = m(3, 3);
+			auto const* src = pts.data();
+			auto* dst = ptsTarget.data();
+			for (size_t i{}, n = pts.size(); i < n; i++) {
+				double const x = src[i].x, y = src[i].y;
+				double z{};
+				if constexpr (b3d)
+					z = src[i].z;
+				double tx = m00 * x + m01 * y + m02 * z + m03;
+				double ty = m10 * x + m11 * y + m12 * z + m13;
+				double tz = m20 * x + m21 * y + m22 * z + m23;
+				double const d = m30 * x + m31 * y + m32 * z + m33;
+				if ( (d != 0.0) and (d != 1.0) and std::isfinite(d) ) {
+					tx /= d;
+					ty /= d;
+					tz /= d;
+				}
+				dst[i].x = tx;
+				dst[i].y = ty;
+				if constexpr (b3d)
+					dst[i].z = tz;
+			}
+		}
+		template < typename tpoint >
+		static cv::Matx44d const& GetCompiledMatrix(compiled_link_t const& c) {
+			if constexpr (std::is_same_v<tpoint, point3_t>)
+				return c.mat3;
+			else
+				return c.mat2;
+		}
+
+	public:
 
 		//-------------------------------------------------------------------------
 		// Operation
@@ -315,11 +446,65 @@ namespace gtl {
 			return ptT;
 		}
 
-		virtual [[nodiscard]] point2_t Trans(point2_t const& pt) const override  { return ChainTrans(chain_, pt); }
-		virtual [[nodiscard]] point3_t Trans(point3_t const& pt) const override  { return ChainTrans(chain_, pt); }
+		/// @brief using compiled_ (flattened chain)
+		template < typename tpoint >
+		[[nodiscard]] tpoint CompiledTrans(tpoint const& pt) const {
+			tpoint ptT(pt);
+			for (auto const& c : compiled_) {
+				if (c.iLink >= 0)
+					ptT = chain_[c.iLink].Trans(ptT);
+				else
+					TransH<tpoint>(GetCompiledMatrix<tpoint>(c), std::span<tpoint const>{&ptT, 1}, std::span<tpoint>{&ptT, 1});
+			}
+			return ptT;
+		}
+		/// @brief using compiledI_ (flattened inverse chain)
+		template < typename tpoint >
+		[[nodiscard]] std::optional<tpoint> CompiledTransI(tpoint const& pt) const {
+			if constexpr (std::is_same_v<tpoint, point3_t>) {
+				if (!bCompiledI3_)
+					return ChainTransI(chain_, pt);
+			}
+			tpoint ptT(pt);
+			for (auto const& c : compiledI_) {
+				if (c.iLink >= 0) {
+					auto r = chain_[c.iLink].TransInverse(ptT);
+					if (!r)
+						return {};
+					ptT = *r;
+				}
+				else {
+					TransH<tpoint>(GetCompiledMatrix<tpoint>(c), std::span<tpoint const>{&ptT, 1}, std::span<tpoint>{&ptT, 1});
+				}
+			}
+			return ptT;
+		}
+		/// @brief batch version. each step transforms the whole buffer at once. (one virtual call per step, not per point)
+		template < typename tpoint >
+		void CompiledTrans(std::span<tpoint const> pts, std::span<tpoint> ptsTarget) const {
+			CheckBatchSize(pts.size(), ptsTarget.size());
+			if (compiled_.empty()) {
+				if (pts.data() != ptsTarget.data())
+					std::copy(pts.begin(), pts.end(), ptsTarget.begin());
+				return;
+			}
+			for (auto const& c : compiled_) {
+				if (c.iLink >= 0)
+					chain_[c.iLink].Trans(pts, ptsTarget);
+				else
+					TransH<tpoint>(GetCompiledMatrix<tpoint>(c), pts, ptsTarget);
+				pts = ptsTarget;
+			}
+		}
+
+		using base_t::Trans;
+		virtual [[nodiscard]] point2_t Trans(point2_t const& pt) const override  { return CompiledTrans(pt); }
+		virtual [[nodiscard]] point3_t Trans(point3_t const& pt) const override  { return CompiledTrans(pt); }
 		virtual [[nodiscard]] double Trans(double dLength) const override  { return ChainTrans(chain_, dLength); }
-		virtual [[nodiscard]] std::optional<point2_t> TransInverse(point2_t const& pt) const override { return ChainTransI(chain_, pt); }
-		virtual [[nodiscard]] std::optional<point3_t> TransInverse(point3_t const& pt) const override { return ChainTransI(chain_, pt); }
+		virtual void Trans(std::span<point2_t const> pts, std::span<point2_t> ptsTarget) const override { CompiledTrans(pts, ptsTarget); }
+		virtual void Trans(std::span<point3_t const> pts, std::span<point3_t> ptsTarget) const override { CompiledTrans(pts, ptsTarget); }
+		virtual [[nodiscard]] std::optional<point2_t> TransInverse(point2_t const& pt) const override { return CompiledTransI(pt); }
+		virtual [[nodiscard]] std::optional<point3_t> TransInverse(point3_t const& pt) const override { return CompiledTransI(pt); }
 		virtual [[nodiscard]] std::optional<double> TransInverse(double dLength) const override { return ChainTransI(chain_, dLength); }
 
 		virtual [[nodiscard]] bool IsRightHanded() const override {
@@ -334,6 +519,174 @@ namespace gtl {
 	};
 
 
+	//-----------------------------------------------------------------------------
+	/// @brief RANSAC option for SetFromNPoints()
+	struct sCoordTransRANSAC {
+		double dInlierThreshold{1.0};	// max. distance (in target coord.) of inlier
+		int nMaxIteration{2'000};
+		double dConfidence{0.999};		// iteration stops when an outlier free sample is drawn with this probability
+		int nThread{};					// 0 : std::thread::hardware_concurrency()
+		uint32_t seed{5489u};
+	};
+
+	/// @brief result of SetFromNPoints()
+	struct sCoordTransFitResult {
+		std::vector<double> residuals;	// |Trans(ptsSource[i]) - ptsTarget[i]|
+		std::vector<bool> inliers;		// all true, if not RANSAC
+		size_t nInlier{};
+		double dRMS{};					// RMS of residuals of inliers
+		double dMaxResidual{};			// max. residual of inliers
+		int nIteration{};				// RANSAC iterations evaluated
+	};
+
+	namespace internal {
+
+		/// @brief residuals of ct. |ct(ptsSource[i]) - ptsTarget[i]|
+		template < typename tct, typename tpoint >
+		void CalcCoordTransResidual(tct const& ct, std::span<tpoint const> ptsSource, std::span<tpoint const> ptsTarget, double dInlierThreshold, sCoordTransFitResult& result) {
+			size_t const n = ptsSource.size();
+			std::vector<tpoint> pts(n);
+			ct.Trans(ptsSource, std::span<tpoint>(pts));
+
+			result.residuals.resize(n);
+			result.inliers.assign(n, false);
+			result.nInlier = 0;
+			result.dMaxResidual = 0.0;
+			double sum{};
+			for (size_t i{}; i < n; i++) {
+				double const d = pts[i].Distance(ptsTarget[i]);
+				result.residuals[i] = d;
+				if (d > dInlierThreshold)
+					continue;
+				result.inliers[i] = true;
+				result.nInlier++;
+				sum += d*d;
+				result.dMaxResidual = std::max(result.dMaxResidual, d);
+			}
+			result.dRMS = result.nInlier ? std::sqrt(sum / result.nInlier) : 0.0;
+		}
+
+		/// @brief RANSAC (MSAC scoring). hypotheses are scored on multiple threads.
+		/// @param FitMinimal : bool (tct& ct, std::span<tpoint const> ptsSource, std::span<tpoint const> ptsTarget). fits ct from nSample points.
+		/// @param inliers : inliers of the best hypothesis
+		template < size_t nSample, typename tct, typename tpoint, typename tfunc >
+		[[nodiscard]] bool FitCoordTransRANSAC(tct& ct, std::span<tpoint const> ptsSource, std::span<tpoint const> ptsTarget, sCoordTransRANSAC const& option,
+			tfunc&& FitMinimal, std::vector<bool>& inliers, int& nIteration)
+		{
+			size_t const n = ptsSource.size();
+			if ( (n < nSample) or (ptsTarget.size() != n) or (option.nMaxIteration <= 0) )
+				return false;
+			double const thr2 = Square(option.dInlierThreshold);
+
+			// samples are drawn up front. (result doesn't depend on the number of threads)
+			std::vector<std::array<size_t, nSample>> samples(option.nMaxIteration);
+			std::mt19937 engine(option.seed);
+			std::uniform_int_distribution<size_t> dist(0, n-1);
+			for (auto& sample : samples) {
+				for (size_t i{}; i < nSample; i++) {
+					size_t index{};
+					do {
+						index = dist(engine);
+					} while (std::find(sample.begin(), sample.begin()+i, index) != sample.begin()+i);
+					sample[i] = index;
+				}
+			}
+
+			std::mutex mtx;
+			double dBestScore = std::numeric_limits<double>::max();
+			int iBest = -1;
+			std::atomic<int> iNext{};
+			std::atomic<int> nRequired{option.nMaxIteration};
+
+			auto Worker = [&]() {
+				std::array<tpoint, nSample> ptsS, ptsT;
+				for (int iter = iNext++; iter < nRequired; iter = iNext++) {
+					for (size_t i{}; i < nSample; i++) {
+						ptsS[i] = ptsSource[samples[iter][i]];
+						ptsT[i] = ptsTarget[samples[iter][i]];
+					}
+					tct ctH;
+					if (!FitMinimal(ctH, std::span<tpoint const>(ptsS), std::span<tpoint const>(ptsT)))
+						continue;
+
+					// score : sum of min(d^2, thr^2)
+					double score{};
+					size_t nInlier{};
+					for (size_t i{}; i < n; i++) {
+						auto v = ctH.Trans(ptsSource[i]) - ptsTarget[i];
+						double const d2 = v.Dot(v);
+						if (d2 <= thr2) {
+							score += d2;
+							nInlier++;
+						} else {
+							score += thr2;
+						}
+					}
+
+					std::scoped_lock lock(mtx);
+					if ( (score > dBestScore) or ((score == dBestScore) and (iter > iBest)) )
+						continue;
+					dBestScore = score;
+					iBest = iter;
+
+					// adaptive number of iterations
+					double const p = std::pow((double)nInlier / n, (double)nSample);
+					int nRequiredNew = option.nMaxIteration;
+					if (p >= 1.0)
+						nRequiredNew = iter+1;
+					else if (p > 0.0)
+						nRequiredNew = (int)std::min<double>(option.nMaxIteration, std::ceil(std::log(1.0-option.dConfidence) / std::log(1.0-p)));
+					nRequired = std::min<int>(nRequired, std::max(nRequiredNew, iter+1));
+				}
+			};
+
+			int nThread = option.nThread > 0 ? option.nThread : (int)std::thread::hardware_concurrency();
+			nThread = std::clamp(nThread, 1, option.nMaxIteration);
+			if (nThread == 1) {
+				Worker();
+			} else {
+				std::vector<std::jthread> threads;
+				threads.reserve(nThread);
+				for (int i{}; i < nThread; i++)
+					threads.emplace_back(Worker);
+			}	// join
+
+			nIteration = std::min<int>(iNext, nRequired);
+			if (iBest < 0)
+				return false;
+
+			std::array<tpoint, nSample> ptsS, ptsT;
+			for (size_t i{}; i < nSample; i++) {
+				ptsS[i] = ptsSource[samples[iBest][i]];
+				ptsT[i] = ptsTarget[samples[iBest][i]];
+			}
+			if (!FitMinimal(ct, std::span<tpoint const>(ptsS), std::span<tpoint const>(ptsT)))
+				return false;
+
+			inliers.assign(n, false);
+			for (size_t i{}; i < n; i++) {
+				auto v = ct.Trans(ptsSource[i]) - ptsTarget[i];
+				inliers[i] = v.Dot(v) <= thr2;
+			}
+			return true;
+		}
+
+		/// @brief ptsSource[i], ptsTarget[i] where inliers[i]
+		template < typename tpoint >
+		void SelectInliers(std::span<tpoint const> ptsSource, std::span<tpoint const> ptsTarget, std::vector<bool> const& inliers, std::vector<tpoint>& ptsS, std::vector<tpoint>& ptsT) {
+			ptsS.clear();
+			ptsT.clear();
+			for (size_t i{}; i < inliers.size(); i++) {
+				if (!inliers[i])
+					continue;
+				ptsS.push_back(ptsSource[i]);
+				ptsT.push_back(ptsTarget[i]);
+			}
+		}
+
+	}	// namespace internal
+
+
 	//-----------------------------------------------------------------------------
 	/// @brief class TCoordTransDim 
 	/// TARGET = scale * mat ( SOURCE - origin ) + offset
@@ -575,6 +928,102 @@ namespace gtl {
 			return true;
 		}
 
+		/// @brief least square fit (affine) from N (>= dim+1) points. with pRANSAC, outliers are rejected by RANSAC first and the inliers are fitted.
+		/// @param bCalcScale : if false, m_scale is 1.0 and m_mat is normalized (|det| == 1)
+		/// @param pResult : (optional) residuals, inliers
+		/// @param pRANSAC : (optional) RANSAC option. if nullptr, all points are used.
+		[[nodiscard]] bool SetFromNPoints(std::span<point_t const> ptsSource, std::span<point_t const> ptsTarget, bool bCalcScale = true,
+			sCoordTransFitResult* pResult = nullptr, sCoordTransRANSAC const* pRANSAC = nullptr, double dMinDeterminant = 0.0)
+		{
+			if ( (ptsSource.size() != ptsTarget.size()) or (ptsSource.size() < dim+1) )
+				return false;
+
+			int nIteration{};
+			if (pRANSAC) {
+				auto FitMinimal = [dMinDeterminant](this_t& ct, std::span<point_t const> ptsS, std::span<point_t const> ptsT) -> bool {
+					if constexpr (dim == 2)
+						return ct.SetFrom3Points(ptsS, ptsT, true, dMinDeterminant);
+					else
+						return ct.SetFrom4Points(ptsS, ptsT, true, dMinDeterminant);
+				};
+				this_t ct;
+				std::vector<bool> inliers;
+				if (!internal::FitCoordTransRANSAC<dim+1>(ct, ptsSource, ptsTarget, *pRANSAC, FitMinimal, inliers, nIteration))
+					return false;
+				std::vector<point_t> ptsS, ptsT;
+				internal::SelectInliers(ptsSource, ptsTarget, inliers, ptsS, ptsT);
+				if (!ct.FitLeastSquare(ptsS, ptsT, bCalcScale, dMinDeterminant)) {
+					// keeps the best hypothesis
+					ct.NormalizeScale();
+					if (!bCalcScale)
+						ct.m_scale = 1.0;
+				}
+				*this = ct;
+			}
+			else {
+				if (!FitLeastSquare(ptsSource, ptsTarget, bCalcScale, dMinDeterminant))
+					return false;
+			}
+
+			if (pResult) {
+				internal::CalcCoordTransResidual(*this, ptsSource, ptsTarget, pRANSAC ? pRANSAC->dInlierThreshold : std::numeric_limits<double>::infinity(), *pResult);
+				pResult->nIteration = nIteration;
+			}
+			return true;
+		}
+
+	protected:
+		/// @brief TARGET - cT = A (SOURCE - cS). A = Σ(dT dS') (Σ(dS dS'))^-1, (cS, cT : centroids)
+		bool FitLeastSquare(std::span<point_t const> ptsSource, std::span<point_t const> ptsTarget, bool bCalcScale, double dMinDeterminant) {
+			size_t const n = ptsSource.size();
+			if ( (n < dim+1) or (ptsTarget.size() != n) )
+				return false;
+
+			point_t cS{}, cT{};
+			for (size_t i{}; i < n; i++) {
+				cS += ptsSource[i];
+				cT += ptsTarget[i];
+			}
+			cS /= (double)n;
+			cT /= (double)n;
+
+			mat_t SS = mat_t::zeros(), TS = mat_t::zeros();
+			for (size_t i{}; i < n; i++) {
+				auto const dS = ptsSource[i] - cS;
+				auto const dT = ptsTarget[i] - cT;
+				for (int r{}; r < dim; r++) {
+					for (int c{}; c < dim; c++) {
+						SS(r, c) += dS.member(r) * dS.member(c);
+						TS(r, c) += dT.member(r) * dS.member(c);
+					}
+				}
+			}
+			if (std::abs(cv::determinant(SS)) <= dMinDeterminant)
+				return false;
+			bool bOK{};
+			auto SSi = SS.inv(cv::DECOMP_LU, &bOK);
+			if (!bOK)
+				return false;
+
+			m_mat = TS * SSi;
+			m_scale = 1.0;
+			NormalizeScale();
+			if (!bCalcScale)
+				m_scale = 1.0;
+			m_origin = cS;
+			m_offset = cT;
+			return true;
+		}
+		/// @brief m_scale * m_mat -> m_scale, m_mat (|det(m_mat)| == 1)
+		void NormalizeScale() {
+			double const scale = std::pow(std::abs(cv::determinant(m_mat)), 1.0/dim);
+			if ( (scale == 0.0) or !std::isfinite(scale) )
+				return;
+			m_mat /= scale;
+			m_scale *= scale;
+		}
+
+	public:
 		static inline [[nodiscard]] mat_t GetRotatingMatrix(rad_t angle) requires (dim == 2) {
 			double c{cos(angle)}, s{sin(angle)};
 			return mat_t(c, -s, s, c);
@@ -624,6 +1073,7 @@ namespace gtl {
 		//-------------------------------------------------------------------------
 		// Operation
 		//
+		using base_t::Trans;
 		virtual [[nodiscard]] point2_t Trans(point2_t const& pt) const override {
 			if constexpr (dim == 2) {
 				return m_scale * (m_mat * (pt-m_origin)) + m_offset;
@@ -667,6 +1117,66 @@ namespace gtl {
 			return cv::determinant(m_mat) >= 0;
 		}
 
+		/// @brief TARGET = m * SOURCE + t. (m = scale * mat, t = offset - m * origin)
+		void GetLinear(mat_t& m, point_t& t) const {
+			m = m_scale * m_mat;
+			t = m_offset - m * m_origin;
+		}
+
+		virtual [[nodiscard]] std::optional<cv::Matx44d> GetHomogeneousMatrix() const override {
+			mat_t m; point_t t;
+			GetLinear(m, t);
+			if constexpr (dim == 2) {
+				// z is not changed
+				return cv::Matx44d{ m(0, 0), m(0, 1), 0., t.x, /**/ m(1, 0), m(1, 1), 0., t.y, /**/ 0., 0., 1., 0., /**/ 0., 0., 0., 1. };
+			} else if constexpr (dim == 3) {
+				return cv::Matx44d{ m(0, 0), m(0, 1), m(0, 2), t.x, /**/ m(1, 0), m(1, 1), m(1, 2), t.y, /**/ m(2, 0), m(2, 1), m(2, 2), t.z, /**/ 0., 0., 0., 1. };
+			}
+		}
+
+		virtual void Trans(std::span<point2_t const> pts, std::span<point2_t> ptsTarget) const override {
+			CheckBatchSize(pts.size(), ptsTarget.size());
+			mat_t m; point_t t;
+			GetLinear(m, t);
+			double const m00 = m(0, 0), m01 = m(0, 1), m10 = m(1, 0), m11 = m(1, 1);
+			double const tx = t.x, ty = t.y;
+			auto const* src = pts.data();
+			auto* dst = ptsTarget.data();
+			for (size_t i{}, n = pts.size(); i < n; i++) {
+				double const x = src[i].x, y = src[i].y;
+				dst[i].x = m00 * x + m01 * y + tx;
+				dst[i].y = m10 * x + m11 * y + ty;
+			}
+		}
+		virtual void Trans(std::span<point3_t const> pts, std::span<point3_t> ptsTarget) const override {
+			CheckBatchSize(pts.size(), ptsTarget.size());
+			mat_t m; point_t t;
+			GetLinear(m, t);
+			auto const* src = pts.data();
+			auto* dst = ptsTarget.data();
+			if constexpr (dim == 2) {
+				double const m00 = m(0, 0), m01 = m(0, 1), m10 = m(1, 0), m11 = m(1, 1);
+				double const tx = t.x, ty = t.y;
+				for (size_t i{}, n = pts.size(); i < n; i++) {
+					double const x = src[i].x, y = src[i].y, z = src[i].z;
+					dst[i].x = m00 * x + m01 * y + tx;
+					dst[i].y = m10 * x + m11 * y + ty;
+					dst[i].z = z;
+				}
+			} else if constexpr (dim == 3) {
+				double const m00 = m(0, 0), m01 = m(0, 1), m02 = m(0, 2);
+				double const m10 = m(1, 0), m11 = m(1, 1), m12 = m(1, 2);
+				double const m20 = m(2, 0), m21 = m(2, 1), m22 = m(2, 2);
+				double const tx = t.x, ty = t.y, tz = t.z;
+				for (size_t i{}, n = pts.size(); i < n; i++) {
+					double const x = src[i].x, y = src[i].y, z = src[i].z;
+					dst[i].x = m00 * x + m01 * y + m02 * z + tx;
+					dst[i].y = m10 * x + m11 * y + m12 * z + ty;
+					dst[i].z = m20 * x + m21 * y + m22 * z + tz;
+				}
+			}
+		}
+
 		TCoordTransDim& operator *= (TCoordTransDim const& B) {
 			// 순서 바꾸면 안됨.
 			m_offset		= m_scale * m_mat * (B.m_offset - m_origin) + m_offset;
@@ -109,9 +109,112 @@ namespace gtl {
 			return true;
 		}
 
+		/// @brief least square fit (normalized DLT) from N (>= 4) points. with pRANSAC, outliers are rejected by RANSAC first and the inliers are fitted.
+		/// @param pResult : (optional) residuals, inliers
+		/// @param pRANSAC : (optional) RANSAC option. if nullptr, all points are used.
+		[[nodiscard]] bool SetFromNPoints(std::span<point_t const> ptsSource, std::span<point_t const> ptsTarget,
+			sCoordTransFitResult* pResult = nullptr, sCoordTransRANSAC const* pRANSAC = nullptr)
+		{
+			if ( (ptsSource.size() != ptsTarget.size()) or (ptsSource.size() < 4) )
+				return false;
+
+			int nIteration{};
+			if (pRANSAC) {
+				auto FitMinimal = [](this_t& ct, std::span<point_t const> ptsS, std::span<point_t const> ptsT) -> bool {
+					return ct.SetFrom4Points(ptsS, ptsT);
+				};
+				this_t ct;
+				std::vector<bool> inliers;
+				if (!internal::FitCoordTransRANSAC<4>(ct, ptsSource, ptsTarget, *pRANSAC, FitMinimal, inliers, nIteration))
+					return false;
+				std::vector<point_t> ptsS, ptsT;
+				internal::SelectInliers(ptsSource, ptsTarget, inliers, ptsS, ptsT);
+				ct.FitLeastSquare(ptsS, ptsT);	// keeps the best hypothesis if fails.
+				*this = ct;
+			}
+			else {
+				if (!FitLeastSquare(ptsSource, ptsTarget))
+					return false;
+			}
+
+			if (pResult) {
+				internal::CalcCoordTransResidual(*this, ptsSource, ptsTarget, pRANSAC ? pRANSAC->dInlierThreshold : std::numeric_limits<double>::infinity(), *pResult);
+				pResult->nIteration = nIteration;
+			}
+			return true;
+		}
+
+	protected:
+		/// @brief normalized DLT. (minimizes algebraic error)
+		bool FitLeastSquare(std::span<point_t const> ptsSource, std::span<point_t const> ptsTarget) {
+			size_t const n = ptsSource.size();
+			if ( (n < 4) or (ptsTarget.size() != n) )
+				return false;
+
+			// centroid -> 0, mean distance -> sqrt(2)
+			auto GetNormalizingMatrix = [n](std::span<point_t const> pts) -> std::optional<mat_t> {
+				point_t c{};
+				for (auto const& pt : pts)
+					c += pt;
+				c /= (double)n;
+				double d{};
+				for (auto const& pt : pts)
+					d += pt.Distance(c);
+				d /= (double)n;
+				if ( (d <= 0.0) or !std::isfinite(d) )
+					return {};
+				double const s = std::numbers::sqrt2 / d;
+				return mat_t{ s, 0., -s*c.x, /**/ 0., s, -s*c.y, /**/ 0., 0., 1. };
+			};
+			auto NS = GetNormalizingMatrix(ptsSource);
+			auto NT = GetNormalizingMatrix(ptsTarget);
+			if (!NS or !NT)
+				return false;
+
+			// A'A, (A : 2n x 9)
+			auto AtA = cv::Matx<double, 9, 9>::zeros();
+			for (size_t i{}; i < n; i++) {
+				double const x = (*NS)(0, 0) * ptsSource[i].x + (*NS)(0, 2);
+				double const y = (*NS)(1, 1) * ptsSource[i].y + (*NS)(1, 2);
+				double const u = (*NT)(0, 0) * ptsTarget[i].x + (*NT)(0, 2);
+				double const v = (*NT)(1, 1) * ptsTarget[i].y + (*NT)(1, 2);
+				double const r1[9] = { x, y, 1., 0., 0., 0., -u*x, -u*y, -u };
+				double const r2[9] = { 0., 0., 0., x, y, 1., -v*x, -v*y, -v };
+				for (int r{}; r < 9; r++) {
+					for (int c{r}; c < 9; c++)
+						AtA(r, c) += r1[r]*r1[c] + r2[r]*r2[c];
+				}
+			}
+			for (int r{1}; r < 9; r++) {
+				for (int c{}; c < r; c++)
+					AtA(r, c) = AtA(c, r);
+			}
+
+			// eigen vector of the smallest eigen value. (eigen values are in descending order)
+			cv::Mat evals, evecs;
+			if (!cv::eigen(cv::Mat(AtA), evals, evecs))
+				return false;
+			mat_t H;
+			for (int i{}; i < 9; i++)
+				H.val[i] = evecs.at<double>(8, i);
+
+			bool bOK{};
+			auto NTi = NT->inv(cv::DECOMP_LU, &bOK);
+			if (!bOK)
+				return false;
+			H = NTi * H * (*NS);
+			if ( (H(2, 2) == 0.0) or !std::isfinite(H(2, 2)) )
+				return false;
+			m_mat = H * (1.0 / H(2, 2));
+			return true;
+		}
+
+	public:
+
 		//-------------------------------------------------------------------------
 		// Operation
 		//
+		using base_t::Trans;
 		virtual [[nodiscard]] point2_t Trans(point2_t const& pt) const override {
 			point3_t ptNew;
 			ptNew.x = m_mat(0, 0) * pt.x + m_mat(0, 1) * pt.y + m_mat(0, 2);
@@ -128,6 +231,14 @@ namespace gtl {
 		virtual [[nodiscard]] point3_t Trans(point3_t const& pt) const override  {
 			return Trans(point2_t{pt.x, pt.y});
 		}
+		virtual void Trans(std::span<point2_t const> pts, std::span<point2_t> ptsTarget) const override {
+			CheckBatchSize(pts.size(), ptsTarget.size());
+			TransBatch(pts, ptsTarget);
+		}
+		virtual void Trans(std::span<point3_t const> pts, std::span<point3_t> ptsTarget) const override {
+			CheckBatchSize(pts.size(), ptsTarget.size());
+			TransBatch(pts, ptsTarget);
+		}
 		virtual [[nodiscard]] double Trans(double dLength) const override  {
 			return std::sqrt(cv::determinant(m_mat))*dLength;
 		}
@@ -153,7 +264,38 @@ namespace gtl {
 			bool bRightHanded{cv::determinant(m_mat) > 0};
 			return bRightHanded;
 		}
+		virtual [[nodiscard]] std::optional<cv::Matx44d> GetHomogeneousMatrix() const override {
+			auto const& m = m_mat;
+			// z is not used, and result z is 0.
+			return cv::Matx44d{ m(0, 0), m(0, 1), 0., m(0, 2), /**/ m(1, 0), m(1, 1), 0., m(1, 2), /**/ 0., 0., 0., 0., /**/ m(2, 0), m(2, 1), 0., m(2, 2) };
+		}
+
+	protected:
+		/// @brief same as Trans(point2_t), but w/o virtual call. z of point3_t is set to 0.
+		template < typename tpoint >
+		void TransBatch(std::span<tpoint const> pts, std::span<tpoint> ptsTarget) const {
+			double const m00 = m_mat(0, 0), m01 = m_mat(0, 1), m02 = m_mat(0, 2);
+			double const m10 = m_mat(1, 0), m11 = m_mat(1, 1), m12 = m_mat(1, 2);
+			double const m20 = m_mat(2, 0), m21 = m_mat(2, 1), m22 = m_mat(2, 2);
+			auto const* src = pts.data();
+			auto* dst = ptsTarget.data();
+			for (size_t i{}, n = pts.size(); i < n; i++) {
+				double const x = src[i].x, y = src[i].y;
+				double tx = m00 * x + m01 * y + m02;
+				double ty = m10 * x + m11 * y + m12;
+				double const d = m20 * x + m21 * y + m22;
+				if ( (d != 0.0) and (d != 1.0) ) {
+					tx /= d;
+					ty /= d;
+				}
+				dst[i].x = tx;
+				dst[i].y = ty;
+				if constexpr (std::is_same_v<tpoint, point3_t>)
+					dst[i].z = 0.0;
+			}
+		}
 
+	public:
 		static inline [[nodiscard]] mat_t GetRotatingMatrixXY(rad_t angle) {
 			double c{cos(angle)}, s{sin(angle)};
 			//return mat_t{c, -s, 0., 0., /**/ s, c, 0., 0., /**/ 0., 0., 1., 0., /**/ 0., 0., 0., 1. };
@@ -285,11 +427,11 @@ namespace gtl {
 		//-------------------------------------------------------------------------
 		// Operation
 		//
+		using base_t::Trans;
 		virtual [[nodiscard]] point2_t Trans(point2_t const& pt) const override {
 			return Trans(point3_t{pt.x, pt.y, 0.});
 		}
 		virtual [[nodiscard]] point3_t Trans(point3_t const& pt) const override  {
-			auto t0 = std::chrono::steady_clock::now();
 			point3_t ptNew;
 			ptNew.x = m_mat(0, 0) * pt.x + m_mat(0, 1) * pt.y + m_mat(0, 2) * pt.z + m_mat(0, 3);
 			ptNew.y = m_mat(1, 0) * pt.x + m_mat(1, 1) * pt.y + m_mat(1, 2) * pt.z + m_mat(1, 3);
@@ -300,10 +442,16 @@ namespace gtl {
 				ptNew.y /= d;
 				ptNew.z /= d;
 			}
-			auto t1 = std::chrono::steady_clock::now();
-			auto duration = std::chrono::duration<double, std::micro>(t1-t0);
 			return ptNew;
 		}
+		virtual void Trans(std::span<point2_t const> pts, std::span<point2_t> ptsTarget) const override {
+			CheckBatchSize(pts.size(), ptsTarget.size());
+			TransBatch(pts, ptsTarget);
+		}
+		virtual void Trans(std::span<point3_t const> pts, std::span<point3_t> ptsTarget) const override {
+			CheckBatchSize(pts.size(), ptsTarget.size());
+			TransBatch(pts, ptsTarget);
+		}
 		virtual [[nodiscard]] double Trans(double dLength) const override  {
 			return std::sqrt(cv::determinant(m_mat))*dLength;
 		}
@@ -327,7 +475,43 @@ namespace gtl {
 			bool bRightHanded{cv::determinant(m_mat) > 0};
 			return bRightHanded;
 		}
+		virtual [[nodiscard]] std::optional<cv::Matx44d> GetHomogeneousMatrix() const override {
+			return m_mat;
+		}
 
+	protected:
+		/// @brief same as Trans(point3_t), but w/o virtual call. z of point2_t is regarded as 0.
+		template < typename tpoint >
+		void TransBatch(std::span<tpoint const> pts, std::span<tpoint> ptsTarget) const {
+			constexpr bool b3d = std::is_same_v<tpoint, point3_t>;
+			double const m00 = m_mat(0, 0), m01 = m_mat(0, 1), m02 = m_mat(0, 2), m03 = m_mat(0, 3);
+			double const m10 = m_mat(1, 0), m11 = m_mat(1, 1), m12 = m_mat(1, 2), m13 = m_mat(1, 3);
+			double const m20 = m_mat(2, 0), m21 = m_mat(2, 1), m22 = m_mat(2, 2), m23 = m_mat(2, 3);
+			double const m30 = m_mat(3, 0), m31 = m_mat(3, 1), m32 = m_mat(3, 2), m33 = m_mat(3, 3);
+			auto const* src = pts.data();
+			auto* dst = ptsTarget.data();
+			for (size_t i{}, n = pts.size(); i < n; i++) {
+				double const x = src[i].x, y = src[i].y;
+				double z{};
+				if constexpr (b3d)
+					z = src[i].z;
+				double tx = m00 * x + m01 * y + m02 * z + m03;
+				double ty = m10 * x + m11 * y + m12 * z + m13;
+				double tz = m20 * x + m21 * y + m22 * z + m23;
+				double const d = m30 * x + m31 * y + m32 * z + m33;
+				if ( (d != 0.0) and (d != 1.0) and std::isfinite(d) ) {
+					tx /= d;
+					ty /= d;
+					tz /= d;
+				}
+				dst[i].x = tx;
+				dst[i].y = ty;
+				if constexpr (b3d)
+					dst[i].z = tz;
+			}
+		}
+
+	public:
 		static inline [[nodiscard]] mat_t GetRotatingMatrixXY(rad_t angle) {
 			double c{cos(angle)}, s{sin(angle)};
 			//return mat_t{c, -s, 0., 0., /**/ s, c, 0., 0., /**/ 0., 0., 1., 0., /**/ 0., 0., 0., 1. };
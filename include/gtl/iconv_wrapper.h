@@ -5,6 +5,7 @@
 // PWH
 //
 // 2021.05.07. libiconv wrapper
+// 2026.10.17. descriptor pool (xIconvPool), buffer reusing Convert(), streaming (ConvertChunk)
 // 
 //   https://www.gnu.org/software/libiconv/
 //
@@ -17,8 +18,12 @@
 #ifndef GTL__HEADER__ICONV_WRAPPER
 #define GTL__HEADER__ICONV_WRAPPER
 
+#include <map>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #pragma warning(push)
 #pragma warning(disable: 4819)	// codepage
@@ -94,9 +99,122 @@ namespace gtl {
 #pragma pack(push, 8)
 
 
+	//-----------------------------------------------------------------------------------------------------------------
+	/// @brief pool of iconv descriptors, per (to, from). thread safe.
+	///
+	/// Checkout() takes one from this thread's cache (no lock), then from the shared pool, or opens a new one.
+	/// Return() resets it (initial shift state, no flags) and keeps it in this thread's cache. (goes to the shared pool when the thread exits)
+	/// a descriptor checked out is used by one owner only.
+	class xIconvPool {
+	public:
+		using key_t = std::pair<std::string, std::string>;	// to, from
+		constexpr static size_t const s_nMaxThreadCache = 4;	// per key
+		constexpr static size_t const s_nMaxShared = 64;		// per key
+
+	protected:
+		std::mutex m_mtx;	// shared pool only
+		std::map<key_t, std::vector<libiconv_t>> m_descriptors;
+
+	public:
+		xIconvPool() = default;
+		xIconvPool(xIconvPool const&) = delete;
+		xIconvPool& operator = (xIconvPool const&) = delete;
+		~xIconvPool() {
+			for (auto& [key, descriptors] : m_descriptors) {
+				for (auto cd : descriptors)
+					iconv_close(cd);
+			}
+		}
+
+		/// @return descriptor, (iconv_t)-1 if (to, from) is not supported.
+		static libiconv_t Checkout(char const* to, char const* from) {
+			auto& shared = GetShared();	// constructed before any owner of a descriptor
+			key_t key{ to, from };
+			if (auto* cache = GetThreadCache()) {
+				if (auto cd = cache->Pop(key); cd != (iconv_t)-1)
+					return cd;
+			}
+			{
+				std::unique_lock lock(shared.m_mtx);
+				if (auto cd = shared.Pop(key); cd != (iconv_t)-1)
+					return cd;
+			}
+			return iconv_open(to, from);
+		}
+		static void Return(char const* to, char const* from, libiconv_t cd) {
+			if (cd == (iconv_t)-1)
+				return;
+			iconv(cd, nullptr, nullptr, nullptr, nullptr);
+			int bOff{};
+			iconvctl(cd, ICONV_SET_TRANSLITERATE, &bOff);
+			iconvctl(cd, ICONV_SET_DISCARD_ILSEQ, &bOff);
+			key_t key{ to, from };
+			if (auto* cache = GetThreadCache(); cache and cache->Push(key, cd, s_nMaxThreadCache))
+				return;
+			{
+				auto& shared = GetShared();
+				std::unique_lock lock(shared.m_mtx);
+				if (shared.Push(key, cd, s_nMaxShared))
+					return;
+			}
+			iconv_close(cd);
+		}
+
+	protected:
+		libiconv_t Pop(key_t const& key) {
+			auto iter = m_descriptors.find(key);
+			if (iter == m_descriptors.end() or iter->second.empty())
+				return (iconv_t)-1;
+			auto cd = iter->second.back();
+			iter->second.pop_back();
+			return cd;
+		}
+		bool Push(key_t const& key, libiconv_t cd, size_t nMax) {
+			auto& descriptors = m_descriptors[key];
+			if (descriptors.size() >= nMax)
+				return false;
+			descriptors.push_back(cd);
+			return true;
+		}
+
+		static xIconvPool& GetShared() {
+			static xIconvPool pool;
+			return pool;
+		}
+		/// @return nullptr while the thread is exiting (cache is already destroyed)
+		static xIconvPool* GetThreadCache() {
+			struct xThreadCache : public xIconvPool {
+				bool& m_bDestroyed;
+				xThreadCache(bool& bDestroyed) : m_bDestroyed(bDestroyed) {}
+				~xThreadCache() {
+					m_bDestroyed = true;
+					auto& shared = GetShared();
+					std::unique_lock lock(shared.m_mtx);
+					for (auto& [key, descriptors] : m_descriptors) {
+						while (!descriptors.empty() and shared.Push(key, descriptors.back(), s_nMaxShared))
+							descriptors.pop_back();
+					}
+				}
+			};
+			thread_local bool bDestroyed{};	// trivially destructible. valid until the thread ends.
+			if (bDestroyed)
+				return nullptr;
+			thread_local xThreadCache cache(bDestroyed);
+			return &cache;
+		}
+	};
+
+
+	/// @brief iconv converter. descriptor is from xIconvPool. (constructing one is cheap)
+	/// not thread safe. (one converter per thread. see ToString_iconv())
 	template < gtlc::string_elem tchar_to, gtlc::string_elem tchar_from, size_t initial_dst_buf_size = 1024 >
 	class Ticonv {
+		std::string to_, from_;
 		libiconv_t cd_ {(iconv_t)-1};
+		std::basic_string<tchar_to> buffer_;	// for Convert(svFrom). kept if result is short (<= initial_dst_buf_size)
+		std::string carry_;						// ConvertChunk(). incomplete sequence at the end of previous chunk
+
+		constexpr static size_t const s_nMaxCarry = 16;	// bytes. longer than any incomplete sequence
 
 	public:
 		Ticonv(char const* to = nullptr, char const* from = nullptr) {
@@ -104,15 +222,18 @@ namespace gtl {
 				to = GuessCodeFromType<tchar_to>();
 			if (!from or !*from)
 				from = GuessCodeFromType<tchar_from>();
-			cd_ = iconv_open(to, from);
+			to_ = to;
+			from_ = from;
+			cd_ = xIconvPool::Checkout(to, from);
 		}
 		Ticonv(char const* to, char const* from, bool bTransliterate, bool bDiscardIlseq) : Ticonv(to, from) {
 			SetTransliterate(bTransliterate);
 			SetDiscardIsseq(bDiscardIlseq);
 		}
+		Ticonv(Ticonv const&) = delete;
+		Ticonv& operator = (Ticonv const&) = delete;
 		~Ticonv() {
-			if (IsOpen())
-				iconv_close(cd_);
+			xIconvPool::Return(to_.c_str(), from_.c_str(), cd_);
 		}
 
 		bool IsOpen() const {
@@ -140,61 +261,112 @@ namespace gtl {
 			return Convert(std::basic_string_view<tchar_from>{strFrom});
 		}
 		std::optional<std::basic_string<tchar_to>> Convert(std::basic_string_view<tchar_from> svFrom) {
-			if (!IsOpen())
+			if (!Convert(svFrom, buffer_))
 				return {};
+			if (buffer_.size() <= initial_dst_buf_size)
+				return std::basic_string<tchar_to>(buffer_);	// exact size. buffer_ is kept for next call
+			return std::move(buffer_);
+		}
 
-			// source
-			using char_source_buf_t = char;	// or char const
-
-			char_source_buf_t* src = (char_source_buf_t*)(svFrom.data());
-			size_t remnant_src = svFrom.size()*sizeof(tchar_from);
-
-			auto Conv = [](iconv_t cd, std::basic_string<tchar_to>& strTo, char_source_buf_t** psrc, auto& remnant_src, auto& remnant_dst) -> std::optional<std::basic_string<tchar_to>> {
-				while (remnant_src) {
-					char* out = std::bit_cast<char*>(strTo.data() + strTo.size() - remnant_dst/sizeof(tchar_to));
-					if (iconv(cd, psrc, &remnant_src, &out, &remnant_dst) == (size_t)-1) {
-						if (errno == E2BIG) {
-							//size_t const old_size = strTo.size() * sizeof(tchar_to);
-							//size_t const new_size = strTo.size() * sizeof(tchar_to) * 2;
-							remnant_dst += strTo.size() * sizeof(tchar_to);
-							strTo.resize(strTo.size()*2);
-							continue;
-						}
-						return {};
-					}
-				}
-
-				strTo.resize(strTo.size() - remnant_dst/sizeof(tchar_to));
-				return std::move(strTo);
-			};
-
+		/// @brief converts into strTo, reusing its capacity.
+		/// @return false if svFrom is invalid or incomplete. (strTo is cleared)
+		bool Convert(std::basic_string_view<tchar_from> svFrom, std::basic_string<tchar_to>& strTo) {
+			strTo.clear();
+			if (!IsOpen())
+				return false;
+			Reset();
+			char* src = (char*)svFrom.data();
+			size_t nSrc = svFrom.size() * sizeof(tchar_from);
+			bool const bOK = (Iconv(&src, &nSrc, strTo) == eRESULT::ok) and (Iconv(nullptr, nullptr, strTo) == eRESULT::ok);
+			if (!bOK) {
+				strTo.clear();
+				Reset();
+			}
+			return bOK;
+		}
 
-			if constexpr (initial_dst_buf_size != 0) {
-				tchar_to initial_dst_buf[initial_dst_buf_size]{};
-				size_t remnant_dst = sizeof(initial_dst_buf);
-				char* out = (char*)initial_dst_buf;
-				if (iconv(cd_, &src, &remnant_src, &out, &remnant_dst) == (size_t)-1) {
-					auto e = errno;
-					if (e == E2BIG) {
-						std::basic_string<tchar_to> strTo;
-						size_t const old_size = sizeof(initial_dst_buf);
-						size_t const new_size = std::max(old_size*2, svFrom.size());
-						strTo.resize(new_size/sizeof(tchar_to));
-						std::memmove(strTo.data(), initial_dst_buf, old_size - remnant_dst);
-						remnant_dst += (new_size - old_size);
-
-						return Conv(cd_, strTo, &src, remnant_src, remnant_dst);
+		/// @brief streaming. converts svChunk and appends to strTo.
+		/// incomplete sequence at the end of chunk (split multibyte char, surrogate pair) is carried to the next call, as is the shift state (ISO-2022-*).
+		/// call Finish() after the last chunk.
+		/// @return false on invalid sequence.
+		bool ConvertChunk(std::basic_string_view<tchar_from> svChunk, std::basic_string<tchar_to>& strTo) {
+			if (!IsOpen())
+				return false;
+			char* src = (char*)svChunk.data();
+			size_t nSrc = svChunk.size() * sizeof(tchar_from);
+			if (!carry_.empty()) {
+				// carried bytes + head of this chunk
+				size_t const nCarry = carry_.size();
+				size_t const nHead = std::min(nSrc, s_nMaxCarry);
+				carry_.append(src, nHead);
+				char* tmp = carry_.data();
+				size_t nTmp = carry_.size();
+				auto const r = Iconv(&tmp, &nTmp, strTo);
+				size_t const nUsed = carry_.size() - nTmp;
+				if (r == eRESULT::error) {
+					Reset();
+					return false;
+				}
+				if (nUsed < nCarry) {	// still incomplete
+					if (nHead < nSrc) {
+						Reset();
+						return false;
 					}
-					return {};
+					carry_.erase(0, nUsed);
+					return true;
 				}
-				return std::move(std::basic_string<tchar_to>(initial_dst_buf, std::size(initial_dst_buf)-remnant_dst/sizeof(tchar_to)));
-
-			} else {
-				std::basic_string<tchar_to> strTo;
-				strTo.resize(svFrom.size());
-				size_t remnant_dst = strTo.size()*sizeof(tchar_to);
+				src += nUsed - nCarry;
+				nSrc -= nUsed - nCarry;
+				carry_.clear();
+			}
+			auto const r = Iconv(&src, &nSrc, strTo);
+			if (r == eRESULT::incomplete and nSrc <= s_nMaxCarry) {
+				carry_.assign(src, nSrc);
+				return true;
+			}
+			if (r != eRESULT::ok) {
+				Reset();
+				return false;
+			}
+			return true;
+		}
+		/// @brief end of stream. appends the sequence back to initial shift state (stateful encodings) and resets.
+		/// @return false if an incomplete sequence is left.
+		bool Finish(std::basic_string<tchar_to>& strTo) {
+			bool const bOK = IsOpen() and carry_.empty() and (Iconv(nullptr, nullptr, strTo) == eRESULT::ok);
+			Reset();
+			return bOK;
+		}
+		/// @brief initial shift state. discards carried bytes.
+		void Reset() {
+			carry_.clear();
+			if (IsOpen())
+				iconv(cd_, nullptr, nullptr, nullptr, nullptr);
+		}
 
-				return Conv(cd_, strTo, &src, remnant_src, remnant_dst);
+	protected:
+		enum class eRESULT { ok, incomplete, error };
+		/// @brief iconv, appending to strTo. (no reallocation if its capacity is enough, grows if needed). psrc == nullptr : writes sequence back to initial shift state.
+		eRESULT Iconv(char** psrc, size_t* pnSrc, std::basic_string<tchar_to>& strTo) {
+			size_t nWritten = strTo.size();
+			size_t const nEstimated = (pnSrc ? *pnSrc / std::min(sizeof(tchar_from), sizeof(tchar_to)) : 0) + 16;
+			strTo.resize(nWritten + nEstimated);	// only the estimated part is filled. (not the whole capacity)
+			while (true) {
+				char* out = (char*)(strTo.data() + nWritten);
+				size_t nOut = (strTo.size() - nWritten) * sizeof(tchar_to);
+				auto const r = iconv(cd_, psrc, pnSrc, &out, &nOut);
+				auto const e = errno;
+				nWritten = strTo.size() - nOut / sizeof(tchar_to);
+				if (r != (size_t)-1) {
+					strTo.resize(nWritten);
+					return eRESULT::ok;
+				}
+				if (e == E2BIG) {
+					strTo.resize(strTo.size() * 2);
+					continue;
+				}
+				strTo.resize(nWritten);
+				return (e == EINVAL) ? eRESULT::incomplete : eRESULT::error;
 			}
 		}
 
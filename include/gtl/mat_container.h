@@ -0,0 +1,144 @@
+﻿#pragma once
+
+//////////////////////////////////////////////////////////////////////
+//
+// mat_container.h: chunked, compressed cv::Mat block and multi-mat container file
+//
+// PWH
+// 2026.10.17.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "gtl/_lib_gtl.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include "opencv2/core.hpp"
+
+namespace gtl {
+	#pragma pack(push, 8)
+
+	/// @brief type read from file (or stream) is one of CV_MAKETYPE(depth, cn). (flag bits, negative or out of range values are not)
+	inline bool IsValidMatType(int type) {
+		return (type >= 0) and (type <= CV_MAT_TYPE_MASK);
+	}
+
+	enum class eMAT_CODEC : uint8_t {
+		none,
+		rle,		// run length (binary masks)
+		lz,			// LZ77 (LZ4 block style. fast)
+	};
+
+	struct sMatCodecOption {
+		eMAT_CODEC codec{eMAT_CODEC::lz};
+		bool bChecksum{true};				// CRC-32C per chunk
+		size_t nChunkSize{256*1024};		// bytes of rows per chunk (approx.)
+	};
+
+	//-----------------------------------------------------------------------------
+	// mat block : sMatBlockHeader, sMatChunk[nChunk], encoded chunks
+	//
+	// rows are split into chunks, encoded / decoded in parallel.
+	// the sign is length prefixed as the old "mat" format ({3, 'm', 'a', 't'}), ReadMat() reads both.
+	//
+	struct sMatBlockHeader {
+		constexpr static inline char const s_magic[8] = "\x07gtlmat";
+		constexpr static inline uint32_t s_version = 1;
+
+		char magic[8];
+		uint32_t version;
+		int32_t rows, cols, type;
+		int32_t rowsPerChunk;
+		uint32_t nChunk;
+		uint64_t sizeData;			// bytes of encoded chunks (after chunk table)
+		eMAT_CODEC codec;
+		uint8_t bChecksum;
+		uint8_t reserved[6];
+	};
+	struct sMatChunk {
+		uint32_t sizeEncoded;
+		uint32_t crc;				// CRC-32C of decoded rows (0 if !bChecksum)
+		eMAT_CODEC codec;			// none, if not compressible
+		uint8_t reserved[3];
+	};
+	static_assert(sizeof(sMatBlockHeader) == 48);
+	static_assert(sizeof(sMatChunk) == 12);
+
+	/// @brief writes mat as a block of chunks. (2 dims only)
+	GTL__API bool WriteMatBlock(std::ostream& os, cv::Mat const& mat, sMatCodecOption const& option = {});
+	/// @brief reads mat block. false if broken (checksum, size mismatch, ...)
+	GTL__API bool ReadMatBlock(std::istream& is, cv::Mat& mat);
+
+	namespace internal {
+		GTL__API uint32_t Crc32C(uint32_t crc, uint8_t const* data, size_t size);
+		/// @return size encoded. 0 if dst is not enough
+		GTL__API size_t EncodeRLE(uint8_t const* src, size_t size, uint8_t* dst, size_t sizeDst);
+		/// @return false if src is broken or doesn't fill dst exactly
+		GTL__API bool DecodeRLE(uint8_t const* src, size_t size, uint8_t* dst, size_t sizeDst);
+		/// @return size encoded. 0 if dst is not enough
+		GTL__API size_t EncodeLZ(uint8_t const* src, size_t size, uint8_t* dst, size_t sizeDst);
+		/// @return false if src is broken or doesn't fill dst exactly
+		GTL__API bool DecodeLZ(uint8_t const* src, size_t size, uint8_t* dst, size_t sizeDst);
+	}
+
+
+	//---------------------------------------------------------------------------------------------------------------------------------
+	// CMatContainerFile : many cv::Mat (ex, inspection crops) in a file, random access by index.
+	//
+	// file : sHeader, mat blocks, index (uint64_t offset of each block)
+	// index is written on Flush() / Close(). if not (ex, crashed while adding), blocks are scanned on Open().
+	//
+	class GTL__CLASS CMatContainerFile {
+	public:
+		constexpr static inline char const s_magic[8] = "GTLMATS";
+		constexpr static inline uint32_t s_version = 1;
+
+		struct sHeader {
+			char magic[8];
+			uint32_t version;
+			uint32_t reserved;
+			uint64_t offsetIndex;		// 0 : no index
+			uint64_t nMat;
+		};
+
+	protected:
+		mutable std::mutex m_mtx;
+		mutable std::fstream m_file;
+		bool m_bReadOnly{};
+		sHeader m_header{};
+		sMatCodecOption m_option;
+		std::vector<uint64_t> m_index;	// offset of each block
+		uint64_t m_offsetEnd{};			// end of last block
+		bool m_bIndexDirty{};
+
+	public:
+		CMatContainerFile() = default;
+		CMatContainerFile(CMatContainerFile const&) = delete;
+		~CMatContainerFile() { Close(); }
+
+		bool Create(std::filesystem::path const& path, sMatCodecOption const& option = {});
+		/// @brief opens existing file. mats can be added if !bReadOnly.
+		bool Open(std::filesystem::path const& path, bool bReadOnly = true, sMatCodecOption const& option = {});
+		void Close();
+		bool IsOpen() const { std::scoped_lock lock(m_mtx); return m_file.is_open(); }
+		/// @brief writes index
+		bool Flush();
+
+		size_t size() const { std::scoped_lock lock(m_mtx); return m_index.size(); }
+		bool empty() const { return size() == 0; }
+
+		/// @brief appends mat (encoded in caller's thread, then written). index of it is size()-1
+		bool Add(cv::Mat const& mat);
+		/// @brief empty if failed.
+		cv::Mat Get(size_t index) const;
+		bool Get(size_t index, cv::Mat& mat) const;
+
+	protected:
+		bool WriteHeader();
+	};
+
+	#pragma pack(pop)
+}
@@ -15,6 +15,7 @@
 #include "gtl/coord.h"
 #include "gtl/archive.h"
 #include "gtl/misc.h"
+#include "gtl/mat_container.h"
 #include "opencv2/opencv.hpp"
 
 namespace gtl {
@@ -63,7 +64,11 @@ namespace gtl {
 	}
 #endif
 
+	/// @brief reads mat block (mat_container.h) or old "mat" format
 	static inline bool ReadMat(std::istream& is, cv::Mat& mat) {
+		if (is.peek() == sMatBlockHeader::s_magic[0])
+			return ReadMatBlock(is, mat);
+
 		auto ReadVar = [&is, &mat](auto& var) -> bool {
 			return (bool)is.read((char*)&var, sizeof(var));
 		};
@@ -88,7 +93,7 @@ namespace gtl {
 			if (!ReadVar(cols)) break;
 			if (!ReadVar(type)) break;
 
-			if ( (rows < 0) || (cols < 0) )
+			if ( (rows < 0) || (cols < 0) || !IsValidMatType(type) )
 				break;
 			if ( (rows == 0) || (cols == 0) ) {
 				mat.release();
@@ -108,7 +113,12 @@ namespace gtl {
 
 		return false;
 	}
-	static inline bool SaveMat(std::ostream& os, cv::Mat const& mat) {
+	/// @brief writes mat block (chunked, compressed. mat_container.h)
+	static inline bool SaveMat(std::ostream& os, cv::Mat const& mat, sMatCodecOption const& option = {}) {
+		return WriteMatBlock(os, mat, option);
+	}
+	/// @brief old "mat" format (raw rows), for readers not updated yet
+	static inline bool SaveMatLegacy(std::ostream& os, cv::Mat const& mat) {
 		uint8_t buf[4] = { 3, 'm', 'a', 't' };
 		os.write((char const*)buf, sizeof(buf));
 		os.write((char const*)&mat.rows, sizeof(mat.rows));
@@ -182,6 +192,9 @@ namespace gtl {
 	GTL__API bool ResizeImage(cv::Mat const& imgSrc, cv::Mat& imgDest, double dScale, int eInterpolation = cv::INTER_LINEAR/*, int eScaleDownMethod = cv::INTER_AREA*/);
 	GTL__API bool MatchTemplate(cv::Mat const& img, cv::Mat const& imgTempl, cv::Mat& matResult, int method);
 	GTL__API bool MatchTemplate(cv::Mat const& img, cv::Mat const& imgTempl, int method, xPoint2d& ptBest, double& dMinMax, double& dRate, double dScale = 0.0, int eInterpolation = cv::INTER_LINEAR);
+	/// @brief Mat header on the same data as img, reference counted. owner (ex, memory-mapped file) is released when the last Mat (including ROIs) is released.
+	/// img may be on user memory (no reference count).
+	GTL__API cv::Mat AttachMatOwner(cv::Mat const& img, std::shared_ptr<void const> owner);
 
 	//-----------------------------------------------------------------------------
 	// Mat to DC
@@ -365,6 +378,22 @@ namespace gtl {
 
 	GTL__API bool CopyMatToXY(cv::Mat const& src, cv::Mat& dest, gtl::xPoint2i ptDestTopLeft, cv::Mat const* pMask = nullptr);
 
+	/// @brief Make cv::remap maps (CV_32FC1) : mapX(x, y), mapY(x, y) = ctDestToSource(x, y)
+	/// @param ctDestToSource : transform from dest(output) pixel to source pixel. (usually, inverse of source->dest CT)
+	/// @param sizeDest : size of output image
+	/// @param nGridStep : 0 or 1 : evaluate every pixel. >1 : evaluate every nGridStep pixels and bilinear-interpolate between them (for smooth transforms only)
+	/// @param nThread : 0 : std::thread::hardware_concurrency()
+	/// @return false if size is empty.
+	GTL__API bool MakeRemapMaps(ICoordTrans const& ctDestToSource, cv::Size const& sizeDest, cv::Mat& mapX, cv::Mat& mapY, int nGridStep = 0, int nThread = 0);
+	struct sRemapMaps {
+		cv::Mat mapX, mapY;
+	};
+	inline sRemapMaps MakeRemapMaps(ICoordTrans const& ctDestToSource, cv::Size const& sizeDest, int nGridStep = 0, int nThread = 0) {
+		sRemapMaps result;
+		MakeRemapMaps(ctDestToSource, sizeDest, result.mapX, result.mapY, nGridStep, nThread);
+		return result;
+	}
+
 
 	inline bool IsImageExtension(std::filesystem::path const& path) {
 		auto ext = gtl::ToLower<char>(path.extension().string());
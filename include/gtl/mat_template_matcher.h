@@ -0,0 +1,61 @@
+﻿#pragma once
+
+//////////////////////////////////////////////////////////////////////
+//
+// mat_template_matcher.h: coarse-to-fine (pyramid) template matching
+//
+// PWH
+// 2026.10.17.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "gtl/mat_helper.h"
+
+namespace gtl {
+	#pragma pack(push, 8)
+
+
+	//---------------------------------------------------------------------------------------------------------------------------------
+	// CTemplateMatcher : searches templates on image pyramid.
+	//
+	// matchTemplate on the coarsest level, then each peak is refined in a small ROI of the finer levels down to the original.
+	// image pyramid is made once (SetImage) and shared by all templates. (Match() is const, can be called from many threads)
+	//
+	class GTL__CLASS CTemplateMatcher {
+	public:
+		struct sOption {
+			int method{cv::TM_CCOEFF_NORMED};
+			int nLevel{-1};					// pyramid level to start search. -1 : auto (template is not reduced below nMinTemplateSize)
+			int nMinTemplateSize{16};
+			int nMaxPeak{1};
+			double dMinScore{0.5};			// see sResult::dScore
+			double dMinPeakDistance{0.5};	// ratio of template size. peaks closer are suppressed.
+			int nRefineMargin{1};			// margin (pixel) of searching ROI, on each finer level
+			bool bSubPixel{true};			// quadratic fit on the peak
+		};
+		struct sResult {
+			xPoint2d pt;		// center of template (as MatchTemplate())
+			double dScore;		// higher is better. (value of cv::matchTemplate. TM_SQDIFF_NORMED : 1 - value, TM_SQDIFF : -value)
+		};
+
+	protected:
+		std::vector<cv::Mat> m_pyramid;	// [0] : original image
+
+	public:
+		CTemplateMatcher() = default;
+		explicit CTemplateMatcher(cv::Mat const& img, int nMaxLevel = 4) { SetImage(img, nMaxLevel); }
+
+		/// @brief makes image pyramid (cv::pyrDown) up to nMaxLevel
+		void SetImage(cv::Mat const& img, int nMaxLevel = 4);
+		cv::Mat GetImage() const { return m_pyramid.empty() ? cv::Mat{} : m_pyramid.front(); }
+		int GetMaxLevel() const { return (int)m_pyramid.size() - 1; }
+
+		/// @brief peaks sorted by score. (at most option.nMaxPeak)
+		std::vector<sResult> Match(cv::Mat const& imgTempl, sOption const& option = {}) const;
+		/// @brief many templates on the image, in parallel.
+		std::vector<std::vector<sResult>> Match(std::span<cv::Mat const> templs, sOption const& option = {}) const;
+	};
+
+
+	#pragma pack(pop)
+}
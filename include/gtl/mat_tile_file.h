@@ -0,0 +1,112 @@
+﻿#pragma once
+
+//////////////////////////////////////////////////////////////////////
+//
+// mat_tile_file.h: out-of-core tiled image on a memory-mapped container file
+//
+// PWH
+// 2026.10.17.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "gtl/2dMatArray.h"
+
+namespace gtl {
+	#pragma pack(push, 8)
+
+
+	//---------------------------------------------------------------------------------------------------------------------------------
+	// CMatTileFile : tiles (and their power of two pyramid levels) in a memory-mapped file.
+	//
+	// file : sHeader, flags (uint8_t per tile), tiles (fixed slot per tile. level 0 first, row major)
+	// tiles are paged in on demand (by OS), neighbors of last ROI are prefetched in background.
+	// views on the mapped file (GetTileView(), single tile ROI of GetResizedImage()) are read-only. write tiles by SetTile().
+	// (read-only file is mapped copy-on-write, so writing to a view changes neither the file nor crashes, but it is seen by other views)
+	//
+	class GTL__CLASS CMatTileFile : public IMatImage {
+	public:
+		constexpr static inline char const s_magic[8] = "GTLTILE";
+		constexpr static inline uint32_t s_version = 1;
+
+		struct sHeader {
+			char magic[8];
+			uint32_t version;
+			int32_t type;
+			int32_t width, height;
+			int32_t tileWidth, tileHeight;		// even numbers
+			int32_t nLevel;
+			uint32_t reserved;
+			uint64_t offsetFlags;
+			uint64_t offsetData;
+			uint64_t sizeSlot;					// bytes per tile (page aligned)
+		};
+		/// @brief bits of flag. quadrant (made from child tile of finer level). level 0 tile is written as whole.
+		enum fTILE : uint8_t { fTILE_Q0 = 1, fTILE_Q1 = 2, fTILE_Q2 = 4, fTILE_Q3 = 8, fTILE_ALL = 0x0f, };
+
+		struct sMapping;	// file mapping. (kept alive by tiles returned)
+
+	protected:
+		std::shared_ptr<sMapping> m_mapping;
+		sHeader m_header{};
+		bool m_bReadOnly{};
+		std::vector<cv::Size> m_sizeLevels;		// image size of each level
+		std::vector<cv::Size> m_nTiles;			// tile count of each level
+		std::vector<size_t> m_iTileBase;		// index of first tile of each level
+		std::mutex m_mtxWrite;
+
+		// prefetch
+		mutable std::mutex m_mtxPrefetch;
+		mutable std::condition_variable_any m_cvPrefetch;
+		mutable std::optional<std::pair<int, cv::Rect>> m_prefetch;	// level, tile range
+		std::jthread m_threadPrefetch;
+
+	public:
+		CMatTileFile() = default;
+		CMatTileFile(CMatTileFile const&) = delete;
+		~CMatTileFile() { Close(); }
+
+		/// @brief creates new container file. all tiles are empty (zero).
+		bool Create(std::filesystem::path const& path, cv::Size sizeImage, int type, cv::Size sizeTile = {1024, 1024}, int nLevel = 6);
+		bool Open(std::filesystem::path const& path, bool bReadOnly = true);
+		void Close();
+		bool IsOpen() const { return (bool)m_mapping; }
+		bool Flush();
+
+		/// @brief writes tile of level 0 (ex, as it arrives from camera). pyramid tiles covering it are updated if bUpdatePyramid.
+		/// img must be of the same type and the size of the tile at pos.
+		bool SetTile(xPoint2i const& pos, cv::Mat const& img, bool bUpdatePyramid = true);
+		/// @brief rebuilds all pyramid levels from level 0
+		bool UpdatePyramid();
+		bool IsTileReady(int iLevel, xPoint2i const& pos) const;
+		/// @brief copy of tile. empty if out of range.
+		cv::Mat GetTile(int iLevel, xPoint2i const& pos) const;
+		/// @brief read-only view of tile on the mapped file (no copy). kept alive after Close(). empty if out of range.
+		cv::Mat GetTileView(int iLevel, xPoint2i const& pos) const;
+
+		int GetLevelCount() const { return m_header.nLevel; }
+		cv::Size GetTileSize() const { return { m_header.tileWidth, m_header.tileHeight }; }
+		cv::Size GetTileCount(int iLevel = 0) const { return (iLevel >= 0 and iLevel < m_nTiles.size()) ? m_nTiles[iLevel] : cv::Size{}; }
+
+	public:
+		bool empty() const override		{ return !m_mapping; }
+		int depth() const override		{ return CV_MAT_DEPTH(m_header.type); }
+		int type() const override		{ return m_header.type; }
+		int channels() const override	{ return CV_MAT_CN(m_header.type); }
+		int GetWidth() const override	{ return m_header.width; }
+		int GetHeight() const override	{ return m_header.height; }
+
+		cv::Mat GetResizedImage(cv::Rect& rc, double dScale, int eScaleDownMethod = -1, int eScaleUpMethod = -1) const override;
+
+	protected:
+		bool Init(std::shared_ptr<sMapping> mapping, bool bReadOnly);
+		uint8_t* GetFlag(int iLevel, xPoint2i const& pos) const;
+		uint8_t GetFlagsExpected(int iLevel, xPoint2i const& pos) const;
+		/// @brief tile on the mapped file. (not kept alive. for writing tiles and internal use)
+		cv::Mat GetTileRaw(int iLevel, xPoint2i const& pos) const;
+		/// @brief makes quadrant of parent tile (iLevel+1) from tile at (iLevel, pos)
+		bool UpdateParent(int iLevel, xPoint2i const& pos);
+		void Prefetch(std::stop_token token);
+	};
+
+	#pragma pack(pop)
+}
@@ -53,6 +53,8 @@ namespace gtl::shape {
 	class ICanvas {
 	public:
 		xCoordTransChain m_ct, m_ctI;
+		/// @brief applied before m_ct. (block -> drawing, set by xBlockRef while drawing. m_ct is not rebuilt for each instance)
+		std::optional<xCoordTrans3d> m_ctLocal, m_ctLocalI;
 		point_t m_ptLast{};
 
 	public:
@@ -82,20 +84,21 @@ namespace gtl::shape {
 			m_target_interpolation_inverval = 1.0;
 		}
 
+		/// @brief m_ct, m_ctI are flattened (xCoordTransChain::Compile()) here, so drawing costs one matrix multiply per point for linear/perspective CTs.
 		void SetCT(ICoordTrans const& ct) {
 			if (auto* pCT = dynamic_cast<xCoordTransChain const*>(&ct); pCT) {
 				m_ct = *pCT;
-				m_ct.GetInv(m_ctI);
 			} else {
 				m_ct.clear();
 				m_ct *= ct;
-
 			}
+			m_ct.GetInv(m_ctI);
 		}
 
 		// Scratching
-		point_t Trans(point_t const& pt) const { return m_ct(pt); }
-		point_t TransI(point_t const& pt) const { return m_ctI(pt); }
+		point_t Trans(point_t const& pt) const { return m_ctLocal ? m_ct((*m_ctLocal)(pt)) : m_ct(pt); }
+		point_t TransI(point_t const& pt) const { return m_ctLocalI ? (*m_ctLocalI)(m_ctI(pt)) : m_ctI(pt); }
+		double TransLength(double dLength) const { return m_ct.Trans(m_ctLocal ? m_ctLocal->Trans(dLength) : dLength); }
 
 		virtual void MoveTo_Target(point_t const& ptTargetSystem) = 0;
 		virtual void LineTo_Target(point_t const& ptTargetSystem) = 0;
@@ -41,6 +41,7 @@
 #include "canvas.h"
 #include "shape_primitives.h"
 #include "shape_others.h"
+#include "shape_binary.h"
 
 //export module shape;
 
@@ -0,0 +1,174 @@
+﻿//////////////////////////////////////////////////////////////////////
+//
+// shape_binary.h: flat binary format of xDrawing (memory mapped)
+//
+// PWH
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+
+#include "boost/iostreams/device/mapped_file.hpp"
+
+#include "shape_primitives.h"
+#include "canvas.h"
+#include "shape_others.h"
+
+//export module shape;
+
+namespace gtl::shape {
+#pragma pack(push, 8)
+
+	/// @brief flat binary format of xDrawing.
+	/// file : sHeader, sSection[nSection], sections (8 bytes aligned).
+	/// geometries of dot, line, circle/arc/ellipse, polyline are stored as arrays per shape type, and drawn from mapped memory w/o creating xShape.
+	/// other shapes (text, spline, hatch, block_ref, or shapes w/ cookie) are stored in a boost archive section (extra) and created on Open().
+	namespace binary {
+
+		constexpr static std::array<char, 8> const s_magic{ 'G', 'T', 'L', 'S', 'H', 'P', 'B', '\0' };
+		constexpr static uint32_t const s_version = 1;
+
+		enum class eSECTION : uint32_t {
+			meta = 1,		// boost archive. vars, line types, boundary
+			strings,		// char_t[]
+			string_ranges,	// sRange[]
+			layers,			// sLayer[]
+			shapes,			// sShape[]
+			dots,			// point_t[]
+			line_pt0,		// point_t[]
+			line_pt1,		// point_t[]
+			arcs,			// sArc[]
+			poly_ranges,	// sRange[]
+			poly_points,	// polypoint_t[]
+			extra,			// boost archive. boost::ptr_deque<xShape>
+		};
+
+		struct sHeader {
+			std::array<char, 8> magic{s_magic};
+			uint32_t version{s_version};
+			uint32_t sizeof_char{sizeof(string_t::value_type)};
+			uint64_t nSection{};
+		};
+		struct sSection {
+			eSECTION eID{};
+			uint32_t reserved{};
+			uint64_t offset{};
+			uint64_t size{};	// in bytes
+		};
+		struct sRange {
+			uint64_t first{}, count{};
+		};
+
+		enum fSHAPE : uint32_t {
+			visible		= 1 << 0,
+			transparent	= 1 << 1,
+			loop		= 1 << 2,	// polyline
+			extra		= 1 << 3,	// index is of extra shapes
+		};
+		/// @brief common attributes of a shape
+		struct sShape {
+			eSHAPE eType{};
+			uint32_t flags{};
+			int32_t crIndex{};
+			uint32_t color{};
+			int32_t eLineType{};
+			int32_t lineWeight{};
+			uint32_t iLayer{};		// string index of m_strLayer
+			uint32_t iLineType{};	// string index of m_strLineType
+			uint64_t index{};		// index in array of its type
+		};
+		struct sLayer {
+			sShape attr;
+			uint32_t iName{};
+			int32_t flags{};
+			uint32_t bUse{};
+			uint32_t reserved{};
+			sRange shapes;			// in sShape[]
+		};
+		/// @brief circle, arc, ellipse
+		struct sArc {
+			point_t ptCenter;
+			double radius{}, radiusH{};
+			double angle_start{}, angle_length{}, angle_first_axis{};	// in degree
+		};
+
+		static_assert(std::is_trivially_copyable_v<point_t> and sizeof(point_t) == sizeof(double)*3);
+		static_assert(std::is_trivially_copyable_v<polypoint_t> and sizeof(polypoint_t) == sizeof(double)*4);
+	}
+
+	/// @brief read only view of flat binary drawing file (memory mapped).
+	class GTL__SHAPE_CLASS xDrawingBinaryView {
+	public:
+		xDrawingBinaryView();
+		xDrawingBinaryView(xDrawingBinaryView const&) = delete;
+		xDrawingBinaryView& operator = (xDrawingBinaryView const&) = delete;
+		~xDrawingBinaryView();
+
+		/// @brief writes xDrawing as flat binary file.
+		static bool Save(xDrawing const& drawing, std::filesystem::path const& path);
+
+		bool Open(std::filesystem::path const& path);
+		void Close();
+		bool IsOpen() const { return m_file.is_open(); }
+
+		/// @brief converts to object model (xDrawing)
+		bool ToDrawing(xDrawing& drawing) const;
+
+		void Draw(ICanvas& canvas) const;
+		/// @brief shapes are found by R-tree (built on the first call)
+		bool DrawROI(ICanvas& canvas, rect_t const& rectROI) const;
+
+		rect_t const& GetBoundary() const { return m_rectBoundary; }
+		size_t GetLayerCount() const { return m_layers.size(); }
+		size_t GetShapeCount() const { return m_shapes.size(); }
+		std::basic_string_view<string_t::value_type> GetString(uint32_t index) const;
+
+	protected:
+		/// @brief attributes for PreDraw(). strings (layer, line type) are copied only when their index changes.
+		struct sDrawAttr {
+			xDot shape;
+			uint32_t iLayer{(uint32_t)-1}, iLineType{(uint32_t)-1};
+		};
+		struct sSpatialIndex;
+
+		/// @param pRectROI : for extra shapes. (flat shapes are already tested by spatial index)
+		bool DrawShape(ICanvas& canvas, sDrawAttr& attr, binary::sShape const& shape, rect_t const* pRectROI) const;
+		void SetAttributes(xShape& shape, binary::sShape const& s) const;
+		void SetAttributes(sDrawAttr& attr, binary::sShape const& s) const;
+		/// @brief boundary of shape (not normalized). same test as xShape::DrawROI()
+		rect_t GetShapeBoundary(binary::sShape const& s) const;
+		sSpatialIndex const& GetSpatialIndex() const;
+
+	protected:
+		boost::iostreams::mapped_file_source m_file;
+
+		// from meta, extra
+		std::map<std::string, variable_t> m_vars;
+		boost::ptr_deque<line_type_t> m_line_types;
+		rect_t m_rectBoundary;
+		boost::ptr_deque<xShape> m_extras;
+
+		// mapped
+		std::span<string_t::value_type const> m_strings;
+		std::span<binary::sRange const> m_string_ranges;
+		std::span<binary::sLayer const> m_layers;
+		std::span<binary::sShape const> m_shapes;
+		std::span<point_t const> m_dots;
+		std::span<point_t const> m_line_pt0, m_line_pt1;
+		std::span<binary::sArc const> m_arcs;
+		std::span<binary::sRange const> m_poly_ranges;
+		std::span<polypoint_t const> m_poly_points;
+
+		// cache
+		mutable std::mutex m_mtxSpatialIndex;
+		mutable std::unique_ptr<sSpatialIndex> m_spatial_index;
+	};
+
+#pragma pack(pop)
+}
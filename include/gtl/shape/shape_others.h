@@ -53,6 +53,7 @@
 #include "shapes/spline.h"
 #include "shapes/text.h"
 #include "shapes/block.h"
+#include "shapes/block_ref.h"
 #include "shapes/drawing.h"
 
 //export module shape;
@@ -243,6 +244,36 @@ namespace gtl::shape {
 		}
 		virtual eSHAPE GetShapeType() const { return eSHAPE::insert; }
 
+		/// @brief block -> drawing, for (iCol, iRow) of the array
+		xCoordTrans3d GetBlockCT(point_t const& ptBlockBase, int iCol, int iRow) const {
+			xCoordTrans3d ct;
+			// todo : 순서 확인 (scale->rotate ? or rotate->scale ?)
+			if (m_xscale != 1.0) {
+				ct.m_mat(0, 0) *= m_xscale;
+				ct.m_mat(0, 1) *= m_xscale;
+				ct.m_mat(0, 2) *= m_xscale;
+			}
+			if (m_yscale != 1.0) {
+				ct.m_mat(1, 0) *= m_yscale;
+				ct.m_mat(1, 1) *= m_yscale;
+				ct.m_mat(1, 2) *= m_yscale;
+			}
+			if (m_zscale != 1.0) {
+				ct.m_mat(2, 0) *= m_zscale;
+				ct.m_mat(2, 1) *= m_zscale;
+				ct.m_mat(2, 2) *= m_zscale;
+			}
+
+			if (m_angle != 0.0_rad) {
+				ct.m_mat = ct.GetRotatingMatrixXY(m_angle) * ct.m_mat;
+			}
+
+			ct.m_origin = ptBlockBase;
+			ct.m_offset.x = iCol*m_spacingCol + m_pt.x;
+			ct.m_offset.y = iRow*m_spacingRow + m_pt.y;
+			return ct;
+		}
+
 		//virtual point_t PointAt(double t) const = 0;
 		virtual std::optional<std::pair<point_t, point_t>> GetStartEndPoint() const override { return {}; }
 		virtual void FlipX() override {}
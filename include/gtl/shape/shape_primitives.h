@@ -143,6 +143,7 @@ namespace gtl::shape {
 
 		layer = 127,
 		drawing = 128,
+		block_ref = 129,
 
 		user_defined_1 = 256,
 		user_defined_2,
@@ -224,6 +225,7 @@ namespace gtl::shape {
 	class GTL__SHAPE_CLASS xShape {
 	protected:
 		friend class xDrawing;
+		friend class xDrawingBinaryView;
 		mutable int m_crIndex{};		// 0 : byblock, 256 : bylayer, negative : layer is turned off (optional)
 	public:
 		mutable string_t m_strLayer;	// temporary value. (while loading from dxf)
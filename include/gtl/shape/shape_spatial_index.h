@@ -0,0 +1,53 @@
+﻿//////////////////////////////////////////////////////////////////////
+//
+// shape_spatial_index.h: bounding-box spatial index (R-tree) of shapes
+//
+// PWH
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "shape_primitives.h"
+
+//export module shape;
+
+namespace gtl::shape {
+#pragma pack(push, 8)
+
+	/// @brief bounding-box spatial index of shapes (packed R-tree + cached boundary of each shape).
+	/// cache only : not copied, not compared, not serialized.
+	/// built lazily on Query(). rebuilt if Invalidate() is called or the number of shapes changes.
+	class GTL__SHAPE_CLASS xShapeSpatialIndex {
+	public:
+		xShapeSpatialIndex();
+		xShapeSpatialIndex(xShapeSpatialIndex const&);
+		xShapeSpatialIndex& operator = (xShapeSpatialIndex const&);
+		~xShapeSpatialIndex();
+
+		bool operator == (xShapeSpatialIndex const&) const { return true; }
+		auto operator <=> (xShapeSpatialIndex const&) const { return std::strong_ordering::equal; }
+
+		void Invalidate();
+
+		/// @brief indices of shapes whose boundary intersects rectROI (same test as xShape::DrawROI()), in ascending order.
+		/// @return false if nothing intersects.
+		bool Query(boost::ptr_deque<xShape> const& shapes, rect_t const& rectROI, std::vector<size_t>& indices) const;
+
+		/// @brief union of all the shape boundaries.
+		rect_t GetBoundary(boost::ptr_deque<xShape> const& shapes) const;
+
+	protected:
+		struct sIndex;
+		sIndex const& Build(boost::ptr_deque<xShape> const& shapes) const;	// lock must be held
+
+		mutable std::mutex m_mtx;
+		mutable std::unique_ptr<sIndex> m_index;
+	};
+
+#pragma pack(pop)
+}
@@ -0,0 +1,117 @@
+﻿//////////////////////////////////////////////////////////////////////
+//
+// block_ref.h: instance of a block (shared, not cloned)
+//
+// PWH
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "../shape_primitives.h"
+#include "../canvas.h"
+#include "block.h"
+
+#include "boost/serialization/shared_ptr.hpp"
+
+//export module shape;
+
+namespace gtl::shape {
+#pragma pack(push, 8)
+
+	/// @brief instance of a block. the block is shared (not cloned) and placed by m_ct. (block -> drawing)
+	/// created from xInsert by xDrawing::LoadFromCADJson(j, true). Explode() for flattened copies.
+	class GTL__SHAPE_CLASS xBlockRef : public xShape {
+	public:
+		using base_t = xShape;
+		using this_t = xBlockRef;
+
+	public:
+		string_t m_name;	// block name
+		xCoordTrans3d m_ct;	// block -> drawing
+		std::shared_ptr<xBlock> m_block;	// shared by all instances. do not modify.
+
+		xBlockRef() = default;
+		xBlockRef(xBlockRef const&) = default;
+		xBlockRef(xBlockRef&&) = default;
+		xBlockRef(std::shared_ptr<xBlock> block, xCoordTrans3d const& ct) : m_ct(ct), m_block(std::move(block)) {
+			if (m_block)
+				m_name = m_block->m_name;
+			UpdateCT();
+		}
+
+		/// @brief call after m_ct is modified directly. (inverse is kept for drawing)
+		void UpdateCT() {
+			xCoordTrans3d ctI;
+			if (m_ct.GetInv(ctI))
+				m_ctI = ctI;
+			else
+				m_ctI.reset();
+			m_rectLocal.reset();
+		}
+		std::optional<xCoordTrans3d> const& GetInverseCT() const { return m_ctI; }
+
+		virtual bool Compare(xShape const& B_) const override {
+			if (!base_t::Compare(B_))
+				return false;
+			this_t const& B = (this_t const&)B_;
+			return true
+				and ( m_name	== B.m_name )
+				and ( m_ct		== B.m_ct )
+				and ( (m_block == B.m_block) or (m_block and B.m_block and m_block->Compare(*B.m_block)) )
+				;
+		}
+		virtual eSHAPE GetShapeType() const { return eSHAPE::block_ref; }
+
+		virtual std::optional<std::pair<point_t, point_t>> GetStartEndPoint() const override { return {}; }
+		virtual void FlipX() override { Transform(GetFlipCT(0), false); }
+		virtual void FlipY() override { Transform(GetFlipCT(1), false); }
+		virtual void FlipZ() override { Transform(GetFlipCT(2), false); }
+		virtual void Reverse() override {}
+		virtual void Transform(xCoordTrans3d const& ct, bool bRightHanded) override {
+			m_ct = ct * m_ct;
+			UpdateCT();
+		}
+		virtual bool UpdateBoundary(rect_t& rectBoundary) const override;
+		virtual void Draw(ICanvas& canvas) const override;
+		virtual bool DrawROI(ICanvas& canvas, rect_t const& rectROI) const override;
+		virtual void PrintOut(std::wostream& os) const override {
+			xShape::PrintOut(os);
+			fmt::print(os, L"\tblock:{}, scale:{}, offset:({},{},{})\n", m_name, m_ct.m_scale, m_ct.m_offset.x, m_ct.m_offset.y, m_ct.m_offset.z);
+		}
+
+		/// @brief flattened (cloned and transformed) copies of block shapes. nested block references are exploded, too.
+		boost::ptr_deque<xShape> Explode() const;
+
+		GTL__DYNAMIC_VIRTUAL_DERIVED(xBlockRef);
+		auto operator <=> (xBlockRef const&) const = default;
+
+		template < typename archive >
+		friend void serialize(archive& ar, xBlockRef& var, unsigned int const file_version) {
+			boost::serialization::base_object<xShape>(var);
+			ar & var;
+		}
+		template < typename archive >
+		friend archive& operator & (archive& ar, xBlockRef& var) {
+			ar & boost::serialization::base_object<xShape>(var);
+			ar & var.m_name & var.m_ct;
+			ar & var.m_block;	// shared. (tracked)
+			if constexpr (archive::is_loading())
+				var.UpdateCT();
+			return ar;
+		}
+
+	protected:
+		static xCoordTrans3d GetFlipCT(int axis) {
+			xCoordTrans3d ct;
+			ct.m_mat(axis, axis) = -1;
+			return ct;
+		}
+		std::optional<xCoordTrans3d> m_ctI;			// inverse of m_ct. nullopt if not invertible
+		mutable std::optional<rect_t> m_rectLocal;	// cache. boundary of block
+	};
+
+#pragma pack(pop)
+}
+
+BOOST_CLASS_EXPORT_GUID(gtl::shape::xBlockRef, "block_ref")
@@ -95,6 +95,18 @@ namespace gtl::shape {
 			}
 			return result;
 		}
+		/// @brief shapes whose boundary intersects rectROI. (uses spatial index of each layer)
+		std::vector<xShape const*> QueryROI(rect_t const& rectROI) const {
+			std::vector<xShape const*> shapes;
+			std::vector<size_t> indices;
+			for (auto const& layer : m_layers) {
+				if (!layer.QueryROI(rectROI, indices))
+					continue;
+				for (auto i : indices)
+					shapes.push_back(&layer.m_shapes[i]);
+			}
+			return shapes;
+		}
 		virtual void PrintOut(std::wostream& os) const override {
 			for (auto& layer : m_layers) {
 				layer.PrintOut(os);
@@ -166,9 +178,35 @@ namespace gtl::shape {
 		}
 
 		bool AddEntity(std::unique_ptr<xShape> rShape, std::map<string_t, xLayer*> const& mapLayers, std::map<string_t, xBlock*> const& mapBlocks, rect_t& rectBoundary);
+		/// @brief xInsert is added as xBlockRef(s) sharing the block, instead of flattened (cloned) block shapes.
+		bool AddEntity(std::unique_ptr<xShape> rShape, std::map<string_t, xLayer*> const& mapLayers, std::map<string_t, std::shared_ptr<xBlock>> const& mapBlocks, rect_t& rectBoundary);
+
+		/// @brief replaces xBlockRef with flattened shapes. (same result as LoadFromCADJson(j, false))
+		/// @return number of exploded block references
+		size_t ExplodeBlockRefs();
+
+	public:
+		virtual bool LoadFromCADJson(json_t& _j) override { return LoadFromCADJson(_j, false); }
+		/// @param bInstanceBlocks : if true, INSERTs are loaded as xBlockRef (blocks are shared, not cloned).
+		bool LoadFromCADJson(json_t& _j, bool bInstanceBlocks);
+		/// @brief loads CAD json file w/o building DOM of whole file. entities are parsed and created in parallel (in order).
+		/// @param nThread : 0 for number of CPU cores.
+		bool LoadFromCADJsonFile(std::filesystem::path const& path, bool bInstanceBlocks = false, int nThread = 0);
+
+	protected:
+		struct sLoadContext;
+		/// @brief header, line types, layers, blocks
+		bool LoadCADJsonTables(json_t& _j, sLoadContext& context);
+		bool AddEntity(std::unique_ptr<xShape> rShape, sLoadContext& context);
+
+		/// @brief ByLayer color, line weight
+		static void ResolveLayerAttributes(xShape& shape, xLayer const& layer);
+		/// @brief removes nested xInsert closing a cycle of blocks (A -> B -> A), which would recurse endlessly. (and leak shared blocks)
+		static void RemoveCyclicInserts(std::map<string_t, xBlock*> const& mapBlocks);
+		/// @brief resolves ByBlock/ByLayer attributes of block shapes in advance, and converts nested xInsert to xBlockRef.
+		static void PrepareInstanceBlock(xBlock& block, std::map<string_t, xLayer*> const& mapLayers, std::map<string_t, std::shared_ptr<xBlock>> const& mapBlocks);
 
 	public:
-		virtual bool LoadFromCADJson(json_t& _j) override;
 
 		void clear() {
 			m_vars.clear();
@@ -14,6 +14,7 @@
 
 #include "../shape_primitives.h"
 #include "../canvas.h"
+#include "../shape_spatial_index.h"
 
 //export module shape;
 
@@ -60,18 +61,20 @@ namespace gtl::shape {
 				return {};
 			return std::pair{r0->first, r1->second};
 		}
-		virtual void FlipX() override { for (auto& shape : m_shapes) shape.FlipX(); }
-		virtual void FlipY() override { for (auto& shape : m_shapes) shape.FlipY(); }
-		virtual void FlipZ() override { for (auto& shape : m_shapes) shape.FlipZ(); }
+		virtual void FlipX() override { for (auto& shape : m_shapes) shape.FlipX(); InvalidateSpatialIndex(); }
+		virtual void FlipY() override { for (auto& shape : m_shapes) shape.FlipY(); InvalidateSpatialIndex(); }
+		virtual void FlipZ() override { for (auto& shape : m_shapes) shape.FlipZ(); InvalidateSpatialIndex(); }
 		virtual void Reverse() override {
 			std::ranges::reverse(m_shapes.base());
 			for (auto& shape : m_shapes) {
 				shape.Reverse();
 			}
+			InvalidateSpatialIndex();
 		}
 		virtual void Transform(xCoordTrans3d const& ct, bool bRightHanded) override {
 			for (auto& shape : m_shapes)
 				shape.Transform(ct, bRightHanded);
+			InvalidateSpatialIndex();
 		}
 		virtual bool UpdateBoundary(rect_t& rect) const override {
 			bool r{};
@@ -86,12 +89,37 @@ namespace gtl::shape {
 			}
 		}
 		virtual bool DrawROI(ICanvas& canvas, rect_t const& rectROI) const override {
+			if (m_shapes.size() < s_nMinShapesForSpatialIndex) {
+				bool result{};
+				for (auto& shape : m_shapes) {
+					result |= shape.DrawROI(canvas, rectROI);
+				}
+				return result;
+			}
+
+			std::vector<size_t> indices;
+			if (!QueryROI(rectROI, indices))
+				return false;
 			bool result{};
-			for (auto& shape : m_shapes) {
-				result |= shape.DrawROI(canvas, rectROI);
+			for (auto i : indices) {
+				auto const& shape = m_shapes[i];
+				if (auto eType = shape.GetShapeType(); eType == eSHAPE::layer or eType == eSHAPE::block or eType == eSHAPE::block_ref) {
+					result |= shape.DrawROI(canvas, rectROI);
+				} else {
+					shape.Draw(canvas);
+					result = true;
+				}
 			}
 			return result;
 		}
+
+		/// @brief indices of shapes (ascending) whose boundary intersects rectROI. uses spatial index.
+		bool QueryROI(rect_t const& rectROI, std::vector<size_t>& indices) const {
+			return m_spatial_index.Query(m_shapes, rectROI, indices);
+		}
+		/// @brief spatial index is rebuilt automatically when number of shapes changes.
+		/// if shapes in m_shapes are modified (or replaced) directly, call this.
+		void InvalidateSpatialIndex() { m_spatial_index.Invalidate(); }
 		virtual void PrintOut(std::wostream& os) const override {
 			xShape::PrintOut(os);
 			for (auto& shape : m_shapes) {
@@ -133,6 +161,7 @@ namespace gtl::shape {
 
 		void clear() {
 			m_shapes.clear();
+			InvalidateSpatialIndex();
 			m_strLineType.clear();
 			m_flags = {};
 			m_bUse = true;
@@ -140,6 +169,13 @@ namespace gtl::shape {
 		}
 
 		virtual void Sort_Loop();
+		/// @brief reorder (and reverse) shapes to minimize total jump distance. Sort_Loop() and then 2-opt improvement.
+		/// shapes without end points are moved to back.
+		/// @param dMinJumpLength jumps shorter than this are not counted. (see ICanvas::m_min_jump_length)
+		/// @return total jump distance
+		double Sort_Path(double dMinJumpLength = 0.0, int nMaxPass = 8);
+		/// @brief sum of distances from end point of a shape to start point of next shape.
+		double GetJumpLength(double dMinJumpLength = 0.0) const;
 		bool IsLoop(double dMinGap = 1.e-3) const;
 
 		inline static bool RemoveConnectedComponents(std::deque<xShape const*>& shapes, xShape const* pSeed, double const dMinDistance = 0.000'1) {
@@ -178,9 +214,14 @@ namespace gtl::shape {
 			return true;
 		}
 
+		/// @brief DrawROI() uses spatial index if number of shapes is not less than this.
+		constexpr static size_t s_nMinShapesForSpatialIndex = 256;
+
 	protected:
 		friend class xDrawing;
+		friend class xDrawingBinaryView;
 		line_type_t* pLineType{};
+		xShapeSpatialIndex m_spatial_index;
 
 	};
 
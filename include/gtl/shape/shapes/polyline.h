@@ -76,6 +76,8 @@ namespace gtl::shape {
 		};
 		virtual bool UpdateBoundary(rect_t& rectBoundary) const override {
 			bool bModified{};
+			if (m_pts.empty())
+				return bModified;
 
 			auto nPt = m_pts.size();
 			if (!m_bLoop)
@@ -94,6 +96,8 @@ namespace gtl::shape {
 			return bModified;
 		};
 		virtual void Draw(ICanvas& canvas) const override;
+		/// @brief draws poly points (bulge as arc). no PreDraw().
+		static void DrawPolyPoints(ICanvas& canvas, std::span<polypoint_t const> pts, bool bLoop);
 		virtual void PrintOut(std::wostream& os) const override {
 			xShape::PrintOut(os);
 			fmt::print(os, L"\t{}", m_bLoop ? L"loop ":L"");
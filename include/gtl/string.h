@@ -26,6 +26,7 @@
 #include "concepts.h"
 #include "string/string_primitives.h"
 #include "string/convert_codepage.h"
+#include "string/stream_transcoder.h"
 #include "string/string_misc.h"
 #include "string/string_to_arithmetic.h"
 
@@ -0,0 +1,27 @@
+﻿#pragma once
+//=========
+//Automatically Generated File.
+//
+//        PWH.
+//
+//=========
+
+
+#include <cstdint>
+#include <array>
+
+#include "gtl/_lib_gtl.h"
+
+namespace gtl::charset {
+#pragma pack(push, 8)
+
+	// MBCS -> UTF16. 0 : not defined
+
+	GTL__DATA extern std::array<char16_t, 0x80> const tblCP1250toUTF16_g;	// [byte - 0x80]
+	GTL__DATA extern std::array<char16_t, 0x80> const tblCP1251toUTF16_g;	// [byte - 0x80]
+	GTL__DATA extern std::array<char16_t, 0x80> const tblCP1252toUTF16_g;	// [byte - 0x80]
+	constexpr inline uint8_t const CP949_LEAD_FIRST = 0x81, CP949_LEAD_LAST = 0xfe, CP949_TRAIL_FIRST = 0x41, CP949_TRAIL_LAST = 0xfe;
+	GTL__DATA extern std::array<char16_t, 126*190> const tblCP949toUTF16_g;	// [(lead - LEAD_FIRST) * 190 + (trail - TRAIL_FIRST)]
+
+#pragma pack(pop)
+}	// namespace gtl::charset
@@ -14,6 +14,7 @@
 #define GTL__HEADER__STRING_CONVERT_CODEPAGE
 
 #include <experimental/generator>
+#include <span>
 
 #include "gtl/_config.h"
 #include "gtl/concepts.h"
@@ -21,6 +22,7 @@
 #include "gtl/iconv_wrapper.h"
 #include "gtl/string/string_primitives.h"
 #include "gtl/string/utf_char_view.h"
+#include "gtl/string/utf_transcode.h"
 
 namespace gtl {
 #pragma pack(push, 8)
@@ -205,6 +207,33 @@ namespace gtl {
 	template < bool bCOUNT_FIRST = true> std::string	ConvWide2MBCS(std::wstring_view svFrom, S_CODEPAGE_OPTION codepage);
 	template < bool bCOUNT_FIRST = true> std::wstring	ConvMBCS2Wide(std::string_view svFrom, S_CODEPAGE_OPTION codepage);
 
+	/// @brief MBCS -> utf, directly into buffer (no allocation). by table only (CP949, CP1250~1252. see IsTableCodepage())
+	/// @param buffer : svFrom.size() * internal::mbcs_to_utf_max_expansion<tchar_to> is enough.
+	/// @return units written. nullopt if codepage has no table, svFrom has a char not in table, or buffer is too small.
+	template < gtlc::string_elem_utf tchar_to >
+	std::optional<size_t> ConvMBCS2UTF(std::string_view svFrom, std::span<tchar_to> buffer, S_CODEPAGE_OPTION codepage = {}) {
+		using utf_t = gtlc::as_utf_t<tchar_to>;
+		if ( (codepage.To<tchar_to>() != eCODEPAGE_DEFAULT<tchar_to>) or !internal::IsTableCodepage((int)codepage.From<char>()) )
+			return {};
+		auto r = internal::TranscodeMBCS((int)codepage.From<char>(), svFrom.data(), svFrom.size(), (utf_t*)buffer.data(), buffer.size());
+		if (r.nRead != svFrom.size())
+			return {};
+		return r.nWritten;
+	}
+	/// @brief utf -> MBCS, directly into buffer (no allocation). by table only (CP949, CP1250~1252. see IsTableCodepage())
+	/// @param buffer : svFrom.size() * internal::utf_to_mbcs_max_expansion<tchar_from> is enough.
+	/// @return bytes written. nullopt if codepage has no table, svFrom has a char not in table (or invalid), or buffer is too small.
+	template < gtlc::string_elem_utf tchar_from >
+	std::optional<size_t> ConvUTF2MBCS(std::basic_string_view<tchar_from> svFrom, std::span<char> buffer, S_CODEPAGE_OPTION codepage = {}) {
+		using utf_t = gtlc::as_utf_t<tchar_from>;
+		if ( (codepage.From<tchar_from>() != eCODEPAGE_DEFAULT<tchar_from>) or !internal::IsTableCodepage((int)codepage.To<char>()) )
+			return {};
+		auto r = internal::TranscodeMBCS((int)codepage.To<char>(), (utf_t const*)svFrom.data(), svFrom.size(), buffer.data(), buffer.size());
+		if (r.nRead != svFrom.size())
+			return {};
+		return r.nWritten;
+	}
+
 
 	/// @brief Converts Codepage To StringA (MBCS)
 	template < bool bCOUNT_FIRST = true> inline std::string		ToStringA(std::string_view svFrom, S_CODEPAGE_OPTION codepage = {});
@@ -241,31 +270,54 @@ namespace gtl {
 	template < bool bCOUNT_FIRST = true> inline std::u32string	ToStringU32(std::u16string_view svFrom, S_CODEPAGE_OPTION codepage = {});
 	template < bool bCOUNT_FIRST = true> inline std::u32string	ToStringU32(std::u32string_view svFrom, S_CODEPAGE_OPTION codepage = {});
 
+	/// @brief validates utf-8 (strict : no overlong, surrogate, > U+10FFFF) and counts its length as utf-16/utf-32, in one pass
+	inline sUTF8Validation ValidateUTF8String(std::u8string_view sv) {
+		return internal::ValidateUTF8(sv.data(), sv.size());
+	}
+	inline sUTF8Validation ValidateUTF8String(std::string_view sv) {
+		return internal::ValidateUTF8((char8_t const*)sv.data(), sv.size());
+	}
+
+	/// @param pOutputBufferCount : number of code points (utf-32 length)
 	inline bool IsUTF8String(std::string_view sv, size_t* pOutputBufferCount = nullptr, bool* pbIsMSBSet = nullptr) {
+		auto const r = ValidateUTF8String(sv);
 		if (pOutputBufferCount)
-			*pOutputBufferCount = 0;
+			*pOutputBufferCount = r.bValid ? r.nUTF32 : 0;
 		if (pbIsMSBSet)
-			*pbIsMSBSet = false;
-
-		size_t nOutputLen = 0;
-		auto const* pos = sv.data();
-		auto const* const end = sv.data() + sv.size();
-		while (pos < end) {
-			if (!gtl::internal::UTFCharConverter<char32_t, char8_t, false, true, false>((char8_t const*&)pos, (char8_t const*)end, nOutputLen))
-				return false;
-		}
-
-		if (pOutputBufferCount)
-			*pOutputBufferCount = nOutputLen;
-		if (pbIsMSBSet && (nOutputLen != sv.size()))
-			*pbIsMSBSet = true;
-
-		return true;
+			*pbIsMSBSet = r.bValid and r.bMSBSet;
+		return r.bValid;
 	}
 
 
 	namespace internal {
 
+		/// @brief MBCS -> utf by table, without intermediate wide string. nullopt if not possible. (caller falls back to system / iconv conversion)
+		template < gtlc::string_elem_utf tchar_to >
+		std::optional<std::basic_string<tchar_to>> ConvMBCS2UTFByTable(std::string_view svFrom, S_CODEPAGE_OPTION codepage) {
+			if (!IsTableCodepage((int)codepage.From<char>()))
+				return {};
+			std::basic_string<tchar_to> str;
+			str.resize(svFrom.size() * mbcs_to_utf_max_expansion<gtlc::as_utf_t<tchar_to>>);
+			auto n = ConvMBCS2UTF<tchar_to>(svFrom, str, codepage);
+			if (!n)
+				return {};
+			str.resize(*n);
+			return str;
+		}
+		/// @brief utf -> MBCS by table, without intermediate wide string. nullopt if not possible. (caller falls back to system / iconv conversion)
+		template < gtlc::string_elem_utf tchar_from >
+		std::optional<std::string> ConvUTF2MBCSByTable(std::basic_string_view<tchar_from> svFrom, S_CODEPAGE_OPTION codepage) {
+			if (!IsTableCodepage((int)codepage.To<char>()))
+				return {};
+			std::string str;
+			str.resize(svFrom.size() * utf_to_mbcs_max_expansion<gtlc::as_utf_t<tchar_from>>);
+			auto n = ConvUTF2MBCS<tchar_from>(svFrom, str, codepage);
+			if (!n)
+				return {};
+			str.resize(*n);
+			return str;
+		}
+
 		/// @brief static type cast (wide string/string_view) -> char16_t/char32_t string/string_vew. (according to its size), NO code conversion.
 		/// @tparam tchar 
 		/// @param str : basic_string or basic_string_view. (or whatever )
@@ -328,6 +380,8 @@ namespace gtl {
 	}
 	template < bool bCOUNT_FIRST >
 	std::string ToStringA(std::u8string_view svFrom, S_CODEPAGE_OPTION codepage) {
+		if (auto str = internal::ConvUTF2MBCSByTable(svFrom, codepage))
+			return std::move(*str);
 		auto str = ToUTFString<wchar_t, char8_t, false>(svFrom, { .from = codepage.from });
 		return ConvWide2MBCS<bCOUNT_FIRST>(str, { .to = codepage.to });
 	}
@@ -337,6 +391,8 @@ namespace gtl {
 			return ConvWide2MBCS<bCOUNT_FIRST>((std::wstring_view&)svFrom, codepage);
 		}
 		else {
+			if (auto str = internal::ConvUTF2MBCSByTable(svFrom, codepage))
+				return std::move(*str);
 			auto str = ToUTFString<wchar_t, char16_t, false>(svFrom, {.from = codepage.from});
 			return ConvWide2MBCS<bCOUNT_FIRST>(str, {.to = codepage.to});
 		}
@@ -347,6 +403,8 @@ namespace gtl {
 			return ConvWide2MBCS<bCOUNT_FIRST>((std::wstring_view&)svFrom, codepage);
 		}
 		else {
+			if (auto str = internal::ConvUTF2MBCSByTable(svFrom, codepage))
+				return std::move(*str);
 			auto str = ToUTFString<wchar_t, char32_t, false>(svFrom, { .from = codepage.from });
 			return ConvWide2MBCS<bCOUNT_FIRST>(str, { .to = codepage.to });
 		}
@@ -363,6 +421,8 @@ namespace gtl {
 	/// @brief Converts Codepage To utf-8
 	template < bool bCOUNT_FIRST >
 	std::u8string ToStringU8(std::string_view svFrom, S_CODEPAGE_OPTION codepage) {
+		if (auto str = internal::ConvMBCS2UTFByTable<char8_t>(svFrom, codepage))
+			return std::move(*str);
 		auto str = ConvMBCS2Wide(svFrom, { .from = codepage.from });
 		return ToUTFString<char8_t, wchar_t, bCOUNT_FIRST>(str, { .to = codepage.to });
 	}
@@ -392,6 +452,8 @@ namespace gtl {
 			return (std::u16string&)ConvMBCS2Wide<bCOUNT_FIRST>(svFrom, codepage);
 		}
 		else {
+			if (auto str = internal::ConvMBCS2UTFByTable<char16_t>(svFrom, codepage))
+				return std::move(*str);
 			auto str = ConvMBCS2Wide<false>(svFrom, {.from = codepage.from});
 			return ToUTFString<char16_t, wchar_t, bCOUNT_FIRST>(str, {.to = codepage.to});
 		}
@@ -423,6 +485,8 @@ namespace gtl {
 	/// @brief Converts Codepage To utf-32
 	template < bool bCOUNT_FIRST >
 	std::u32string ToStringU32(std::string_view svFrom, S_CODEPAGE_OPTION codepage) {
+		if (auto str = internal::ConvMBCS2UTFByTable<char32_t>(svFrom, codepage))
+			return std::move(*str);
 		auto str = ConvMBCS2Wide<false>(svFrom, { .from = codepage.from });
 		return ToUTFString<char32_t, wchar_t, bCOUNT_FIRST>(str, { .to = codepage.to });
 	}
@@ -524,6 +588,53 @@ namespace gtl {
 		auto strOther = internal::CheckAndConvertEndian(svFrom, codepage.from);
 		if (strOther) { [[unlikely]] svFrom = strOther.value(); } //svFrom = strOther.value_or(svFrom);
 
+		// SIMD engine (runtime only)
+		using utf_from_t = gtlc::as_utf_t<tchar_from>;
+		using utf_to_t = gtlc::as_utf_t<tchar_to>;
+		if constexpr (!std::is_same_v<utf_from_t, utf_to_t>) {
+			if (!std::is_constant_evaluated()) {
+				auto const* pos = svFrom.data();
+				auto const* const end = svFrom.data() + svFrom.size();
+				// sized once. (grows only if count first and not strict chars need more)
+				str.resize(bCOUNT_FIRST ? internal::CountUTF<utf_to_t>((utf_from_t const*)pos, svFrom.size()) : svFrom.size() * internal::utf_max_expansion<utf_to_t, utf_from_t>);
+				size_t nWritten{};
+				// per char converter writes at nWritten
+				struct xOutput {
+					tchar_to* p;
+					void push_back(tchar_to c) { *p++ = c; }
+					xOutput& operator += (tchar_to c) { *p++ = c; return *this; }
+				};
+				constexpr size_t nCharMax = 4 / sizeof(utf_from_t);	// units of the longest strict char
+				auto IsStrictChar = [&](tchar_from const* pos) {
+					utf_to_t buf[4];
+					return internal::TranscodeUTF((utf_from_t const*)pos, std::min<size_t>(end - pos, nCharMax), buf, std::size(buf)).nRead > 0;
+				};
+				while (true) {
+					auto r = internal::TranscodeUTF((utf_from_t const*)pos, end - pos, (utf_to_t*)str.data() + nWritten, str.size() - nWritten);
+					nWritten += r.nWritten;
+					pos += r.nRead;
+					if (pos >= end)
+						break;
+					if (str.size() - nWritten < 4) {
+						// dst may be full (count first)
+						str.resize(std::max(str.size() * 2, nWritten + (end - pos) * internal::utf_max_expansion<utf_to_t, utf_from_t>));
+						continue;
+					}
+					// not strict (ex, overlong, CESU-8, unpaired surrogate) or invalid : per char converter (throws if invalid), up to the next strict char
+					do {
+						if (str.size() - nWritten < 4)
+							str.resize(std::max(str.size() * 2, nWritten + 4));
+						xOutput out{ str.data() + nWritten };
+						internal::UTFCharConverter<tchar_to, tchar_from, true, true, true>(pos, end, out);
+						nWritten = out.p - str.data();
+					} while ( (pos < end) and !IsStrictChar(pos) );
+				}
+				str.resize(nWritten);
+				internal::CheckAndConvertEndian(str, codepage.to);
+				return str;
+			}
+		}
+
 		// Count Converted-String Length
 		size_t nOutputLen = 0;
 		auto const* pos = svFrom.data();
@@ -571,6 +682,8 @@ namespace gtl {
 				return ConvWide2MBCS((std::wstring_view&)svFrom, codepage);
 			}
 			else {
+				if (auto str = internal::ConvUTF2MBCSByTable(svFrom, codepage))
+					return std::move(*str);
 				return ConvWide2MBCS(
 							ToUTFString<wchar_t, tchar_from, false>(svFrom, {.from = codepage.from}),
 							{.to = codepage.to});
@@ -581,6 +694,8 @@ namespace gtl {
 				return (std::basic_string<tchar_to>&)ConvMBCS2Wide(svFrom, codepage);
 			}
 			else {
+				if (auto str = internal::ConvMBCS2UTFByTable<tchar_to>(svFrom, codepage))
+					return std::move(*str);
 				return ToUTFString<tchar_to, wchar_t, bCOUNT_FIRST>(
 							ConvMBCS2Wide(svFrom, {.from = codepage.from}),
 							{.to = codepage.to});
@@ -606,6 +721,8 @@ namespace gtl {
 #if (GTL__STRING_PRIMITIVES__WINDOWS_FRIENDLY) && defined(_WINDOWS)
 	template < bool bCOUNT_FIRST >
 	std::string ConvWide2MBCS(std::wstring_view svFrom, S_CODEPAGE_OPTION codepage) {
+		if (auto str = internal::ConvUTF2MBCSByTable(svFrom, codepage))
+			return std::move(*str);
 		std::string str;
 		if (svFrom.empty())
 			return str;
@@ -648,6 +765,8 @@ namespace gtl {
 	}
 	template < bool bCOUNT_FIRST >
 	std::wstring ConvMBCS2Wide(std::string_view svFrom, S_CODEPAGE_OPTION codepage) {
+		if (auto str = internal::ConvMBCS2UTFByTable<wchar_t>(svFrom, codepage))
+			return std::move(*str);
 		std::wstring str;
 		if (svFrom.empty())
 			return str;
@@ -685,6 +804,8 @@ namespace gtl {
 #else
 	template < bool bCOUNT_FIRST >
 	std::string ConvWide2MBCS(std::wstring_view svFrom, S_CODEPAGE_OPTION codepage) {
+		if (auto str = internal::ConvUTF2MBCSByTable(svFrom, codepage))
+			return std::move(*str);
 		codepage.from = codepage.From<wchar_t>();
 		codepage.to = codepage.To<char>();		// ..if codepage.to == 0 then codepage.to = DEFAULT Codepage
 		if (codepage.to == eCODEPAGE::UTF8) {
@@ -704,6 +825,8 @@ namespace gtl {
 	}
 	template < bool bCOUNT_FIRST >
 	std::wstring ConvMBCS2Wide(std::string_view svFrom, S_CODEPAGE_OPTION codepage) {
+		if (auto str = internal::ConvMBCS2UTFByTable<wchar_t>(svFrom, codepage))
+			return std::move(*str);
 		codepage.from = codepage.From<char>();
 		codepage.to = codepage.To<wchar_t>();		// ..if codepage.to == 0 then codepage.to = DEFAULT Codepage
 		if (codepage.from == eCODEPAGE::UTF8) {
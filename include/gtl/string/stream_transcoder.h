@@ -0,0 +1,344 @@
+﻿#pragma once
+
+//////////////////////////////////////////////////////////////////////
+//
+// stream_transcoder.h: chunk by chunk codepage conversion (large files, network)
+//
+// PWH
+// 2026.10.17.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "gtl/string/convert_codepage.h"
+#include "gtl/string/CodepageMap.h"
+
+namespace gtl {
+#pragma pack(push, 8)
+
+
+	//---------------------------------------------------------------------------------------------------------------------------------
+	// TStreamTranscoder : converts text given in chunks of bytes (any codepage) to utf (tchar_to).
+	//
+	// chunks can be split anywhere. incomplete sequence (multibyte char, code unit, surrogate pair) at the end of a chunk is carried to the next one.
+	// BOM at the start of stream selects the codepage, and is skipped.
+	// utf, table codepages (CP949, CP1250~1252) : block transcoders (utf_transcode.h). invalid sequence -> U+FFFD (GetErrorCount())
+	// others : iconv (Ticonv::ConvertChunk()). invalid sequence is discarded.
+	//
+	template < gtlc::string_elem_utf tchar_to >
+	class TStreamTranscoder {
+	public:
+		using string_t = std::basic_string<tchar_to>;
+		using utf_t = gtlc::as_utf_t<tchar_to>;
+
+	protected:
+		constexpr static size_t const s_nMaxCarry = 16;	// bytes. longer than any incomplete sequence
+
+		eCODEPAGE m_eCodepageDefault{};
+		eCODEPAGE m_eCodepage{};
+		bool m_bDetectBOM{};
+		bool m_bStarted{};				// BOM checked, converter is ready
+		std::string m_carry;			// bytes not converted yet
+		std::u16string m_units16;		// utf-16 source : aligned, host endian copy
+		std::u32string m_units32;		// utf-32 source : aligned, host endian copy
+		std::optional<Ticonv<tchar_to, char>> m_iconv;
+		size_t m_nError{};
+
+	public:
+		/// @param eCodepage : codepage of source. (DEFAULT : g_eCodepageMBCS)
+		/// @param bDetectBOM : BOM overrides eCodepage
+		explicit TStreamTranscoder(eCODEPAGE eCodepage = eCODEPAGE::DEFAULT, bool bDetectBOM = true)
+			: m_eCodepageDefault(eCodepage), m_eCodepage(eCodepage), m_bDetectBOM(bDetectBOM) {
+		}
+		TStreamTranscoder(TStreamTranscoder const&) = delete;
+		TStreamTranscoder& operator = (TStreamTranscoder const&) = delete;
+
+		/// @brief codepage of source. (after BOM is checked)
+		eCODEPAGE GetCodepage() const { return m_eCodepage; }
+		/// @brief number of invalid sequences replaced by U+FFFD
+		size_t GetErrorCount() const { return m_nError; }
+
+		/// @brief converts chunk and appends to strTo. (chunk can be split anywhere)
+		/// @return false if codepage is not supported.
+		bool Feed(std::string_view chunk, string_t& strTo) {
+			if (!m_bStarted) {
+				if ( m_bDetectBOM and (m_carry.size() + chunk.size() < 4) ) {
+					m_carry += chunk;
+					return true;
+				}
+				if (!Start(chunk))
+					return false;
+			}
+			if (!m_carry.empty()) {
+				// carried bytes + head of this chunk
+				size_t const nCarry = m_carry.size();
+				m_carry.append(chunk.data(), std::min(chunk.size(), s_nMaxCarry));
+				size_t const nUsed = Process(m_carry, strTo, false);
+				if (nUsed < nCarry) {	// still incomplete. (whole chunk is in m_carry)
+					m_carry.erase(0, nUsed);
+					return true;
+				}
+				chunk.remove_prefix(nUsed - nCarry);
+				m_carry.clear();
+			}
+			size_t const nUsed = Process(chunk, strTo, false);
+			m_carry.assign(chunk.substr(nUsed));
+			return true;
+		}
+
+		/// @brief end of stream. incomplete sequence left is replaced by U+FFFD. ready for a new stream.
+		/// @return false if codepage is not supported.
+		bool Finish(string_t& strTo) {
+			std::string_view empty;
+			bool bOK = m_bStarted or Start(empty);
+			if (bOK) {
+				Process(m_carry, strTo, true);
+				if (m_iconv and !m_iconv->Finish(strTo))
+					m_nError++;
+			}
+			m_carry.clear();
+			m_bStarted = false;
+			return bOK;
+		}
+
+		/// @brief converts whole stream. (for convenience, ex, a file in memory)
+		std::optional<string_t> Convert(std::string_view svFrom) {
+			string_t str;
+			if (!Feed(svFrom, str) or !Finish(str))
+				return {};
+			return str;
+		}
+
+	protected:
+		/// @brief checks BOM (m_carry + head of chunk), prepares converter.
+		bool Start(std::string_view& chunk) {
+			m_eCodepage = S_CODEPAGE_OPTION{ .from = m_eCodepageDefault }.From<char>();
+			if (m_bDetectBOM) {
+				constexpr static std::array<eCODEPAGE, 5> const codepages{{
+					eCODEPAGE::UTF8, eCODEPAGE::UTF32LE, eCODEPAGE::UTF16LE, eCODEPAGE::UTF16BE, eCODEPAGE::UTF32BE,	// UTF32LE must precede UTF16LE
+				}};
+				std::string const head = m_carry + std::string(chunk.substr(0, 4));
+				for (auto codepage : codepages) {
+					auto const bom = GetCodepageBOM(codepage);
+					if (!head.starts_with(bom))
+						continue;
+					m_eCodepage = codepage;
+					if (bom.size() >= m_carry.size()) {
+						chunk.remove_prefix(bom.size() - m_carry.size());
+						m_carry.clear();
+					}
+					else {
+						m_carry.erase(0, bom.size());
+					}
+					break;
+				}
+			}
+
+			m_iconv.reset();
+			switch (m_eCodepage) {
+				using enum eCODEPAGE;
+			case UTF8 : case UTF16LE : case UTF16BE : case UTF32LE : case UTF32BE :
+				break;
+			default :
+				if (internal::IsTableCodepage((int)m_eCodepage))
+					break;
+				m_iconv.emplace(nullptr, GetCodepageName(m_eCodepage));
+				if (!m_iconv->IsOpen()) {
+					m_iconv.reset();
+					return false;
+				}
+				m_iconv->SetDiscardIsseq(true);
+				break;
+			}
+			m_bStarted = true;
+			return true;
+		}
+
+		/// @brief converts bytes. invalid sequences are replaced.
+		/// @return bytes converted. (less than bytes.size() only if an incomplete sequence is at the end and !bFinal)
+		size_t Process(std::string_view bytes, string_t& strTo, bool bFinal) {
+			switch (m_eCodepage) {
+				using enum eCODEPAGE;
+			case UTF8 :
+				return ProcessUTF((char8_t const*)bytes.data(), bytes.size(), strTo, bFinal);
+			case UTF16LE : case UTF16BE :
+				return ProcessUnits(m_units16, bytes, m_eCodepage != UTF16, strTo, bFinal);
+			case UTF32LE : case UTF32BE :
+				return ProcessUnits(m_units32, bytes, m_eCodepage != UTF32, strTo, bFinal);
+			default :
+				break;
+			}
+			if (m_iconv) {
+				if (!m_iconv->ConvertChunk(std::string_view(bytes), strTo))
+					m_nError++;
+				return bytes.size();
+			}
+			return ProcessMBCS(bytes, strTo, bFinal);
+		}
+
+		template < typename tchar_unit >
+		size_t ProcessUnits(std::basic_string<tchar_unit>& units, std::string_view bytes, bool bSwap, string_t& strTo, bool bFinal) {
+			units.resize(bytes.size() / sizeof(tchar_unit));
+			std::memcpy(units.data(), bytes.data(), units.size() * sizeof(tchar_unit));
+			if (bSwap) {
+				for (auto& c : units)
+					c = GetByteSwap(c);
+			}
+			size_t n = ProcessUTF(units.data(), units.size(), strTo, bFinal) * sizeof(tchar_unit);
+			if (bFinal and (n < bytes.size())) {	// broken code unit
+				AppendReplacement(strTo);
+				n = bytes.size();
+			}
+			return n;
+		}
+
+		template < typename tchar_from >
+		size_t ProcessUTF(tchar_from const* src, size_t nSrc, string_t& strTo, bool bFinal) {
+			constexpr size_t nExpansion = internal::utf_max_expansion<utf_t, tchar_from>;
+			size_t pos{};
+			size_t nWritten = strTo.size();
+			while (pos < nSrc) {
+				EnsureRoom(strTo, nWritten, (nSrc - pos) * nExpansion);
+				auto const r = Transcode(src + pos, nSrc - pos, (utf_t*)strTo.data() + nWritten, strTo.size() - nWritten);
+				nWritten += r.nWritten;
+				pos += r.nRead;
+				if (pos >= nSrc)
+					break;
+				size_t const nSubpart = GetSubpartLength(src + pos, nSrc - pos);
+				if (!bFinal and IsIncomplete(src + pos, nSrc - pos, nSubpart))
+					break;
+				nWritten = WriteReplacement(strTo, nWritten);
+				pos += nSubpart;
+			}
+			strTo.resize(nWritten);
+			return pos;
+		}
+
+		size_t ProcessMBCS(std::string_view bytes, string_t& strTo, bool bFinal) {
+			int const codepage = (int)m_eCodepage;
+			size_t pos{};
+			size_t nWritten = strTo.size();
+			while (pos < bytes.size()) {
+				EnsureRoom(strTo, nWritten, (bytes.size() - pos) * internal::mbcs_to_utf_max_expansion<utf_t>);
+				auto const r = internal::TranscodeMBCS(codepage, bytes.data() + pos, bytes.size() - pos, (utf_t*)strTo.data() + nWritten, strTo.size() - nWritten);
+				nWritten += r.nWritten;
+				pos += r.nRead;
+				if (pos >= bytes.size())
+					break;
+				if (!bFinal and (bytes.size() - pos == 1))	// may be a lead byte
+					break;
+				nWritten = WriteReplacement(strTo, nWritten);
+				pos += IsDoubleByte(codepage, bytes.substr(pos)) ? 2 : 1;
+			}
+			strTo.resize(nWritten);
+			return pos;
+		}
+
+		/// @brief undefined double byte char is replaced as a whole. ascii trail byte is not (as WHATWG euc-kr decoder)
+		static bool IsDoubleByte(int codepage, std::string_view sv) {
+			using namespace gtl::charset;
+			if ( (codepage != (int)eCODEPAGE::KO_KR_949) or (sv.size() < 2) )
+				return false;
+			uint8_t const lead = sv[0], trail = sv[1];
+			return (lead >= CP949_LEAD_FIRST) and (lead <= CP949_LEAD_LAST) and (trail >= 0x80) and (trail <= CP949_TRAIL_LAST);
+		}
+
+		/// @brief valid prefix of utf (same type : copied)
+		template < typename tchar_from >
+		static internal::sUTFTranscodeResult Transcode(tchar_from const* src, size_t nSrc, utf_t* dst, size_t nDst) {
+			if constexpr (std::is_same_v<tchar_from, utf_t>) {
+				size_t n{};
+				if constexpr (sizeof(tchar_from) == 1) {
+					n = internal::ValidateUTF8(src, nSrc).posError;
+				}
+				else if constexpr (sizeof(tchar_from) == 2) {
+					for (; n < nSrc; n++) {
+						if ((src[n] & 0xf800) != 0xd800)
+							continue;
+						if ( (src[n] > 0xdbff) or (n + 1 >= nSrc) or ((src[n+1] & 0xfc00) != 0xdc00) )
+							break;
+						n++;
+					}
+				}
+				else {
+					while ( (n < nSrc) and (src[n] <= 0x10'ffff) and ((src[n] & 0xffff'f800) != 0xd800) )
+						n++;
+				}
+				std::copy_n(src, n, dst);
+				return { n, n };
+			}
+			else {
+				return internal::TranscodeUTF(src, nSrc, dst, nDst);
+			}
+		}
+
+		/// @brief length of the invalid (or incomplete) sequence at src, to be replaced by one U+FFFD. (maximal subpart)
+		static size_t GetSubpartLength(char8_t const* src, size_t nSrc) {
+			auto const [nLength, lo, hi] = GetUTF8SequenceInfo(src[0]);
+			size_t n = 1;
+			for (; (n < nLength) and (n < nSrc); n++) {
+				uint8_t const b = src[n];
+				if ( (n == 1) ? (b < lo or b > hi) : ((b & 0xc0) != 0x80) )
+					break;
+			}
+			return n;
+		}
+		static size_t GetSubpartLength(char16_t const*, size_t) { return 1; }
+		static size_t GetSubpartLength(char32_t const*, size_t) { return 1; }
+
+		static bool IsIncomplete(char8_t const* src, size_t nSrc, size_t nSubpart) {
+			return (nSubpart == nSrc) and (nSrc < std::get<0>(GetUTF8SequenceInfo(src[0])));
+		}
+		static bool IsIncomplete(char16_t const* src, size_t nSrc, size_t) {
+			return (nSrc == 1) and (src[0] >= 0xd800) and (src[0] <= 0xdbff);
+		}
+		static bool IsIncomplete(char32_t const*, size_t, size_t) { return false; }
+
+		/// @return length of sequence (0 if not a lead byte), range of 2nd byte
+		static std::tuple<size_t, uint8_t, uint8_t> GetUTF8SequenceInfo(uint8_t b0) {
+			if ( (b0 >= 0xc2) and (b0 <= 0xdf) )	return { 2, 0x80, 0xbf };
+			if (b0 == 0xe0)							return { 3, 0xa0, 0xbf };	// overlong
+			if (b0 == 0xed)							return { 3, 0x80, 0x9f };	// surrogate
+			if ( (b0 >= 0xe1) and (b0 <= 0xef) )	return { 3, 0x80, 0xbf };
+			if (b0 == 0xf0)							return { 4, 0x90, 0xbf };	// overlong
+			if ( (b0 >= 0xf1) and (b0 <= 0xf3) )	return { 4, 0x80, 0xbf };
+			if (b0 == 0xf4)							return { 4, 0x80, 0x8f };	// > U+10FFFF
+			return { 0, 0, 0 };
+		}
+
+		void AppendReplacement(string_t& strTo) {
+			m_nError++;
+			if constexpr (sizeof(utf_t) == 1) {
+				strTo.append({ (tchar_to)0xef, (tchar_to)0xbf, (tchar_to)0xbd });
+			}
+			else {
+				strTo.push_back((tchar_to)0xfffd);
+			}
+		}
+
+		/// @brief strTo is sized ahead, [0, nWritten) is the output. grows geometrically, so a run of invalid sequences stays linear.
+		static void EnsureRoom(string_t& strTo, size_t nWritten, size_t nRequired) {
+			if (strTo.size() - nWritten < nRequired)
+				strTo.resize(std::max(strTo.size() * 2, nWritten + nRequired));
+		}
+
+		/// @brief writes U+FFFD at nWritten. returns new nWritten
+		size_t WriteReplacement(string_t& strTo, size_t nWritten) {
+			m_nError++;
+			if constexpr (sizeof(utf_t) == 1) {
+				EnsureRoom(strTo, nWritten, 3);
+				strTo[nWritten++] = (tchar_to)0xef;
+				strTo[nWritten++] = (tchar_to)0xbf;
+				strTo[nWritten++] = (tchar_to)0xbd;
+			}
+			else {
+				EnsureRoom(strTo, nWritten, 1);
+				strTo[nWritten++] = (tchar_to)0xfffd;
+			}
+			return nWritten;
+		}
+
+	};
+
+
+#pragma pack(pop)
+}
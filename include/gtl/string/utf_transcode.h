@@ -0,0 +1,109 @@
+﻿#pragma once
+
+//////////////////////////////////////////////////////////////////////
+//
+// utf_transcode.h: UTF-8/16/32 transcoding by blocks (SIMD), MBCS <-> UTF by tables
+//
+// PWH
+// 2026.10.17.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "gtl/_lib_gtl.h"
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace gtl {
+#pragma pack(push, 8)
+
+	/// @brief result of ValidateUTF8String()
+	struct sUTF8Validation {
+		bool bValid{};
+		bool bMSBSet{};			// non-ascii in valid part
+		size_t posError{};		// start of the first invalid (or truncated) sequence. size of input if valid
+		size_t nUTF16{};		// length of valid part as utf-16
+		size_t nUTF32{};		// length of valid part as utf-32 (number of code points)
+	};
+
+#pragma pack(pop)
+}
+
+namespace gtl::internal {
+#pragma pack(push, 8)
+
+	//-----------------------------------------------------------------------------
+	// AVX2 (as compiled. /arch:AVX2) kernels : validated chunks, ascii blocks, 4 code points by shuffle table. scalar for the rest.
+	//
+	// strict : overlong, surrogate code point (utf-8, utf-32), > U+10FFFF, unpaired surrogate (utf-16) are invalid.
+	// stops at the first invalid sequence or if dst is full. (ToUTFString() hands the rest to the per-char converter)
+	//
+
+	struct sUTFTranscodeResult {
+		size_t nRead{};			// units of src converted
+		size_t nWritten{};		// units written to dst
+	};
+
+	GTL__API sUTFTranscodeResult TranscodeUTF(char8_t const* src, size_t nSrc, char16_t* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeUTF(char8_t const* src, size_t nSrc, char32_t* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeUTF(char16_t const* src, size_t nSrc, char8_t* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeUTF(char16_t const* src, size_t nSrc, char32_t* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeUTF(char32_t const* src, size_t nSrc, char8_t* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeUTF(char32_t const* src, size_t nSrc, char16_t* dst, size_t nDst);
+
+	/// @brief strict utf-8 validation (as TranscodeUTF) and length as utf-16/utf-32, in one pass
+	GTL__API sUTF8Validation ValidateUTF8(char8_t const* src, size_t nSrc);
+
+	/// @brief length of transcoded string. (exact if src is valid)
+	GTL__API size_t CountUTF16(char8_t const* src, size_t nSrc);
+	GTL__API size_t CountUTF32(char8_t const* src, size_t nSrc);
+	GTL__API size_t CountUTF8(char16_t const* src, size_t nSrc);
+	GTL__API size_t CountUTF32(char16_t const* src, size_t nSrc);
+	GTL__API size_t CountUTF8(char32_t const* src, size_t nSrc);
+	GTL__API size_t CountUTF16(char32_t const* src, size_t nSrc);
+
+	template < typename tchar_to, typename tchar_from >
+	size_t CountUTF(tchar_from const* src, size_t nSrc) {
+		if constexpr (std::is_same_v<tchar_to, char8_t>)
+			return CountUTF8(src, nSrc);
+		else if constexpr (std::is_same_v<tchar_to, char16_t>)
+			return CountUTF16(src, nSrc);
+		else if constexpr (std::is_same_v<tchar_to, char32_t>)
+			return CountUTF32(src, nSrc);
+		else
+			static_assert(!std::is_same_v<tchar_to, tchar_to>);
+	}
+
+	/// @brief max units of tchar_to for a unit of tchar_from
+	template < typename tchar_to, typename tchar_from >
+	constexpr inline size_t const utf_max_expansion = (sizeof(tchar_from) == 1) ? 1
+		: (sizeof(tchar_from) == 2) ? ((sizeof(tchar_to) == 1) ? 3 : 1)
+		: ((sizeof(tchar_to) == 1) ? 4 : (sizeof(tchar_to) == 2) ? 2 : 1);
+
+
+	//-----------------------------------------------------------------------------
+	// MBCS <-> UTF by tables (CodepageMap.h) : CP949, CP1250, CP1251, CP1252
+	//
+	// single pass, no intermediate wide string.
+	// stops at a char not in table (not defined, invalid, truncated) or if dst is full. (callers fall back to system / iconv conversion)
+	//
+
+	/// @brief codepage can be converted by table. (0 (DEFAULT) : active ANSI codepage)
+	GTL__API bool IsTableCodepage(int codepage);
+
+	GTL__API sUTFTranscodeResult TranscodeMBCS(int codepage, char const* src, size_t nSrc, char8_t* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeMBCS(int codepage, char const* src, size_t nSrc, char16_t* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeMBCS(int codepage, char const* src, size_t nSrc, char32_t* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeMBCS(int codepage, char8_t const* src, size_t nSrc, char* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeMBCS(int codepage, char16_t const* src, size_t nSrc, char* dst, size_t nDst);
+	GTL__API sUTFTranscodeResult TranscodeMBCS(int codepage, char32_t const* src, size_t nSrc, char* dst, size_t nDst);
+
+	/// @brief max units of utf for a byte of MBCS (all chars in tables are in BMP)
+	template < typename tchar_utf >
+	constexpr inline size_t const mbcs_to_utf_max_expansion = (sizeof(tchar_utf) == 1) ? 3 : 1;
+	/// @brief max bytes of MBCS for a unit of utf
+	template < typename tchar_utf >
+	constexpr inline size_t const utf_to_mbcs_max_expansion = (sizeof(tchar_utf) == 1) ? 1 : 2;
+
+#pragma pack(pop)
+}
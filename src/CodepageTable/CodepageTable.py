@@ -0,0 +1,79 @@
+﻿import os
+
+# MBCS -> UTF16 tables (CodepageMap.h) for table driven conversion (gtl/string/utf_transcode.h)
+#   single byte : [byte - 0x80]
+#   double byte : [(lead - leadFirst) * nTrail + (trail - trailFirst)]
+#   0 : not defined in codepage (converted by system / iconv)
+
+pathOutH = 'CodepageMap.h'
+pathOutC = 'CodepageMapMBCS_UTF16.cpp'
+
+singleByteCodepages = [ 1250, 1251, 1252 ]
+doubleByteCodepages = [ (949, 0x81, 0xfe, 0x41, 0xfe) ]    # codepage, lead first, lead last, trail first, trail last
+
+strLineSeperator = '//------------------------------------------------------------------------------------------------\n'
+strGenerated = ('//=========\n'
+                '//Automatically Generated File.\n'
+                '//\n'
+                '//        PWH.\n'
+                '//\n'
+                '//=========\n')
+
+def Decode(b : bytes, codepage : int) -> int :
+    try :
+        c = b.decode('cp{}'.format(codepage))
+    except UnicodeDecodeError :
+        return 0
+    if (len(c) != 1) or (ord(c) > 0xffff) :
+        return 0
+    return ord(c)
+
+def WriteTable(f, name : str, values : list) :
+    f.write('\t' + strLineSeperator)
+    f.write('\tGTL__DATA std::array<char16_t, {}> const {} {{ {{\n'.format(len(values), name))
+    for i in range(0, len(values), 16) :
+        f.write('\t\t' + ' '.join('0x{:04x},'.format(v) for v in values[i:i+16]) + '\n')
+    f.write('\t} };\n\n')
+
+#=================
+# .h
+fOutHeader = open(pathOutH, mode='w', encoding='utf-8-sig')
+fOutHeader.write('#pragma once\n' + strGenerated + '\n\n'
+                 '#include <cstdint>\n'
+                 '#include <array>\n'
+                 '\n'
+                 '#include "gtl/_lib_gtl.h"\n\n'
+                 'namespace gtl::charset {\n'
+                 '#pragma pack(push, 8)\n'
+                 '\n'
+                 '\t// MBCS -> UTF16. 0 : not defined\n'
+                 '\n')
+for cp in singleByteCodepages :
+    fOutHeader.write('\tGTL__DATA extern std::array<char16_t, 0x80> const tblCP{}toUTF16_g;\t// [byte - 0x80]\n'.format(cp))
+for (cp, leadFirst, leadLast, trailFirst, trailLast) in doubleByteCodepages :
+    nLead, nTrail = leadLast - leadFirst + 1, trailLast - trailFirst + 1
+    fOutHeader.write('\tconstexpr inline uint8_t const CP{0}_LEAD_FIRST = 0x{1:02x}, CP{0}_LEAD_LAST = 0x{2:02x}, CP{0}_TRAIL_FIRST = 0x{3:02x}, CP{0}_TRAIL_LAST = 0x{4:02x};\n'
+                     .format(cp, leadFirst, leadLast, trailFirst, trailLast))
+    fOutHeader.write('\tGTL__DATA extern std::array<char16_t, {1}*{2}> const tblCP{0}toUTF16_g;\t// [(lead - LEAD_FIRST) * {2} + (trail - TRAIL_FIRST)]\n'
+                     .format(cp, nLead, nTrail))
+fOutHeader.write('\n'
+                 '#pragma pack(pop)\n'
+                 '}\t// namespace gtl::charset\n')
+fOutHeader.close()
+
+#=================
+# .cpp
+fOutImpl = open(pathOutC, mode='w', encoding='utf-8-sig')
+fOutImpl.write('#include "pch.h"\n\n' + strGenerated + '\n\n'
+               '#include "gtl/string/' + pathOutH + '"\n\n\n'
+               'namespace gtl::charset {\n\n\n')
+for cp in singleByteCodepages :
+    WriteTable(fOutImpl, 'tblCP{}toUTF16_g'.format(cp), [ Decode(bytes([b]), cp) for b in range(0x80, 0x100) ])
+for (cp, leadFirst, leadLast, trailFirst, trailLast) in doubleByteCodepages :
+    values = []
+    for lead in range(leadFirst, leadLast+1) :
+        for trail in range(trailFirst, trailLast+1) :
+            values.append(Decode(bytes([lead, trail]), cp))
+    WriteTable(fOutImpl, 'tblCP{}toUTF16_g'.format(cp), values)
+fOutImpl.write('\n}\t// namespace gtl::charset\n')
+fOutImpl.close()
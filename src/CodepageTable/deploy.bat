@@ -0,0 +1,2 @@
+copy CodepageMap*.cpp ..\gtl\
+copy CodepageMap.h ..\..\include\gtl\string\
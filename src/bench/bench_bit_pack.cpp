@@ -0,0 +1,104 @@
+﻿#include "benchmark/benchmark.h"
+
+#include "gtl/gtl.h"
+#include "gtl/bit_pack.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+namespace {
+
+	/// @brief one row of pattern image (random indices of nBPP)
+	std::vector<uint8_t> MakeRow(size_t nPixel, int nBPP) {
+		std::mt19937 engine(1);
+		std::uniform_int_distribution<int> dist(0, (1 << nBPP) - 1);
+		std::vector<uint8_t> row(nPixel);
+		for (auto& v : row)
+			v = (uint8_t)dist(engine);
+		return row;
+	}
+
+}
+
+// args : pixels per row, bpp, SIMD
+static void BitPack_Pack(benchmark::State& state) {
+	size_t const nPixel = state.range(0);
+	int const nBPP = (int)state.range(1);
+	bool const bSIMD = state.range(2) != 0;
+	auto src = MakeRow(nPixel, nBPP);
+	std::vector<uint8_t> packed((nPixel * nBPP + 7) / 8);
+	for (auto _ : state) {
+		gtl::PackBits(nBPP, src.data(), nPixel, packed.data(), bSIMD);
+		benchmark::DoNotOptimize(packed.data());
+	}
+	state.SetBytesProcessed(state.iterations() * nPixel);
+}
+
+static void BitPack_PackLUT(benchmark::State& state) {
+	size_t const nPixel = state.range(0);
+	int const nBPP = (int)state.range(1);
+	bool const bSIMD = state.range(2) != 0;
+	auto src = MakeRow(nPixel, 8);
+	std::vector<uint8_t> lut(256);
+	for (int i{}; i < 256; i++)
+		lut[i] = (uint8_t)(i >> (8 - nBPP));
+	std::vector<uint8_t> packed((nPixel * nBPP + 7) / 8);
+	for (auto _ : state) {
+		gtl::PackBitsLUT(nBPP, src.data(), nPixel, lut.data(), packed.data(), bSIMD);
+		benchmark::DoNotOptimize(packed.data());
+	}
+	state.SetBytesProcessed(state.iterations() * nPixel);
+}
+
+static void BitPack_Threshold(benchmark::State& state) {
+	size_t const nPixel = state.range(0);
+	bool const bSIMD = state.range(1) != 0;
+	auto src = MakeRow(nPixel, 8);
+	std::vector<uint8_t> packed((nPixel + 7) / 8);
+	for (auto _ : state) {
+		gtl::PackBitsThreshold(src.data(), nPixel, 128, packed.data(), bSIMD);
+		benchmark::DoNotOptimize(packed.data());
+	}
+	state.SetBytesProcessed(state.iterations() * nPixel);
+}
+
+static void BitPack_UnpackLUT(benchmark::State& state) {
+	size_t const nPixel = state.range(0);
+	int const nBPP = (int)state.range(1);
+	bool const bSIMD = state.range(2) != 0;
+	auto src = MakeRow(nPixel, nBPP);
+	std::vector<uint8_t> packed((nPixel * nBPP + 7) / 8);
+	gtl::PackBits(nBPP, src.data(), nPixel, packed.data());
+	std::vector<uint8_t> palette(1 << nBPP);
+	for (int i{}; i < palette.size(); i++)
+		palette[i] = (uint8_t)(i * 255 / (palette.size() - 1));
+	std::vector<uint8_t> dst(nPixel);
+	for (auto _ : state) {
+		gtl::UnpackBitsLUT(nBPP, packed.data(), nPixel, palette.data(), dst.data(), bSIMD);
+		benchmark::DoNotOptimize(dst.data());
+	}
+	state.SetBytesProcessed(state.iterations() * nPixel);
+}
+
+BENCHMARK(BitPack_Pack)->ArgsProduct({ {16'384}, {1, 2, 4}, {0, 1} });
+BENCHMARK(BitPack_PackLUT)->ArgsProduct({ {16'384}, {1, 4}, {0, 1} });
+BENCHMARK(BitPack_Threshold)->ArgsProduct({ {16'384}, {0, 1} });
+BENCHMARK(BitPack_UnpackLUT)->ArgsProduct({ {16'384}, {1, 2, 4, 8}, {0, 1} });
+
+// 1 bpp pattern file (unaligned width), SaveBitmapMat / LoadBitmapMat
+static void BitPack_PatternFile(benchmark::State& state) {
+	auto path = std::filesystem::temp_directory_path() / L"bench_bit_pack.bmp";
+	cv::Mat img(4'000, 16'001, CV_8UC1);
+	cv::randu(img, 0, 2);
+	img *= 255;
+	std::vector<gtl::color_bgra_t> palette(2);
+	palette[1].b = palette[1].g = palette[1].r = 255;
+	for (auto _ : state) {
+		gtl::SaveBitmapMat(path, img, 1, {}, palette);
+		auto [img2, pelsPerMeter] = gtl::LoadBitmapMat(path);
+		benchmark::DoNotOptimize(img2.data);
+	}
+	state.SetBytesProcessed(state.iterations() * img.total() * 2);
+	std::filesystem::remove(path);
+}
+BENCHMARK(BitPack_PatternFile)->Unit(benchmark::kMillisecond);
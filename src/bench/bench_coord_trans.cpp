@@ -0,0 +1,122 @@
+﻿#include "benchmark/benchmark.h"
+
+#include "gtl/gtl.h"
+#include "gtl/coord/coord_trans.h"
+#include "gtl/coord/coord_trans_perspective.h"
+#include "gtl/mat_helper.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+namespace {
+
+	std::vector<gtl::xPoint2d> MakePoints2d(size_t n) {
+		std::mt19937 engine(0);
+		std::uniform_real_distribution<double> dist(-1000., 1000.);
+		std::vector<gtl::xPoint2d> pts(n);
+		for (auto& pt : pts)
+			pt.Set(dist(engine), dist(engine));
+		return pts;
+	}
+
+	gtl::xCoordTransChain MakeChain() {
+		gtl::xCoordTrans2d ct0(1.001, gtl::xCoordTrans2d::GetRotatingMatrix(gtl::deg_t(1.0)), {10., 20.}, {-5., 3.});
+		gtl::xCoordTrans2d ct1(0.999, gtl::xCoordTrans2d::GetRotatingMatrix(gtl::deg_t(-2.0)), {}, {100., 100.});
+		gtl::xCoordTransP33 ct2(cv::Matx33d{1., 0.001, 0., /**/ 0., 1., 0., /**/ 1.e-6, 2.e-6, 1.});
+		gtl::xCoordTransChain chain;
+		chain *= ct0;
+		chain *= ct1;
+		chain *= ct2;
+		return chain;
+	}
+
+}
+
+static void CoordTrans_2d_PerPoint(benchmark::State& state) {
+	gtl::xCoordTrans2d ct0(1.001, gtl::xCoordTrans2d::GetRotatingMatrix(gtl::deg_t(1.0)), {10., 20.}, {-5., 3.});
+	gtl::ICoordTrans const& ct = ct0;
+	auto pts = MakePoints2d(state.range(0));
+	std::vector<gtl::xPoint2d> ptsTarget(pts.size());
+	for (auto _ : state) {
+		for (size_t i{}; i < pts.size(); i++)
+			ptsTarget[i] = ct(pts[i]);
+		benchmark::DoNotOptimize(ptsTarget.data());
+	}
+	state.SetItemsProcessed(state.iterations() * pts.size());
+}
+
+static void CoordTrans_2d_Batch(benchmark::State& state) {
+	gtl::xCoordTrans2d ct0(1.001, gtl::xCoordTrans2d::GetRotatingMatrix(gtl::deg_t(1.0)), {10., 20.}, {-5., 3.});
+	gtl::ICoordTrans const& ct = ct0;
+	auto pts = MakePoints2d(state.range(0));
+	std::vector<gtl::xPoint2d> ptsTarget(pts.size());
+	for (auto _ : state) {
+		ct.Trans(pts, ptsTarget);
+		benchmark::DoNotOptimize(ptsTarget.data());
+	}
+	state.SetItemsProcessed(state.iterations() * pts.size());
+}
+
+static void CoordTrans_Chain_PerPoint(benchmark::State& state) {
+	auto chain = MakeChain();
+	gtl::ICoordTrans const& ct = chain;
+	auto pts = MakePoints2d(state.range(0));
+	std::vector<gtl::xPoint2d> ptsTarget(pts.size());
+	for (auto _ : state) {
+		for (size_t i{}; i < pts.size(); i++)
+			ptsTarget[i] = ct(pts[i]);
+		benchmark::DoNotOptimize(ptsTarget.data());
+	}
+	state.SetItemsProcessed(state.iterations() * pts.size());
+}
+
+static void CoordTrans_Chain_Batch(benchmark::State& state) {
+	auto chain = MakeChain();
+	gtl::ICoordTrans const& ct = chain;
+	auto pts = MakePoints2d(state.range(0));
+	std::vector<gtl::xPoint2d> ptsTarget(pts.size());
+	for (auto _ : state) {
+		ct.Trans(pts, ptsTarget);
+		benchmark::DoNotOptimize(ptsTarget.data());
+	}
+	state.SetItemsProcessed(state.iterations() * pts.size());
+}
+
+BENCHMARK(CoordTrans_2d_PerPoint)->Arg(1'000)->Arg(1'000'000);
+BENCHMARK(CoordTrans_2d_Batch)->Arg(1'000)->Arg(1'000'000);
+BENCHMARK(CoordTrans_Chain_PerPoint)->Arg(1'000)->Arg(1'000'000);
+BENCHMARK(CoordTrans_Chain_Batch)->Arg(1'000)->Arg(1'000'000);
+
+static void RemapMaps_PerPixel(benchmark::State& state) {
+	auto chain = MakeChain();
+	gtl::ICoordTrans const& ct = chain;
+	cv::Size size((int)state.range(0), (int)state.range(0));
+	cv::Mat mapX(size, CV_32FC1), mapY(size, CV_32FC1);
+	for (auto _ : state) {
+		for (int y{}; y < size.height; y++) {
+			auto* px = mapX.ptr<float>(y);
+			auto* py = mapY.ptr<float>(y);
+			for (int x{}; x < size.width; x++) {
+				auto pt = ct(gtl::xPoint2d(x, y));
+				px[x] = (float)pt.x;
+				py[x] = (float)pt.y;
+			}
+		}
+		benchmark::DoNotOptimize(mapX.data);
+	}
+	state.SetItemsProcessed(state.iterations() * size.area());
+}
+
+static void RemapMaps_Make(benchmark::State& state) {
+	auto chain = MakeChain();
+	cv::Size size((int)state.range(0), (int)state.range(0));
+	cv::Mat mapX, mapY;
+	for (auto _ : state) {
+		gtl::MakeRemapMaps(chain, size, mapX, mapY, (int)state.range(1));
+		benchmark::DoNotOptimize(mapX.data);
+	}
+	state.SetItemsProcessed(state.iterations() * size.area());
+}
+
+BENCHMARK(RemapMaps_PerPixel)->Arg(4'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(RemapMaps_Make)->Args({4'000, 0})->Args({4'000, 16})->Unit(benchmark::kMillisecond);
@@ -0,0 +1,25 @@
+﻿#include "benchmark/benchmark.h"
+
+#include "gtl/gtl.h"
+#include "gtl/mat_helper.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+// 4K canvas, zoomed in. args : channels of image, zoom scale
+static void DrawPixelValue_4K(benchmark::State& state) {
+	int const nChannel = (int)state.range(0);
+	double const dScale = (double)state.range(1);
+	cv::Mat img(1'000, 1'000, CV_16UC(nChannel));
+	cv::randu(img, 0, 65535);
+	cv::Mat canvas(2'160, 3'840, CV_8UC3, cv::Scalar::all(64));
+	cv::Rect roi(100, 100, (int)std::ceil(canvas.cols / dScale), (int)std::ceil(canvas.rows / dScale));
+	gtl::xCoordTrans2d ct(dScale, gtl::xCoordTrans2d::mat_t::eye(), { roi.x, roi.y }, {});
+	for (auto _ : state) {
+		gtl::DrawPixelValue(canvas, img, roi, ct);
+		benchmark::DoNotOptimize(canvas.data);
+	}
+	state.SetItemsProcessed(state.iterations() * roi.area());
+}
+
+BENCHMARK(DrawPixelValue_4K)->ArgsProduct({ {1, 3}, {40, 80} })->Unit(benchmark::kMicrosecond);
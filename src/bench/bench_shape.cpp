@@ -0,0 +1,108 @@
+﻿#include "benchmark/benchmark.h"
+
+#include "gtl/gtl.h"
+#include "gtl/shape/shape.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+namespace {
+
+	/// @brief files in temp folder. removed at exit
+	struct xTempFiles {
+		std::map<int, std::filesystem::path> paths;
+		~xTempFiles() {
+			for (auto const& [key, path] : paths) {
+				std::error_code ec;
+				std::filesystem::remove(path, ec);
+			}
+		}
+	};
+
+	/// @brief test fixture (bridge.dxf.json), entities repeated nRepeat times.
+	std::filesystem::path const& GetScaledCADJson(int nRepeat) {
+		static xTempFiles files;
+		auto& path = files.paths[nRepeat];
+		if (!path.empty())
+			return path;
+
+		gtl::bjson jDXF;
+		jDXF.read(LR"xx(../test/shape_test/bridge.dxf.json)xx");
+		auto& jEntities = jDXF.json().as_object()["mainBlock"].as_array();
+		boost::json::array entities(jEntities);
+		for (int i = 1; i < nRepeat; i++)
+			jEntities.insert(jEntities.end(), entities.begin(), entities.end());
+
+		path = std::filesystem::temp_directory_path() / std::format(L"bench_bridge_x{}.dxf.json", nRepeat);
+		std::ofstream f(path, std::ios_base::binary);
+		f << boost::json::serialize(jDXF.json());
+		return path;
+	}
+
+}
+
+static void CADJson_LoadDOM(benchmark::State& state) {
+	auto const& path = GetScaledCADJson((int)state.range(0));
+	for (auto _ : state) {
+		gtl::bjson jDXF;
+		jDXF.read(path);
+		gtl::shape::xDrawing drawing;
+		drawing.LoadFromCADJson(jDXF.json());
+		benchmark::DoNotOptimize(drawing.m_layers.size());
+	}
+	state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(path));
+}
+
+static void CADJson_LoadFile(benchmark::State& state) {
+	auto const& path = GetScaledCADJson((int)state.range(0));
+	for (auto _ : state) {
+		gtl::shape::xDrawing drawing;
+		drawing.LoadFromCADJsonFile(path, false, (int)state.range(1));
+		benchmark::DoNotOptimize(drawing.m_layers.size());
+	}
+	state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(path));
+}
+
+BENCHMARK(CADJson_LoadDOM)->Arg(1'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(CADJson_LoadFile)->Args({1'000, 1})->Args({1'000, 0})->Unit(benchmark::kMillisecond);
+
+static void ShapeFile_LoadArchive(benchmark::State& state) {
+	gtl::shape::xDrawing drawing;
+	drawing.LoadFromCADJsonFile(GetScaledCADJson((int)state.range(0)));
+	auto path = std::filesystem::temp_directory_path() / L"bench_bridge.shape";
+	{
+		std::ofstream f(path, std::ios_base::binary);
+		boost::archive::text_oarchive oa(f);
+		oa & drawing;
+	}
+	for (auto _ : state) {
+		gtl::shape::xDrawing drawing2;
+		std::ifstream f(path, std::ios_base::binary);
+		boost::archive::text_iarchive ia(f);
+		ia & drawing2;
+		benchmark::DoNotOptimize(drawing2.m_layers.size());
+	}
+	std::filesystem::remove(path);
+}
+
+static void ShapeFile_LoadBinary(benchmark::State& state) {
+	gtl::shape::xDrawing drawing;
+	drawing.LoadFromCADJsonFile(GetScaledCADJson((int)state.range(0)));
+	auto path = std::filesystem::temp_directory_path() / L"bench_bridge.shapeb";
+	gtl::shape::xDrawingBinaryView::Save(drawing, path);
+	bool const bToDrawing = state.range(1) != 0;
+	for (auto _ : state) {
+		gtl::shape::xDrawingBinaryView view;
+		view.Open(path);
+		if (bToDrawing) {
+			gtl::shape::xDrawing drawing2;
+			view.ToDrawing(drawing2);
+			benchmark::DoNotOptimize(drawing2.m_layers.size());
+		}
+		benchmark::DoNotOptimize(view.GetShapeCount());
+	}
+	std::filesystem::remove(path);
+}
+
+BENCHMARK(ShapeFile_LoadArchive)->Arg(1'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(ShapeFile_LoadBinary)->Args({1'000, 0})->Args({1'000, 1})->Unit(benchmark::kMillisecond);
@@ -285,3 +285,315 @@ BENCHMARK(StringCodepageConv_WindowsAPI_UTF8_WIDE);
 
 //=====================================================================================================
 
+
+namespace {
+	/// @brief 0 : mixed (hangeul, ascii, emoji), 1 : ascii only, 2 : mixed with many NUL as C0 80 (modified utf-8). ~64kB
+	std::u8string const& GetLongTestString(int64_t index) {
+		static std::array<std::u8string, 3> const strs = [] {
+			std::array<std::u8string, 3> strs;
+			while (strs[0].size() < 64 * 1024)
+				strs[0] += TEXT_u8(TEST_SZ);
+			while (strs[1].size() < 64 * 1024)
+				strs[1] += u8"asdfasdfaskdfjaklsjgflak;sdfjaskl;dfjnvakls;dfnvja;slfvnlikasjf";
+			while (strs[2].size() < 64 * 1024) {
+				strs[2] += TEXT_u8(TEST_SZ);
+				strs[2] += u8"\xc0\x80";
+				strs[2] += u8"abc\xc0\x80\xc0\x80";
+			}
+			return strs;
+		}();
+		return strs[index];
+	}
+}
+
+static void StringCodepageConv_Long_U8toU16_CharConverter(benchmark::State& state) {
+	std::u8string_view svFrom { GetLongTestString(state.range(0)) };
+	for (auto _ : state) {
+		std::u16string str;
+		str.reserve(svFrom.size());
+		auto const* pos = svFrom.data();
+		auto const* const end = pos + svFrom.size();
+		while (pos < end) {
+			gtl::internal::UTFCharConverter<char16_t, char8_t, true, true, true>(pos, end, str);
+		}
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+
+static void StringCodepageConv_Long_U8toU16(benchmark::State& state) {
+	std::u8string_view svFrom { GetLongTestString(state.range(0)) };
+	for (auto _ : state) {
+		auto str = gtl::ToStringU16(svFrom);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+
+static void StringCodepageConv_Long_U8toU32(benchmark::State& state) {
+	std::u8string_view svFrom { GetLongTestString(state.range(0)) };
+	for (auto _ : state) {
+		auto str = gtl::ToStringU32(svFrom);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+
+static void StringCodepageConv_Long_U16toU8_CharConverter(benchmark::State& state) {
+	auto strFrom = gtl::ToStringU16(GetLongTestString(state.range(0)));
+	std::u16string_view svFrom { strFrom };
+	for (auto _ : state) {
+		std::u8string str;
+		str.reserve(svFrom.size() * 3);
+		auto const* pos = svFrom.data();
+		auto const* const end = pos + svFrom.size();
+		while (pos < end) {
+			gtl::internal::UTFCharConverter<char8_t, char16_t, true, true, true>(pos, end, str);
+		}
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size() * sizeof(char16_t));
+}
+
+static void StringCodepageConv_Long_U16toU8(benchmark::State& state) {
+	auto strFrom = gtl::ToStringU16(GetLongTestString(state.range(0)));
+	std::u16string_view svFrom { strFrom };
+	for (auto _ : state) {
+		auto str = gtl::ToStringU8(svFrom);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size() * sizeof(char16_t));
+}
+
+static void StringCodepageConv_Long_U32toU8(benchmark::State& state) {
+	auto strFrom = gtl::ToStringU32(GetLongTestString(state.range(0)));
+	std::u32string_view svFrom { strFrom };
+	for (auto _ : state) {
+		auto str = gtl::ToStringU8(svFrom);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size() * sizeof(char32_t));
+}
+
+BENCHMARK(StringCodepageConv_Long_U8toU16_CharConverter)->Arg(0)->Arg(1)->Arg(2);
+BENCHMARK(StringCodepageConv_Long_U8toU16)->Arg(0)->Arg(1)->Arg(2);
+BENCHMARK(StringCodepageConv_Long_U8toU32)->Arg(0)->Arg(1)->Arg(2);
+BENCHMARK(StringCodepageConv_Long_U16toU8_CharConverter)->Arg(0)->Arg(1);
+BENCHMARK(StringCodepageConv_Long_U16toU8)->Arg(0)->Arg(1);
+BENCHMARK(StringCodepageConv_Long_U32toU8)->Arg(0)->Arg(1);
+
+static void StringCodepageConv_Long_IsUTF8_CharConverter(benchmark::State& state) {
+	std::u8string_view sv { GetLongTestString(state.range(0)) };
+	for (auto _ : state) {
+		size_t nOutputLen{};
+		auto const* pos = sv.data();
+		auto const* const end = pos + sv.size();
+		bool bOK{true};
+		while (bOK and (pos < end)) {
+			bOK = gtl::internal::UTFCharConverter<char32_t, char8_t, false, true, false>(pos, end, nOutputLen);
+		}
+		benchmark::DoNotOptimize(nOutputLen);
+	}
+	state.SetBytesProcessed(state.iterations() * sv.size());
+}
+
+static void StringCodepageConv_Long_ValidateUTF8String(benchmark::State& state) {
+	std::u8string_view sv { GetLongTestString(state.range(0)) };
+	for (auto _ : state) {
+		auto r = gtl::ValidateUTF8String(sv);
+		benchmark::DoNotOptimize(r);
+	}
+	state.SetBytesProcessed(state.iterations() * sv.size());
+}
+
+BENCHMARK(StringCodepageConv_Long_IsUTF8_CharConverter)->Arg(0)->Arg(1);
+BENCHMARK(StringCodepageConv_Long_ValidateUTF8String)->Arg(0)->Arg(1);
+
+namespace {
+	/// @brief cp949 (hangeul, hanja, ascii). ~64kB
+	std::string const& GetLongTestStringCP949() {
+		static std::string const str = [] {
+			std::u16string strU;
+			while (strU.size() < 40 * 1024)
+				strU += u"가나다라마바사아자차카타파하긎긣꿳뎓뫓멙뻍 漢字 asdfasdf가나다라마adrg바sfdgdh사아자차카타dd파하 asdfasdfaskdfjaklsjgflak;sdfjaskl;dfjnvakls;";
+			return gtl::ToString_iconv<char>(std::u16string_view(strU), "CP949").value_or(""s);
+		}();
+		return str;
+	}
+}
+
+static void StringCodepageConv_Long_CP949toU16_WindowsAPI(benchmark::State& state) {
+	std::string_view svFrom { GetLongTestStringCP949() };
+	for (auto _ : state) {
+		std::wstring str(svFrom.size(), 0);
+		auto n = MultiByteToWideChar((int)gtl::eCODEPAGE::KO_KR_949, 0, svFrom.data(), (int)svFrom.size(), str.data(), (int)str.size());
+		str.resize(n);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+static void StringCodepageConv_Long_CP949toU16_iconv(benchmark::State& state) {
+	std::string_view svFrom { GetLongTestStringCP949() };
+	for (auto _ : state) {
+		auto str = gtl::ToString_iconv<char16_t, char, "", "CP949">(svFrom);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+static void StringCodepageConv_Long_CP949toU8_Wide(benchmark::State& state) {
+	std::string_view svFrom { GetLongTestStringCP949() };
+	for (auto _ : state) {
+		std::wstring strW(svFrom.size(), 0);
+		strW.resize(MultiByteToWideChar((int)gtl::eCODEPAGE::KO_KR_949, 0, svFrom.data(), (int)svFrom.size(), strW.data(), (int)strW.size()));
+		auto str = gtl::ToStringU8(strW);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+static void StringCodepageConv_Long_CP949toU8(benchmark::State& state) {
+	std::string_view svFrom { GetLongTestStringCP949() };
+	for (auto _ : state) {
+		auto str = gtl::ToStringU8(svFrom, {.from = gtl::eCODEPAGE::KO_KR_949});
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+static void StringCodepageConv_Long_CP949toU16(benchmark::State& state) {
+	std::string_view svFrom { GetLongTestStringCP949() };
+	for (auto _ : state) {
+		auto str = gtl::ToStringU16(svFrom, {.from = gtl::eCODEPAGE::KO_KR_949});
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+static void StringCodepageConv_Long_CP949toU16_Buffer(benchmark::State& state) {
+	std::string_view svFrom { GetLongTestStringCP949() };
+	std::vector<char16_t> buffer(svFrom.size());
+	for (auto _ : state) {
+		auto n = gtl::ConvMBCS2UTF<char16_t>(svFrom, buffer, {.from = gtl::eCODEPAGE::KO_KR_949});
+		benchmark::DoNotOptimize(n);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+static void StringCodepageConv_Long_U16toCP949_WindowsAPI(benchmark::State& state) {
+	auto strFrom = gtl::ToStringU16(GetLongTestStringCP949(), {.from = gtl::eCODEPAGE::KO_KR_949});
+	for (auto _ : state) {
+		std::string str(strFrom.size() * 2, 0);
+		auto n = WideCharToMultiByte((int)gtl::eCODEPAGE::KO_KR_949, 0, (wchar_t const*)strFrom.data(), (int)strFrom.size(), str.data(), (int)str.size(), nullptr, nullptr);
+		str.resize(n);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * strFrom.size() * sizeof(char16_t));
+}
+static void StringCodepageConv_Long_U16toCP949(benchmark::State& state) {
+	auto strFrom = gtl::ToStringU16(GetLongTestStringCP949(), {.from = gtl::eCODEPAGE::KO_KR_949});
+	for (auto _ : state) {
+		auto str = gtl::ToStringA(strFrom, {.to = gtl::eCODEPAGE::KO_KR_949});
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * strFrom.size() * sizeof(char16_t));
+}
+
+BENCHMARK(StringCodepageConv_Long_CP949toU16_WindowsAPI);
+BENCHMARK(StringCodepageConv_Long_CP949toU16_iconv);
+BENCHMARK(StringCodepageConv_Long_CP949toU8_Wide);
+BENCHMARK(StringCodepageConv_Long_CP949toU8);
+BENCHMARK(StringCodepageConv_Long_CP949toU16);
+BENCHMARK(StringCodepageConv_Long_CP949toU16_Buffer);
+BENCHMARK(StringCodepageConv_Long_U16toCP949_WindowsAPI);
+BENCHMARK(StringCodepageConv_Long_U16toCP949);
+
+static void StringCodepageConv_iconv_ConstructEachCall(benchmark::State& state) {
+	std::u8string_view svFrom { TEXT_u8(TEST_SZ) };
+	for (auto _ : state) {
+		gtl::Ticonv<char16_t, char8_t> conv;	// descriptor from xIconvPool
+		auto str = conv.Convert(svFrom);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+static void StringCodepageConv_iconv_OpenEachCall(benchmark::State& state) {
+	std::u8string_view svFrom { TEXT_u8(TEST_SZ) };
+	std::u16string str(svFrom.size(), 0);
+	for (auto _ : state) {
+		auto cd = iconv_open("UTF-16LE", "UTF-8");
+		char* src = (char*)svFrom.data();
+		char* out = (char*)str.data();
+		size_t nSrc = svFrom.size(), nOut = str.size() * sizeof(char16_t);
+		iconv(cd, &src, &nSrc, &out, &nOut);
+		iconv_close(cd);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+static void StringCodepageConv_iconv_ReuseBuffer(benchmark::State& state) {
+	std::u8string_view svFrom { GetLongTestString(state.range(0)) };
+	gtl::Ticonv<char16_t, char8_t> conv;
+	std::u16string str;
+	for (auto _ : state) {
+		conv.Convert(svFrom, str);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+static void StringCodepageConv_iconv_NewString(benchmark::State& state) {
+	std::u8string_view svFrom { GetLongTestString(state.range(0)) };
+	gtl::Ticonv<char16_t, char8_t> conv;
+	for (auto _ : state) {
+		auto str = conv.Convert(svFrom);
+		benchmark::DoNotOptimize(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+
+BENCHMARK(StringCodepageConv_iconv_ConstructEachCall);
+BENCHMARK(StringCodepageConv_iconv_OpenEachCall);
+BENCHMARK(StringCodepageConv_iconv_ReuseBuffer)->Arg(0)->Arg(1);
+BENCHMARK(StringCodepageConv_iconv_NewString)->Arg(0)->Arg(1);
+
+namespace {
+	/// @brief large stream (4MB) : 0 : utf-8, 1 : utf-16le (BOM), 2 : cp949, 3 : broken utf-8 (every other byte is invalid)
+	std::string const& GetStreamTestBytes(int64_t index) {
+		static std::array<std::string, 4> const streams = [] {
+			std::array<std::string, 4> streams;
+			auto const& str8 = GetLongTestString(0);
+			auto const str16 = gtl::ToStringU16(str8);
+			auto const& strA = GetLongTestStringCP949();
+			streams[1] = gtl::GetCodepageBOM(gtl::eCODEPAGE::UTF16LE);
+			while (streams[0].size() < 4 * 1024 * 1024) {
+				streams[0].append((char const*)str8.data(), str8.size());
+				streams[1].append((char const*)str16.data(), str16.size() * sizeof(char16_t));
+				streams[2] += strA;
+			}
+			while (streams[3].size() < 4 * 1024 * 1024) {
+				for (int c{0x80}; c < 0x100; c++) {
+					streams[3] += 'a';
+					streams[3] += (char)c;	// lone trail byte, or lead byte without trail
+				}
+			}
+			return streams;
+		}();
+		return streams[index];
+	}
+}
+
+template < typename tchar_to >
+static void StringCodepageConv_Stream(benchmark::State& state) {
+	using enum gtl::eCODEPAGE;
+	std::string_view svFrom { GetStreamTestBytes(state.range(0)) };
+	size_t const nChunk = 64 * 1024;
+	gtl::TStreamTranscoder<tchar_to> transcoder(state.range(0) == 2 ? KO_KR_949 : UTF8);
+	std::basic_string<tchar_to> str;
+	for (auto _ : state) {
+		for (size_t pos{}; pos < svFrom.size(); pos += nChunk) {
+			str.clear();	// output chunk is consumed (ex, written to file)
+			transcoder.Feed(svFrom.substr(pos, nChunk), str);
+			benchmark::DoNotOptimize(str);
+		}
+		transcoder.Finish(str);
+	}
+	state.SetBytesProcessed(state.iterations() * svFrom.size());
+}
+
+BENCHMARK(StringCodepageConv_Stream<char16_t>)->Arg(0)->Arg(2)->Arg(3);
+BENCHMARK(StringCodepageConv_Stream<char8_t>)->Arg(1)->Arg(2)->Arg(3);
@@ -0,0 +1,77 @@
+﻿#include "benchmark/benchmark.h"
+
+#include "gtl/gtl.h"
+#include "gtl/mat_template_matcher.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+namespace {
+
+	/// @brief blurred noise (textured, no repeated pattern) and templates cut from it
+	struct sScene {
+		cv::Mat img;
+		std::vector<cv::Mat> templs;
+
+		sScene(cv::Size size, int nTempl, int sizeTempl) {
+			img = cv::Mat(size, CV_8UC1);
+			cv::randu(img, 0, 256);
+			cv::GaussianBlur(img, img, cv::Size(0, 0), 2.0);
+			cv::normalize(img, img, 0, 255, cv::NORM_MINMAX);
+			std::mt19937 engine(1);
+			std::uniform_int_distribution<int> distX(0, size.width - sizeTempl), distY(0, size.height - sizeTempl);
+			for (int i{}; i < nTempl; i++)
+				templs.push_back(img(cv::Rect(distX(engine), distY(engine), sizeTempl, sizeTempl)).clone());
+		}
+	};
+	sScene const& GetScene() {
+		static sScene const scene({4'000, 3'000}, 24, 128);
+		return scene;
+	}
+
+}
+
+// gtl::MatchTemplate(), for each template
+static void TemplateMatcher_MatchTemplate(benchmark::State& state) {
+	auto const& scene = GetScene();
+	int const nTempl = (int)state.range(0);
+	for (auto _ : state) {
+		for (int i{}; i < nTempl; i++) {
+			gtl::xPoint2d pt;
+			double dMinMax{}, dRate{};
+			gtl::MatchTemplate(scene.img, scene.templs[i], cv::TM_CCOEFF_NORMED, pt, dMinMax, dRate);
+			benchmark::DoNotOptimize(pt);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * nTempl);
+}
+
+// CTemplateMatcher, one by one. (pyramid is made once)
+static void TemplateMatcher_Pyramid(benchmark::State& state) {
+	auto const& scene = GetScene();
+	int const nTempl = (int)state.range(0);
+	gtl::CTemplateMatcher matcher(scene.img);
+	for (auto _ : state) {
+		for (int i{}; i < nTempl; i++) {
+			auto results = matcher.Match(scene.templs[i]);
+			benchmark::DoNotOptimize(results.data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * nTempl);
+}
+
+// CTemplateMatcher, all templates at once (in parallel)
+static void TemplateMatcher_PyramidBatch(benchmark::State& state) {
+	auto const& scene = GetScene();
+	int const nTempl = (int)state.range(0);
+	gtl::CTemplateMatcher matcher(scene.img);
+	for (auto _ : state) {
+		auto results = matcher.Match(std::span(scene.templs.data(), nTempl));
+		benchmark::DoNotOptimize(results.data());
+	}
+	state.SetItemsProcessed(state.iterations() * nTempl);
+}
+
+BENCHMARK(TemplateMatcher_MatchTemplate)->Arg(1)->Arg(24)->Unit(benchmark::kMillisecond);
+BENCHMARK(TemplateMatcher_Pyramid)->Arg(1)->Arg(24)->Unit(benchmark::kMillisecond);
+BENCHMARK(TemplateMatcher_PyramidBatch)->Arg(24)->Unit(benchmark::kMillisecond);
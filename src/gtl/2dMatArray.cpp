@@ -24,6 +24,204 @@ namespace gtl {
 	//-----------------------------------------------------------------------------
 
 
+	//=============================================================================
+	// CThumbnailWorkerPool
+	//
+	static thread_local std::pair<CThumbnailWorkerPool const*, int> s_currentThumbnailWorker{ nullptr, -1 };
+
+	CThumbnailWorkerPool::CThumbnailWorkerPool(int nWorker) {
+		if (nWorker <= 0)
+			nWorker = std::max(1, (int)std::thread::hardware_concurrency());
+		for (int i = 0; i < nWorker; i++)
+			m_queues.emplace_back(std::make_unique<sQueue>());
+		for (int i = 0; i < nWorker; i++)
+			m_workers.emplace_back([this, i](std::stop_token token) { Worker(token, i); });
+	}
+	CThumbnailWorkerPool::~CThumbnailWorkerPool() {
+		for (auto& worker : m_workers)
+			worker.request_stop();
+		m_cv.notify_all();
+		m_workers.clear();
+	}
+
+	CThumbnailWorkerPool& CThumbnailWorkerPool::GetInstance() {
+		static CThumbnailWorkerPool pool;
+		return pool;
+	}
+
+	CThumbnailWorkerPool::P_JOB CThumbnailWorkerPool::Submit(void const* owner, int priority, std::function<void()> func) {
+		auto job = std::make_shared<sJob>();
+		job->owner = owner;
+		job->priority = priority;
+		job->seq = m_seq++;
+		job->tSubmitted = clock_t::now();
+		job->func = std::move(func);
+
+		// worker thread submits to its own queue. others, round robin
+		size_t iQueue = (s_currentThumbnailWorker.first == this) ? s_currentThumbnailWorker.second : (m_iNextQueue++ % m_queues.size());
+		{
+			std::unique_lock lock(m_mtx);
+			m_pending[owner]++;
+			m_nQueuedMax = std::max(m_nQueuedMax, ++m_nQueued);
+			auto& queue = *m_queues[iQueue];
+			std::unique_lock lockQueue(queue.mtx);
+			queue.jobs.emplace(std::pair(-priority, job->seq), job);
+		}
+		m_cv.notify_one();
+		return job;
+	}
+
+	bool CThumbnailWorkerPool::SetPriority(P_JOB const& job, int priority) {
+		if (!job or job->state != sJob::eSTATE::queued)
+			return false;
+		for (auto& rQueue : m_queues) {
+			std::unique_lock lock(rQueue->mtx);
+			auto iter = rQueue->jobs.find(std::pair(-job->priority, job->seq));
+			if (iter == rQueue->jobs.end() or iter->second != job)
+				continue;
+			if (job->priority != priority) {
+				auto node = rQueue->jobs.extract(iter);
+				job->priority = priority;
+				node.key().first = -priority;
+				rQueue->jobs.insert(std::move(node));
+			}
+			return true;
+		}
+		return false;
+	}
+
+	size_t CThumbnailWorkerPool::Cancel(void const* owner) {
+		size_t nRemoved{}, nCancelled{};
+		for (auto& rQueue : m_queues) {
+			std::unique_lock lock(rQueue->mtx);
+			std::erase_if(rQueue->jobs, [&](auto const& pair) {
+				auto const& job = pair.second;
+				if (job->owner != owner)
+					return false;
+				if (job->Cancel())
+					nCancelled++;
+				nRemoved++;
+				return true;
+			});
+		}
+		if (!nRemoved)
+			return 0;
+		m_nQueued -= nRemoved;
+		m_nCancelled += nRemoved;
+		{
+			std::unique_lock lock(m_mtx);
+			if (auto iter = m_pending.find(owner); iter != m_pending.end()) {
+				iter->second -= std::min(iter->second, nRemoved);
+				if (!iter->second)
+					m_pending.erase(iter);
+			}
+		}
+		m_cv.notify_all();
+		return nCancelled;
+	}
+
+	void CThumbnailWorkerPool::Wait(void const* owner) {
+		if (s_currentThumbnailWorker.first == this)
+			return;	// a job waiting for jobs would dead-lock
+		std::unique_lock lock(m_mtx);
+		m_cv.wait(lock, [&] { return !m_pending.contains(owner); });
+	}
+
+	size_t CThumbnailWorkerPool::GetPending(void const* owner) {
+		std::unique_lock lock(m_mtx);
+		auto iter = m_pending.find(owner);
+		return iter == m_pending.end() ? 0 : iter->second;
+	}
+
+	CThumbnailWorkerPool::sMetrics CThumbnailWorkerPool::GetMetrics() {
+		sMetrics metrics;
+		metrics.nWorker = (int)m_workers.size();
+		metrics.nQueued = m_nQueued;
+		{
+			std::unique_lock lock(m_mtx);
+			metrics.nQueuedMax = m_nQueuedMax;
+		}
+		metrics.nDone = m_nDone;
+		metrics.nCancelled = m_nCancelled;
+		metrics.nStolen = m_nStolen;
+		if (auto nStarted = m_nStarted.load())
+			metrics.tLatencyAverage = std::chrono::nanoseconds(m_tLatencySum / (int64_t)nStarted);
+		metrics.tLatencyMax = std::chrono::nanoseconds(m_tLatencyMax);
+		return metrics;
+	}
+
+	void CThumbnailWorkerPool::ResetMetrics() {
+		{
+			std::unique_lock lock(m_mtx);
+			m_nQueuedMax = m_nQueued;
+		}
+		m_nDone = m_nCancelled = m_nStolen = m_nStarted = 0;
+		m_tLatencySum = m_tLatencyMax = 0;
+	}
+
+	CThumbnailWorkerPool::P_JOB CThumbnailWorkerPool::Pop(int iWorker) {
+		auto PopFront = [&](sQueue& queue) -> P_JOB {
+			std::unique_lock lock(queue.mtx);
+			if (queue.jobs.empty())
+				return {};
+			auto job = std::move(queue.jobs.begin()->second);
+			queue.jobs.erase(queue.jobs.begin());
+			m_nQueued--;
+			return job;
+		};
+		if (auto job = PopFront(*m_queues[iWorker]))
+			return job;
+		// steal
+		for (size_t i = 1; i < m_queues.size(); i++) {
+			if (auto job = PopFront(*m_queues[(iWorker + i) % m_queues.size()])) {
+				m_nStolen++;
+				return job;
+			}
+		}
+		return {};
+	}
+
+	void CThumbnailWorkerPool::Done(void const* owner) {
+		{
+			std::unique_lock lock(m_mtx);
+			if (auto iter = m_pending.find(owner); iter != m_pending.end() and !--(iter->second))
+				m_pending.erase(iter);
+		}
+		m_cv.notify_all();
+	}
+
+	void CThumbnailWorkerPool::Worker(std::stop_token token, int iWorker) {
+		s_currentThumbnailWorker = { this, iWorker };
+		while (!token.stop_requested()) {
+			auto job = Pop(iWorker);
+			if (!job) {
+				std::unique_lock lock(m_mtx);
+				m_cv.wait(lock, token, [&] { return m_nQueued > 0; });
+				continue;
+			}
+
+			auto e = sJob::eSTATE::queued;
+			if (job->state.compare_exchange_strong(e, sJob::eSTATE::running)) {
+				int64_t tLatency = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - job->tSubmitted).count();
+				m_nStarted++;
+				m_tLatencySum += tLatency;
+				for (auto tMax = m_tLatencyMax.load(); tMax < tLatency and !m_tLatencyMax.compare_exchange_weak(tMax, tLatency); )
+					;
+				try {
+					job->func();
+				} catch (...) {
+				}
+				job->state = sJob::eSTATE::done;
+				m_nDone++;
+			} else {
+				m_nCancelled++;
+			}
+			job->func = nullptr;
+			Done(job->owner);
+		}
+	}
+
+
 	//=============================================================================
 	//
 
@@ -38,8 +236,9 @@ namespace gtl {
 			}
 			m_sizeArray		= B.m_sizeArray;
 			m_sizeImage		= B.m_sizeImage;
+			UpdateTileOffsets();
 		} else {
-			Create(B.m_imgWhole, xSize2i(B.m_sizeImage.cx / B.m_sizeArray.cx, B.m_sizeImage.cy / B.m_sizeArray.cy), B.m_sizeArray);
+			Create(B.m_imgWhole, B.m_sizePiece, B.m_sizeArray);
 		}
 		return *this;
 	}
@@ -56,6 +255,7 @@ namespace gtl {
 			int nSize = size.cx * size.cy;
 			m_set.assign(nSize, T_ITEM());
 		}
+		UpdateTileOffsets();
 		return true;
 	}
 
@@ -71,6 +271,7 @@ namespace gtl {
 		m_imgWhole.release();
 
 		m_sizeArray = size;
+		m_sizePiece = sizePieceImage;
 
 		int nSize = size.cx * size.cy;
 		if (nSize) {
@@ -103,70 +304,134 @@ namespace gtl {
 				}
 			}
 			m_sizeImage = m_imgWhole.size();
+			UpdateTileOffsets();
 		}
 		return true;
 	}
 
+	bool C2dMatArray::Create(const cv::Mat& imgWhole, const xSize2i& sizePieceImage, const xSize2i& size, std::shared_ptr<void const> owner) {
+		return Create(AttachMatOwner(imgWhole, std::move(owner)), sizePieceImage, size);
+	}
+
 	void C2dMatArray::Destroy() {
 		StopThumbnailMaker();
+		m_sizePiece.SetZero();
 		m_sizeArray.SetZero();
 		m_sizeImage.SetZero();
-		m_dequeThumbnailWork.clear();
 		m_set.clear();
+		m_colOffsets.clear();
+		m_rowOffsets.clear();
+		m_nThumbnailMemory = 0;
 		m_imgWhole.release();
 	}
 
 	bool C2dMatArray::SetThumbnailMaker(const T_THUMBNAIL_SIZES& sizesThumbnail, int nThreadThumbnailMaker) {
-		if (m_threadsThumbnailWorker.size()) {
+		if (IsThumbnailMakerRunning()) {
 			return false;
 		}
+		if (m_sizesThumbnail != sizesThumbnail) {
+			for (auto const& item : m_set)
+				ClearThumbnails(item);
+		}
 		m_sizesThumbnail = sizesThumbnail;
 		m_nThreadThumbnailMaker = nThreadThumbnailMaker;
+		m_bPyramid = false;
+		return true;
+	}
+	bool C2dMatArray::SetPyramid(int nLevel, int nThreadThumbnailMaker) {
+		if ( (nLevel <= 0) or (nLevel > 30) )
+			return false;
+		T_THUMBNAIL_SIZES sizes;
+		for (int i = 1; i <= nLevel; i++)
+			sizes.emplace_back(1, 1 << i);
+		if (!SetThumbnailMaker(sizes, nThreadThumbnailMaker))
+			return false;
+		m_bPyramid = true;
 		return true;
 	}
+	void C2dMatArray::SetThumbnailPriority(int nPriority, cv::Rect const& rcVisible) {
+		if (m_nThumbnailPriority == nPriority and m_rcThumbnailVisible == rcVisible)
+			return;
+		m_nThumbnailPriority = nPriority;
+		m_rcThumbnailVisible = rcVisible;
+
+		// re-key queued jobs (ex, scrolled)
+		for (int i = 0; i < m_set.size(); i++) {
+			auto& item = m_set[i];
+			std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
+			if (item.jobThumbnail and item.jobThumbnail->state == CThumbnailWorkerPool::sJob::eSTATE::queued)
+				m_pThumbnailPool->SetPriority(item.jobThumbnail, GetThumbnailJobPriority(GetPos(i)));
+		}
+	}
 	bool C2dMatArray::StartThumbnailMaker() {
 		StopThumbnailMaker();
 
-		//m_bStopThumbnailMaker = false;
-		//m_evtThumbnail.ResetEvent();
-		m_bImageReady = false;
-		for (int i = 0; i < m_nThreadThumbnailMaker; i++)
-			m_threadsThumbnailWorker.emplace_back(new std::jthread( [&](std::stop_token token) { ThumbnailMaker(token); }, m_stopThumbnail.get_token()));
+		// workers are shared. (CThumbnailWorkerPool)
+		m_bThumbnailMakerRunning = m_nThreadThumbnailMaker > 0;
 
 		return true;
 	}
 	bool C2dMatArray::StopThumbnailMaker() {
-		m_stopThumbnail.request_stop();
-		m_cvThumbnail.notify_all();
-		for (const auto& rThread : m_threadsThumbnailWorker) {
-			rThread->join();
-		}
-		m_threadsThumbnailWorker.clear();
+		if (auto nCancelled = m_pThumbnailPool->Cancel(this))
+			m_nThumbnailPending -= nCancelled;
+		m_pThumbnailPool->Wait(this);
+		m_nThumbnailPending = 0;
+		m_bThumbnailMakerRunning = false;
 		return false;
 	}
 
+	int C2dMatArray::GetThumbnailJobPriority(xPoint2i const& pos) const {
+		// visible tiles first
+		bool bVisible = m_rcThumbnailVisible.empty();
+		if (!bVisible and ((size_t)pos.x+1 < m_colOffsets.size()) and ((size_t)pos.y+1 < m_rowOffsets.size())) {
+			cv::Rect rcTile(m_colOffsets[pos.x], m_rowOffsets[pos.y], m_colOffsets[pos.x+1] - m_colOffsets[pos.x], m_rowOffsets[pos.y+1] - m_rowOffsets[pos.y]);
+			bVisible = !(rcTile & m_rcThumbnailVisible).empty();
+		}
+		return m_nThumbnailPriority * 2 + (bVisible ? 1 : 0);
+	}
+
+	void C2dMatArray::QueueThumbnail(xPoint2i const& pos, T_ITEM& item, bool bCounted) {
+		int priority = GetThumbnailJobPriority(pos);
+
+		std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
+		if (item.jobThumbnail and item.jobThumbnail->Cancel())
+			m_nThumbnailPending--;
+		if (!bCounted)
+			m_nThumbnailPending++;
+		item.jobThumbnail = m_pThumbnailPool->Submit(this, priority, [this, pos, &item] { OnThumbnailMade(pos, item); });
+	}
+
+	void C2dMatArray::OnThumbnailMade(xPoint2i pos, T_ITEM& item) {
+		MakeThumbnail(item);
+		// notifies every m_nNotifierInterval thumbnails, and when all queued thumbnails are made
+		bool const bDone = !--m_nThumbnailPending;
+		bool const bInterval = !(++m_nThumbnailMade % m_nNotifierInterval);
+		if ((bDone or bInterval) and m_funcNotifier)
+			m_funcNotifier(pos, item);
+	}
+
 	bool C2dMatArray::UpdateThumbnail(bool bThumbnailInBkgnd) {
 		if (bThumbnailInBkgnd) {
-			{
-				std::lock_guard lock(m_mtxThumbnailWork);
-				m_dequeThumbnailWork.clear();
-
-				for (int i = 0; i < m_set.size(); i++) {
-					auto& item = m_set[i];
-					{
-						std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
-						item.thumbnails.clear();
-					}
-					m_dequeThumbnailWork.emplace_back(new std::pair<xPoint2i, P_ITEM>(GetPos(i), &item));
-				}
-				m_bImageReady = true;
-				m_cvThumbnail.notify_all();
-			}
-
 			if (!IsThumbnailMakerRunning()) {
 				StartThumbnailMaker();
 			}
 
+			if (auto nCancelled = m_pThumbnailPool->Cancel(this))
+				m_nThumbnailPending -= nCancelled;
+			m_nThumbnailMade = 0;
+			// whole batch is counted before the first Submit. (or a fast worker takes m_nThumbnailPending to 0, notifying 'all done', while queueing)
+			bool const bQueue = IsThumbnailMakerRunning();
+			if (bQueue)
+				m_nThumbnailPending += m_set.size();
+			for (int i = 0; i < m_set.size(); i++) {
+				auto& item = m_set[i];
+				ClearThumbnails(item);
+				if (bQueue)
+					QueueThumbnail(GetPos(i), item, true);
+				else
+					MakeThumbnail(item);
+			}
+
 		} else {
 			for (auto& item : m_set)
 				MakeThumbnail(item);
@@ -189,6 +454,7 @@ namespace gtl {
 			bCopy = true;
 		}
 
+		bool bSizeChanged = (img.size() != item.img.size());
 		{
 			std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
 			if (bCopy) {
@@ -196,32 +462,20 @@ namespace gtl {
 			} else {
 				item.img = img;
 			}
-			item.thumbnails.clear();
+			ClearThumbnails(item);
+			if (item.jobThumbnail and item.jobThumbnail->Cancel())
+				m_nThumbnailPending--;
+			item.jobThumbnail.reset();
 		}
 
-		if (m_imgWhole.empty()) {
-			int nTotalCols = 0;
-			for (int ix = 0; ix < m_sizeArray.cx; ix++) {
-				int iIndex = ix + m_sizeArray.cx * pos.y;
-				if (iIndex >= m_set.size())
-					continue;
-				nTotalCols += m_set[iIndex].img.cols;
-			}
-			int nTotalRows = 0;
-			for (int iy = 0; iy < m_sizeArray.cy; iy++) {
-				int iIndex = pos.x + m_sizeArray.cx * iy;
-				if (iIndex >= m_set.size())
-					continue;
-				nTotalRows += m_set[iIndex].img.rows;
-			}
-			m_sizeImage.Set(nTotalCols, nTotalRows);
+		if (m_imgWhole.empty() and bSizeChanged) {
+			UpdateTileOffsets();
+			m_sizeImage.Set(m_colOffsets.back(), m_rowOffsets.back());
 		}
 
 		if (bUpdateThumbnail) {
-			if (bThumbnailInBkgnd && m_threadsThumbnailWorker.size()) {
-				std::lock_guard lock(m_mtxThumbnailWork);
-				m_dequeThumbnailWork.emplace_back(new std::pair<xPoint2i, P_ITEM>(pos, &item));
-				m_cvThumbnail.notify_all();
+			if (bThumbnailInBkgnd && IsThumbnailMakerRunning()) {
+				QueueThumbnail(pos, item);
 			} else
 				MakeThumbnail(item);
 		}
@@ -291,65 +545,26 @@ namespace gtl {
 
 		Mat img;
 
-		int ix = 0, iy = 0;
-		int ny = 1;
-		int nx = 1;
-		int rowsPred = 0;
-		int colsPred = 0;
-		int iyEnd = 0;
-		int ixEnd = 0;
-
-		// Y Start
-		for (iy = 0; iy < m_sizeArray.cy; iy++) {
-			const Mat& m = GetItem({0, iy}).img;
-			if (m.empty())
-				continue;
-			if (rowsPred > rc.y)
-				return img;
-			int r = rowsPred + m.rows;
-			if (r > rc.y)
-				break;
-			rowsPred = r;
-		}
-		if (iy >= m_sizeArray.cy)
+		// Tile Range. binary search on the prefix sum of tile sizes
+		if ( (rc.x < 0) || (rc.y < 0) || (m_colOffsets.size() != (size_t)m_sizeArray.cx+1) || (m_rowOffsets.size() != (size_t)m_sizeArray.cy+1) )
 			return img;
-		// Y End
-		int rowsEnd = rowsPred;
-		for (iyEnd = iy; iyEnd < m_sizeArray.cy; iyEnd++) {
-			const Mat& m = GetItem({0, iyEnd}).img;
-			rowsEnd += m.rows;
-			if (rc.y + rc.height <= rowsEnd)
-				break;
-			ny++;
-		}
-		if (rc.y + rc.height > rowsEnd)
-			rc.height = rowsEnd - rc.y;
-
-		// X Start
-		for (ix = 0; ix < m_sizeArray.cx; ix++) {
-			const Mat& m = GetItem({ix, iy}).img;
-			if (m.empty())
-				continue;
-			if (colsPred > rc.x)
-				return img;
-			int c = colsPred + m.cols;
-			if (c > rc.x)
-				break;
-			colsPred = c;
-		}
-		if (ix >= m_sizeArray.cx)
+		auto FindTile = [](std::vector<int> const& offsets, int pos) -> int {
+			return (int)(std::upper_bound(offsets.begin(), offsets.end(), pos) - offsets.begin()) - 1;
+		};
+		int const iy = FindTile(m_rowOffsets, rc.y);
+		int const ix = FindTile(m_colOffsets, rc.x);
+		if ( (iy >= m_sizeArray.cy) || (ix >= m_sizeArray.cx) )
 			return img;
-		// X End
-		int colsEnd = colsPred;
-		for (ixEnd = ix; ixEnd < m_sizeArray.cx; ixEnd++) {
-			const Mat& m = GetItem({ixEnd, iy}).img;
-			colsEnd += m.cols;
-			if (rc.x + rc.width <= colsEnd)
-				break;
-			nx++;
-		}
-		if (rc.x + rc.width > colsEnd)
-			rc.width = colsEnd - rc.x;
+		int const iyEnd = std::clamp(FindTile(m_rowOffsets, rc.y + rc.height - 1), iy, m_sizeArray.cy-1);
+		int const ixEnd = std::clamp(FindTile(m_colOffsets, rc.x + rc.width - 1), ix, m_sizeArray.cx-1);
+		int const ny = iyEnd - iy + 1;
+		int const nx = ixEnd - ix + 1;
+		int const rowsPred = m_rowOffsets[iy];
+		int const colsPred = m_colOffsets[ix];
+		if (rc.y + rc.height > m_rowOffsets[iyEnd+1])
+			rc.height = m_rowOffsets[iyEnd+1] - rc.y;
+		if (rc.x + rc.width > m_colOffsets[ixEnd+1])
+			rc.width = m_colOffsets[ixEnd+1] - rc.x;
 
 		// Get
 		if ( (nx == 1) && (ny == 1) ) {
@@ -360,14 +575,14 @@ namespace gtl {
 			rcROI.y -= rowsPred;
 
 			if (iThumbnail >= 0) {
-				std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
-				if ( (iThumbnail < item.thumbnails.size()) && !item.thumbnails[iThumbnail].empty() ) {
-					auto& thumbnail = item.thumbnails[iThumbnail];
+				if (auto thumbnail = GetThumbnail(item, iThumbnail); !thumbnail.empty()) {
 					Rect rcNew(imuldiv(rcROI.x, scaleThumbnail), imuldiv(rcROI.y, scaleThumbnail), imuldiv(rcROI.width, scaleThumbnail), imuldiv(rcROI.height, scaleThumbnail));
 					rcNew = gtl::GetSafeROI(rcNew, thumbnail.size());
 					double dScaleNew = dScale / dScaleThumbnail;
-					if (dScaleNew == 1.0)
+					if (dScaleNew == 1.0) {
 						img = thumbnail(rcNew);
+						return img;
+					}
 					else if (ResizeImage(thumbnail(rcNew), img, dScaleNew, dScaleNew >= 1 ? eScaleUpMethod : eScaleDownMethod))
 						return img;
 				}
@@ -381,54 +596,53 @@ namespace gtl {
 
 		} else {
 
-			auto MoveImages = [&](Mat& imgTarget, Rect& rcT, int iThumbnail) {
-				int iRowStart = rcT.y - imuldiv(rowsPred, scaleThumbnail);
-				int iRowStartTarget = 0;
-				int nRowsLeft = rcT.height;
-				for (int y = iy; y <= iyEnd; y++) {
-					int iColStart = rcT.x - imuldiv(colsPred, scaleThumbnail);
-					int iColStartTarget = 0;
-					int nColsLeft = rcT.width;
-					int cy = 0;
-					for (int x = ix; x <= ixEnd; x++) {
-						const auto& item = GetItem({x, y});
-
-						static const Mat mEmpty;
-
-						item.mtxThumbnail.lock();
-						const Mat& m = (iThumbnail < 0) ? item.img : ((iThumbnail < item.thumbnails.size()) ? item.thumbnails[iThumbnail] : mEmpty);
-						item.mtxThumbnail.unlock();
-
-						if (m.empty())
-							continue;
-						int cx = std::min(m.cols-iColStart, nColsLeft);
-						if (!cy)
-							cy = std::min(m.rows-iRowStart, nRowsLeft);
-
-						if ( (cx > 0) && (cy > 0) ) {
-							try {
-								Rect rcSource(iColStart, iRowStart, cx, cy);
-								Rect rcTarget(iColStartTarget, iRowStartTarget, cx, cy);
-								if ( IsROI_Valid(rcSource, m.size()) && IsROI_Valid(rcTarget, imgTarget.size()) )
-									m(rcSource).copyTo(imgTarget(rcTarget));
-								else
-									throw std::exception("Unknown Internal Error");
-							} catch (cv::Exception& ) {
-								return;
-							}
+			// each tile is copied to its own part of imgTarget, so tiles are assembled in parallel.
+			auto MoveImages = [&](Mat& imgTarget, Rect const& rcT, int iThumbnail) {
+				// tile positions in the scale of imgTarget. (thumbnail size is MulDiv(size, scale))
+				auto Scale = [&](int v) { return (iThumbnail < 0) ? v : imuldiv(v, scaleThumbnail); };
+				std::vector<int> cols(nx+1), rows(ny+1);
+				cols[0] = Scale(colsPred);
+				for (int x = 0; x < nx; x++)
+					cols[x+1] = cols[x] + Scale(m_colOffsets[ix+x+1] - m_colOffsets[ix+x]);
+				rows[0] = Scale(rowsPred);
+				for (int y = 0; y < ny; y++)
+					rows[y+1] = rows[y] + Scale(m_rowOffsets[iy+y+1] - m_rowOffsets[iy+y]);
+
+				std::atomic<bool> bError{};
+				cv::parallel_for_(cv::Range(0, nx*ny), [&](cv::Range const& range) {
+					for (int i = range.start; i < range.end; i++) {
+						int x = i % nx;
+						int y = i / nx;
+						const auto& item = GetItem({ix+x, iy+y});
+
+						Mat m;
+						if (iThumbnail < 0) {
+							std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
+							m = item.img;
 						} else {
-							if (cx < 0 || cy < 0)
-								throw std::exception("Unknown Internal Error");
+							m = GetThumbnail(item, iThumbnail);
 						}
+						if (m.empty())
+							continue;
 
-						iColStart = 0;
-						iColStartTarget += cx;
-						nColsLeft -= cx;
+						Rect rcTile(cols[x], rows[y], cols[x+1]-cols[x], rows[y+1]-rows[y]);
+						Rect rcSource = (rcTile & rcT) - rcTile.tl();
+						rcSource &= Rect(0, 0, m.cols, m.rows);
+						if (rcSource.empty())
+							continue;
+						Rect rcTarget = rcSource + (rcTile.tl() - rcT.tl());
+						if (!IsROI_Valid(rcTarget, imgTarget.size())) {
+							bError = true;
+							continue;
+						}
+						try {
+							m(rcSource).copyTo(imgTarget(rcTarget));
+						} catch (cv::Exception& ) {
+						}
 					}
-					iRowStart = 0;
-					iRowStartTarget += cy;
-					nRowsLeft -= cy;
-				}
+				});
+				if (bError)
+					throw std::exception("Unknown Internal Error");
 			};
 
 			if (iThumbnail >= 0) {
@@ -450,80 +664,127 @@ namespace gtl {
 				} else {
 					img = m_imgWhole(rc);
 				}
+				// at scale 1, ROI of m_imgWhole itself. (no copy)
 				double dScaleNew = dScale / dScaleThumbnail;
-				ResizeImage(img, img, dScaleNew, dScaleNew >= 1 ? eScaleUpMethod : eScaleDownMethod);
+				if (dScaleNew != 1.0)
+					ResizeImage(img, img, dScaleNew, dScaleNew >= 1 ? eScaleUpMethod : eScaleDownMethod);
 			}
 		}
 
 		return img;
 	}
 
-	void C2dMatArray::ThumbnailMaker(std::stop_token token) {
-		using namespace std::literals;
-		//static volatile long iThreadNumber = 0;
-		//long iCurrentThread = InterlockedAdd(&iThreadNumber, 1);
-		//TRACE("ThumbnailMaker Start(%d)\n", iCurrentThread);
-
-		std::unique_lock lock(m_mtxThumbnail);
-		while (m_cvThumbnail.wait_for(lock, 1000ms, [&]{return (bool)m_bImageReady;}), !token.stop_requested()) {	// NOT '&&' but ','
-			std::unique_ptr<std::pair<xPoint2i, P_ITEM>> rItemL;
-			int nThumbnail = 0;
-			while (!token.stop_requested()) {
-				std::unique_ptr<std::pair<xPoint2i, P_ITEM>> rItem;
-				{
-					std::lock_guard<std::mutex> lock(m_mtxThumbnailWork);
-					if (m_dequeThumbnailWork.size()) {
-						rItem = move(m_dequeThumbnailWork.front());
-						m_dequeThumbnailWork.pop_front();
-					}
-					if (m_dequeThumbnailWork.empty())
-						m_bImageReady = false;
-				}
-				if (!rItem)
-					break;
+	bool C2dMatArray::MakeThumbnail(T_ITEM& item) {
+		{
+			std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
 
-				MakeThumbnail(*(rItem->second));
+			//item.bTumbnail = false;
+			ClearThumbnails(item);
+			item.thumbnails.resize(m_sizesThumbnail.size());
+			item.thumbnailsAccessed.resize(m_sizesThumbnail.size());
+			for (int i = 0; i < m_sizesThumbnail.size(); i++)
+				MakeThumbnail(item, i);
+			//item.bTumbnail = true;
+		}
+		EvictThumbnails();
 
-				rItemL = move(rItem);
+		return false;
+	}
 
-				if (nThumbnail > 3) {
-					if (rItemL && !token.stop_requested() && m_funcNotifier) {
-						m_funcNotifier(rItemL->first, *(rItemL->second));
-						rItemL.reset();
-					}
+	bool C2dMatArray::MakeThumbnail(T_ITEM const& item, int iThumbnail) const {
+		auto const& size = m_sizesThumbnail[iThumbnail];
+		cv::Size sizeThumbnail(MulDiv(item.img.cols, size.first, size.second), MulDiv(item.img.rows, size.first, size.second));
+		double dScale = (double)size.first / size.second;
+		int eResizingMethod = dScale < 1 ? m_eScaleDownMethod : m_eScaleUpMethod;
+
+		// pyramid : from the next finer level (if not evicted)
+		cv::Mat const* pSource = &item.img;
+		if (m_bPyramid) {
+			for (int i = iThumbnail-1; i >= 0; i--) {
+				if (!item.thumbnails[i].empty()) {
+					pSource = &item.thumbnails[i];
+					break;
 				}
 			}
-			if (rItemL && !token.stop_requested() && m_funcNotifier) {
-				m_funcNotifier(rItemL->first, *(rItemL->second));
-			}
-		};
+		}
+
+		cv::Mat imgThumbnail;
+		bool bOK = Resize(*pSource, imgThumbnail, sizeThumbnail, eResizingMethod);
 
-		//TRACE("ThumbnailMaker End -- (%d)\n", iCurrentThread);
+		m_nThumbnailMemory += imgThumbnail.total() * imgThumbnail.elemSize();
+		item.thumbnails[iThumbnail] = imgThumbnail;
+		item.thumbnailsAccessed[iThumbnail] = ++m_tickThumbnail;
+		return bOK;
 	}
 
-	bool C2dMatArray::MakeThumbnail(T_ITEM& item) {
+	cv::Mat C2dMatArray::GetThumbnail(T_ITEM const& item, int iThumbnail) const {
+		cv::Mat img;
+		bool bMade{};
 		{
 			std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
+			if (iThumbnail >= item.thumbnails.size() or item.thumbnails[iThumbnail].empty()) {
+				if (!m_bPyramid or item.img.empty() or iThumbnail >= m_sizesThumbnail.size())
+					return img;
+				item.thumbnails.resize(m_sizesThumbnail.size());
+				item.thumbnailsAccessed.resize(m_sizesThumbnail.size());
+				MakeThumbnail(item, iThumbnail);
+				bMade = true;
+			}
+			item.thumbnailsAccessed[iThumbnail] = ++m_tickThumbnail;
+			img = item.thumbnails[iThumbnail];
+		}
+		if (bMade)
+			EvictThumbnails();
+		return img;
+	}
 
-			//item.bTumbnail = false;
-			item.thumbnails.clear();
-			for (const auto& size : m_sizesThumbnail) {
-				cv::Mat imgThumbnail;
-				cv::Size sizeThumbnail(MulDiv(item.img.cols, size.first, size.second), MulDiv(item.img.rows, size.first, size.second));
-				double dScale = (double)size.first / size.second;
-				int eResizingMethod = dScale < 1 ? m_eScaleDownMethod : m_eScaleUpMethod;
-
-				Resize(item.img, imgThumbnail, sizeThumbnail, eResizingMethod);
+	void C2dMatArray::ClearThumbnails(T_ITEM const& item) const {
+		std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
+		for (auto const& thumbnail : item.thumbnails)
+			m_nThumbnailMemory -= thumbnail.total() * thumbnail.elemSize();
+		item.thumbnails.clear();
+		item.thumbnailsAccessed.clear();
+	}
 
-				item.thumbnails.emplace_back(imgThumbnail);
+	void C2dMatArray::EvictThumbnails() const {
+		if (!m_nThumbnailMemoryBudget or (m_nThumbnailMemory <= m_nThumbnailMemoryBudget))
+			return;
+		std::unique_lock lockEvict(m_mtxEvictThumbnail, std::try_to_lock);
+		if (!lockEvict)
+			return;	// being evicted by other thread
+
+		struct sEntry {
+			uint64_t tick;
+			T_ITEM const* item;
+			int iThumbnail;
+		};
+		std::vector<sEntry> entries;
+		for (auto const& item : m_set) {
+			std::lock_guard<std::recursive_mutex> lock(item.mtxThumbnail);
+			for (int i = 0; i < item.thumbnails.size(); i++) {
+				if (!item.thumbnails[i].empty())
+					entries.push_back({ item.thumbnailsAccessed[i], &item, i });
 			}
-			//item.bTumbnail = true;
 		}
+		std::ranges::sort(entries, {}, &sEntry::tick);
 
-		return false;
+		// evict down to 7/8 of budget, not to evict on every new thumbnail
+		size_t const nTarget = m_nThumbnailMemoryBudget / 8 * 7;
+		for (auto const& entry : entries) {
+			if (m_nThumbnailMemory <= nTarget)
+				break;
+			std::lock_guard<std::recursive_mutex> lock(entry.item->mtxThumbnail);
+			if (entry.iThumbnail >= entry.item->thumbnails.size())
+				continue;
+			auto& thumbnail = entry.item->thumbnails[entry.iThumbnail];
+			if (thumbnail.empty() or (entry.item->thumbnailsAccessed[entry.iThumbnail] != entry.tick))	// accessed again
+				continue;
+			m_nThumbnailMemory -= thumbnail.total() * thumbnail.elemSize();
+			thumbnail.release();
+		}
 	}
 
-	bool C2dMatArray::Resize(cv::Mat& imgSrc, cv::Mat& imgDest, const cv::Size& size, int eResizingMethod) {
+	bool C2dMatArray::Resize(cv::Mat const& imgSrc, cv::Mat& imgDest, const cv::Size& size, int eResizingMethod) const {
 		//if (m_bUseGPU && IsGPUEnabled()) {
 		//	try {
 		//		cv::cuda::GpuMat dst;
@@ -542,4 +803,31 @@ namespace gtl {
 		return true;
 	}
 
+	void C2dMatArray::UpdateTileOffsets() {
+		m_colOffsets.assign(m_sizeArray.cx+1, 0);
+		m_rowOffsets.assign(m_sizeArray.cy+1, 0);
+		if (m_set.size() < (size_t)m_sizeArray.cx * m_sizeArray.cy)
+			return;
+		for (int x = 0; x < m_sizeArray.cx; x++) {
+			int cx = 0;
+			for (int y = 0; y < m_sizeArray.cy; y++) {
+				if (auto const& img = m_set[x + m_sizeArray.cx * y].img; !img.empty()) {
+					cx = img.cols;
+					break;
+				}
+			}
+			m_colOffsets[x+1] = m_colOffsets[x] + cx;
+		}
+		for (int y = 0; y < m_sizeArray.cy; y++) {
+			int cy = 0;
+			for (int x = 0; x < m_sizeArray.cx; x++) {
+				if (auto const& img = m_set[x + m_sizeArray.cx * y].img; !img.empty()) {
+					cy = img.rows;
+					break;
+				}
+			}
+			m_rowOffsets[y+1] = m_rowOffsets[y] + cy;
+		}
+	}
+
 }
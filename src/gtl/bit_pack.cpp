@@ -0,0 +1,384 @@
+﻿#include "pch.h"
+
+#include "gtl/bit_pack.h"
+
+#if defined(__AVX2__)
+#	define GTL__BIT_PACK_AVX2 1
+#endif
+#if defined(__AVX2__) or defined(__SSE2__) or defined(_M_X64) or (defined(_M_IX86_FP) and (_M_IX86_FP >= 2))
+#	define GTL__BIT_PACK_SSE2 1
+#	include <immintrin.h>
+#endif
+
+namespace gtl {
+
+	namespace {
+
+		//-----------------------------------------------------------------------------
+		// scalar
+
+		void PackBits_Scalar(int nBPP, uint8_t const* src, size_t nPixel, uint8_t* packed) {
+			uint8_t const mask = (uint8_t)((1 << nBPP) - 1);
+			size_t const nPixelPerByte = 8 / nBPP;
+			size_t const nPixelFull = nPixel / nPixelPerByte * nPixelPerByte;
+			size_t x{};
+			for (; x < nPixelFull; packed++) {
+				uint8_t v{};
+				for (int shift{ 8 - nBPP }; shift >= 0; shift -= nBPP)
+					v |= (src[x++] & mask) << shift;
+				*packed = v;
+			}
+			if (x < nPixel) {
+				uint8_t v{};
+				for (int shift{ 8 - nBPP }; x < nPixel; shift -= nBPP)
+					v |= (src[x++] & mask) << shift;
+				*packed = v;
+			}
+		}
+
+		void PackBitsThreshold_Scalar(uint8_t const* src, size_t nPixel, uint8_t threshold, uint8_t* packed) {
+			for (size_t x{}; x < nPixel; x += 8) {
+				uint8_t v{};
+				for (size_t i{}; (i < 8) and (x + i < nPixel); i++)
+					v |= (src[x + i] >= threshold ? 0x80 : 0) >> i;
+				*packed++ = v;
+			}
+		}
+
+		/// @brief lut : nullable
+		void UnpackBits_Scalar(int nBPP, uint8_t const* packed, size_t nPixel, uint8_t const* lut, uint8_t* dst) {
+			uint8_t const mask = (uint8_t)((1 << nBPP) - 1);
+			int shift{ 8 - nBPP };
+			for (size_t x{}; x < nPixel; x++) {
+				uint8_t index = (*packed >> shift) & mask;
+				dst[x] = lut ? lut[index] : index;
+				if ((shift -= nBPP) < 0) {
+					shift = 8 - nBPP;
+					packed++;
+				}
+			}
+		}
+
+#if (GTL__BIT_PACK_SSE2)
+
+		//-----------------------------------------------------------------------------
+		// SIMD : returns count of pixels done (multiple of 16). the rest is left for scalar.
+
+		/// @brief movemask gives first pixel on LSB. (BMP : MSB)
+		constexpr auto const s_tblBitReversed = [] {
+			std::array<uint8_t, 256> tbl{};
+			for (int i{}; i < 256; i++) {
+				for (int b{}; b < 8; b++) {
+					if (i & (1 << b))
+						tbl[i] |= 0x80 >> b;
+				}
+			}
+			return tbl;
+		}();
+
+#	if (GTL__BIT_PACK_AVX2)
+		/// @brief reverses order of each 8 bytes, so movemask gives first pixel on MSB
+		inline __m256i ReverseBytesOf8(__m256i v) {
+			__m256i const idx = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+			return _mm256_shuffle_epi8(v, idx);
+		}
+#	endif
+
+		/// @brief MSB of each byte -> bits
+		template < typename tmsb >
+		size_t PackMSB_SIMD(uint8_t const* src, size_t nPixel, uint8_t* packed, tmsb&& MSB128, [[maybe_unused]] auto&& MSB256) {
+			size_t x{};
+#	if (GTL__BIT_PACK_AVX2)
+			for (; x + 32 <= nPixel; x += 32) {
+				__m256i v = MSB256(_mm256_loadu_si256((__m256i const*)(src + x)));
+				uint32_t bits = (uint32_t)_mm256_movemask_epi8(ReverseBytesOf8(v));
+				std::memcpy(packed + x / 8, &bits, sizeof(bits));
+			}
+#	endif
+			for (; x + 16 <= nPixel; x += 16) {
+				__m128i v = MSB128(_mm_loadu_si128((__m128i const*)(src + x)));
+				uint32_t bits = (uint32_t)_mm_movemask_epi8(v);
+				packed[x / 8 + 0] = s_tblBitReversed[bits & 0xff];
+				packed[x / 8 + 1] = s_tblBitReversed[bits >> 8];
+			}
+			return x;
+		}
+
+		size_t PackBits1_SIMD(uint8_t const* src, size_t nPixel, uint8_t* packed) {
+			// bit 0 -> bit 7 (shifting 16 bit lanes doesn't matter, bit 7 of each byte comes from bit 0 of itself)
+			return PackMSB_SIMD(src, nPixel, packed,
+				[](__m128i v) { return _mm_slli_epi16(v, 7); },
+#	if (GTL__BIT_PACK_AVX2)
+				[](__m256i v) { return _mm256_slli_epi16(v, 7); }
+#	else
+				nullptr
+#	endif
+			);
+		}
+
+		size_t PackBitsThreshold_SIMD(uint8_t const* src, size_t nPixel, uint8_t threshold, uint8_t* packed) {
+			// v >= threshold : max(v, threshold) == v
+			__m128i const thr128 = _mm_set1_epi8((char)threshold);
+#	if (GTL__BIT_PACK_AVX2)
+			__m256i const thr256 = _mm256_set1_epi8((char)threshold);
+#	endif
+			return PackMSB_SIMD(src, nPixel, packed,
+				[&](__m128i v) { return _mm_cmpeq_epi8(_mm_max_epu8(v, thr128), v); },
+#	if (GTL__BIT_PACK_AVX2)
+				[&](__m256i v) { return _mm256_cmpeq_epi8(_mm256_max_epu8(v, thr256), v); }
+#	else
+				nullptr
+#	endif
+			);
+		}
+
+		size_t PackBits2_SIMD(uint8_t const* src, size_t nPixel, uint8_t* packed) {
+			__m128i const mask = _mm_set1_epi8(0x03);
+			__m128i const mask16 = _mm_set1_epi16(0x00ff);
+			__m128i const mask32 = _mm_set1_epi32(0x0000ffff);
+			// 16 pixels -> 4 bytes in 32 bit lanes
+			auto Pack16 = [&](uint8_t const* p) {
+				__m128i v = _mm_and_si128(_mm_loadu_si128((__m128i const*)p), mask);
+				v = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, mask16), 2), _mm_srli_epi16(v, 8));
+				return _mm_or_si128(_mm_slli_epi32(_mm_and_si128(v, mask32), 4), _mm_srli_epi32(v, 16));
+			};
+			size_t x{};
+			for (; x + 64 <= nPixel; x += 64) {
+				__m128i a = _mm_packs_epi32(Pack16(src + x + 0), Pack16(src + x + 16));
+				__m128i b = _mm_packs_epi32(Pack16(src + x + 32), Pack16(src + x + 48));
+				_mm_storeu_si128((__m128i*)(packed + x / 4), _mm_packus_epi16(a, b));
+			}
+			return x;
+		}
+
+		size_t PackBits4_SIMD(uint8_t const* src, size_t nPixel, uint8_t* packed) {
+			size_t x{};
+#	if (GTL__BIT_PACK_AVX2)
+			{
+				__m256i const mask = _mm256_set1_epi8(0x0f);
+				__m256i const mask16 = _mm256_set1_epi16(0x00ff);
+				auto Pack32 = [&](uint8_t const* p) {
+					__m256i v = _mm256_and_si256(_mm256_loadu_si256((__m256i const*)p), mask);
+					return _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(v, mask16), 4), _mm256_srli_epi16(v, 8));
+				};
+				for (; x + 64 <= nPixel; x += 64) {
+					// packus works on 128 bit lanes
+					__m256i v = _mm256_packus_epi16(Pack32(src + x), Pack32(src + x + 32));
+					_mm256_storeu_si256((__m256i*)(packed + x / 2), _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0)));
+				}
+			}
+#	endif
+			__m128i const mask = _mm_set1_epi8(0x0f);
+			__m128i const mask16 = _mm_set1_epi16(0x00ff);
+			// 16 pixels -> 8 bytes in 16 bit lanes
+			auto Pack16 = [&](uint8_t const* p) {
+				__m128i v = _mm_and_si128(_mm_loadu_si128((__m128i const*)p), mask);
+				return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, mask16), 4), _mm_srli_epi16(v, 8));
+			};
+			for (; x + 32 <= nPixel; x += 32) {
+				_mm_storeu_si128((__m128i*)(packed + x / 2), _mm_packus_epi16(Pack16(src + x), Pack16(src + x + 16)));
+			}
+			return x;
+		}
+
+		/// @brief lut : nullable
+		size_t UnpackBits1_SIMD(uint8_t const* packed, size_t nPixel, uint8_t const* lut, uint8_t* dst) {
+			size_t x{};
+			uint8_t const v0 = lut ? lut[0] : 0, v1 = lut ? lut[1] : 1;
+#	if (GTL__BIT_PACK_AVX2)
+			{
+				// each byte of 4 bytes -> 8 lanes
+				__m256i const idx = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+				__m256i const bits = _mm256_set1_epi64x(0x0102040810204080);
+				__m256i const c0 = _mm256_set1_epi8((char)v0), c1 = _mm256_set1_epi8((char)v1);
+				for (; x + 32 <= nPixel; x += 32) {
+					uint32_t b;
+					std::memcpy(&b, packed + x / 8, sizeof(b));
+					__m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32((int)b), idx);
+					__m256i m = _mm256_cmpeq_epi8(_mm256_and_si256(v, bits), bits);
+					_mm256_storeu_si256((__m256i*)(dst + x), _mm256_blendv_epi8(c0, c1, m));
+				}
+			}
+#	endif
+			__m128i const bits = _mm_set1_epi64x(0x0102040810204080);
+			__m128i const c0 = _mm_set1_epi8((char)v0), c1 = _mm_set1_epi8((char)v1);
+			for (; x + 16 <= nPixel; x += 16) {
+				uint16_t b;
+				std::memcpy(&b, packed + x / 8, sizeof(b));
+				// b0 x 8, b1 x 8
+				__m128i v = _mm_cvtsi32_si128(b);
+				v = _mm_unpacklo_epi8(v, v);
+				v = _mm_unpacklo_epi16(v, v);
+				v = _mm_unpacklo_epi32(v, v);
+				__m128i m = _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+				_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_and_si128(m, c1), _mm_andnot_si128(m, c0)));
+			}
+			return x;
+		}
+
+		/// @brief lut (nullable) of 4 or 16 entries, applied to 16 indices
+		class xLUT16 {
+		protected:
+			uint8_t const* m_lut{};
+#	if (GTL__BIT_PACK_AVX2)
+			__m128i m_tbl{};
+#	endif
+		public:
+			xLUT16(uint8_t const* lut, int nEntry) : m_lut(lut) {
+#	if (GTL__BIT_PACK_AVX2)
+				if (lut) {
+					alignas(16) uint8_t tbl[16]{};
+					std::memcpy(tbl, lut, nEntry);
+					m_tbl = _mm_load_si128((__m128i const*)tbl);
+				}
+#	endif
+			}
+			void Store(uint8_t* dst, __m128i index) const {
+				if (!m_lut) {
+					_mm_storeu_si128((__m128i*)dst, index);
+					return;
+				}
+#	if (GTL__BIT_PACK_AVX2)
+				_mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi8(m_tbl, index));
+#	else
+				alignas(16) uint8_t indices[16];
+				_mm_store_si128((__m128i*)indices, index);
+				for (int i{}; i < 16; i++)
+					dst[i] = m_lut[indices[i]];
+#	endif
+			}
+		};
+
+		size_t UnpackBits2_SIMD(uint8_t const* packed, size_t nPixel, uint8_t const* lut, uint8_t* dst) {
+			xLUT16 tbl(lut, 4);
+			__m128i const mask = _mm_set1_epi8(0x03);
+			size_t x{};
+			for (; x + 64 <= nPixel; x += 64) {
+				__m128i v = _mm_loadu_si128((__m128i const*)(packed + x / 4));
+				__m128i p0 = _mm_and_si128(_mm_srli_epi16(v, 6), mask);
+				__m128i p1 = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+				__m128i p2 = _mm_and_si128(_mm_srli_epi16(v, 2), mask);
+				__m128i p3 = _mm_and_si128(v, mask);
+				__m128i a = _mm_unpacklo_epi8(p0, p1), b = _mm_unpacklo_epi8(p2, p3);
+				tbl.Store(dst + x + 0, _mm_unpacklo_epi16(a, b));
+				tbl.Store(dst + x + 16, _mm_unpackhi_epi16(a, b));
+				a = _mm_unpackhi_epi8(p0, p1), b = _mm_unpackhi_epi8(p2, p3);
+				tbl.Store(dst + x + 32, _mm_unpacklo_epi16(a, b));
+				tbl.Store(dst + x + 48, _mm_unpackhi_epi16(a, b));
+			}
+			return x;
+		}
+
+		size_t UnpackBits4_SIMD(uint8_t const* packed, size_t nPixel, uint8_t const* lut, uint8_t* dst) {
+			xLUT16 tbl(lut, 16);
+			__m128i const mask = _mm_set1_epi8(0x0f);
+			size_t x{};
+			for (; x + 32 <= nPixel; x += 32) {
+				__m128i v = _mm_loadu_si128((__m128i const*)(packed + x / 2));
+				__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+				__m128i lo = _mm_and_si128(v, mask);
+				tbl.Store(dst + x + 0, _mm_unpacklo_epi8(hi, lo));
+				tbl.Store(dst + x + 16, _mm_unpackhi_epi8(hi, lo));
+			}
+			return x;
+		}
+
+#endif	// GTL__BIT_PACK_SSE2
+
+		/// @brief lut : nullable
+		bool Unpack(int nBPP, uint8_t const* packed, size_t nPixel, uint8_t const* lut, uint8_t* dst, bool bSIMD) {
+			size_t x{};
+			switch (nBPP) {
+			case 1 : case 2 : case 4 :
+				break;
+			case 8 :
+				if (lut) {
+					for (; x < nPixel; x++)
+						dst[x] = lut[packed[x]];
+				}
+				else if (nPixel)
+					std::memcpy(dst, packed, nPixel);
+				return true;
+			default :
+				return false;
+			}
+
+#if (GTL__BIT_PACK_SSE2)
+			if (bSIMD) {
+				switch (nBPP) {
+				case 1 : x = UnpackBits1_SIMD(packed, nPixel, lut, dst); break;
+				case 2 : x = UnpackBits2_SIMD(packed, nPixel, lut, dst); break;
+				case 4 : x = UnpackBits4_SIMD(packed, nPixel, lut, dst); break;
+				}
+			}
+#endif
+			UnpackBits_Scalar(nBPP, packed + x * nBPP / 8, nPixel - x, lut, dst + x);
+			return true;
+		}
+
+	}	// anonymous namespace
+
+	bool PackBits(int nBPP, uint8_t const* src, size_t nPixel, uint8_t* packed, bool bSIMD) {
+		size_t x{};
+		switch (nBPP) {
+		case 1 : case 2 : case 4 :
+			break;
+		case 8 :
+			if (nPixel)
+				std::memcpy(packed, src, nPixel);
+			return true;
+		default :
+			return false;
+		}
+
+#if (GTL__BIT_PACK_SSE2)
+		if (bSIMD) {
+			switch (nBPP) {
+			case 1 : x = PackBits1_SIMD(src, nPixel, packed); break;
+			case 2 : x = PackBits2_SIMD(src, nPixel, packed); break;
+			case 4 : x = PackBits4_SIMD(src, nPixel, packed); break;
+			}
+		}
+#endif
+		PackBits_Scalar(nBPP, src + x, nPixel - x, packed + x * nBPP / 8);
+		return true;
+	}
+
+	bool PackBitsLUT(int nBPP, uint8_t const* src, size_t nPixel, uint8_t const* lut, uint8_t* packed, bool bSIMD) {
+		if (nBPP == 8) {
+			for (size_t x{}; x < nPixel; x++)
+				packed[x] = lut[src[x]];
+			return true;
+		}
+		if ((nBPP != 1) and (nBPP != 2) and (nBPP != 4))
+			return false;
+
+		// looked up by chunk (multiple of 8 pixels, on byte boundary), then packed
+		std::array<uint8_t, 1024> indices;
+		for (size_t x{}; x < nPixel; x += indices.size()) {
+			size_t n = std::min(indices.size(), nPixel - x);
+			for (size_t i{}; i < n; i++)
+				indices[i] = lut[src[x + i]];
+			PackBits(nBPP, indices.data(), n, packed + x * nBPP / 8, bSIMD);
+		}
+		return true;
+	}
+
+	void PackBitsThreshold(uint8_t const* src, size_t nPixel, uint8_t threshold, uint8_t* packed, bool bSIMD) {
+		size_t x{};
+#if (GTL__BIT_PACK_SSE2)
+		if (bSIMD)
+			x = PackBitsThreshold_SIMD(src, nPixel, threshold, packed);
+#endif
+		PackBitsThreshold_Scalar(src + x, nPixel - x, threshold, packed + x / 8);
+	}
+
+	bool UnpackBits(int nBPP, uint8_t const* packed, size_t nPixel, uint8_t* dst, bool bSIMD) {
+		return Unpack(nBPP, packed, nPixel, nullptr, dst, bSIMD);
+	}
+
+	bool UnpackBitsLUT(int nBPP, uint8_t const* packed, size_t nPixel, uint8_t const* lut, uint8_t* dst, bool bSIMD) {
+		return Unpack(nBPP, packed, nPixel, lut, dst, bSIMD);
+	}
+
+}
@@ -0,0 +1,606 @@
+﻿#include "pch.h"
+
+#include "gtl/mat_container.h"
+
+#if defined(__AVX2__) and (defined(_M_X64) or defined(__x86_64__))
+#	define GTL__CRC32C_SSE42 1
+#	include <immintrin.h>
+#endif
+
+namespace gtl {
+
+	namespace internal {
+
+		//-----------------------------------------------------------------------------
+		// CRC-32C (Castagnoli). SSE4.2 crc32 instruction (implied by /arch:AVX2), table otherwise
+
+#if !(GTL__CRC32C_SSE42)
+		constexpr auto const s_tblCrc32C = [] {
+			std::array<uint32_t, 256> tbl{};
+			for (uint32_t i{}; i < 256; i++) {
+				uint32_t crc = i;
+				for (int b{}; b < 8; b++)
+					crc = (crc & 1) ? ((crc >> 1) ^ 0x82F6'3B78u) : (crc >> 1);
+				tbl[i] = crc;
+			}
+			return tbl;
+		}();
+#endif
+
+		uint32_t Crc32C(uint32_t crc, uint8_t const* data, size_t size) {
+			crc = ~crc;
+#if (GTL__CRC32C_SSE42)
+			uint64_t crc64 = crc;
+			for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), data += sizeof(uint64_t)) {
+				uint64_t v;
+				std::memcpy(&v, data, sizeof(v));
+				crc64 = _mm_crc32_u64(crc64, v);
+			}
+			crc = (uint32_t)crc64;
+			for (; size; size--)
+				crc = _mm_crc32_u8(crc, *data++);
+#else
+			for (; size; size--)
+				crc = s_tblCrc32C[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+#endif
+			return ~crc;
+		}
+
+		//-----------------------------------------------------------------------------
+		// RLE : control byte c
+		//		c < 128 : (c+1) literal bytes follow
+		//		c >= 128 : next byte is repeated (c-125) times (3 ~ 130)
+
+		size_t EncodeRLE(uint8_t const* src, size_t size, uint8_t* dst, size_t sizeDst) {
+			size_t i{}, o{};
+			while (i < size) {
+				size_t run{1};
+				while ((i + run < size) and (run < 130) and (src[i + run] == src[i]))
+					run++;
+				if (run >= 3) {
+					if (o + 2 > sizeDst)
+						return 0;
+					dst[o++] = (uint8_t)(128 + run - 3);
+					dst[o++] = src[i];
+					i += run;
+					continue;
+				}
+				// literals, until next run
+				size_t const start = i;
+				size_t n{};
+				for (; (i < size) and (n < 128); i++, n++) {
+					if ((i + 2 < size) and (src[i] == src[i + 1]) and (src[i] == src[i + 2]))
+						break;
+				}
+				if (o + 1 + n > sizeDst)
+					return 0;
+				dst[o++] = (uint8_t)(n - 1);
+				std::memcpy(dst + o, src + start, n);
+				o += n;
+			}
+			return o;
+		}
+
+		bool DecodeRLE(uint8_t const* src, size_t size, uint8_t* dst, size_t sizeDst) {
+			size_t i{}, o{};
+			while (i < size) {
+				uint8_t c = src[i++];
+				if (c < 128) {
+					size_t n = c + 1;
+					if ((n > size - i) or (n > sizeDst - o))
+						return false;
+					std::memcpy(dst + o, src + i, n);
+					i += n;
+					o += n;
+				}
+				else {
+					size_t n = c - 125;
+					if ((i >= size) or (n > sizeDst - o))
+						return false;
+					std::memset(dst + o, src[i++], n);
+					o += n;
+				}
+			}
+			return o == sizeDst;
+		}
+
+		//-----------------------------------------------------------------------------
+		// LZ : sequences of LZ4 block format.
+		//		token (literal length : 4 bits, match length - 4 : 4 bits), [length bytes], literals, offset (uint16), [length bytes]
+		//		last sequence has literals only. last 5 bytes are always literals.
+
+		constexpr static int const s_nLZHashBits = 14;
+		constexpr static size_t const s_nLZMinMatch = 4;
+		constexpr static size_t const s_nLZLastLiterals = 5;
+		constexpr static size_t const s_nLZMatchStartLimit = 12;
+
+		inline uint32_t Read32(uint8_t const* p) {
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		size_t EncodeLZ(uint8_t const* src, size_t size, uint8_t* dst, size_t sizeDst) {
+			thread_local std::vector<uint32_t> table;
+			table.assign((size_t)1 << s_nLZHashBits, 0);
+
+			size_t op{};
+			auto PutLength = [&](size_t len) {
+				for (; len >= 255; len -= 255)
+					dst[op++] = 255;
+				dst[op++] = (uint8_t)len;
+			};
+			// nMatch == 0 : last sequence
+			auto Emit = [&](uint8_t const* literal, size_t nLiteral, size_t offset, size_t nMatch) -> bool {
+				size_t const ml = nMatch ? nMatch - s_nLZMinMatch : 0;
+				size_t const need = 1 + (nLiteral / 255 + 1) + nLiteral + (nMatch ? 2 + (ml / 255 + 1) : 0);
+				if (need > sizeDst - op)
+					return false;
+				dst[op++] = (uint8_t)((std::min<size_t>(nLiteral, 15) << 4) | std::min<size_t>(ml, 15));
+				if (nLiteral >= 15)
+					PutLength(nLiteral - 15);
+				std::memcpy(dst + op, literal, nLiteral);
+				op += nLiteral;
+				if (!nMatch)
+					return true;
+				dst[op++] = (uint8_t)(offset & 0xff);
+				dst[op++] = (uint8_t)(offset >> 8);
+				if (ml >= 15)
+					PutLength(ml - 15);
+				return true;
+			};
+
+			size_t ip{}, anchor{};
+			if (size > s_nLZMatchStartLimit) {
+				size_t const ipLimit = size - s_nLZMatchStartLimit;
+				size_t const matchLimit = size - s_nLZLastLiterals;
+				while (ip < ipLimit) {
+					uint32_t const seq = Read32(src + ip);
+					uint32_t const h = (seq * 2654435761u) >> (32 - s_nLZHashBits);
+					size_t const ref = table[h];
+					table[h] = (uint32_t)ip;
+					if ((ref < ip) and (ip - ref <= 0xffff) and (Read32(src + ref) == seq)) {
+						size_t len = s_nLZMinMatch;
+						for (; ip + len + sizeof(uint64_t) <= matchLimit; len += sizeof(uint64_t)) {
+							uint64_t a, b;
+							std::memcpy(&a, src + ref + len, sizeof(a));
+							std::memcpy(&b, src + ip + len, sizeof(b));
+							if (a != b) {
+								len += std::countr_zero(a ^ b) / 8;	// little endian
+								break;
+							}
+						}
+						if (ip + len + sizeof(uint64_t) > matchLimit) {
+							while ((ip + len < matchLimit) and (src[ref + len] == src[ip + len]))
+								len++;
+						}
+						if (!Emit(src + anchor, ip - anchor, ip - ref, len))
+							return 0;
+						ip += len;
+						anchor = ip;
+					}
+					else {
+						// skips faster on incompressible data
+						ip += 1 + ((ip - anchor) >> 6);
+					}
+				}
+			}
+			if (!Emit(src + anchor, size - anchor, 0, 0))
+				return 0;
+			return op;
+		}
+
+		bool DecodeLZ(uint8_t const* src, size_t size, uint8_t* dst, size_t sizeDst) {
+			size_t ip{}, op{};
+			auto AddLength = [&](size_t& len) -> bool {
+				uint8_t b;
+				do {
+					if (ip >= size)
+						return false;
+					b = src[ip++];
+					len += b;
+				} while (b == 255);
+				return true;
+			};
+			while (ip < size) {
+				uint8_t const token = src[ip++];
+				size_t nLiteral = token >> 4;
+				if ((nLiteral == 15) and !AddLength(nLiteral))
+					return false;
+				if ((nLiteral > size - ip) or (nLiteral > sizeDst - op))
+					return false;
+				std::memcpy(dst + op, src + ip, nLiteral);
+				ip += nLiteral;
+				op += nLiteral;
+				if (ip == size)
+					break;	// last sequence
+
+				if (size - ip < 2)
+					return false;
+				size_t const offset = src[ip] | (src[ip + 1] << 8);
+				ip += 2;
+				if ((offset == 0) or (offset > op))
+					return false;
+				size_t nMatch = token & 0x0f;
+				if ((nMatch == 15) and !AddLength(nMatch))
+					return false;
+				nMatch += s_nLZMinMatch;
+				if (nMatch > sizeDst - op)
+					return false;
+				uint8_t const* ref = dst + op - offset;
+				// overlapped (offset < nMatch) : repeating pattern. copied span doubles.
+				for (size_t done{}; done < nMatch; ) {
+					size_t n = std::min(nMatch - done, offset + done);
+					std::memcpy(dst + op + done, ref, n);
+					done += n;
+				}
+				op += nMatch;
+			}
+			return op == sizeDst;
+		}
+
+	}	// namespace internal
+
+
+	//-----------------------------------------------------------------------------
+	// mat block
+
+	namespace {
+
+		struct sEncodedMatBlock {
+			sMatBlockHeader header{};
+			std::vector<sMatChunk> chunks;
+			std::vector<std::vector<uint8_t>> data;
+
+			bool Write(std::ostream& os) const {
+				os.write((char const*)&header, sizeof(header));
+				if (!chunks.empty())
+					os.write((char const*)chunks.data(), chunks.size() * sizeof(chunks[0]));
+				for (auto const& d : data)
+					os.write((char const*)d.data(), d.size());
+				return (bool)os;
+			}
+			uint64_t size() const { return sizeof(header) + chunks.size() * sizeof(sMatChunk) + header.sizeData; }
+		};
+
+		bool EncodeMatBlock(cv::Mat const& mat, sMatCodecOption const& option, sEncodedMatBlock& block) {
+			if (mat.dims > 2)
+				return false;
+			auto& header = block.header;
+			header = {};
+			std::ranges::copy(sMatBlockHeader::s_magic, header.magic);
+			header.version = sMatBlockHeader::s_version;
+			header.rows = mat.rows;
+			header.cols = mat.cols;
+			header.type = mat.type();
+			header.codec = option.codec;
+			header.bChecksum = option.bChecksum;
+			if (mat.empty())
+				return true;
+
+			size_t const sizeRow = mat.cols * mat.elemSize();
+			if (sizeRow > std::numeric_limits<uint32_t>::max())
+				return false;
+			size_t rowsPerChunk = std::clamp<size_t>(option.nChunkSize / sizeRow, 1, std::numeric_limits<uint32_t>::max() / sizeRow);
+			header.rowsPerChunk = (int32_t)std::min<size_t>(rowsPerChunk, mat.rows);
+			header.nChunk = (mat.rows + header.rowsPerChunk - 1) / header.rowsPerChunk;
+
+			block.chunks.assign(header.nChunk, sMatChunk{});
+			block.data.assign(header.nChunk, {});
+			cv::parallel_for_(cv::Range(0, header.nChunk), [&](cv::Range const& range) {
+				std::vector<uint8_t> rows;
+				for (int i = range.start; i < range.end; i++) {
+					int y0 = i * header.rowsPerChunk;
+					int y1 = std::min(y0 + header.rowsPerChunk, mat.rows);
+					size_t const sizeRaw = (y1 - y0) * sizeRow;
+					uint8_t const* raw = mat.ptr(y0);
+					if (!mat.isContinuous()) {
+						rows.resize(sizeRaw);
+						for (int y = y0; y < y1; y++)
+							std::memcpy(rows.data() + (y - y0) * sizeRow, mat.ptr(y), sizeRow);
+						raw = rows.data();
+					}
+
+					auto& chunk = block.chunks[i];
+					auto& data = block.data[i];
+					chunk.crc = option.bChecksum ? internal::Crc32C(0, raw, sizeRaw) : 0;
+					data.resize(sizeRaw);
+					size_t len{};
+					switch (option.codec) {
+					case eMAT_CODEC::rle : len = internal::EncodeRLE(raw, sizeRaw, data.data(), data.size()); break;
+					case eMAT_CODEC::lz : len = internal::EncodeLZ(raw, sizeRaw, data.data(), data.size()); break;
+					default : break;
+					}
+					if (len and (len < sizeRaw)) {
+						chunk.codec = option.codec;
+						data.resize(len);
+					}
+					else {
+						chunk.codec = eMAT_CODEC::none;
+						std::memcpy(data.data(), raw, sizeRaw);
+					}
+					chunk.sizeEncoded = (uint32_t)data.size();
+				}
+			});
+
+			for (auto const& d : block.data)
+				header.sizeData += d.size();
+			return true;
+		}
+
+		/// @brief validates header, returns size of chunk table + encoded data. (nullopt if broken)
+		std::optional<uint64_t> GetMatBlockBodySize(sMatBlockHeader const& header) {
+			if (std::memcmp(header.magic, sMatBlockHeader::s_magic, sizeof(header.magic)) != 0)
+				return {};
+			if ( (header.version != sMatBlockHeader::s_version) or (header.rows < 0) or (header.cols < 0) )
+				return {};
+			if ( (header.rows == 0) or (header.cols == 0) ) {
+				if (header.nChunk or header.sizeData)
+					return {};
+				return 0;
+			}
+			if ( !IsValidMatType(header.type) or (header.rowsPerChunk <= 0)
+				or (header.nChunk != (uint32_t)((header.rows + header.rowsPerChunk - 1) / header.rowsPerChunk)) )
+				return {};
+			// encoded chunk is not larger than raw
+			uint64_t const nPixel = (uint64_t)header.rows * header.cols;
+			uint64_t const sizeElem = CV_ELEM_SIZE(header.type);
+			if (nPixel > std::numeric_limits<uint64_t>::max() / sizeElem)
+				return {};
+			uint64_t const sizeRaw = nPixel * sizeElem;
+			if (header.sizeData > sizeRaw)
+				return {};
+			return header.nChunk * sizeof(sMatChunk) + header.sizeData;
+		}
+
+		bool DecodeMatBlock(sMatBlockHeader const& header, std::span<uint8_t const> body, cv::Mat& mat) {
+			auto sizeBody = GetMatBlockBodySize(header);
+			if (!sizeBody or (*sizeBody != body.size()))
+				return false;
+			if ( (header.rows == 0) or (header.cols == 0) ) {
+				mat.release();
+				return true;
+			}
+
+			std::vector<sMatChunk> chunks(header.nChunk);
+			std::memcpy(chunks.data(), body.data(), chunks.size() * sizeof(sMatChunk));
+			std::vector<uint64_t> offsets(chunks.size() + 1);
+			offsets[0] = chunks.size() * sizeof(sMatChunk);
+			for (size_t i{}; i < chunks.size(); i++)
+				offsets[i + 1] = offsets[i] + chunks[i].sizeEncoded;
+			if (offsets.back() != body.size())
+				return false;
+
+			mat.create(header.rows, header.cols, header.type);
+			size_t const sizeRow = mat.cols * mat.elemSize();
+			std::atomic<bool> bOK{true};
+			cv::parallel_for_(cv::Range(0, header.nChunk), [&](cv::Range const& range) {
+				for (int i = range.start; (i < range.end) and bOK; i++) {
+					int y0 = i * header.rowsPerChunk;
+					int y1 = std::min(y0 + header.rowsPerChunk, header.rows);
+					size_t const sizeRaw = (y1 - y0) * sizeRow;
+					uint8_t* raw = mat.ptr(y0);
+					auto const& chunk = chunks[i];
+					uint8_t const* src = body.data() + offsets[i];
+					bool bDecoded{};
+					switch (chunk.codec) {
+					case eMAT_CODEC::none :
+						bDecoded = (chunk.sizeEncoded == sizeRaw);
+						if (bDecoded)
+							std::memcpy(raw, src, sizeRaw);
+						break;
+					case eMAT_CODEC::rle : bDecoded = internal::DecodeRLE(src, chunk.sizeEncoded, raw, sizeRaw); break;
+					case eMAT_CODEC::lz : bDecoded = internal::DecodeLZ(src, chunk.sizeEncoded, raw, sizeRaw); break;
+					}
+					if (bDecoded and header.bChecksum)
+						bDecoded = (internal::Crc32C(0, raw, sizeRaw) == chunk.crc);
+					if (!bDecoded)
+						bOK = false;
+				}
+			});
+			if (!bOK)
+				mat.release();
+			return bOK;
+		}
+
+	}	// anonymous namespace
+
+	bool WriteMatBlock(std::ostream& os, cv::Mat const& mat, sMatCodecOption const& option) {
+		sEncodedMatBlock block;
+		if (!EncodeMatBlock(mat, option, block))
+			return false;
+		return block.Write(os);
+	}
+
+	bool ReadMatBlock(std::istream& is, cv::Mat& mat) {
+		sMatBlockHeader header{};
+		if (!is.read((char*)&header, sizeof(header)))
+			return false;
+		auto sizeBody = GetMatBlockBodySize(header);
+		if (!sizeBody or (*sizeBody > std::numeric_limits<size_t>::max()))
+			return false;
+		std::vector<uint8_t> body(*sizeBody);
+		if (!body.empty() and !is.read((char*)body.data(), body.size()))
+			return false;
+		return DecodeMatBlock(header, body, mat);
+	}
+
+
+	//-----------------------------------------------------------------------------
+	// CMatContainerFile
+
+	bool CMatContainerFile::Create(std::filesystem::path const& path, sMatCodecOption const& option) {
+		Close();
+		std::scoped_lock lock(m_mtx);
+		m_file.open(path, std::ios_base::in | std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (!m_file)
+			return false;
+		m_bReadOnly = false;
+		m_option = option;
+		m_header = {};
+		std::ranges::copy(s_magic, m_header.magic);
+		m_header.version = s_version;
+		m_offsetEnd = sizeof(m_header);
+		if (!WriteHeader()) {
+			m_file.close();
+			return false;
+		}
+		return true;
+	}
+
+	bool CMatContainerFile::Open(std::filesystem::path const& path, bool bReadOnly, sMatCodecOption const& option) {
+		Close();
+		std::scoped_lock lock(m_mtx);
+		m_file.open(path, bReadOnly ? (std::ios_base::in | std::ios_base::binary) : (std::ios_base::in | std::ios_base::out | std::ios_base::binary));
+		if (!m_file)
+			return false;
+		m_bReadOnly = bReadOnly;
+		m_option = option;
+
+		auto Fail = [&] {
+			m_file.close();
+			m_index.clear();
+			return false;
+		};
+		if ( !m_file.read((char*)&m_header, sizeof(m_header))
+			or (std::memcmp(m_header.magic, s_magic, sizeof(m_header.magic)) != 0)
+			or (m_header.version != s_version) )
+			return Fail();
+
+		if (m_header.offsetIndex) {
+			// index must be in the file
+			m_file.seekg(0, std::ios_base::end);
+			uint64_t const sizeFile = (uint64_t)m_file.tellg();
+			if ( (m_header.offsetIndex < sizeof(m_header)) or (m_header.offsetIndex > sizeFile)
+				or (m_header.nMat > (sizeFile - m_header.offsetIndex) / sizeof(m_index[0])) )
+				return Fail();
+			m_index.resize(m_header.nMat);
+			m_file.seekg(m_header.offsetIndex);
+			if (!m_index.empty() and !m_file.read((char*)m_index.data(), m_index.size() * sizeof(m_index[0])))
+				return Fail();
+			m_offsetEnd = m_header.offsetIndex;
+		}
+		else {
+			// no index. scan blocks
+			uint64_t offset = sizeof(m_header);
+			while (true) {
+				sMatBlockHeader header{};
+				m_file.seekg(offset);
+				if (!m_file.read((char*)&header, sizeof(header)))
+					break;
+				auto sizeBody = GetMatBlockBodySize(header);
+				if (!sizeBody)
+					break;
+				m_index.push_back(offset);
+				offset += sizeof(header) + *sizeBody;
+			}
+			m_file.clear();
+			// last one may be written partially
+			m_file.seekg(0, std::ios_base::end);
+			if (!m_index.empty() and (offset > (uint64_t)m_file.tellg())) {
+				offset = m_index.back();
+				m_index.pop_back();
+			}
+			m_offsetEnd = offset;
+			m_bIndexDirty = !m_bReadOnly;
+		}
+		return true;
+	}
+
+	void CMatContainerFile::Close() {
+		Flush();
+		std::scoped_lock lock(m_mtx);
+		if (m_file.is_open())
+			m_file.close();
+		m_file.clear();
+		m_index.clear();
+		m_header = {};
+		m_offsetEnd = 0;
+		m_bIndexDirty = false;
+	}
+
+	bool CMatContainerFile::Flush() {
+		std::scoped_lock lock(m_mtx);
+		if (!m_file.is_open() or m_bReadOnly)
+			return false;
+		if (m_bIndexDirty) {
+			m_file.seekp(m_offsetEnd);
+			if (!m_index.empty())
+				m_file.write((char const*)m_index.data(), m_index.size() * sizeof(m_index[0]));
+			m_header.offsetIndex = m_offsetEnd;
+			m_header.nMat = m_index.size();
+			if (!WriteHeader())
+				return false;
+			m_bIndexDirty = false;
+		}
+		m_file.flush();
+		return (bool)m_file;
+	}
+
+	bool CMatContainerFile::WriteHeader() {
+		m_file.seekp(0);
+		m_file.write((char const*)&m_header, sizeof(m_header));
+		return (bool)m_file;
+	}
+
+	bool CMatContainerFile::Add(cv::Mat const& mat) {
+		sMatCodecOption option;
+		{
+			std::scoped_lock lock(m_mtx);
+			if (!m_file.is_open() or m_bReadOnly)
+				return false;
+			option = m_option;
+		}
+		sEncodedMatBlock block;
+		if (!EncodeMatBlock(mat, option, block))
+			return false;
+
+		std::scoped_lock lock(m_mtx);
+		if (!m_file.is_open())
+			return false;
+		m_file.clear();
+		if (m_header.offsetIndex) {
+			// index on file is to be overwritten. (blocks are scanned on Open() until new index is written)
+			m_header.offsetIndex = 0;
+			m_header.nMat = 0;
+			if (!WriteHeader())
+				return false;
+		}
+		m_file.seekp(m_offsetEnd);
+		if (!block.Write(m_file))
+			return false;
+		m_index.push_back(m_offsetEnd);
+		m_offsetEnd += block.size();
+		m_bIndexDirty = true;
+		return true;
+	}
+
+	bool CMatContainerFile::Get(size_t index, cv::Mat& mat) const {
+		sMatBlockHeader header{};
+		std::vector<uint8_t> body;
+		{
+			std::scoped_lock lock(m_mtx);
+			if (!m_file.is_open() or (index >= m_index.size()))
+				return false;
+			m_file.clear();
+			m_file.seekg(m_index[index]);
+			if (!m_file.read((char*)&header, sizeof(header)))
+				return false;
+			auto sizeBody = GetMatBlockBodySize(header);
+			if (!sizeBody)
+				return false;
+			body.resize(*sizeBody);
+			if (!body.empty() and !m_file.read((char*)body.data(), body.size()))
+				return false;
+		}
+		// decoded out of lock
+		return DecodeMatBlock(header, body, mat);
+	}
+
+	cv::Mat CMatContainerFile::Get(size_t index) const {
+		cv::Mat mat;
+		Get(index, mat);
+		return mat;
+	}
+
+}
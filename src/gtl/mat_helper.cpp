@@ -3,6 +3,7 @@
 #include <chrono>
 
 #include "gtl/mat_helper.h"
+#include "gtl/bit_pack.h"
 
 #include <windows.h>
 
@@ -106,6 +107,44 @@ namespace gtl {
 		return true;
 	}
 
+	namespace {
+		/// @brief deallocates UMatData only. data is owned by UMatData::userdata (std::shared_ptr<void const>*)
+		class xOwnerMatAllocator : public cv::MatAllocator {
+		public:
+			cv::UMatData* allocate(int, const int*, int, void*, size_t*, cv::AccessFlag, cv::UMatUsageFlags) const override { return nullptr; }
+			bool allocate(cv::UMatData*, cv::AccessFlag, cv::UMatUsageFlags) const override { return false; }
+			void deallocate(cv::UMatData* u) const override {
+				if (!u)
+					return;
+				CV_Assert(u->urefcount == 0 and u->refcount == 0);
+				delete (std::shared_ptr<void const>*)u->userdata;
+				delete u;
+			}
+		};
+	}
+
+	cv::Mat AttachMatOwner(cv::Mat const& img, std::shared_ptr<void const> owner) {
+		static xOwnerMatAllocator allocator;
+		if (img.empty())
+			return {};
+		if (img.u) {
+			// already reference counted. keeps both.
+			struct sHolder { cv::Mat img; std::shared_ptr<void const> owner; };
+			owner = std::make_shared<sHolder>(img, std::move(owner));
+		}
+
+		auto* u = new cv::UMatData(&allocator);
+		u->data = u->origdata = const_cast<uchar*>(img.datastart);
+		u->size = img.dataend - img.datastart;
+		u->flags = cv::UMatData::USER_ALLOCATED;
+		u->userdata = new std::shared_ptr<void const>(std::move(owner));
+		u->refcount = 1;
+
+		cv::Mat m(img.dims, img.size.p, img.type(), const_cast<uchar*>(img.data), img.step.p);
+		m.u = u;
+		return m;
+	}
+
 	bool ResizeImage(cv::Mat const& imgSrc, cv::Mat& imgDest, double dScale, int eInterpolation) {
 		try {
 			//#ifdef HAVE_CUDA
@@ -285,126 +324,107 @@ namespace gtl {
 
 	namespace internal {
 
+		/// @brief each worker packs a band of rows and writes it at its own offset of the (pre-sized) file. no ordering between workers.
+		/// rows of bottom-up bitmap are written upside down, so no flip is needed.
+		template < typename telement, typename TPackRow >
+		bool MatToBitmapPixels(std::filesystem::path const& path, uint64_t offsetData, int width32, cv::Mat const& img, bool bFlipY, TPackRow const& PackRow, callback_progress_t const& funcCallback) {
+			HANDLE hFile = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (hFile == INVALID_HANDLE_VALUE)
+				return false;
+			xFinalAction faClose([hFile]{ CloseHandle(hFile); });
+			LARGE_INTEGER li{};
+			li.QuadPart = offsetData + (uint64_t)width32 * img.rows;
+			if (!SetFilePointerEx(hFile, li, nullptr, FILE_BEGIN) or !SetEndOfFile(hFile))
+				return false;
+
+			// about 4MB a band
+			int const nRowBand = std::clamp((4 << 20) / width32, 1, img.rows);
+			auto nCPUDetected = std::thread::hardware_concurrency();
+			auto nThread = std::min((uint)(img.rows + nRowBand - 1) / nRowBand, (nCPUDetected <= 0) ? 2 : nCPUDetected);
+
+			std::atomic<int> yNext{}, nDone{};
+			std::atomic<bool> bStop{}, bError{};
+			{
+				std::vector<std::jthread> threads;
+				threads.reserve(nThread);
+				for (uint i{}; i < nThread; i++) {
+					threads.emplace_back([&] {
+						std::vector<uint8> band((size_t)width32 * nRowBand, 0);
+						for (int y0{}; !bStop and ((y0 = yNext.fetch_add(nRowBand)) < img.rows); ) {
+							int y1 = std::min(y0 + nRowBand, img.rows);
+							// file rows [yFile0, yFile0 + (y1-y0))
+							int yFile0 = bFlipY ? img.rows - y1 : y0;
+							for (int y{y0}; y < y1; y++) {
+								int iLine = bFlipY ? (y1-1-y) : (y-y0);
+								PackRow(y, std::span<uint8>(band.data() + (size_t)iLine * width32, width32), img.ptr<telement>(y));
+							}
+							OVERLAPPED ov{};
+							uint64_t offset = offsetData + (uint64_t)yFile0 * width32;
+							ov.Offset = (DWORD)offset;
+							ov.OffsetHigh = (DWORD)(offset >> 32);
+							DWORD len = (DWORD)((size_t)(y1-y0) * width32);
+							DWORD written{};
+							if (!WriteFile(hFile, band.data(), len, &written, &ov) or (written != len)) {
+								bError = bStop = true;
+							}
+							nDone += y1 - y0;
+							nDone.notify_one();
+						}
+					});
+				}
+
+				// progress (and cancel) on this thread. (100% is reported too)
+				int iPercent{};
+				for (int done{}; !bError; nDone.wait(done)) {
+					done = nDone;
+					int iPercentNew = (int)((int64_t)done * 100 / std::max(1, img.rows));
+					if (funcCallback and (iPercent != iPercentNew)) {
+						iPercent = iPercentNew;
+						if (!funcCallback(iPercent, false, false)) {
+							bStop = true;
+							break;
+						}
+					}
+					if (done >= img.rows)
+						break;
+				}
+			}
+			return !bStop;
+		}
+
+		/// @brief writes pixel array of img to f.
+		/// @param pathPositional : path of f. if given (and bMultiThreaded), written by MatToBitmapPixels(). otherwise row by row to f.
+		/// @param bFlipY : rows are written from the last one (bottom-up bitmap)
 		template < bool bNoPaletteLookup, bool bBytePacking, typename telement = uint8, bool bLoopUnrolling = true, bool bMultiThreaded = true >
-		bool MatToBitmapFile(std::ostream& f, cv::Mat const& img, int nBPP, std::vector<telement> const& pal, callback_progress_t funcCallback) {
+		bool MatToBitmapFile(std::ostream& f, cv::Mat const& img, int nBPP, std::vector<telement> const& pal, callback_progress_t funcCallback,
+			std::filesystem::path const& pathPositional = {}, uint64_t offsetData = 0, bool bFlipY = false)
+		{
 
 			int width32 = (img.cols * nBPP + 31) / 32 * 4;
 			int pixel_per_byte = (8/nBPP);
-			int nColPixel = pixel_per_byte ? img.cols/ pixel_per_byte * pixel_per_byte : img.cols;
 
-			using Func_PackSingleRow = std::function<void(int y, std::vector<uint8>& line, telement const* ptr, std::vector<telement> const& pal)>;
+			using Func_PackSingleRow = std::function<void(int y, std::span<uint8> line, telement const* ptr, std::vector<telement> const& pal)>;
 			Func_PackSingleRow PackSingleRow;
 
 			if constexpr (bBytePacking) {
-				if constexpr (bLoopUnrolling) {
-
-					switch (nBPP) {
-					case 1 :
-						PackSingleRow = [img_cols = img.cols, nBPP, pixel_per_byte, nColPixel](int y, std::vector<uint8>& line, telement const* ptr, std::vector<telement> const& pal) {
-							int x{};
-							for (; x < nColPixel; x += pixel_per_byte) {
-								int col = x / pixel_per_byte;
-								if constexpr (bNoPaletteLookup) {
-									line[col] = (ptr[x + 0] << 7) | (ptr[x + 1] << 6) | (ptr[x + 2] << 5) | (ptr[x + 3] << 4) | (ptr[x + 4] << 3) | (ptr[x + 5] << 2) | (ptr[x + 6] << 1) | (ptr[x + 7]);
-								}
-								else {
-									line[col] = (pal[ptr[x + 0]] << 7) | (pal[ptr[x + 1]] << 6) | (pal[ptr[x + 2]] << 5) | (pal[ptr[x + 3]] << 4) | (pal[ptr[x + 4]] << 3) | (pal[ptr[x + 5]] << 2) | (pal[ptr[x + 6]] << 1) | (pal[ptr[x + 7]]);
-								}
-							}
-							int col = x / pixel_per_byte;
-							if (col < line.size())
-								line[col] = 0;
-							for (int shift{ 8-nBPP }; x < img_cols; x++, shift--) {
-								if constexpr (bNoPaletteLookup) {
-									line[col] |= ptr[x] << shift;
-								}
-								else {
-									line[col] |= pal[ptr[x]] << shift;
-								}
-							}
-						};
-						break;
-					case 4 :
-						PackSingleRow = [img_cols = img.cols, nBPP, pixel_per_byte, nColPixel](int y, std::vector<uint8>& line, telement const* ptr, std::vector<telement> const& pal) {
-							int x{};
-							for (; x < nColPixel; x += pixel_per_byte) {
-								int col = x / pixel_per_byte;
-								if constexpr (bNoPaletteLookup) {
-									line[col] = (ptr[x + 0] << 4) | (ptr[x + 1] << 0);
-								}
-								else {
-									line[col] = (pal[ptr[x + 0]] << 4) | (pal[ptr[x + 1]] << 0);
-								}
-							}
-							int col = x / pixel_per_byte;
-							if (col < line.size())
-								line[col] = 0;
-							for (int shift{ 8-nBPP }; x < img_cols; x++, shift-=nBPP) {
-								if constexpr (bNoPaletteLookup) {
-									line[col] |= ptr[x] << shift;
-								}
-								else {
-									line[col] |= pal[ptr[x]] << shift;
-								}
-							}
-						};
-						break;
-					case 8 :
-						PackSingleRow = [img_cols = img.cols](int y, std::vector<uint8>& line, telement const* ptr, std::vector<telement> const& pal) {
-							for (int x{}; x < img_cols; x++) {
-								if constexpr (bNoPaletteLookup) {
-									line[x] = ptr[x];
-								}
-								else {
-									line[x] = pal[ptr[x]];
-								}
-							}
-						};
-						break;
-					default :
-						return false;
+				static_assert(std::is_same_v<telement, uint8>);
+				if ((nBPP != 1) and (nBPP != 4) and (nBPP != 8))
+					return false;
+				// SIMD kernels (bit_pack.h). plain loops if !bLoopUnrolling
+				PackSingleRow = [img_cols = img.cols, nBPP](int y, std::span<uint8> line, telement const* ptr, std::vector<telement> const& pal) {
+					if constexpr (bNoPaletteLookup) {
+						PackBits(nBPP, ptr, img_cols, line.data(), bLoopUnrolling);
 					}
-				}
-				else {
-					switch (nBPP) {
-					case 1 :
-					case 4 :
-						PackSingleRow = [img_cols = img.cols, nBPP, pixel_per_byte](int y, std::vector<uint8>& line, telement const* ptr, std::vector<telement> const& pal) {
-							std::memset(line.data(), 0, line.size()*sizeof(line[0]));
-							for (int x{}; x < img_cols; x++) {
-								int col = x / pixel_per_byte;
-								int shift = 8 - (nBPP * ((x%pixel_per_byte)+1));
-								if constexpr (bNoPaletteLookup) {
-									line[col] |= ptr[x] << shift;
-								}
-								else {
-									line[col] |= pal[ptr[x]] << shift;
-								}
-							}
-						};
-						break;
-					case 8 :
-						PackSingleRow = [img_cols = img.cols](int y, std::vector<uint8>& line, telement const* ptr, std::vector<telement> const& pal) {
-							for (int x{}; x < img_cols; x++) {
-								if constexpr (bNoPaletteLookup) {
-									line[x] = ptr[x];
-								}
-								else {
-									line[x] = pal[ptr[x]];
-								}
-							}
-						};
-						break;
-					default :
-						return false;
+					else {
+						PackBitsLUT(nBPP, ptr, img_cols, pal.data(), line.data(), bLoopUnrolling);
 					}
-				}
+				};
 			}	// if constexpr (bBytePacking)
 			else {
 				if (nBPP == 24) {
 					if (sizeof(telement) != 3)
 						return false;
-					PackSingleRow = [img_cols = img.cols, nBPP, pixel_per_byte](int y, std::vector<uint8>& line, telement const* ptr, std::vector<telement> const& pal) {
+					PackSingleRow = [img_cols = img.cols, nBPP, pixel_per_byte](int y, std::span<uint8> line, telement const* ptr, std::vector<telement> const& pal) {
 						telement* line3 = (telement*)line.data();
 						for (int x{}; x < img_cols; x++) {
 							if constexpr (bNoPaletteLookup) {
@@ -418,135 +438,33 @@ namespace gtl {
 				}
 			}
 
-			if constexpr (bMultiThreaded) {
-				auto nCPUDetected = std::thread::hardware_concurrency();
-				auto nThread = std::min((uint)img.rows, (nCPUDetected <= 0) ? 2 : nCPUDetected);
-
-				struct BUFFER {
-					std::atomic<int> y{-1};
-					std::atomic<bool> bReady{false};
-					std::vector<uint8> line;
-					//std::set<int> idsThread;
-
-					BUFFER() : y{-1} {}
-				};
-				size_t sizeBuffer = nThread*2;
-				std::mutex mtxBuffer;
-				std::vector<BUFFER> buffers(sizeBuffer);
-				for (auto& buf : buffers)
-					buf.line.assign(width32, 0);
-
-				std::atomic<int> yCur, yWritten;
-				bool bWritten{};
-
-				auto GetBuffer = [img_rows = img.rows, &mtxBuffer, &buffers, &yCur, &yWritten](std::stop_token stop) -> BUFFER* {
-					if (yCur >= img_rows)
-						return nullptr;
-					std::unique_lock lock(mtxBuffer);
-					auto y = yCur.fetch_add(1);
-					if (y >= img_rows)
-						return nullptr;
-					auto& buf = buffers[y % buffers.size()];
-					int yOld = buf.y;
-					while (yOld >= 0) {
-						buf.y.wait(yOld);
-						if (stop.stop_requested())
-							return nullptr;
-						yOld = buf.y;
-					}
-					buf.y = y;
-					buf.y.notify_one();
-
-					return &buf;
-				};
-
-				auto PackBuffer = [&img, &buffers, &PackSingleRow, &pal, &yCur, &yWritten/*, &id*/, &GetBuffer](std::stop_token stop) {
-					do {
-						auto* pBuffer = GetBuffer(stop);
-						if (!pBuffer)
-							break;
-						auto& buf = *pBuffer;
-
-						PackSingleRow(buf.y, buf.line, img.ptr<telement>(buf.y), pal);
-
-						buf.bReady = true;
-						buf.bReady.notify_one();
-					} while(!stop.stop_requested());
-				};
-
-				auto Writer = [&f, &buffers, img_rows = img.rows, &yWritten, &bWritten, &funcCallback]() {
-					int iPercent{};
-					while (yWritten < img_rows) {
-						auto index = yWritten % buffers.size();
-						auto& buf = buffers[index];
-
-						while (yWritten != buf.y) {
-							buf.y.wait(-1);
-						}
-						while (!buf.bReady) {
-							buf.bReady.wait(false);
-						}
-
-						if (!f.write((char*)buf.line.data(), buf.line.size()))
-							return;
-
-						buf.bReady = false;
-						buf.y = -1;
-						buf.y.notify_one();
-
-						yWritten++;
-						yWritten.notify_one();
-
-						if (funcCallback) {
-							int iPercentNew = yWritten * 100 / img_rows;
-							if (iPercent != iPercentNew) {
-								iPercent = iPercentNew;
-								if (!funcCallback(iPercent, false, false))
-									return;
-							}
-						}
-					};
-					f.flush();
-					bWritten = (bool)f;
-				};
-
-				std::thread threadWriter(Writer);
-				std::vector<std::jthread> threads;
-				threads.reserve(nThread);
-				for (uint i{}; i < nThread; i++) {
-					threads.emplace_back(PackBuffer);
-				}
-
-				threadWriter.join();
-				if (!bWritten) {
-					for (auto& thread : threads)
-						thread.request_stop();
-					for (auto& buffer : buffers) {
-						buffer.y = -1;
-						buffer.y.notify_all();
-					}
-				}
-				return bWritten;
+			// multi threaded : each worker writes a band of rows at its own offset of the file
+			if (bMultiThreaded and !pathPositional.empty()) {
+				f.flush();
+				if (!f)
+					return false;
+				return MatToBitmapPixels<telement>(pathPositional, offsetData, width32, img, bFlipY,
+					[&](int y, std::span<uint8> line, telement const* ptr) { PackSingleRow(y, line, ptr, pal); }, funcCallback);
 			}
-			else {
-				int iPercent{};
-				std::vector<uint8> line((size_t)width32, 0);
-				for (int y{}; y < img.rows; y++) {
-					auto const* ptr = img.ptr<telement>(y);
-					PackSingleRow(y, line, ptr, pal);
-					f.write((char const*)line.data(), width32);
 
-					if (funcCallback) {
-						int iPercentNew = y * 100 / img.rows;
-						if (iPercent != iPercentNew) {
-							iPercent = iPercentNew;
-							if (!funcCallback(iPercent, false, false))
-								return false;
-						}
+			int iPercent{};
+			std::vector<uint8> line((size_t)width32, 0);
+			for (int y{}; y < img.rows; y++) {
+				auto const* ptr = img.ptr<telement>(bFlipY ? img.rows-1-y : y);
+				PackSingleRow(y, line, ptr, pal);
+				if (!f.write((char const*)line.data(), width32))
+					return false;
+
+				if (funcCallback) {
+					int iPercentNew = (y+1) * 100 / img.rows;
+					if (iPercent != iPercentNew) {
+						iPercent = iPercentNew;
+						if (!funcCallback(iPercent, false, false))
+							return false;
 					}
 				}
-				return true;
 			}
+			return true;
 		}
 
 	}	// namespace internal
@@ -588,9 +506,7 @@ namespace gtl {
 		header.XPelsPerMeter = pelsPerMeter.cx;
 		header.YPelsPerMeter = pelsPerMeter.cy;
 
-		cv::Mat img2 = img;
-		if (bBottom2Top)
-			cv::flip(img, img2, 0);
+		// rows of bottom-up bitmap are written from the last one. (no flipped copy)
 
 		if (pixel_size == 3) {
 			std::ofstream f(path, std::ios_base::binary);
@@ -616,7 +532,7 @@ namespace gtl {
 			//	f.write(redundant, sr);
 			//}
 			//bOK = true;
-			bOK = gtl::internal::MatToBitmapFile<true, false, cv::Vec3b, bLoopUnrolling, bMultiThreaded>(f, img2, nBPP, {}, funcCallback);
+			bOK = gtl::internal::MatToBitmapFile<true, false, cv::Vec3b, bLoopUnrolling, bMultiThreaded>(f, img, nBPP, {}, funcCallback, path, fh.offsetData, bBottom2Top);
 
 			return true;
 		}
@@ -653,9 +569,9 @@ namespace gtl {
 			}
 
 			if (bNoPaletteLookup)
-				bOK = gtl::internal::MatToBitmapFile<true, true, uint8, bLoopUnrolling, bMultiThreaded>(f, img2, nBPP, pal, funcCallback);
+				bOK = gtl::internal::MatToBitmapFile<true, true, uint8, bLoopUnrolling, bMultiThreaded>(f, img, nBPP, pal, funcCallback, path, fh.offsetData, bBottom2Top);
 			else
-				bOK = gtl::internal::MatToBitmapFile<false, true, uint8, bLoopUnrolling, bMultiThreaded>(f, img2, nBPP, pal, funcCallback);
+				bOK = gtl::internal::MatToBitmapFile<false, true, uint8, bLoopUnrolling, bMultiThreaded>(f, img, nBPP, pal, funcCallback, path, fh.offsetData, bBottom2Top);
 			return bOK;
 		}
 
@@ -664,8 +580,87 @@ namespace gtl {
 
 	namespace internal {
 
+		/// @brief read only view of whole file
+		class xMappedFileView {
+		protected:
+			HANDLE m_hFile{INVALID_HANDLE_VALUE};
+			HANDLE m_hMapping{};
+			uint8 const* m_data{};
+			uint64_t m_size{};
+		public:
+			explicit xMappedFileView(std::filesystem::path const& path) {
+				m_hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+				if (m_hFile == INVALID_HANDLE_VALUE)
+					return;
+				LARGE_INTEGER li{};
+				if (!GetFileSizeEx(m_hFile, &li) or (li.QuadPart <= 0) or ((uint64_t)li.QuadPart > std::numeric_limits<size_t>::max()))
+					return;
+				m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (!m_hMapping)
+					return;
+				m_data = (uint8 const*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+				if (m_data)
+					m_size = li.QuadPart;
+			}
+			xMappedFileView(xMappedFileView const&) = delete;
+			~xMappedFileView() {
+				if (m_data)
+					UnmapViewOfFile(m_data);
+				if (m_hMapping)
+					CloseHandle(m_hMapping);
+				if (m_hFile != INVALID_HANDLE_VALUE)
+					CloseHandle(m_hFile);
+			}
+			uint8 const* data() const { return m_data; }
+			uint64_t size() const { return m_size; }
+		};
+
+		/// @brief unpacks rows from pixel array on memory-mapped file, directly into img. each worker takes a band of rows. (no line buffer, no queue)
+		/// rows of bottom-up bitmap are unpacked upside down, so no flip is needed.
+		template < typename telement, typename TUnpackRow >
+		bool MatFromBitmapPixels(uint8 const* pixels, int width32, cv::Mat& img, bool bFlipY, TUnpackRow const& UnPackRow, callback_progress_t const& funcCallback) {
+			constexpr int nRowBand = 64;
+			auto nCPUDetected = std::thread::hardware_concurrency();
+			auto nThread = std::min((uint)(img.rows + nRowBand - 1) / nRowBand, (nCPUDetected <= 0) ? 2 : nCPUDetected);
+
+			std::atomic<int> yNext{}, nDone{};
+			std::atomic<bool> bStop{};
+			{
+				std::vector<std::jthread> threads;
+				threads.reserve(nThread);
+				for (uint i{}; i < nThread; i++) {
+					threads.emplace_back([&] {
+						for (int y0{}; !bStop and ((y0 = yNext.fetch_add(nRowBand)) < img.rows); ) {
+							int y1 = std::min(y0 + nRowBand, img.rows);
+							for (int y{y0}; y < y1; y++)
+								UnPackRow(y, pixels + (size_t)y * width32, img.ptr<telement>(bFlipY ? img.rows-1-y : y));
+							nDone += y1 - y0;
+							nDone.notify_one();
+						}
+					});
+				}
+
+				// progress (and cancel) on this thread. (100% is reported too)
+				int iPercent{};
+				for (int done{}; ; nDone.wait(done)) {
+					done = nDone;
+					int iPercentNew = (int)((int64_t)done * 100 / std::max(1, img.rows));
+					if (funcCallback and (iPercent != iPercentNew)) {
+						iPercent = iPercentNew;
+						if (!funcCallback(iPercent, false, false)) {
+							bStop = true;
+							break;
+						}
+					}
+					if (done >= img.rows)
+						break;
+				}
+			}
+			return !bStop;
+		}
+
 		template < typename telement = cv::Vec3b, bool bLoopUnrolling = true, bool bMultiThreaded = false >
-		bool MatFromBitmapFile(std::istream& f, cv::Mat& img, int nBPP, std::vector<telement> palette, callback_progress_t funcCallback) {
+		bool MatFromBitmapFile(std::istream& f, cv::Mat& img, int nBPP, std::vector<telement> palette, callback_progress_t funcCallback, uint8 const* pixelsMapped = nullptr, bool bFlipY = false) {
 
 			if ((nBPP != 1) and (nBPP != 4) and (nBPP != 8) and (nBPP != 24) and (nBPP != 32) )
 				return false;
@@ -680,7 +675,7 @@ namespace gtl {
 			int pixel_per_byte = (8/nBPP);
 			int nColPixel = pixel_per_byte ? img.cols/ pixel_per_byte * pixel_per_byte : img.cols;
 
-			using Func_UnPackSingleRow = std::function<void(int y, std::vector<uint8> const& line, telement* ptr, std::vector<telement> const& palette)>;
+			using Func_UnPackSingleRow = std::function<void(int y, uint8 const* line, telement* ptr, std::vector<telement> const& palette)>;
 			Func_UnPackSingleRow UnPackSingleRow;
 
 
@@ -690,7 +685,7 @@ namespace gtl {
 				if (nBPP == 1) {
 					if (palette.size() < 2)
 						return false;
-					UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, &nColPixel](int y, std::vector<uint8> const& line, telement* ptr, std::vector<telement> const& palette) {
+					UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, &nColPixel](int y, uint8 const* line, telement* ptr, std::vector<telement> const& palette) {
 						int x{};
 						for (; x < nColPixel; x += pixel_per_byte) {
 							int col = x / pixel_per_byte;
@@ -712,7 +707,7 @@ namespace gtl {
 				else if (nBPP == 4) {
 					if (palette.size() < 16)
 						return false;
-					UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, &nColPixel](int y, std::vector<uint8> const& line, telement* ptr, std::vector<telement> const& palette) {
+					UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, &nColPixel](int y, uint8 const* line, telement* ptr, std::vector<telement> const& palette) {
 						int x{};
 						for (; x < nColPixel; x += 2) {
 							int col = x / 2;
@@ -728,7 +723,7 @@ namespace gtl {
 				else if (nBPP == 8) {
 					if (palette.size() < 256)
 						return false;
-					UnPackSingleRow = [img_cols = img.cols](int y, std::vector<uint8> const& line, telement* ptr, std::vector<telement> const& palette) {
+					UnPackSingleRow = [img_cols = img.cols](int y, uint8 const* line, telement* ptr, std::vector<telement> const& palette) {
 						for (int x{}; x < img_cols; x++) {
 							ptr[x] = palette[line[x]];
 						}
@@ -746,7 +741,7 @@ namespace gtl {
 
 				if ( (nBPP == 1) or (nBPP == 4) ) {
 					uint8 mask = (0x01 << nBPP) - 1;
-					UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, mask](int y, std::vector<uint8> const& line, telement* ptr, std::vector<telement> const& palette) {
+					UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, mask](int y, uint8 const* line, telement* ptr, std::vector<telement> const& palette) {
 						for (int x{}; x < img_cols; x++) {
 							int col = x / pixel_per_byte;
 							int shift = 8 - (nBPP * ((x%pixel_per_byte)+1));
@@ -754,7 +749,7 @@ namespace gtl {
 						}
 					};
 				} else if (nBPP == 8) {
-					UnPackSingleRow = [img_cols = img.cols](int y, std::vector<uint8> const& line, telement* ptr, std::vector<telement> const& palette) {
+					UnPackSingleRow = [img_cols = img.cols](int y, uint8 const* line, telement* ptr, std::vector<telement> const& palette) {
 						for (int x{}; x < img_cols; x++) {
 							ptr[x] = palette[line[x]];
 						}
@@ -767,8 +762,17 @@ namespace gtl {
 					return false;
 			}
 
+			// gray palette : SIMD kernels (bit_pack.h)
+			if constexpr (std::is_same_v<telement, uint8>) {
+				if (nBPP <= 8) {
+					UnPackSingleRow = [img_cols = img.cols, nBPP](int y, uint8 const* line, telement* ptr, std::vector<telement> const& palette) {
+						UnpackBitsLUT(nBPP, line, img_cols, palette.data(), ptr, bLoopUnrolling);
+					};
+				}
+			}
+
 			if ( (nBPP == 24) or (nBPP == 32) ) {
-				UnPackSingleRow = [img_cols = img.cols](int y, std::vector<uint8> const& line, telement* ptr, std::vector<telement> const& palette) {
+				UnPackSingleRow = [img_cols = img.cols](int y, uint8 const* line, telement* ptr, std::vector<telement> const& palette) {
 					for (int x{}; x < img_cols; x++) {
 						int xc = x * sizeof(telement);
 						if constexpr (sizeof(telement) == sizeof(cv::Vec3b)) {
@@ -780,6 +784,10 @@ namespace gtl {
 				};
 			}
 
+			if (pixelsMapped) {
+				return MatFromBitmapPixels<telement>(pixelsMapped, width32, img, bFlipY, [&](int y, uint8 const* line, telement* ptr) { UnPackSingleRow(y, line, ptr, palette); }, funcCallback);
+			}
+
 			if constexpr (bMultiThreaded) {
 				auto nCPUDetected = std::thread::hardware_concurrency();
 				auto nThread = std::min((uint)img.rows, (nCPUDetected <= 0) ? 2 : nCPUDetected);
@@ -849,7 +857,7 @@ namespace gtl {
 							}
 						}
 
-						UnPackSingleRow(pBuf->y, pBuf->line, img.ptr<telement>(pBuf->y), palette);
+						UnPackSingleRow(pBuf->y, pBuf->line.data(), img.ptr<telement>(pBuf->y), palette);
 						pBuf->y = -1;
 						pBuf->y.notify_one();
 
@@ -879,7 +887,7 @@ namespace gtl {
 						return false;
 					auto* ptr = img.ptr<telement>(y);
 
-					UnPackSingleRow(y, line, ptr, palette);
+					UnPackSingleRow(y, line.data(), ptr, palette);
 
 					if (funcCallback) {
 						int iPercentNew = y * 100 / img.rows;
@@ -896,7 +904,7 @@ namespace gtl {
 		}
 
 		template < typename telement = cv::Vec3b, bool bLoopUnrolling = true, bool bMultiThreaded = false >
-		bool MatFromBitmapFilePixelArray(std::istream& f, cv::Mat& img, int nBPP, callback_progress_t funcCallback) {
+		bool MatFromBitmapFilePixelArray(std::istream& f, cv::Mat& img, int nBPP, callback_progress_t funcCallback, uint8 const* pixelsMapped = nullptr, bool bFlipY = false) {
 
 			if ((nBPP != 1) and (nBPP != 4) and (nBPP != 8) and (nBPP != 24) and (nBPP != 32) )
 				return false;
@@ -908,13 +916,13 @@ namespace gtl {
 			int pixel_per_byte = (8/nBPP);
 			int nColPixel = pixel_per_byte ? img.cols/ pixel_per_byte * pixel_per_byte : img.cols;
 
-			using Func_UnPackSingleRow = std::function<void(int y, std::vector<uint8> const& line, telement* ptr)>;
+			using Func_UnPackSingleRow = std::function<void(int y, uint8 const* line, telement* ptr)>;
 			Func_UnPackSingleRow UnPackSingleRow;
 
 			using Func_UnpackLine = std::function<void()>;
 
 			if (nBPP == 1) {
-				UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, &nColPixel](int y, std::vector<uint8> const& line, telement* ptr) {
+				UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, &nColPixel](int y, uint8 const* line, telement* ptr) {
 					int x{};
 					for (; x < nColPixel; x += pixel_per_byte) {
 						int col = x / pixel_per_byte;
@@ -934,7 +942,7 @@ namespace gtl {
 				};
 			}
 			else if (nBPP == 4) {
-				UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, &nColPixel](int y, std::vector<uint8> const& line, telement* ptr) {
+				UnPackSingleRow = [img_cols = img.cols, &nBPP, &pixel_per_byte, &nColPixel](int y, uint8 const* line, telement* ptr) {
 					int x{};
 					for (; x < nColPixel; x += 2) {
 						int col = x / 2;
@@ -948,7 +956,7 @@ namespace gtl {
 				};
 			}
 			else if (nBPP == 8) {
-				UnPackSingleRow = [img_cols = img.cols](int y, std::vector<uint8> const& line, telement* ptr) {
+				UnPackSingleRow = [img_cols = img.cols](int y, uint8 const* line, telement* ptr) {
 					for (int x{}; x < img_cols; x++) {
 						ptr[x] = line[x];
 					}
@@ -961,8 +969,17 @@ namespace gtl {
 				return false;
 			}
 
+			// SIMD kernels (bit_pack.h)
+			if constexpr (std::is_same_v<telement, uint8>) {
+				if (nBPP <= 8) {
+					UnPackSingleRow = [img_cols = img.cols, nBPP](int y, uint8 const* line, telement* ptr) {
+						UnpackBits(nBPP, line, img_cols, ptr, bLoopUnrolling);
+					};
+				}
+			}
+
 			if ( (nBPP == 24) or (nBPP == 32) ) {
-				UnPackSingleRow = [img_cols = img.cols](int y, std::vector<uint8> const& line, telement* ptr) {
+				UnPackSingleRow = [img_cols = img.cols](int y, uint8 const* line, telement* ptr) {
 					for (int x{}; x < img_cols; x++) {
 						int xc = x * sizeof(telement);
 						if constexpr (sizeof(telement) == sizeof(cv::Vec3b)) {
@@ -979,6 +996,10 @@ namespace gtl {
 				};
 			}
 
+			if (pixelsMapped) {
+				return MatFromBitmapPixels<telement>(pixelsMapped, width32, img, bFlipY, UnPackSingleRow, funcCallback);
+			}
+
 			auto nCPUDetected = std::thread::hardware_concurrency();
 			auto nThread = std::min((uint)img.rows, (nCPUDetected <= 0) ? 2 : nCPUDetected);
 
@@ -1047,7 +1068,7 @@ namespace gtl {
 						}
 					}
 
-					UnPackSingleRow(pBuf->y, pBuf->line, img.ptr<telement>(pBuf->y));
+					UnPackSingleRow(pBuf->y, pBuf->line.data(), img.ptr<telement>(pBuf->y));
 					pBuf->y = -1;
 					pBuf->y.notify_one();
 
@@ -1175,6 +1196,12 @@ namespace gtl {
 		if (!f.seekg(fh.offsetData))
 			return img;
 
+		// pixel array directly from memory-mapped file, if possible
+		internal::xMappedFileView view(path);
+		uint8 const* pixelsMapped{};
+		if (uint64_t width32 = ((uint64_t)cx * header.nBPP + 31) / 32 * 4; view.data() and (view.size() >= fh.offsetData + width32 * cy))
+			pixelsMapped = view.data() + fh.offsetData;
+
 		bool bGrayScale {};
 		if (header.nBPP <= 8) {
 			bGrayScale = true;
@@ -1192,15 +1219,15 @@ namespace gtl {
 			for (size_t i{}; i < palette.size(); i++)
 				paletteG[i] = palette[i][0];
 
-			bOK = gtl::internal::MatFromBitmapFile<uint8, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, paletteG, funcCallback);
+			bOK = gtl::internal::MatFromBitmapFile<uint8, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, paletteG, funcCallback, pixelsMapped, bFlipY);
 		}
 		else {
-			bOK = gtl::internal::MatFromBitmapFile<cv::Vec3b, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, palette, funcCallback);
+			bOK = gtl::internal::MatFromBitmapFile<cv::Vec3b, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, palette, funcCallback, pixelsMapped, bFlipY);
 		}
 		if (!bOK)
 			img.release();
 
-		if (!img.empty() and bFlipY) {
+		if (!img.empty() and bFlipY and !pixelsMapped) {
 			cv::flip(img, img, 0);
 		}
 
@@ -1276,24 +1303,30 @@ namespace gtl {
 		if (!f.seekg(fh.offsetData))
 			return img;
 
+		// pixel array directly from memory-mapped file, if possible
+		internal::xMappedFileView view(path);
+		uint8 const* pixelsMapped{};
+		if (uint64_t width32 = ((uint64_t)cx * header.nBPP + 31) / 32 * 4; view.data() and (view.size() >= fh.offsetData + width32 * cy))
+			pixelsMapped = view.data() + fh.offsetData;
+
 		if (header.nBPP <= 8) {
 			img = cv::Mat::zeros(cv::Size(cx, cy), CV_8UC1);
-			bOK = gtl::internal::MatFromBitmapFilePixelArray<uint8, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, funcCallback);
+			bOK = gtl::internal::MatFromBitmapFilePixelArray<uint8, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, funcCallback, pixelsMapped, bFlipY);
 		} else if (header.nBPP <= 16) {
 			img = cv::Mat::zeros(cv::Size(cx, cy), CV_16UC1);
-			bOK = gtl::internal::MatFromBitmapFilePixelArray<uint16, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, funcCallback);
+			bOK = gtl::internal::MatFromBitmapFilePixelArray<uint16, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, funcCallback, pixelsMapped, bFlipY);
 		} else if (header.nBPP <= 24) {
 			img = cv::Mat::zeros(cv::Size(cx, cy), CV_8UC3);
-			bOK = gtl::internal::MatFromBitmapFilePixelArray<cv::Vec3b, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, funcCallback);
+			bOK = gtl::internal::MatFromBitmapFilePixelArray<cv::Vec3b, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, funcCallback, pixelsMapped, bFlipY);
 		} else if (header.nBPP <= 32) {
 			img = cv::Mat::zeros(cv::Size(cx, cy), CV_8UC4);
-			bOK = gtl::internal::MatFromBitmapFilePixelArray<cv::Vec4b, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, funcCallback);
+			bOK = gtl::internal::MatFromBitmapFilePixelArray<cv::Vec4b, bLoopUnrolling, bMultiThreaded>(f, img, header.nBPP, funcCallback, pixelsMapped, bFlipY);
 		}
 
 		if (!bOK)
 			img.release();
 
-		if (!img.empty() and bFlipY) {
+		if (!img.empty() and bFlipY and !pixelsMapped) {
 			cv::flip(img, img, 0);
 		}
 
@@ -1352,59 +1385,319 @@ namespace gtl {
 		}
 	}
 
+	namespace {
+
+		//-------------------------------------------------------------------------
+		/// @brief pre-rasterized (anti-aliased) glyphs of printable ascii, for DrawPixelValue()
+		class xGlyphAtlas {
+		public:
+			constexpr static inline int s_font = cv::FONT_HERSHEY_DUPLEX;
+			struct sGlyph {
+				cv::Mat alpha;			// CV_8UC1. (cropped)
+				cv::Point offset;		// top-left of alpha, from origin (left of base line)
+				int advance{};
+			};
+			std::array<sGlyph, 128> m_glyphs;
+
+		public:
+			explicit xGlyphAtlas(int heightFont) {
+				double const fontScale = heightFont / 40.;
+				int const pad = 2;
+				for (int c = ' '; c < 127; c++) {
+					char const str[2] { (char)c, 0 };
+					int baseline{};
+					auto size = cv::getTextSize(str, s_font, fontScale, 1, &baseline);
+					auto& glyph = m_glyphs[c];
+					glyph.advance = size.width;
+					cv::Point const org(pad, pad + size.height);
+					cv::Mat mask = cv::Mat::zeros(size.height + baseline + 2*pad, size.width + 2*pad, CV_8UC1);
+					cv::putText(mask, str, org, s_font, fontScale, cv::Scalar::all(255), 1, cv::LINE_AA);
+					auto rc = cv::boundingRect(mask);
+					if (rc.empty())
+						continue;
+					glyph.alpha = mask(rc).clone();
+					glyph.offset = rc.tl() - org;
+				}
+			}
+
+			/// @brief atlas of font height (pixel). made once, kept.
+			static xGlyphAtlas const& Get(int heightFont) {
+				static std::mutex mtx;
+				static std::map<int, std::unique_ptr<xGlyphAtlas const>> atlases;
+				std::scoped_lock lock(mtx);
+				auto& atlas = atlases[heightFont];
+				if (!atlas)
+					atlas = std::make_unique<xGlyphAtlas const>(heightFont);
+				return *atlas;
+			}
+
+			/// @brief blends text on 8-bit canvas, clipped by rcClip.
+			void Blend(cv::Mat& canvas, std::string_view str, cv::Point org, uint8_t const (&color)[4], cv::Rect const& rcClip) const {
+				int const cn = canvas.channels();
+				for (char c : str) {
+					if ((uint8_t)c >= m_glyphs.size())
+						continue;
+					auto const& glyph = m_glyphs[(uint8_t)c];
+					if (!glyph.alpha.empty()) {
+						cv::Rect rcGlyph(org + glyph.offset, glyph.alpha.size());
+						cv::Rect rc = rcGlyph & rcClip;
+						for (int y = rc.y; y < rc.y + rc.height; y++) {
+							auto const* a = glyph.alpha.ptr<uint8_t>(y - rcGlyph.y) + (rc.x - rcGlyph.x);
+							auto* dst = canvas.ptr<uint8_t>(y) + rc.x * cn;
+							for (int x{}; x < rc.width; x++, dst += cn) {
+								int const alpha = a[x];
+								if (alpha == 0)
+									continue;
+								if (alpha == 255) {
+									for (int i{}; i < cn; i++)
+										dst[i] = color[i];
+									continue;
+								}
+								for (int i{}; i < cn; i++)
+									dst[i] = (uint8_t)(dst[i] + ((color[i] - dst[i]) * alpha + 127) / 255);
+							}
+						}
+					}
+					org.x += glyph.advance;
+				}
+			}
+		};
+
+		//! @brief cv::line / cv::putText for every pixel. (any canvas, any transform)
+		void DrawPixelValueGeneric(cv::Mat& canvas, cv::Mat const& imgOriginal, cv::Rect roi, gtl::xCoordTrans2d const& ctCanvasFromImage, double heightFont, bool bDrawText) {
+			using xPoint2d = gtl::xPoint2d;
+
+			cv::Scalar cr{127, 127, 127, 255};
+			// grid - horizontal
+			for (int y{roi.y}, y1{roi.y+roi.height}; y < y1; y++) {
+				auto pt0 = ctCanvasFromImage(xPoint2d{roi.x, y});
+				auto pt1 = ctCanvasFromImage(xPoint2d{roi.x+roi.width, y});
+				cv::line(canvas, pt0, pt1, cr);
+			}
+			// grid - vertical
+			for (int x{roi.x}, x1{roi.x+roi.width}; x < x1; x++) {
+				auto pt0 = ctCanvasFromImage(xPoint2d{x, roi.y});
+				auto pt1 = ctCanvasFromImage(xPoint2d{x, roi.y+roi.height});
+				cv::line(canvas, pt0, pt1, cr);
+			}
+			if (!bDrawText)
+				return;
+
+			// Pixel Value
+			auto nChannel = imgOriginal.channels();
+			auto depth = imgOriginal.depth();
+			for (int y{roi.y}, y1{roi.y+roi.height}; y < y1; y++) {
+				auto* ptr = imgOriginal.ptr(y);
+				int x1{roi.x+roi.width};
+				for (int x{roi.x}; x < x1; x++) {
+					auto pt = ctCanvasFromImage(xPoint2d{x, y});
+					auto v = GetMatValue(ptr, depth, nChannel, y, x);
+					auto avg = (v[0] + v[1] + v[2]) / nChannel;
+					auto cr = (avg > 128) ? cv::Scalar{0, 0, 0, 255} : cv::Scalar{255, 255, 255, 255};
+					for (int ch{}; ch < nChannel; ch++) {
+						auto str = std::format("{:3}", v[ch]);
+						cv::putText(canvas, str, cv::Point(pt.x, pt.y+(ch+1)*heightFont*40), cv::FONT_HERSHEY_DUPLEX, heightFont, cr, 1, true);
+					}
+				}
+			}
+		}
+	}
+
 	//! @brief Draw gridlines and pixel value of Mat to canvas.
+	/// 8-bit canvas (1, 3, 4 channels) without rotation : grid is written directly to rows, pixel values are blended from glyph atlas, in parallel (bands of image rows).
 	bool DrawPixelValue(cv::Mat& canvas, cv::Mat const& imgOriginal, cv::Rect roi, gtl::xCoordTrans2d const& ctCanvasFromImage, double const minTextHeight) {
 		using xPoint2d = gtl::xPoint2d;
 
 		// Draw Grid / pixel value
 		if (ctCanvasFromImage.m_scale < 4)
 			return false;
-		cv::Scalar cr{127, 127, 127, 255};
-		// grid - horizontal
-		for (int y{roi.y}, y1{roi.y+roi.height}; y < y1; y++) {
-			auto pt0 = ctCanvasFromImage(xPoint2d{roi.x, y});
-			auto pt1 = ctCanvasFromImage(xPoint2d{roi.x+roi.width, y});
-			cv::line(canvas, pt0, pt1, cr);
-		}
-		// grid - vertical
-		for (int x{roi.x}, x1{roi.x+roi.width}; x < x1; x++) {
-			auto pt0 = ctCanvasFromImage(xPoint2d{x, roi.y});
-			auto pt1 = ctCanvasFromImage(xPoint2d{x, roi.y+roi.height});
-			cv::line(canvas, pt0, pt1, cr);
-		}
 
-		// Pixel Value
 		auto nChannel = imgOriginal.channels();
 		auto depth = imgOriginal.depth();
+		bool const bDrawText = ctCanvasFromImage.m_scale >= ((nChannel+1.0)*minTextHeight);
+		double heightFont = std::clamp(ctCanvasFromImage.m_scale/(nChannel+1.0), 1., 40.) / 40.;
 
-		if ( ctCanvasFromImage.m_scale < ((nChannel+1.0)*minTextHeight) )
+		int const cn = canvas.channels();
+		auto const& m = ctCanvasFromImage.m_mat;
+		if ( (canvas.depth() != CV_8U) or (cn != 1 and cn != 3 and cn != 4)
+			or (m(0, 1) != 0.) or (m(1, 0) != 0.) or (m(0, 0) <= 0.) or (m(1, 1) <= 0.) )
+		{
+			DrawPixelValueGeneric(canvas, imgOriginal, roi, ctCanvasFromImage, heightFont, bDrawText);
+			return bDrawText;
+		}
+
+		// canvas position of grid lines
+		std::vector<int> cols(roi.width+1), rows(roi.height+1);
+		for (int i{}; i <= roi.width; i++)
+			cols[i] = xPoint2i(ctCanvasFromImage(xPoint2d{roi.x+i, roi.y})).x;
+		for (int i{}; i <= roi.height; i++)
+			rows[i] = xPoint2i(ctCanvasFromImage(xPoint2d{roi.x, roi.y+i})).y;
+
+		uint8_t const crGrid[4]{127, 127, 127, 255};
+		uint8_t const crBlack[4]{0, 0, 0, 255}, crWhite[4]{255, 255, 255, 255};
+		cv::Rect const rcCanvas(cv::Point(), canvas.size());
+		int const heightText = (int)std::round(heightFont*40);
+		auto const& atlas = xGlyphAtlas::Get(heightText);
+
+		// each band of image rows owns its canvas rows. (rows[i], rows[i+1]]
+		cv::parallel_for_(cv::Range(0, roi.height), [&](cv::Range const& range) {
+			for (int i = range.start; i < range.end; i++) {
+				int const yTop = rows[i];
+				int const yBottom = (i+1 == roi.height) ? rows[i+1]+1 : rows[i+1];	// last vertical lines include end point (as cv::line)
+				cv::Rect const rcBand = cv::Rect(0, yTop, canvas.cols, yBottom - yTop) & rcCanvas;
+				if (rcBand.empty())
+					continue;
+
+				// grid - horizontal
+				if (yTop == rcBand.y) {
+					int x0 = std::max(cols.front(), 0), x1 = std::min(cols.back()+1, canvas.cols);
+					auto* ptr = canvas.ptr<uint8_t>(yTop);
+					for (int x = x0; x < x1; x++)
+						std::memcpy(ptr + x*cn, crGrid, cn);
+				}
+				// grid - vertical
+				for (int y = rcBand.y; y < rcBand.y + rcBand.height; y++) {
+					auto* ptr = canvas.ptr<uint8_t>(y);
+					for (int j{}; j < roi.width; j++) {
+						if (cols[j] >= 0 and cols[j] < canvas.cols)
+							std::memcpy(ptr + cols[j]*cn, crGrid, cn);
+					}
+				}
+				if (!bDrawText)
+					continue;
+
+				// Pixel Value
+				int const y = roi.y + i;
+				auto* ptr = imgOriginal.ptr(y);
+				char buf[64];
+				for (int j{}; j < roi.width; j++) {
+					if (cols[j+1] < 0 or cols[j] >= canvas.cols)
+						continue;
+					auto v = GetMatValue(ptr, depth, nChannel, y, roi.x + j);
+					auto avg = (v[0] + v[1] + v[2]) / nChannel;
+					auto const& cr = (avg > 128) ? crBlack : crWhite;
+					for (int ch{}; ch < nChannel; ch++) {
+						auto r = std::format_to_n(buf, std::size(buf), "{:3}", v[ch]);
+						atlas.Blend(canvas, std::string_view(buf, r.out), cv::Point(cols[j], yTop + (ch+1)*heightText), cr, rcBand);
+					}
+				}
+			}
+		});
+
+		return bDrawText;
+	}
+
+
+
+	//=============================================================================
+	// Remap Maps
+	bool MakeRemapMaps(ICoordTrans const& ctDestToSource, cv::Size const& sizeDest, cv::Mat& mapX, cv::Mat& mapY, int nGridStep, int nThread) {
+		if (sizeDest.width <= 0 or sizeDest.height <= 0)
 			return false;
-		double heightFont = std::clamp(ctCanvasFromImage.m_scale/(nChannel+1.0), 1., 40.) / 40.;
-		//auto t0 = stdc::steady_clock::now();
-		for (int y{roi.y}, y1{roi.y+roi.height}; y < y1; y++) {
-			auto* ptr = imgOriginal.ptr(y);
-			int x1{roi.x+roi.width};
-			//#pragma omp parallel for --------- little improvement
-			for (int x{roi.x}; x < x1; x++) {
-				auto pt = ctCanvasFromImage(xPoint2d{x, y});
-				//auto p = SkPoint::Make(pt.x, pt.y);
-				auto v = GetMatValue(ptr, depth, nChannel, y, x);
-				auto avg = (v[0] + v[1] + v[2]) / nChannel;
-				auto cr = (avg > 128) ? cv::Scalar{0, 0, 0, 255} : cv::Scalar{255, 255, 255, 255};
-				for (int ch{}; ch < nChannel; ch++) {
-					auto str = std::format("{:3}", v[ch]);
-					cv::putText(canvas, str, cv::Point(pt.x, pt.y+(ch+1)*heightFont*40), cv::FONT_HERSHEY_DUPLEX, heightFont, cr, 1, true);
+
+		mapX.create(sizeDest, CV_32FC1);
+		mapY.create(sizeDest, CV_32FC1);
+
+		if (nThread <= 0)
+			nThread = std::max(1, (int)std::thread::hardware_concurrency());
+
+		using point_t = ICoordTrans::point2_t;
+		int const width = sizeDest.width;
+		int const height = sizeDest.height;
+
+		// calls func(y0, y1) for every band of rows. bands are distributed to threads.
+		auto ForEachBand = [nThread](int nRow, int nBandHeight, auto&& func) {
+			int const nBand = (nRow + nBandHeight - 1) / nBandHeight;
+			std::atomic<int> iNext{};
+			auto Worker = [&]() {
+				for (int iBand{}; (iBand = iNext++) < nBand; ) {
+					int y0 = iBand * nBandHeight;
+					func(y0, std::min(y0 + nBandHeight, nRow));
 				}
+			};
+			int n = std::min(nThread, nBand);
+			if (n <= 1) {
+				Worker();
+				return;
 			}
+			std::vector<std::jthread> threads;
+			threads.reserve(n);
+			for (int i{}; i < n; i++)
+				threads.emplace_back(Worker);
+		};
+
+		constexpr int nBandHeight = 32;
+
+		//-------------------------------------------------------------------------
+		// every pixel
+		if (nGridStep <= 1) {
+			ForEachBand(height, nBandHeight, [&](int y0, int y1) {
+				std::vector<point_t> pts((size_t)width);
+				for (int y{y0}; y < y1; y++) {
+					for (int x{}; x < width; x++)
+						pts[x] = point_t((double)x, (double)y);
+					ctDestToSource.Trans(std::span<point_t>{pts});
+					auto* px = mapX.ptr<float>(y);
+					auto* py = mapY.ptr<float>(y);
+					for (int x{}; x < width; x++) {
+						px[x] = (float)pts[x].x;
+						py[x] = (float)pts[x].y;
+					}
+				}
+			});
+			return true;
 		}
-		//auto t1 = stdc::steady_clock::now();
-		//auto dur = stdc::duration_cast<stdc::milliseconds>(t1-t0).count();
-		//OutputDebugString(std::format(L"{} ms\n", dur).c_str());
 
-		return true;
-	}
+		//-------------------------------------------------------------------------
+		// coarse grid. nodes at (i*step, j*step). last node is at (or beyond) the last pixel.
+		int const step = nGridStep;
+		int const nx = std::max(2, (width - 1 + step - 1) / step + 1);
+		int const ny = std::max(2, (height - 1 + step - 1) / step + 1);
+		std::vector<point_t> grid((size_t)nx * ny);
+		ForEachBand(ny, nBandHeight, [&](int j0, int j1) {
+			for (int j{j0}; j < j1; j++) {
+				std::span<point_t> row(grid.data() + (size_t)j * nx, (size_t)nx);
+				for (int i{}; i < nx; i++)
+					row[i] = point_t((double)i * step, (double)j * step);
+				ctDestToSource.Trans(row);
+			}
+		});
+
+		// column index / weight of each pixel
+		std::vector<int> cols((size_t)width);
+		std::vector<double> weights((size_t)width);
+		for (int x{}; x < width; x++) {
+			int i = std::min(x / step, nx - 2);
+			cols[x] = i;
+			weights[x] = (double)(x - i * step) / step;
+		}
 
+		// bilinear interpolation : vertical first (one row of nodes), then horizontal.
+		ForEachBand(height, nBandHeight, [&](int y0, int y1) {
+			std::vector<point_t> nodes((size_t)nx);
+			for (int y{y0}; y < y1; y++) {
+				int j = std::min(y / step, ny - 2);
+				double fy = (double)(y - j * step) / step;
+				auto const* r0 = grid.data() + (size_t)j * nx;
+				auto const* r1 = r0 + nx;
+				for (int i{}; i < nx; i++) {
+					nodes[i].x = r0[i].x + (r1[i].x - r0[i].x) * fy;
+					nodes[i].y = r0[i].y + (r1[i].y - r0[i].y) * fy;
+				}
+				auto* px = mapX.ptr<float>(y);
+				auto* py = mapY.ptr<float>(y);
+				for (int x{}; x < width; x++) {
+					auto const& n0 = nodes[cols[x]];
+					auto const& n1 = nodes[cols[x] + 1];
+					double fx = weights[x];
+					px[x] = (float)(n0.x + (n1.x - n0.x) * fx);
+					py[x] = (float)(n0.y + (n1.y - n0.y) * fx);
+				}
+			}
+		});
 
+		return true;
+	}
 
 	//=============================================================================
 	//
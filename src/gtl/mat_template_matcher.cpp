@@ -0,0 +1,176 @@
+﻿#include "pch.h"
+
+#include "gtl/mat_template_matcher.h"
+
+namespace gtl {
+
+	namespace {
+
+		float const s_fScoreNone = -std::numeric_limits<float>::max();
+
+		/// @brief result of cv::matchTemplate -> score (higher is better)
+		void ToScore(cv::Mat& result, int method) {
+			switch (method) {
+			case cv::TM_SQDIFF :		result.convertTo(result, CV_32F, -1.0); break;
+			case cv::TM_SQDIFF_NORMED :	result.convertTo(result, CV_32F, -1.0, 1.0); break;
+			}
+			cv::patchNaNs(result, s_fScoreNone);
+		}
+
+		cv::Mat MatchScore(cv::Mat const& img, cv::Mat const& templ, int method) {
+			cv::Mat result;
+			cv::matchTemplate(img, templ, result, method);
+			ToScore(result, method);
+			return result;
+		}
+
+		/// @brief peaks, from the highest. score is modified (suppressed around peaks)
+		std::vector<cv::Point> FindPeaks(cv::Mat& score, int nPeak, cv::Size sizeSuppress, double dMinScore) {
+			std::vector<cv::Point> peaks;
+			cv::Rect const rcScore(cv::Point(), score.size());
+			for (int i{}; i < nPeak; i++) {
+				double dMax{};
+				cv::Point pt;
+				cv::minMaxLoc(score, nullptr, &dMax, nullptr, &pt);
+				if ( (dMax <= s_fScoreNone) or (dMax < dMinScore) )
+					break;
+				peaks.push_back(pt);
+				cv::Rect rc(pt - cv::Point(sizeSuppress.width/2, sizeSuppress.height/2), sizeSuppress);
+				score(rc & rcScore) = s_fScoreNone;
+			}
+			return peaks;
+		}
+
+		/// @brief vertex of parabola through (-1, l), (0, c), (1, r)
+		double FitPeak(float l, float c, float r) {
+			double d = (double)l - 2.*c + r;
+			if ( (d >= 0.) or (l <= s_fScoreNone) or (r <= s_fScoreNone) )
+				return 0.;
+			return std::clamp(0.5 * (l - r) / d, -0.5, 0.5);
+		}
+
+		xPoint2d SubPixel(cv::Mat const& score, cv::Point pt) {
+			xPoint2d ptSub(pt.x, pt.y);
+			auto const* row = score.ptr<float>(pt.y);
+			if ( (pt.x > 0) and (pt.x + 1 < score.cols) )
+				ptSub.x += FitPeak(row[pt.x - 1], row[pt.x], row[pt.x + 1]);
+			if ( (pt.y > 0) and (pt.y + 1 < score.rows) )
+				ptSub.y += FitPeak(score.at<float>(pt.y - 1, pt.x), row[pt.x], score.at<float>(pt.y + 1, pt.x));
+			return ptSub;
+		}
+	}
+
+	void CTemplateMatcher::SetImage(cv::Mat const& img, int nMaxLevel) {
+		m_pyramid.clear();
+		if (img.empty())
+			return;
+		m_pyramid.push_back(img);
+		for (int i{}; i < nMaxLevel; i++) {
+			auto const& prev = m_pyramid.back();
+			if ( (prev.cols < 2) or (prev.rows < 2) )
+				break;
+			cv::Mat down;
+			cv::pyrDown(prev, down);
+			m_pyramid.push_back(std::move(down));
+		}
+	}
+
+	std::vector<CTemplateMatcher::sResult> CTemplateMatcher::Match(cv::Mat const& imgTempl, sOption const& option) const {
+		std::vector<sResult> results;
+		if ( m_pyramid.empty() or imgTempl.empty() or (option.nMaxPeak <= 0)
+			or (imgTempl.cols > m_pyramid[0].cols) or (imgTempl.rows > m_pyramid[0].rows) or (imgTempl.type() != m_pyramid[0].type()) )
+			return results;
+
+		try {
+			// level to start
+			int nLevel = option.nLevel;
+			if (nLevel < 0) {
+				nLevel = 0;
+				for (int s = std::min(imgTempl.cols, imgTempl.rows) / 2; s >= option.nMinTemplateSize; s /= 2)
+					nLevel++;
+			}
+			nLevel = std::min(nLevel, GetMaxLevel());
+
+			std::vector<cv::Mat> templs{ imgTempl };
+			for (int i{}; i < nLevel; i++) {
+				cv::Mat down;
+				cv::pyrDown(templs.back(), down);
+				templs.push_back(std::move(down));
+			}
+
+			// coarsest level : whole image. more candidates than asked (some may be dropped on finer levels)
+			auto score = MatchScore(m_pyramid[nLevel], templs[nLevel], option.method);
+			cv::Mat const scoreWhole = nLevel ? cv::Mat{} : score.clone();	// FindPeaks() modifies score
+			cv::Size const sizeTempl = templs[nLevel].size();
+			cv::Size const sizeSuppress(std::max(1, (int)(sizeTempl.width * option.dMinPeakDistance * 2)), std::max(1, (int)(sizeTempl.height * option.dMinPeakDistance * 2)));
+			int const nCandidate = nLevel ? std::max(option.nMaxPeak * 2, option.nMaxPeak + 4) : option.nMaxPeak;
+			auto peaks = FindPeaks(score, nCandidate, sizeSuppress, nLevel ? s_fScoreNone : option.dMinScore);
+
+			// refines peak on finer levels, in small ROI
+			auto Refine = [&](cv::Point pt) -> std::optional<sResult> {
+				int const r = 2 + option.nRefineMargin;
+				for (int iLevel = nLevel-1; iLevel >= 0; iLevel--) {
+					auto const& img = m_pyramid[iLevel];
+					auto const& templ = templs[iLevel];
+					cv::Rect rcScore(pt.x*2 - r, pt.y*2 - r, 2*r + 1, 2*r + 1);
+					rcScore &= cv::Rect(0, 0, img.cols - templ.cols + 1, img.rows - templ.rows + 1);
+					if (rcScore.empty())
+						return {};
+					cv::Rect rcImage(rcScore.tl(), rcScore.size() + templ.size() - cv::Size(1, 1));
+					auto scoreROI = MatchScore(img(rcImage), templ, option.method);
+					cv::Point ptMax;
+					cv::minMaxLoc(scoreROI, nullptr, nullptr, nullptr, &ptMax);
+					pt = rcScore.tl() + ptMax;
+					if (iLevel == 0) {
+						auto ptSub = option.bSubPixel ? SubPixel(scoreROI, ptMax) : xPoint2d(ptMax.x, ptMax.y);
+						return sResult{ ptSub + xPoint2d(rcScore.x, rcScore.y), scoreROI.at<float>(ptMax) };
+					}
+				}
+				return {};
+			};
+
+			std::vector<sResult> candidates;
+			for (auto const& pt : peaks) {
+				if (nLevel == 0) {
+					candidates.push_back({ option.bSubPixel ? SubPixel(scoreWhole, pt) : xPoint2d(pt.x, pt.y), scoreWhole.at<float>(pt) });
+				}
+				else if (auto res = Refine(pt)) {
+					candidates.push_back(*res);
+				}
+			}
+
+			// candidates may converge to the same peak
+			std::ranges::sort(candidates, [](auto const& a, auto const& b) { return a.dScore > b.dScore; });
+			double const dx = imgTempl.cols * option.dMinPeakDistance, dy = imgTempl.rows * option.dMinPeakDistance;
+			for (auto const& c : candidates) {
+				if ( (c.dScore < option.dMinScore) or (c.dScore <= s_fScoreNone) )
+					break;
+				if (std::ranges::any_of(results, [&](auto const& res) { return (std::abs(res.pt.x - c.pt.x) < dx) and (std::abs(res.pt.y - c.pt.y) < dy); }))
+					continue;
+				results.push_back(c);
+				if ((int)results.size() >= option.nMaxPeak)
+					break;
+			}
+			// top-left -> center (as MatchTemplate())
+			for (auto& res : results) {
+				res.pt.x += imgTempl.cols/2;
+				res.pt.y += imgTempl.rows/2;
+			}
+		}
+		catch (...) {
+			results.clear();
+		}
+
+		return results;
+	}
+
+	std::vector<std::vector<CTemplateMatcher::sResult>> CTemplateMatcher::Match(std::span<cv::Mat const> templs, sOption const& option) const {
+		std::vector<std::vector<sResult>> results(templs.size());
+		cv::parallel_for_(cv::Range(0, (int)templs.size()), [&](cv::Range const& range) {
+			for (int i = range.start; i < range.end; i++)
+				results[i] = Match(templs[i], option);
+		});
+		return results;
+	}
+
+}
@@ -0,0 +1,362 @@
+﻿#include "pch.h"
+
+#include "gtl/mat_tile_file.h"
+#include "gtl/mat_helper.h"
+
+#include <windows.h>
+
+namespace gtl {
+
+	struct CMatTileFile::sMapping {
+		HANDLE hFile{INVALID_HANDLE_VALUE};
+		HANDLE hMapping{};
+		uint8_t* data{};
+		uint64_t size{};
+
+		~sMapping() {
+			if (data)
+				UnmapViewOfFile(data);
+			if (hMapping)
+				CloseHandle(hMapping);
+			if (hFile != INVALID_HANDLE_VALUE)
+				CloseHandle(hFile);
+		}
+
+		bool Map(std::filesystem::path const& path, bool bReadOnly, std::optional<uint64_t> sizeNew) {
+			hFile = CreateFileW(path.c_str(), bReadOnly ? GENERIC_READ : (GENERIC_READ|GENERIC_WRITE), FILE_SHARE_READ, nullptr,
+				sizeNew ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (hFile == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER li{};
+			if (sizeNew) {
+				// new file is filled with zero
+				li.QuadPart = *sizeNew;
+				if (!SetFilePointerEx(hFile, li, nullptr, FILE_BEGIN) or !SetEndOfFile(hFile))
+					return false;
+			}
+			if (!GetFileSizeEx(hFile, &li) or (li.QuadPart <= 0))
+				return false;
+			size = li.QuadPart;
+			hMapping = CreateFileMappingW(hFile, nullptr, bReadOnly ? PAGE_READONLY : PAGE_READWRITE, 0, 0, nullptr);
+			if (!hMapping)
+				return false;
+			// read-only : copy-on-write. (a write to a view returned never reaches the file)
+			data = (uint8_t*)MapViewOfFile(hMapping, bReadOnly ? FILE_MAP_COPY : FILE_MAP_ALL_ACCESS, 0, 0, 0);
+			return data != nullptr;
+		}
+	};
+
+	static size_t CalcTileLayout(CMatTileFile::sHeader const& header, std::vector<cv::Size>& sizeLevels, std::vector<cv::Size>& nTiles, std::vector<size_t>& iTileBase) {
+		sizeLevels.clear();
+		nTiles.clear();
+		iTileBase.clear();
+		size_t nTotal{};
+		cv::Size size(header.width, header.height);
+		for (int i = 0; i < header.nLevel; i++) {
+			sizeLevels.push_back(size);
+			nTiles.emplace_back((size.width + header.tileWidth - 1) / header.tileWidth, (size.height + header.tileHeight - 1) / header.tileHeight);
+			iTileBase.push_back(nTotal);
+			nTotal += (size_t)nTiles.back().area();
+			size = cv::Size((size.width+1)/2, (size.height+1)/2);
+		}
+		return nTotal;
+	}
+
+	bool CMatTileFile::Create(std::filesystem::path const& path, cv::Size sizeImage, int type, cv::Size sizeTile, int nLevel) {
+		Close();
+		if ( !IsValidMatType(type) or (sizeImage.width <= 0) or (sizeImage.height <= 0) or (sizeTile.width <= 0) or (sizeTile.height <= 0)
+			or (sizeTile.width % 2) or (sizeTile.height % 2) or (nLevel <= 0) or (nLevel > 16) )
+			return false;
+
+		constexpr uint64_t page = 4096;
+		auto Align = [&](uint64_t v) { return (v + page - 1) / page * page; };
+
+		sHeader header{};
+		std::ranges::copy(s_magic, header.magic);
+		header.version = s_version;
+		header.type = type;
+		header.width = sizeImage.width;
+		header.height = sizeImage.height;
+		header.tileWidth = sizeTile.width;
+		header.tileHeight = sizeTile.height;
+		header.nLevel = nLevel;
+		std::vector<cv::Size> sizeLevels, nTiles;
+		std::vector<size_t> iTileBase;
+		auto nTile = CalcTileLayout(header, sizeLevels, nTiles, iTileBase);
+		header.offsetFlags = sizeof(header);
+		header.offsetData = Align(header.offsetFlags + nTile);
+		header.sizeSlot = Align((uint64_t)sizeTile.area() * CV_ELEM_SIZE(type));
+
+		auto mapping = std::make_shared<sMapping>();
+		if (!mapping->Map(path, false, header.offsetData + header.sizeSlot * nTile))
+			return false;
+		memcpy(mapping->data, &header, sizeof(header));
+
+		return Init(std::move(mapping), false);
+	}
+
+	bool CMatTileFile::Open(std::filesystem::path const& path, bool bReadOnly) {
+		Close();
+		auto mapping = std::make_shared<sMapping>();
+		if (!mapping->Map(path, bReadOnly, {}))
+			return false;
+		return Init(std::move(mapping), bReadOnly);
+	}
+
+	bool CMatTileFile::Init(std::shared_ptr<sMapping> mapping, bool bReadOnly) {
+		if (mapping->size < sizeof(sHeader))
+			return false;
+		sHeader header;
+		memcpy(&header, mapping->data, sizeof(header));
+		if ( !std::ranges::equal(header.magic, s_magic) or (header.version != s_version) or !IsValidMatType(header.type)
+			or (header.width <= 0) or (header.height <= 0) or (header.tileWidth <= 0) or (header.tileHeight <= 0)
+			or (header.tileWidth % 2) or (header.tileHeight % 2) or (header.nLevel <= 0) or (header.nLevel > 16)
+			or (header.sizeSlot < (uint64_t)header.tileWidth * header.tileHeight * CV_ELEM_SIZE(header.type)) )
+			return false;
+		auto nTile = CalcTileLayout(header, m_sizeLevels, m_nTiles, m_iTileBase);
+		if ( (header.offsetFlags + nTile > header.offsetData) or (header.offsetData + header.sizeSlot * nTile > mapping->size) )
+			return false;
+
+		m_header = header;
+		m_bReadOnly = bReadOnly;
+		m_mapping = std::move(mapping);
+		m_threadPrefetch = std::jthread([this](std::stop_token token) { Prefetch(token); });
+		return true;
+	}
+
+	void CMatTileFile::Close() {
+		if (m_threadPrefetch.joinable()) {
+			m_threadPrefetch.request_stop();
+			m_threadPrefetch.join();
+		}
+		m_prefetch.reset();
+		m_mapping.reset();	// unmapped when all tiles from GetTile() are released
+		m_header = {};
+		m_sizeLevels.clear();
+		m_nTiles.clear();
+		m_iTileBase.clear();
+	}
+
+	bool CMatTileFile::Flush() {
+		if (!m_mapping or m_bReadOnly)
+			return false;
+		return FlushViewOfFile(m_mapping->data, 0) and FlushFileBuffers(m_mapping->hFile);
+	}
+
+	uint8_t* CMatTileFile::GetFlag(int iLevel, xPoint2i const& pos) const {
+		if (!m_mapping or (iLevel < 0) or (iLevel >= m_header.nLevel))
+			return nullptr;
+		auto const& n = m_nTiles[iLevel];
+		if ( (pos.x < 0) or (pos.y < 0) or (pos.x >= n.width) or (pos.y >= n.height) )
+			return nullptr;
+		return m_mapping->data + m_header.offsetFlags + m_iTileBase[iLevel] + pos.y * n.width + pos.x;
+	}
+
+	uint8_t CMatTileFile::GetFlagsExpected(int iLevel, xPoint2i const& pos) const {
+		if (iLevel <= 0)
+			return fTILE_ALL;
+		auto const& n = m_nTiles[iLevel-1];
+		uint8_t flags{};
+		for (int q = 0; q < 4; q++) {
+			if ( (pos.x*2 + (q&1) < n.width) and (pos.y*2 + (q>>1) < n.height) )
+				flags |= 1 << q;
+		}
+		return flags;
+	}
+
+	cv::Mat CMatTileFile::GetTileRaw(int iLevel, xPoint2i const& pos) const {
+		auto* flag = GetFlag(iLevel, pos);
+		if (!flag)
+			return {};
+		auto const& size = m_sizeLevels[iLevel];
+		int cx = std::min(m_header.tileWidth, size.width - pos.x * m_header.tileWidth);
+		int cy = std::min(m_header.tileHeight, size.height - pos.y * m_header.tileHeight);
+		auto* data = m_mapping->data + m_header.offsetData + (m_iTileBase[iLevel] + pos.y * m_nTiles[iLevel].width + pos.x) * m_header.sizeSlot;
+		return cv::Mat(cy, cx, m_header.type, data, m_header.tileWidth * CV_ELEM_SIZE(m_header.type));
+	}
+
+	cv::Mat CMatTileFile::GetTile(int iLevel, xPoint2i const& pos) const {
+		return GetTileRaw(iLevel, pos).clone();
+	}
+
+	cv::Mat CMatTileFile::GetTileView(int iLevel, xPoint2i const& pos) const {
+		return AttachMatOwner(GetTileRaw(iLevel, pos), m_mapping);
+	}
+
+	bool CMatTileFile::IsTileReady(int iLevel, xPoint2i const& pos) const {
+		auto* flag = GetFlag(iLevel, pos);
+		if (!flag)
+			return false;
+		auto flags = std::atomic_ref(*flag).load(std::memory_order_acquire);
+		return (flags & GetFlagsExpected(iLevel, pos)) == GetFlagsExpected(iLevel, pos);
+	}
+
+	bool CMatTileFile::SetTile(xPoint2i const& pos, cv::Mat const& img, bool bUpdatePyramid) {
+		if (m_bReadOnly)
+			return false;
+		std::unique_lock lock(m_mtxWrite);
+		auto tile = GetTileRaw(0, pos);
+		if (tile.empty() or (img.size() != tile.size()) or (img.type() != tile.type()))
+			return false;
+		img.copyTo(tile);
+		std::atomic_ref(*GetFlag(0, pos)).store(fTILE_ALL, std::memory_order_release);
+
+		if (bUpdatePyramid) {
+			xPoint2i posChild = pos;
+			for (int iLevel = 0; iLevel+1 < m_header.nLevel; iLevel++, posChild /= 2) {
+				if (!UpdateParent(iLevel, posChild))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	bool CMatTileFile::UpdatePyramid() {
+		if (m_bReadOnly or !m_mapping)
+			return false;
+		std::unique_lock lock(m_mtxWrite);
+		for (int iLevel = 0; iLevel+1 < m_header.nLevel; iLevel++) {
+			auto const& n = m_nTiles[iLevel];
+			std::atomic<bool> bOK{true};
+			cv::parallel_for_(cv::Range(0, n.area()), [&](cv::Range const& range) {
+				for (int i = range.start; i < range.end; i++) {
+					if (!UpdateParent(iLevel, xPoint2i(i % n.width, i / n.width)))
+						bOK = false;
+				}
+			});
+			if (!bOK)
+				return false;
+		}
+		return true;
+	}
+
+	bool CMatTileFile::UpdateParent(int iLevel, xPoint2i const& pos) {
+		auto* flag = GetFlag(iLevel, pos);
+		if (!flag)
+			return false;
+		if (!std::atomic_ref(*flag).load(std::memory_order_acquire))
+			return true;	// nothing written yet
+		auto tile = GetTileRaw(iLevel, pos);
+		xPoint2i posParent = pos / 2;
+		auto parent = GetTileRaw(iLevel+1, posParent);
+		int q = (pos.x & 1) + (pos.y & 1) * 2;
+		cv::Rect rc((pos.x & 1) * m_header.tileWidth/2, (pos.y & 1) * m_header.tileHeight/2, (tile.cols+1)/2, (tile.rows+1)/2);
+		if (parent.empty() or !IsROI_Valid(rc, parent.size()))
+			return false;
+		try {
+			cv::resize(tile, parent(rc), rc.size(), 0., 0., m_eScaleDownMethod);
+		} catch (cv::Exception&) {
+			return false;
+		}
+		std::atomic_ref(*GetFlag(iLevel+1, posParent)).fetch_or((uint8_t)(1 << q), std::memory_order_release);
+		return true;
+	}
+
+	cv::Mat CMatTileFile::GetResizedImage(cv::Rect& rc, double dScale, int eScaleDownMethod, int eScaleUpMethod) const {
+		using namespace cv;
+
+		Mat img;
+		if (!m_mapping)
+			return img;
+		if (dScale <= 0)
+			dScale = 1;
+		if (eScaleUpMethod < 0)
+			eScaleUpMethod = m_eScaleUpMethod;
+		if (eScaleDownMethod < 0)
+			eScaleDownMethod = m_eScaleDownMethod;
+
+		rc &= Rect(0, 0, m_header.width, m_header.height);
+		if (rc.empty())
+			return img;
+
+		// pyramid level : nearest one not smaller than dScale
+		int iLevel = 0;
+		while ( (iLevel+1 < m_header.nLevel) and (dScale <= 1.0 / (1 << (iLevel+1))) )
+			iLevel++;
+		int const d = 1 << iLevel;
+		Rect rcL(rc.x / d, rc.y / d, 0, 0);
+		rcL.width = (rc.x + rc.width + d - 1) / d - rcL.x;
+		rcL.height = (rc.y + rc.height + d - 1) / d - rcL.y;
+		rcL &= Rect(Point(), m_sizeLevels[iLevel]);
+		if (rcL.empty())
+			return img;
+
+		int const tw = m_header.tileWidth, th = m_header.tileHeight;
+		Rect rcTiles(rcL.x / tw, rcL.y / th, 0, 0);
+		rcTiles.width = (rcL.x + rcL.width - 1) / tw - rcTiles.x + 1;
+		rcTiles.height = (rcL.y + rcL.height - 1) / th - rcTiles.y + 1;
+
+		// neighbors
+		{
+			std::unique_lock lock(m_mtxPrefetch);
+			m_prefetch.emplace(iLevel, Rect(rcTiles.x-1, rcTiles.y-1, rcTiles.width+2, rcTiles.height+2));
+		}
+		m_cvPrefetch.notify_one();
+
+		Size sizeTarget(std::max(1, (int)std::round(rc.width * dScale)), std::max(1, (int)std::round(rc.height * dScale)));
+		bool bSameScale = (sizeTarget == rcL.size());
+
+		if ( bSameScale and (rcTiles.area() == 1) ) {
+			// tile on the mapped file itself (read-only view)
+			auto tile = GetTileView(iLevel, xPoint2i(rcTiles.x, rcTiles.y));
+			img = tile(rcL - Point(rcTiles.x * tw, rcTiles.y * th));
+			return img;
+		}
+
+		// assemble (each tile in parallel)
+		Mat imgL = Mat::zeros(rcL.size(), m_header.type);
+		cv::parallel_for_(cv::Range(0, rcTiles.area()), [&](cv::Range const& range) {
+			for (int i = range.start; i < range.end; i++) {
+				xPoint2i pos(rcTiles.x + i % rcTiles.width, rcTiles.y + i / rcTiles.width);
+				auto* flag = GetFlag(iLevel, pos);
+				if (!flag or !std::atomic_ref(*flag).load(std::memory_order_acquire))
+					continue;	// not written yet
+				auto tile = GetTileRaw(iLevel, pos);
+				Rect rcTile(pos.x * tw, pos.y * th, tile.cols, tile.rows);
+				Rect rcCopy = rcTile & rcL;
+				if (rcCopy.empty())
+					continue;
+				tile(rcCopy - rcTile.tl()).copyTo(imgL(rcCopy - rcL.tl()));
+			}
+		});
+
+		if (bSameScale)
+			return imgL;
+		try {
+			double dScaleL = dScale * d;
+			resize(imgL, img, sizeTarget, 0., 0., dScaleL >= 1 ? eScaleUpMethod : eScaleDownMethod);
+		} catch (cv::Exception&) {
+			img.release();
+		}
+		return img;
+	}
+
+	void CMatTileFile::Prefetch(std::stop_token token) {
+		while (!token.stop_requested()) {
+			std::optional<std::pair<int, cv::Rect>> prefetch;
+			{
+				std::unique_lock lock(m_mtxPrefetch);
+				if (!m_cvPrefetch.wait(lock, token, [&] { return m_prefetch.has_value(); }))
+					break;
+				prefetch.swap(m_prefetch);
+			}
+			auto [iLevel, rcTiles] = *prefetch;
+			auto IsCancelled = [&] {
+				std::unique_lock lock(m_mtxPrefetch);
+				return token.stop_requested() or m_prefetch.has_value();	// or newer ROI
+			};
+			for (int i = 0; i < rcTiles.area() and !IsCancelled(); i++) {
+				xPoint2i pos(rcTiles.x + i % rcTiles.width, rcTiles.y + i / rcTiles.width);
+				auto* flag = GetFlag(iLevel, pos);
+				if (!flag or !std::atomic_ref(*flag).load(std::memory_order_relaxed))
+					continue;
+				// touch every page. (OS reads them in)
+				auto tile = GetTileRaw(iLevel, pos);
+				volatile uint8_t sum{};
+				for (auto const* p = tile.datastart; p < tile.dataend; p += 4096)
+					sum += *p;
+			}
+		}
+	}
+
+}
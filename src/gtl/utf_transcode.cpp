@@ -0,0 +1,871 @@
+﻿#include "pch.h"
+
+#include "gtl/string/utf_transcode.h"
+#include "gtl/string/CodepageMap.h"
+
+#if defined(__AVX2__)
+#	define GTL__UTF_AVX2 1		// (SSSE3, SSE4.1 also)
+#	include <immintrin.h>
+#endif
+
+namespace gtl::internal {
+
+	namespace {
+
+		//-----------------------------------------------------------------------------
+		// scalar (strict)
+
+		/// @return length of code point (units), 0 if invalid or truncated
+		inline int Decode(char8_t const* pos, char8_t const* end, char32_t& c) {
+			auto IsCont = [](char8_t b) { return (b & 0xc0) == 0x80; };
+			auto const n = end - pos;
+			char8_t const b0 = pos[0];
+			if (b0 < 0x80) {
+				c = b0;
+				return 1;
+			}
+			if (b0 < 0xc2)	// continuation, overlong (2 bytes)
+				return 0;
+			if (b0 < 0xe0) {
+				if ( (n < 2) or !IsCont(pos[1]) )
+					return 0;
+				c = ((b0 & 0x1f) << 6) | (pos[1] & 0x3f);
+				return 2;
+			}
+			if (b0 < 0xf0) {
+				if ( (n < 3) or !IsCont(pos[1]) or !IsCont(pos[2]) )
+					return 0;
+				c = ((b0 & 0x0f) << 12) | ((pos[1] & 0x3f) << 6) | (pos[2] & 0x3f);
+				if ( (c < 0x800) or (c >= 0xd800 and c <= 0xdfff) )
+					return 0;
+				return 3;
+			}
+			if (b0 < 0xf5) {
+				if ( (n < 4) or !IsCont(pos[1]) or !IsCont(pos[2]) or !IsCont(pos[3]) )
+					return 0;
+				c = ((b0 & 0x07) << 18) | ((pos[1] & 0x3f) << 12) | ((pos[2] & 0x3f) << 6) | (pos[3] & 0x3f);
+				if ( (c < 0x1'0000) or (c > 0x10'ffff) )
+					return 0;
+				return 4;
+			}
+			return 0;
+		}
+		inline int Decode(char16_t const* pos, char16_t const* end, char32_t& c) {
+			char16_t const u = pos[0];
+			if ( (u < 0xd800) or (u > 0xdfff) ) {
+				c = u;
+				return 1;
+			}
+			if ( (u > 0xdbff) or (end - pos < 2) or (pos[1] < 0xdc00) or (pos[1] > 0xdfff) )
+				return 0;
+			c = 0x1'0000 + (((char32_t)u - 0xd800) << 10) + (pos[1] - 0xdc00);
+			return 2;
+		}
+		inline int Decode(char32_t const* pos, char32_t const*, char32_t& c) {
+			c = pos[0];
+			return ( (c > 0x10'ffff) or (c >= 0xd800 and c <= 0xdfff) ) ? 0 : 1;
+		}
+
+		template < typename tchar >
+		constexpr int Length(char32_t c) {
+			if constexpr (sizeof(tchar) == 1)
+				return 1 + (c >= 0x80) + (c >= 0x800) + (c >= 0x1'0000);
+			else if constexpr (sizeof(tchar) == 2)
+				return 1 + (c >= 0x1'0000);
+			else
+				return 1;
+		}
+
+		inline void Encode(char32_t c, char8_t* dst) {
+			if (c < 0x80) {
+				dst[0] = (char8_t)c;
+			}
+			else if (c < 0x800) {
+				dst[0] = (char8_t)(0xc0 | (c >> 6));
+				dst[1] = (char8_t)(0x80 | (c & 0x3f));
+			}
+			else if (c < 0x1'0000) {
+				dst[0] = (char8_t)(0xe0 | (c >> 12));
+				dst[1] = (char8_t)(0x80 | ((c >> 6) & 0x3f));
+				dst[2] = (char8_t)(0x80 | (c & 0x3f));
+			}
+			else {
+				dst[0] = (char8_t)(0xf0 | (c >> 18));
+				dst[1] = (char8_t)(0x80 | ((c >> 12) & 0x3f));
+				dst[2] = (char8_t)(0x80 | ((c >> 6) & 0x3f));
+				dst[3] = (char8_t)(0x80 | (c & 0x3f));
+			}
+		}
+		inline void Encode(char32_t c, char16_t* dst) {
+			if (c < 0x1'0000) {
+				dst[0] = (char16_t)c;
+			}
+			else {
+				c -= 0x1'0000;
+				dst[0] = (char16_t)(0xd800 + (c >> 10));
+				dst[1] = (char16_t)(0xdc00 + (c & 0x3ff));
+			}
+		}
+		inline void Encode(char32_t c, char32_t* dst) {
+			dst[0] = c;
+		}
+
+		/// @brief one code point. false if src is invalid or dst is full
+		template < typename tchar_to, typename tchar_from >
+		inline bool Step(tchar_from const* src, size_t nSrc, tchar_to* dst, size_t nDst, sUTFTranscodeResult& r) {
+			char32_t c{};
+			int const nRead = Decode(src + r.nRead, src + nSrc, c);
+			if (!nRead)
+				return false;
+			int const nWrite = Length<tchar_to>(c);
+			if (r.nWritten + nWrite > nDst)
+				return false;
+			Encode(c, dst + r.nWritten);
+			r.nRead += nRead;
+			r.nWritten += nWrite;
+			return true;
+		}
+
+		template < typename tchar_to, typename tchar_from >
+		sUTFTranscodeResult Transcode_Scalar(tchar_from const* src, size_t nSrc, tchar_to* dst, size_t nDst, sUTFTranscodeResult r) {
+			while ( (r.nRead < nSrc) and Step(src, nSrc, dst, nDst, r) )
+				;
+			return r;
+		}
+
+#if (GTL__UTF_AVX2)
+
+		//-----------------------------------------------------------------------------
+		// tables of 4 code points. key : (length-1) of each code point, 2 bits each. (first one on LSB)
+
+		/// @brief utf-8 -> 4 x 32 bit lanes. lane : bytes of code point in reverse order (last byte on LSB), lead byte masked
+		struct sDecodeEntry {
+			alignas(16) uint8_t shuffle[16];
+			alignas(16) uint8_t mask[16];
+			uint8_t nByte;
+		};
+		constexpr auto const s_tblDecodeUTF8 = [] {
+			std::array<sDecodeEntry, 256> tbl{};
+			constexpr uint8_t maskLead[5] { 0, 0x7f, 0x1f, 0x0f, 0x07 };
+			for (int key{}; key < 256; key++) {
+				auto& e = tbl[key];
+				int offset{};
+				for (int i{}; i < 4; i++) {
+					int const len = ((key >> (2*i)) & 0b11) + 1;
+					for (int k{}; k < 4; k++) {
+						e.shuffle[4*i + k] = (k < len) ? (uint8_t)(offset + len - 1 - k) : 0x80;
+						e.mask[4*i + k] = (k < len - 1) ? 0x3f : (k == len - 1) ? maskLead[len] : 0;
+					}
+					offset += len;
+				}
+				e.nByte = (uint8_t)offset;
+			}
+			return tbl;
+		}();
+
+		/// @brief 4 x 32 bit lanes (each lane : utf-8 bytes, lead byte on highest used byte) -> packed utf-8
+		struct sEncodeEntry {
+			alignas(16) uint8_t shuffle[16];
+			uint8_t nByte;
+		};
+		constexpr auto const s_tblEncodeUTF8 = [] {
+			std::array<sEncodeEntry, 256> tbl{};
+			for (int key{}; key < 256; key++) {
+				auto& e = tbl[key];
+				int n{};
+				for (int i{}; i < 4; i++) {
+					int const len = ((key >> (2*i)) & 0b11) + 1;
+					for (int k = len-1; k >= 0; k--)
+						e.shuffle[n++] = (uint8_t)(4*i + k);
+				}
+				e.nByte = (uint8_t)n;
+				for (; n < 16; n++)
+					e.shuffle[n] = 0x80;
+			}
+			return tbl;
+		}();
+
+		/// @brief 4 bits -> bit 0, 2, 4, 6
+		constexpr uint8_t const s_tblSpread4[16] { 0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15, 0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55 };
+
+		/// @brief length of utf-8 sequence by high nibble of lead byte (continuation : 1, never used on valid input)
+		constexpr uint8_t const s_tblLengthUTF8[16] { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 4 };
+
+		/// @brief 4 code points from validated utf-8. (16 bytes must be readable)
+		inline __m128i Decode4(uint8_t const* pos, int& nByte, bool& bHas4Byte) {
+			int const l0 = s_tblLengthUTF8[pos[0] >> 4];
+			int const l1 = s_tblLengthUTF8[pos[l0] >> 4];
+			int const l2 = s_tblLengthUTF8[pos[l0+l1] >> 4];
+			int const l3 = s_tblLengthUTF8[pos[l0+l1+l2] >> 4];
+			bHas4Byte = (l0 | l1 | l2 | l3) & 4;
+			auto const& e = s_tblDecodeUTF8[(l0-1) | ((l1-1) << 2) | ((l2-1) << 4) | ((l3-1) << 6)];
+			nByte = e.nByte;
+			__m128i v = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const*)pos), _mm_load_si128((__m128i const*)e.shuffle));
+			v = _mm_and_si128(v, _mm_load_si128((__m128i const*)e.mask));
+			__m128i const maskByte = _mm_set1_epi32(0xff);
+			__m128i c = _mm_and_si128(v, maskByte);
+			c = _mm_or_si128(c, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 8), maskByte), 6));
+			c = _mm_or_si128(c, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 16), maskByte), 12));
+			c = _mm_or_si128(c, _mm_slli_epi32(_mm_srli_epi32(v, 24), 18));
+			return c;
+		}
+
+		/// @brief 4 valid code points -> utf-8. writes 16 bytes, returns bytes used.
+		inline int Encode4(__m128i c, uint8_t* dst) {
+			__m128i const c1 = _mm_cmpgt_epi32(c, _mm_set1_epi32(0x7f));
+			__m128i const c2 = _mm_cmpgt_epi32(c, _mm_set1_epi32(0x7ff));
+			__m128i const c3 = _mm_cmpgt_epi32(c, _mm_set1_epi32(0xffff));
+			__m128i const m6 = _mm_set1_epi32(0x3f), m80 = _mm_set1_epi32(0x80);
+			__m128i const t0 = _mm_or_si128(m80, _mm_and_si128(c, m6));
+			__m128i const t1 = _mm_or_si128(m80, _mm_and_si128(_mm_srli_epi32(c, 6), m6));
+			__m128i const t2 = _mm_or_si128(m80, _mm_and_si128(_mm_srli_epi32(c, 12), m6));
+			// lanes, reverse order (lead byte on highest used byte)
+			__m128i const v2 = _mm_or_si128(t0, _mm_slli_epi32(_mm_or_si128(_mm_set1_epi32(0xc0), _mm_srli_epi32(c, 6)), 8));
+			__m128i const v3 = _mm_or_si128(_mm_or_si128(t0, _mm_slli_epi32(t1, 8)), _mm_slli_epi32(_mm_or_si128(_mm_set1_epi32(0xe0), _mm_srli_epi32(c, 12)), 16));
+			__m128i const v4 = _mm_or_si128(_mm_or_si128(t0, _mm_slli_epi32(t1, 8)), _mm_or_si128(_mm_slli_epi32(t2, 16), _mm_slli_epi32(_mm_or_si128(_mm_set1_epi32(0xf0), _mm_srli_epi32(c, 18)), 24)));
+			__m128i v = _mm_blendv_epi8(c, v2, c1);
+			v = _mm_blendv_epi8(v, v3, c2);
+			v = _mm_blendv_epi8(v, v4, c3);
+			int const m1 = _mm_movemask_ps(_mm_castsi128_ps(c1)), m2 = _mm_movemask_ps(_mm_castsi128_ps(c2)), m3 = _mm_movemask_ps(_mm_castsi128_ps(c3));
+			auto const& e = s_tblEncodeUTF8[s_tblSpread4[m1] + s_tblSpread4[m2] + s_tblSpread4[m3]];
+			_mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi8(v, _mm_load_si128((__m128i const*)e.shuffle)));
+			return e.nByte;
+		}
+
+		//-----------------------------------------------------------------------------
+		// utf-8 validation (lookup tables, Keiser & Lemire)
+
+		constexpr uint8_t const TOO_SHORT		= 1 << 0;	// 11______ 0_______ / 11______ 11______
+		constexpr uint8_t const TOO_LONG		= 1 << 1;	// 0_______ 10______
+		constexpr uint8_t const OVERLONG_3		= 1 << 2;	// 11100000 100_____
+		constexpr uint8_t const TOO_LARGE		= 1 << 3;	// 11110100 1001____ / 11110100 101_____ / 11110101+
+		constexpr uint8_t const SURROGATE		= 1 << 4;	// 11101101 101_____
+		constexpr uint8_t const OVERLONG_2		= 1 << 5;	// 1100000_ 10______
+		constexpr uint8_t const TOO_LARGE_1000	= 1 << 6;	// 11110101 1000____ / 1111011_ 1000____ / 11111___ 1000____
+		constexpr uint8_t const OVERLONG_4		= 1 << 6;	// 11110000 1000____
+		constexpr uint8_t const TWO_CONTS		= 1 << 7;	// 10______ 10______
+		constexpr uint8_t const CARRY			= TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+		inline __m256i Table16(std::array<uint8_t, 16> const& tbl) {
+			return _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i const*)tbl.data()));
+		}
+		constexpr std::array<uint8_t, 16> const s_tblByte1High {
+			// 0_______ : ascii
+			TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+			// 10______ : continuation
+			TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+			// 1100____, 1101____ : 2 bytes
+			TOO_SHORT | OVERLONG_2,
+			TOO_SHORT,
+			// 1110____ : 3 bytes
+			TOO_SHORT | OVERLONG_3 | SURROGATE,
+			// 1111____ : 4 bytes
+			TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+		};
+		constexpr std::array<uint8_t, 16> const s_tblByte1Low {
+			CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,	// ____0000
+			CARRY | OVERLONG_2,								// ____0001
+			CARRY,
+			CARRY,
+			CARRY | TOO_LARGE,								// ____0100
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+			CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,	// ____1101
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+			CARRY | TOO_LARGE | TOO_LARGE_1000,
+		};
+		constexpr std::array<uint8_t, 16> const s_tblByte2High {
+			// 0_______ : ascii
+			TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+			// 1000____
+			TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+			// 1001____
+			TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+			// 101_____
+			TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+			TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+			// 11______
+			TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		};
+
+		/// @brief input shifted by N bytes, with last bytes of prev
+		template < int N >
+		inline __m256i Prev(__m256i input, __m256i prev) {
+			return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+		}
+
+		/// @brief non-zero bytes on error (of sequences ending in input)
+		inline __m256i CheckUTF8(__m256i input, __m256i prev) {
+			__m256i const mask0F = _mm256_set1_epi8(0x0f);
+			__m256i const prev1 = Prev<1>(input, prev);
+			__m256i const byte1High = _mm256_shuffle_epi8(Table16(s_tblByte1High), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), mask0F));
+			__m256i const byte1Low = _mm256_shuffle_epi8(Table16(s_tblByte1Low), _mm256_and_si256(prev1, mask0F));
+			__m256i const byte2High = _mm256_shuffle_epi8(Table16(s_tblByte2High), _mm256_and_si256(_mm256_srli_epi16(input, 4), mask0F));
+			__m256i const special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+			// 3rd, 4th bytes must be continuation
+			__m256i const is3rd = _mm256_subs_epu8(Prev<2>(input, prev), _mm256_set1_epi8((char)(0xe0 - 0x80)));
+			__m256i const is4th = _mm256_subs_epu8(Prev<3>(input, prev), _mm256_set1_epi8((char)(0xf0 - 0x80)));
+			__m256i const must23 = _mm256_and_si256(_mm256_or_si256(is3rd, is4th), _mm256_set1_epi8((char)0x80));
+			return _mm256_xor_si256(must23, special);
+		}
+
+		/// @brief non-zero bytes if sequence at the end of input is not complete
+		inline __m256i IsIncomplete(__m256i input) {
+			__m256i const maxValue = _mm256_setr_epi8(
+				-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+				-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)(0xf0 - 1), (char)(0xe0 - 1), (char)(0xc0 - 1));
+			return _mm256_subs_epu8(input, maxValue);
+		}
+
+		/// @brief validates n (multiple of 32) bytes, starting on a code point. sequence at the end may be incomplete.
+		inline bool ValidateChunkUTF8(uint8_t const* pos, size_t n) {
+			__m256i prev = _mm256_setzero_si256();
+			__m256i error = _mm256_setzero_si256();
+			for (size_t i{}; i < n; i += 32) {
+				__m256i const input = _mm256_loadu_si256((__m256i const*)(pos + i));
+				if (_mm256_movemask_epi8(input) == 0)
+					error = _mm256_or_si256(error, IsIncomplete(prev));
+				else
+					error = _mm256_or_si256(error, CheckUTF8(input, prev));
+				prev = input;
+			}
+			return _mm256_testz_si256(error, error);
+		}
+
+		/// @brief 16 ascii -> tchar_to
+		template < typename tchar_to >
+		inline void WidenASCII16(__m128i v, tchar_to* dst) {
+			if constexpr (sizeof(tchar_to) == 2) {
+				_mm256_storeu_si256((__m256i*)dst, _mm256_cvtepu8_epi16(v));
+			}
+			else {
+				_mm256_storeu_si256((__m256i*)dst, _mm256_cvtepu8_epi32(v));
+				_mm256_storeu_si256((__m256i*)(dst + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+			}
+		}
+		/// @brief 4 code points (<= 0xffff for utf-16) -> tchar_to
+		template < typename tchar_to >
+		inline void Store4(__m128i c, tchar_to* dst) {
+			if constexpr (sizeof(tchar_to) == 2)
+				_mm_storel_epi64((__m128i*)dst, _mm_packus_epi32(c, c));
+			else
+				_mm_storeu_si128((__m128i*)dst, c);
+		}
+
+#endif	// GTL__UTF_AVX2
+
+		//-----------------------------------------------------------------------------
+		// utf-8 -> utf-16, utf-32
+		template < typename tchar_to >
+		sUTFTranscodeResult TranscodeFromUTF8(char8_t const* src, size_t nSrc, tchar_to* dst, size_t nDst) {
+			sUTFTranscodeResult r;
+#if (GTL__UTF_AVX2)
+			// validated by chunk, then converted up to the last lead byte of the chunk. (output units <= input bytes)
+			constexpr size_t nChunk = 256;
+			while ( (nSrc - r.nRead >= nChunk) and (nDst - r.nWritten >= nChunk) ) {
+				auto const* pos = (uint8_t const*)src + r.nRead;
+				if (!ValidateChunkUTF8(pos, nChunk))
+					break;	// scalar stops on it
+				size_t nValid = nChunk - 1;
+				while ((pos[nValid] & 0xc0) == 0x80)
+					nValid--;
+				auto const* const end = pos + nValid;
+				auto* out = dst + r.nWritten;
+				while (pos < end) {
+					if (end - pos >= 16) {
+						__m128i const v = _mm_loadu_si128((__m128i const*)pos);
+						if (_mm_movemask_epi8(v) == 0) {
+							WidenASCII16(v, out);
+							pos += 16;
+							out += 16;
+							continue;
+						}
+						int nByte{};
+						bool bHas4Byte{};
+						__m128i const c = Decode4(pos, nByte, bHas4Byte);
+						if ( (sizeof(tchar_to) == 4) or !bHas4Byte ) {
+							Store4(c, out);
+							pos += nByte;
+							out += 4;
+							continue;
+						}
+					}
+					char32_t c{};
+					pos += Decode((char8_t const*)pos, (char8_t const*)end, c);
+					Encode(c, out);
+					out += Length<tchar_to>(c);
+				}
+				r.nRead = (char8_t const*)pos - src;
+				r.nWritten = out - dst;
+			}
+#endif
+			return Transcode_Scalar(src, nSrc, dst, nDst, r);
+		}
+
+		//-----------------------------------------------------------------------------
+		// utf-16 -> utf-8, utf-32
+		template < typename tchar_to >
+		sUTFTranscodeResult TranscodeFromUTF16(char16_t const* src, size_t nSrc, tchar_to* dst, size_t nDst) {
+			sUTFTranscodeResult r;
+#if (GTL__UTF_AVX2)
+			// 8 units without surrogate
+			constexpr size_t nMaxOut = (sizeof(tchar_to) == 1) ? 12 + 16 : 8;	// 2nd Encode4() writes 16 bytes at <= 12
+			while ( (nSrc - r.nRead >= 8) and (nDst - r.nWritten >= nMaxOut) ) {
+				auto const* pos = src + r.nRead;
+				__m128i const v = _mm_loadu_si128((__m128i const*)pos);
+				__m128i const surrogate = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short)0xf800)), _mm_set1_epi16((short)0xd800));
+				if (!_mm_testz_si128(surrogate, surrogate)) {
+					// up to the end of block (pair may go one more)
+					size_t const nEnd = r.nRead + 8;
+					while (r.nRead < nEnd) {
+						if (!Step(src, nSrc, dst, nDst, r))
+							return r;
+					}
+					continue;
+				}
+				if constexpr (sizeof(tchar_to) == 1) {
+					auto* out = (uint8_t*)dst + r.nWritten;
+					if (_mm_testz_si128(v, _mm_set1_epi16((short)0xff80))) {
+						_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(v, v));
+						r.nWritten += 8;
+					}
+					else {
+						int n = Encode4(_mm_cvtepu16_epi32(v), out);
+						n += Encode4(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8)), out + n);
+						r.nWritten += n;
+					}
+				}
+				else {
+					_mm256_storeu_si256((__m256i*)(dst + r.nWritten), _mm256_cvtepu16_epi32(v));
+					r.nWritten += 8;
+				}
+				r.nRead += 8;
+			}
+#endif
+			return Transcode_Scalar(src, nSrc, dst, nDst, r);
+		}
+
+		//-----------------------------------------------------------------------------
+		// utf-32 -> utf-8, utf-16
+		template < typename tchar_to >
+		sUTFTranscodeResult TranscodeFromUTF32(char32_t const* src, size_t nSrc, tchar_to* dst, size_t nDst) {
+			sUTFTranscodeResult r;
+#if (GTL__UTF_AVX2)
+			// 8 valid code points. (<= 0xffff for utf-16)
+			constexpr size_t nMaxOut = (sizeof(tchar_to) == 1) ? 16 + 16 : 8;
+			while ( (nSrc - r.nRead >= 8) and (nDst - r.nWritten >= nMaxOut) ) {
+				auto const* pos = src + r.nRead;
+				__m256i const v = _mm256_loadu_si256((__m256i const*)pos);
+				__m256i const surrogate = _mm256_cmpeq_epi32(_mm256_and_si256(v, _mm256_set1_epi32((int)0xffff'f800)), _mm256_set1_epi32(0xd800));
+				__m256i const large = _mm256_cmpgt_epi32(_mm256_srli_epi32(v, 16), _mm256_set1_epi32(sizeof(tchar_to) == 1 ? 0x10 : 0));
+				__m256i const bad = _mm256_or_si256(surrogate, large);
+				if (!_mm256_testz_si256(bad, bad)) {
+					size_t const nEnd = r.nRead + 8;
+					while (r.nRead < nEnd) {
+						if (!Step(src, nSrc, dst, nDst, r))
+							return r;
+					}
+					continue;
+				}
+				if constexpr (sizeof(tchar_to) == 1) {
+					auto* out = (uint8_t*)dst + r.nWritten;
+					if (_mm256_testz_si256(v, _mm256_set1_epi32((int)0xffff'ff80))) {
+						__m128i const w = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+						_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(w, w));
+						r.nWritten += 8;
+					}
+					else {
+						int n = Encode4(_mm256_castsi256_si128(v), out);
+						n += Encode4(_mm256_extracti128_si256(v, 1), out + n);
+						r.nWritten += n;
+					}
+				}
+				else {
+					_mm_storeu_si128((__m128i*)(dst + r.nWritten), _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+					r.nWritten += 8;
+				}
+				r.nRead += 8;
+			}
+#endif
+			return Transcode_Scalar(src, nSrc, dst, nDst, r);
+		}
+
+	}	// anonymous namespace
+
+
+	sUTFTranscodeResult TranscodeUTF(char8_t const* src, size_t nSrc, char16_t* dst, size_t nDst) { return TranscodeFromUTF8(src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeUTF(char8_t const* src, size_t nSrc, char32_t* dst, size_t nDst) { return TranscodeFromUTF8(src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeUTF(char16_t const* src, size_t nSrc, char8_t* dst, size_t nDst) { return TranscodeFromUTF16(src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeUTF(char16_t const* src, size_t nSrc, char32_t* dst, size_t nDst) { return TranscodeFromUTF16(src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeUTF(char32_t const* src, size_t nSrc, char8_t* dst, size_t nDst) { return TranscodeFromUTF32(src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeUTF(char32_t const* src, size_t nSrc, char16_t* dst, size_t nDst) { return TranscodeFromUTF32(src, nSrc, dst, nDst); }
+
+
+	//-----------------------------------------------------------------------------
+	// Count
+
+	namespace {
+		/// @brief sum of func(unit) for each unit. kernel(ptr) : sum of a block of nBlock units
+		template < size_t nBlock, typename tchar, typename tfunc, typename tkernel >
+		size_t Count(tchar const* src, size_t nSrc, tfunc&& func, [[maybe_unused]] tkernel&& kernel) {
+			size_t n{}, i{};
+#if (GTL__UTF_AVX2)
+			for (; i + nBlock <= nSrc; i += nBlock)
+				n += kernel(src + i);
+#endif
+			for (; i < nSrc; i++)
+				n += func(src[i]);
+			return n;
+		}
+	#if (GTL__UTF_AVX2)
+		inline int PopCount(__m256i mask) { return std::popcount((uint32_t)_mm256_movemask_epi8(mask)); }
+		/// @brief unsigned 16 bit : v >= k
+		inline __m256i IsGE16(__m256i v, uint16_t k) { return _mm256_cmpeq_epi16(_mm256_max_epu16(v, _mm256_set1_epi16((short)k)), v); }
+		inline __m256i IsGE32(__m256i v, uint32_t k) { return _mm256_cmpeq_epi32(_mm256_max_epu32(v, _mm256_set1_epi32((int)k)), v); }
+		inline __m256i Load(void const* p) { return _mm256_loadu_si256((__m256i const*)p); }
+	#endif
+	}
+
+	size_t CountUTF16(char8_t const* src, size_t nSrc) {
+		return Count<32>(src, nSrc, [](char8_t c) { return ((c & 0xc0) != 0x80) + (c >= 0xf0); }, [](char8_t const* p) {
+		#if (GTL__UTF_AVX2)
+			__m256i const v = Load(p);
+			__m256i const lead = _mm256_cmpgt_epi8(v, _mm256_set1_epi8((char)0xbf));	// signed. not continuation
+			__m256i const lead4 = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8((char)0xf0)), v);
+			return PopCount(lead) + PopCount(lead4);
+		#else
+			return 0;
+		#endif
+		});
+	}
+	size_t CountUTF32(char8_t const* src, size_t nSrc) {
+		return Count<32>(src, nSrc, [](char8_t c) { return (size_t)((c & 0xc0) != 0x80); }, [](char8_t const* p) {
+		#if (GTL__UTF_AVX2)
+			return PopCount(_mm256_cmpgt_epi8(Load(p), _mm256_set1_epi8((char)0xbf)));
+		#else
+			return 0;
+		#endif
+		});
+	}
+	size_t CountUTF8(char16_t const* src, size_t nSrc) {
+		// surrogate pair : 2 + 2
+		return Count<16>(src, nSrc, [](char16_t c) { return 1 + (c >= 0x80) + (c >= 0x800) - ((c & 0xf800) == 0xd800); }, [](char16_t const* p) {
+		#if (GTL__UTF_AVX2)
+			__m256i const v = Load(p);
+			__m256i const surrogate = _mm256_cmpeq_epi16(_mm256_and_si256(v, _mm256_set1_epi16((short)0xf800)), _mm256_set1_epi16((short)0xd800));
+			return 16 + (PopCount(IsGE16(v, 0x80)) + PopCount(IsGE16(v, 0x800)) - PopCount(surrogate)) / 2;
+		#else
+			return 0;
+		#endif
+		});
+	}
+	size_t CountUTF32(char16_t const* src, size_t nSrc) {
+		return Count<16>(src, nSrc, [](char16_t c) { return (size_t)((c & 0xfc00) != 0xdc00); }, [](char16_t const* p) {
+		#if (GTL__UTF_AVX2)
+			__m256i const low = _mm256_cmpeq_epi16(_mm256_and_si256(Load(p), _mm256_set1_epi16((short)0xfc00)), _mm256_set1_epi16((short)0xdc00));
+			return 16 - PopCount(low) / 2;
+		#else
+			return 0;
+		#endif
+		});
+	}
+	size_t CountUTF8(char32_t const* src, size_t nSrc) {
+		return Count<8>(src, nSrc, [](char32_t c) { return (size_t)Length<char8_t>(c); }, [](char32_t const* p) {
+		#if (GTL__UTF_AVX2)
+			__m256i const v = Load(p);
+			return 8 + (PopCount(IsGE32(v, 0x80)) + PopCount(IsGE32(v, 0x800)) + PopCount(IsGE32(v, 0x1'0000))) / 4;
+		#else
+			return 0;
+		#endif
+		});
+	}
+	size_t CountUTF16(char32_t const* src, size_t nSrc) {
+		return Count<8>(src, nSrc, [](char32_t c) { return (size_t)Length<char16_t>(c); }, [](char32_t const* p) {
+		#if (GTL__UTF_AVX2)
+			return 8 + PopCount(IsGE32(Load(p), 0x1'0000)) / 4;
+		#else
+			return 0;
+		#endif
+		});
+	}
+
+
+
+	//-----------------------------------------------------------------------------
+	// Validate
+
+	sUTF8Validation ValidateUTF8(char8_t const* src, size_t nSrc) {
+		sUTF8Validation r;
+		size_t pos{};
+	#if (GTL__UTF_AVX2)
+		// 4 blocks of 32 bytes. lead bytes counted on 8 bit lanes, summed on 64 bit lanes
+		__m256i prev = _mm256_setzero_si256();
+		__m256i sum16 = _mm256_setzero_si256(), sum32 = _mm256_setzero_si256();
+		for (; pos + 128 <= nSrc; pos += 128) {
+			__m256i const in[4] { Load(src + pos), Load(src + pos + 32), Load(src + pos + 64), Load(src + pos + 96) };
+			__m256i const any = _mm256_or_si256(_mm256_or_si256(in[0], in[1]), _mm256_or_si256(in[2], in[3]));
+			if (_mm256_movemask_epi8(any) == 0) {
+				__m256i const error = IsIncomplete(prev);
+				if (!_mm256_testz_si256(error, error))
+					break;
+				r.nUTF16 += 128;
+				r.nUTF32 += 128;
+				prev = in[3];
+				continue;
+			}
+			__m256i error = CheckUTF8(in[0], prev);
+			error = _mm256_or_si256(error, CheckUTF8(in[1], in[0]));
+			error = _mm256_or_si256(error, CheckUTF8(in[2], in[1]));
+			error = _mm256_or_si256(error, CheckUTF8(in[3], in[2]));
+			if (!_mm256_testz_si256(error, error))
+				break;
+			__m256i nLead = _mm256_setzero_si256(), nLead4 = _mm256_setzero_si256();
+			for (auto const& v : in) {
+				nLead = _mm256_sub_epi8(nLead, _mm256_cmpgt_epi8(v, _mm256_set1_epi8((char)0xbf)));	// signed. not continuation
+				nLead4 = _mm256_sub_epi8(nLead4, _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8((char)0xf0)), v));
+			}
+			sum16 = _mm256_add_epi64(sum16, _mm256_sad_epu8(_mm256_add_epi8(nLead, nLead4), _mm256_setzero_si256()));
+			sum32 = _mm256_add_epi64(sum32, _mm256_sad_epu8(nLead, _mm256_setzero_si256()));
+			prev = in[3];
+		}
+		auto HSum = [](__m256i v) { return (size_t)(_mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1) + _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3)); };
+		r.nUTF16 += HSum(sum16);
+		r.nUTF32 += HSum(sum32);
+		// back to the start of the last sequence (may be incomplete), scalar from there
+		if (pos) {
+			size_t nBack{};
+			while ( (nBack < 3) and (nBack < pos) and ((src[pos - nBack - 1] & 0xc0) == 0x80) )
+				nBack++;
+			if (nBack == 3)			// 4 bytes sequence, complete
+				nBack = 0;
+			else if (nBack < pos)	// lead byte
+				nBack++;
+			for (; nBack; nBack--) {
+				char8_t const c = src[--pos];
+				bool const bLead = (c & 0xc0) != 0x80;
+				r.nUTF16 -= bLead + (c >= 0xf0);
+				r.nUTF32 -= bLead;
+			}
+		}
+	#endif
+		while (pos < nSrc) {
+			char32_t c{};
+			int const n = Decode(src + pos, src + nSrc, c);
+			if (!n)
+				break;
+			pos += n;
+			r.nUTF16 += Length<char16_t>(c);
+			r.nUTF32++;
+		}
+		r.bValid = (pos >= nSrc);
+		r.posError = pos;
+		r.bMSBSet = (r.nUTF32 != pos);
+		return r;
+	}
+
+
+	//-----------------------------------------------------------------------------
+	// MBCS (table)
+
+	namespace {
+
+		/// @brief MBCS <-> UTF-16 tables of a codepage. (ascii is same)
+		class xCodepageTable {
+		protected:
+			char16_t const* m_tblSingle{};		// [byte - 0x80] (single byte codepage)
+			char16_t const* m_tblDouble{};		// [(lead - m_leadFirst) * m_nTrail + (trail - m_trailFirst)] (double byte codepage)
+			uint8_t m_leadFirst{}, m_leadLast{}, m_trailFirst{}, m_trailLast{};
+			int m_nTrail{};
+			std::vector<uint16_t> m_tblReverse;	// [char16_t] -> byte (< 0x100) or lead << 8 | trail. 0 : not defined
+
+		public:
+			explicit xCodepageTable(char16_t const* tblSingle) : m_tblSingle(tblSingle), m_tblReverse(0x1'0000) {
+				for (int b = 0x80; b < 0x100; b++)
+					Add(m_tblSingle[b - 0x80], (uint16_t)b);
+			}
+			xCodepageTable(char16_t const* tblDouble, uint8_t leadFirst, uint8_t leadLast, uint8_t trailFirst, uint8_t trailLast)
+				: m_tblDouble(tblDouble), m_leadFirst(leadFirst), m_leadLast(leadLast), m_trailFirst(trailFirst), m_trailLast(trailLast),
+				m_nTrail(trailLast - trailFirst + 1), m_tblReverse(0x1'0000)
+			{
+				for (int lead = leadFirst; lead <= leadLast; lead++) {
+					for (int trail = trailFirst; trail <= trailLast; trail++)
+						Add(m_tblDouble[(lead - leadFirst) * m_nTrail + (trail - trailFirst)], (uint16_t)((lead << 8) | trail));
+				}
+			}
+
+			/// @return bytes of a char, 0 if not defined or truncated
+			inline int Decode(uint8_t const* pos, uint8_t const* end, char16_t& c) const {
+				uint8_t const b = pos[0];
+				if (b < 0x80) {
+					c = b;
+					return 1;
+				}
+				if (m_tblSingle) {
+					c = m_tblSingle[b - 0x80];
+					return c ? 1 : 0;
+				}
+				if ( (b < m_leadFirst) or (b > m_leadLast) or (end - pos < 2) )
+					return 0;
+				uint8_t const t = pos[1];
+				if ( (t < m_trailFirst) or (t > m_trailLast) )
+					return 0;
+				c = m_tblDouble[(b - m_leadFirst) * m_nTrail + (t - m_trailFirst)];
+				return c ? 2 : 0;
+			}
+			/// @return bytes written (1 or 2), 0 if not defined
+			inline int Encode(char16_t c, char* dst) const {
+				if (c < 0x80) {
+					dst[0] = (char)c;
+					return 1;
+				}
+				uint16_t const m = m_tblReverse[c];
+				if (!m)
+					return 0;
+				if (m < 0x100) {
+					dst[0] = (char)m;
+					return 1;
+				}
+				dst[0] = (char)(m >> 8);
+				dst[1] = (char)(m & 0xff);
+				return 2;
+			}
+
+		protected:
+			void Add(char16_t c, uint16_t code) {
+				if ( (c >= 0x80) and !m_tblReverse[c] )	// first one
+					m_tblReverse[c] = code;
+			}
+		};
+
+		xCodepageTable const* GetCodepageTable(int codepage) {
+			using namespace gtl::charset;
+		#if (GTL__USE_WINDOWS_API)
+			// DEFAULT (CP_ACP) : active ANSI codepage, as system conversion does
+			if (codepage == 0)
+				codepage = (int)GetACP();
+		#endif
+			switch (codepage) {
+			case 949 :	{ static xCodepageTable const tbl(tblCP949toUTF16_g.data(), CP949_LEAD_FIRST, CP949_LEAD_LAST, CP949_TRAIL_FIRST, CP949_TRAIL_LAST); return &tbl; }
+			case 1250 :	{ static xCodepageTable const tbl(tblCP1250toUTF16_g.data()); return &tbl; }
+			case 1251 :	{ static xCodepageTable const tbl(tblCP1251toUTF16_g.data()); return &tbl; }
+			case 1252 :	{ static xCodepageTable const tbl(tblCP1252toUTF16_g.data()); return &tbl; }
+			}
+			return nullptr;
+		}
+
+	#if (GTL__UTF_AVX2)
+		/// @brief 16 units -> 16 bytes, if all ascii
+		template < typename tchar_from >
+		inline bool NarrowASCII16(tchar_from const* src, char* dst) {
+			auto Load = [src](int i) { return _mm_loadu_si128((__m128i const*)src + i); };
+			__m128i v;
+			if constexpr (sizeof(tchar_from) == 1) {
+				v = Load(0);
+				if (_mm_movemask_epi8(v))
+					return false;
+			}
+			else if constexpr (sizeof(tchar_from) == 2) {
+				__m128i const a = Load(0), b = Load(1);
+				if (!_mm_testz_si128(_mm_or_si128(a, b), _mm_set1_epi16((short)0xff80)))
+					return false;
+				v = _mm_packus_epi16(a, b);
+			}
+			else {
+				__m128i const a = Load(0), b = Load(1), c = Load(2), d = Load(3);
+				if (!_mm_testz_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), _mm_set1_epi32((int)0xffff'ff80)))
+					return false;
+				v = _mm_packus_epi16(_mm_packus_epi32(a, b), _mm_packus_epi32(c, d));
+			}
+			_mm_storeu_si128((__m128i*)dst, v);
+			return true;
+		}
+	#endif
+
+		// MBCS -> utf-8, utf-16, utf-32
+		template < typename tchar_to >
+		sUTFTranscodeResult TranscodeFromMBCS(int codepage, char const* src, size_t nSrc, tchar_to* dst, size_t nDst) {
+			sUTFTranscodeResult r;
+			auto const* tbl = GetCodepageTable(codepage);
+			if (!tbl)
+				return r;
+			auto const* const end = (uint8_t const*)src + nSrc;
+			while (r.nRead < nSrc) {
+				auto const* pos = (uint8_t const*)src + r.nRead;
+			#if (GTL__UTF_AVX2)
+				if ( (*pos < 0x80) and (nSrc - r.nRead >= 16) and (nDst - r.nWritten >= 16) ) {
+					__m128i const v = _mm_loadu_si128((__m128i const*)pos);
+					if (_mm_movemask_epi8(v) == 0) {
+						if constexpr (sizeof(tchar_to) == 1)
+							_mm_storeu_si128((__m128i*)(dst + r.nWritten), v);
+						else
+							WidenASCII16(v, dst + r.nWritten);
+						r.nRead += 16;
+						r.nWritten += 16;
+						continue;
+					}
+				}
+			#endif
+				char16_t c{};
+				int const nRead = tbl->Decode(pos, end, c);
+				if (!nRead)
+					break;
+				int const nWrite = Length<tchar_to>(c);
+				if (r.nWritten + nWrite > nDst)
+					break;
+				Encode(c, dst + r.nWritten);
+				r.nRead += nRead;
+				r.nWritten += nWrite;
+			}
+			return r;
+		}
+
+		// utf-8, utf-16, utf-32 -> MBCS
+		template < typename tchar_from >
+		sUTFTranscodeResult TranscodeToMBCS(int codepage, tchar_from const* src, size_t nSrc, char* dst, size_t nDst) {
+			sUTFTranscodeResult r;
+			auto const* tbl = GetCodepageTable(codepage);
+			if (!tbl)
+				return r;
+			while (r.nRead < nSrc) {
+			#if (GTL__UTF_AVX2)
+				if ( (src[r.nRead] < 0x80) and (nSrc - r.nRead >= 16) and (nDst - r.nWritten >= 16) and NarrowASCII16(src + r.nRead, dst + r.nWritten) ) {
+					r.nRead += 16;
+					r.nWritten += 16;
+					continue;
+				}
+			#endif
+				char32_t c{};
+				int const nRead = Decode(src + r.nRead, src + nSrc, c);
+				if ( !nRead or (c > 0xffff) )
+					break;
+				char buf[2];
+				int const nWrite = tbl->Encode((char16_t)c, buf);
+				if ( !nWrite or (r.nWritten + nWrite > nDst) )
+					break;
+				std::memcpy(dst + r.nWritten, buf, nWrite);
+				r.nRead += nRead;
+				r.nWritten += nWrite;
+			}
+			return r;
+		}
+
+	}
+
+	bool IsTableCodepage(int codepage) {
+		return GetCodepageTable(codepage) != nullptr;
+	}
+
+	sUTFTranscodeResult TranscodeMBCS(int codepage, char const* src, size_t nSrc, char8_t* dst, size_t nDst) { return TranscodeFromMBCS(codepage, src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeMBCS(int codepage, char const* src, size_t nSrc, char16_t* dst, size_t nDst) { return TranscodeFromMBCS(codepage, src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeMBCS(int codepage, char const* src, size_t nSrc, char32_t* dst, size_t nDst) { return TranscodeFromMBCS(codepage, src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeMBCS(int codepage, char8_t const* src, size_t nSrc, char* dst, size_t nDst) { return TranscodeToMBCS(codepage, src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeMBCS(int codepage, char16_t const* src, size_t nSrc, char* dst, size_t nDst) { return TranscodeToMBCS(codepage, src, nSrc, dst, nDst); }
+	sUTFTranscodeResult TranscodeMBCS(int codepage, char32_t const* src, size_t nSrc, char* dst, size_t nDst) { return TranscodeToMBCS(codepage, src, nSrc, dst, nDst); }
+
+}
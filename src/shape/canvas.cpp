@@ -14,7 +14,7 @@ namespace gtl::shape {
 			len += pts[i].Distance(pts[i-1]);
 		}
 
-		double scale = canvas.m_ct.Trans(1.0);
+		double scale = canvas.TransLength(1.0);
 		double step = canvas.m_target_interpolation_inverval / len / scale;
 		//double step = 0.001;
 
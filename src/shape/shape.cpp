@@ -1,6 +1,10 @@
 ﻿#include "pch.h"
 #include <functional>
+#include <numeric>
+#include <span>
 #include "gtl/shape/shape.h"
+#include "boost/geometry.hpp"
+#include "boost/geometry/index/rtree.hpp"
 
 using namespace std::literals;
 
@@ -302,6 +306,7 @@ namespace gtl::shape {
 			{ eSHAPE::xline,			L"XLINE"s },
 			{ eSHAPE::layer,			L"LAYER"s },
 			{ eSHAPE::drawing,			L"DRAWING"s },
+			{ eSHAPE::block_ref,		L"BLOCK_REF"s },
 		};
 
 		auto iter = map.find(eType);
@@ -358,79 +363,397 @@ namespace gtl::shape {
 	}
 
 
+	//-------------------------------------------------------------------------
+	// xShapeSpatialIndex
+	namespace bg = boost::geometry;
+	namespace bgi = boost::geometry::index;
+
+	struct xShapeSpatialIndex::sIndex {
+		using box_t = bg::model::box<bg::model::d2::point_xy<double>>;
+		using value_t = std::pair<box_t, size_t>;
+
+		size_t nShape{};
+		std::vector<rect_t> boundaries;	// boundary of each shape. not normalized if shape has no extent (not indexed)
+		std::vector<size_t> unbounded;	// shapes with infinite boundary. tested one by one.
+		bgi::rtree<value_t, bgi::quadratic<16>> rtree;
+	};
+
+	xShapeSpatialIndex::xShapeSpatialIndex() = default;
+	xShapeSpatialIndex::xShapeSpatialIndex(xShapeSpatialIndex const&) {}
+	xShapeSpatialIndex& xShapeSpatialIndex::operator = (xShapeSpatialIndex const&) {
+		Invalidate();
+		return *this;
+	}
+	xShapeSpatialIndex::~xShapeSpatialIndex() = default;
+
+	void xShapeSpatialIndex::Invalidate() {
+		std::scoped_lock lock(m_mtx);
+		m_index.reset();
+	}
+
+	xShapeSpatialIndex::sIndex const& xShapeSpatialIndex::Build(boost::ptr_deque<xShape> const& shapes) const {
+		if (m_index and m_index->nShape == shapes.size())
+			return *m_index;
+
+		auto rIndex = std::make_unique<sIndex>();
+		auto& index = *rIndex;
+		index.nShape = shapes.size();
+		index.boundaries.reserve(shapes.size());
+		std::vector<sIndex::value_t> values;
+		values.reserve(shapes.size());
+		for (size_t i{}; i < shapes.size(); i++) {
+			// same as xShape::DrawROI()
+			rect_t rect;
+			rect.SetRectEmptyForMinMax2d();
+			shapes[i].UpdateBoundary(rect);
+			index.boundaries.push_back(rect);
+			if (!rect.IsNormalized())	// no extent (empty polyline, text, ...). never intersects ROI
+				continue;
+			if (std::isfinite(rect.right - rect.left) and std::isfinite(rect.bottom - rect.top))
+				values.emplace_back(sIndex::box_t{{rect.left, rect.top}, {rect.right, rect.bottom}}, i);
+			else
+				index.unbounded.push_back(i);
+		}
+		index.rtree = decltype(index.rtree)(values.begin(), values.end());	// packing (bulk loading)
+
+		m_index = std::move(rIndex);
+		return *m_index;
+	}
+
+	bool xShapeSpatialIndex::Query(boost::ptr_deque<xShape> const& shapes, rect_t const& rectROI, std::vector<size_t>& indices) const {
+		indices.clear();
+
+		rect_t roi(rectROI);
+		roi.NormalizeRect();
+
+		std::scoped_lock lock(m_mtx);
+		auto const& index = Build(shapes);
+		auto IsIntersecting = [&](size_t i) { return rect_t(index.boundaries[i]).IntersectRect(roi).IsNormalized(); };
+
+		sIndex::box_t box{{roi.left, roi.top}, {roi.right, roi.bottom}};
+		for (auto iter = index.rtree.qbegin(bgi::intersects(box)); iter != index.rtree.qend(); iter++) {
+			if (IsIntersecting(iter->second))
+				indices.push_back(iter->second);
+		}
+		for (auto i : index.unbounded) {
+			if (IsIntersecting(i))
+				indices.push_back(i);
+		}
+		std::ranges::sort(indices);	// keep drawing order
+
+		return !indices.empty();
+	}
+
+	//-------------------------------------------------------------------------
+	// end point index for Sort_Loop(), Sort_Path()
+	namespace {
+
+		/// @brief end points of shapes in R-tree. value : (point, id*2 + (0:start, 1:end))
+		class xEndPointIndex {
+		public:
+			using rpoint_t = bg::model::point<double, 3, bg::cs::cartesian>;
+			using value_t = std::pair<rpoint_t, size_t>;
+
+			std::vector<std::optional<std::pair<point_t, point_t>>> ends;	// original (not reversed) start/end point of each shape
+			bgi::rtree<value_t, bgi::quadratic<16>> rtree;
+			size_t nPacked{};
+
+		public:
+			xEndPointIndex(std::span<xShape* const> shapes) {
+				ends.resize(shapes.size());
+				std::vector<value_t> values;
+				values.reserve(shapes.size()*2);
+				for (size_t id{}; id < shapes.size(); id++) {
+					auto r = GetEnds(*shapes[id]);
+					if (!r)
+						continue;
+					ends[id] = r;
+					values.emplace_back(ToRPoint(r->first), id*2);
+					values.emplace_back(ToRPoint(r->second), id*2+1);
+				}
+				Pack(values);
+			}
+
+			void Pack(std::vector<value_t> const& values) {
+				rtree = decltype(rtree)(values.begin(), values.end());	// packing (bulk loading)
+				nPacked = rtree.size();
+			}
+
+			static std::optional<std::pair<point_t, point_t>> GetEnds(xShape const& shape) {
+				auto r = shape.GetStartEndPoint();
+				if (!r or !r->first.IsAllValid() or !r->second.IsAllValid())
+					return {};
+				return r;
+			}
+			static rpoint_t ToRPoint(point_t const& pt) { return { pt.x, pt.y, pt.z }; }
+			point_t const& EndPoint(size_t value) const { return (value & 1) ? ends[value/2]->second : ends[value/2]->first; }
+
+			void Remove(size_t id) {
+				if (!ends[id])
+					return;
+				rtree.remove(value_t{ToRPoint(ends[id]->first), id*2});
+				rtree.remove(value_t{ToRPoint(ends[id]->second), id*2+1});
+				// removing degrades the tree. re-pack.
+				if (rtree.size() * 2 < nPacked)
+					Pack(std::vector<value_t>(rtree.begin(), rtree.end()));
+			}
+
+			/// @brief calls func(value) for end points in order of distance from pt, until func returns false.
+			/// (nearest query w/ small k, retried w/ larger k. func is called again for the same values on retry.)
+			template < typename tFunc >
+			void ForEachNearest(point_t const& pt, tFunc&& func) const {
+				auto const rpt = ToRPoint(pt);
+				std::vector<value_t> values;
+				for (size_t k{4}; ; k *= 4) {
+					values.clear();
+					rtree.query(bgi::nearest(rpt, (unsigned)k), std::back_inserter(values));
+					std::ranges::sort(values, {}, [&rpt](value_t const& v) { return bg::comparable_distance(v.first, rpt); });
+					for (auto const& v : values) {
+						if (!func(v.second))
+							return;
+					}
+					if (values.size() < k)
+						return;
+				}
+			}
+
+			/// @brief true if any end point of other shapes is within dThreshold from pt.
+			bool HasNeighbor(point_t const& pt, size_t idExclude, double dThreshold) const {
+				bg::model::box<rpoint_t> box{ToRPoint(pt - point_t::All(dThreshold)), ToRPoint(pt + point_t::All(dThreshold))};
+				for (auto iter = rtree.qbegin(bgi::intersects(box)); iter != rtree.qend(); iter++) {
+					if (iter->second/2 == idExclude)
+						continue;
+					if (pt.Distance(EndPoint(iter->second)) <= dThreshold)
+						return true;
+				}
+				return false;
+			}
+		};
+
+		std::vector<xShape*> GetShapePointers(boost::ptr_deque<xShape>& shapes) {
+			std::vector<xShape*> pointers;
+			pointers.reserve(shapes.size());
+			for (auto& shape : shapes)
+				pointers.push_back(&shape);
+			return pointers;
+		}
+
+		/// @brief reorder shapes to order (order[i] : index of the shape to be placed at i)
+		void PermuteShapes(boost::ptr_deque<xShape>& shapes, std::vector<size_t> const& order) {
+			auto& base = shapes.base();
+			std::vector<std::remove_cvref_t<decltype(base[0])>> old(base.begin(), base.end());
+			for (size_t i{}; i < order.size(); i++)
+				base[i] = old[order[i]];
+		}
+
+	}
+
 	void xLayer::Sort_Loop() {
 		if (m_shapes.size() <= 1) {
 			return;
 		}
 
-		// Search EndPoint if any -> Move it to front
 		auto const dThreshold = 1.e-3;
-		size_t n{m_shapes.size()-1};
-		for (size_t i{}; i < n; i++) {
-			auto const& r = m_shapes[i].GetStartEndPoint();
-			if (!r)
-				continue;
-			auto [pt0, pt1] = *r;
-			bool bFound0{}, bFound1{};
-			for (size_t j{}; j < m_shapes.size(); j++) {
-				if (i == j)
+		size_t const nShape = m_shapes.size();
+		size_t const n{nShape-1};
+
+		// Search EndPoint if any -> Move it to front
+		{
+			auto shapes = GetShapePointers(m_shapes);
+			xEndPointIndex index(shapes);
+			for (size_t i{}; i < n; i++) {
+				auto const& r = index.ends[i];
+				if (!r)
 					continue;
-				if (auto const& r = m_shapes[j].GetStartEndPoint(); r) {
-					if (!bFound0) {
-						auto d0 = pt0.Distance(r->first);
-						auto d1 = pt0.Distance(r->second);
-						if (d0 <= dThreshold or d1 <= dThreshold) {
-							bFound0 = true;
-						}
-					}
-					if (!bFound1) {
-						auto d0 = pt1.Distance(r->first);
-						auto d1 = pt1.Distance(r->second);
-						if (d0 <= dThreshold or d1 <= dThreshold) {
-							bFound1 = true;
-						}
-					}
-					if (bFound0 and bFound1)
-						break;
+				bool bFound0 = index.HasNeighbor(r->first, i, dThreshold);
+				bool bFound1 = index.HasNeighbor(r->second, i, dThreshold);
+				if (!bFound0 or !bFound1) {
+					if (i)
+						std::swap(m_shapes.base().at(0), m_shapes.base().at(i));
+					if (bFound0 and !bFound1)
+						m_shapes.front().Reverse();
+					break;
 				}
 			}
-			if (!bFound0 or !bFound1) {
-				if (i)
-					std::swap(m_shapes.base().at(0), m_shapes.base().at(i));
-				if (bFound0 and !bFound1)
-					m_shapes.front().Reverse();
-				break;
-			}
 		}
 
+		// chaining : nearest end point. (ties : lower position first)
+		auto shapes = GetShapePointers(m_shapes);
+		xEndPointIndex index(shapes);
+		std::vector<size_t> order(nShape), pos(nShape);	// order[position] : id, pos[id] : position
+		std::iota(order.begin(), order.end(), 0);
+		std::iota(pos.begin(), pos.end(), 0);
+		std::vector<bool> reversed(nShape);
+
 		for (size_t i{}; i < n; i++) {
-			auto const& r = m_shapes[i].GetStartEndPoint();
+			auto const id = order[i];
+			auto const& r = index.ends[id];
 			if (!r)
 				continue;
-			auto pt = r->second;
+			index.Remove(id);
+			if (index.rtree.empty())
+				break;
+			auto pt = reversed[id] ? r->first : r->second;
 
 			auto minDist = std::numeric_limits<double>::max();
-			size_t jMin = (size_t)(-1);
+			size_t idMin = (size_t)(-1);
 			bool bReverse{};
-			auto i1{i+1};
-			for (size_t j{i1}; j < m_shapes.size(); j++) {
-				if (auto const& r = m_shapes[j].GetStartEndPoint(); r) {
-					auto d1 = pt.Distance(r->first);
-					auto d2 = pt.Distance(r->second);
-					auto dist = std::min(d1, d2);
-					if (dist < minDist) {
-						bReverse = d1 > d2;
-						minDist = dist;
-						jMin = j;
+			index.ForEachNearest(pt, [&](size_t value) {
+				if (pt.Distance(index.EndPoint(value)) > minDist)
+					return false;
+				auto const idj = value/2;
+				auto d1 = pt.Distance(index.ends[idj]->first);
+				auto d2 = pt.Distance(index.ends[idj]->second);
+				auto dist = std::min(d1, d2);
+				if ( (dist < minDist) or ((dist == minDist) and (idMin < nShape) and (pos[idj] < pos[idMin])) ) {
+					bReverse = d1 > d2;
+					minDist = dist;
+					idMin = idj;
+				}
+				return true;
+			});
+			if (idMin < nShape) {
+				auto const i1{i+1};
+				auto const jMin = pos[idMin];
+				std::swap(order[i1], order[jMin]);
+				pos[order[i1]] = i1;
+				pos[order[jMin]] = jMin;
+				if (bReverse)
+					reversed[idMin] = true;
+			}
+		}
+
+		for (size_t id{}; id < nShape; id++) {
+			if (reversed[id])
+				shapes[id]->Reverse();
+		}
+		PermuteShapes(m_shapes, order);
+
+		InvalidateSpatialIndex();
+	}
+
+	double xLayer::Sort_Path(double dMinJumpLength, int nMaxPass) {
+		Sort_Loop();
+
+		// shapes w/o end points -> back
+		std::stable_partition(m_shapes.base().begin(), m_shapes.base().end(), [](auto const* p) { return xEndPointIndex::GetEnds(*(xShape const*)p).has_value(); });
+
+		auto shapes = GetShapePointers(m_shapes);
+		xEndPointIndex index(shapes);
+		size_t const nPath = std::ranges::count_if(index.ends, [](auto const& r) { return r.has_value(); });
+		if (nPath <= 2)
+			return GetJumpLength(dMinJumpLength);
+
+		std::vector<size_t> order(m_shapes.size()), pos(m_shapes.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::iota(pos.begin(), pos.end(), 0);
+		std::vector<uint8_t> reversed(m_shapes.size());
+
+		auto Start = [&](size_t p) -> point_t const& { auto id = order[p]; return reversed[id] ? index.ends[id]->second : index.ends[id]->first; };
+		auto End = [&](size_t p) -> point_t const& { auto id = order[p]; return reversed[id] ? index.ends[id]->first : index.ends[id]->second; };
+		auto Jump = [dMinJumpLength](point_t const& pt0, point_t const& pt1) {
+			auto d = pt0.Distance(pt1);
+			return d < dMinJumpLength ? 0.0 : d;
+		};
+		// gain of reversing [a, b]
+		auto Gain = [&](size_t a, size_t b) {
+			double gain{};
+			if (a > 0)
+				gain += Jump(End(a-1), Start(a)) - Jump(End(a-1), End(b));
+			if (b+1 < nPath)
+				gain += Jump(End(b), Start(b+1)) - Jump(Start(a), Start(b+1));
+			return gain;
+		};
+		auto Reverse = [&](size_t a, size_t b) {
+			std::reverse(order.begin()+a, order.begin()+b+1);
+			for (size_t p{a}; p <= b; p++) {
+				pos[order[p]] = p;
+				reversed[order[p]] ^= 1;
+			}
+		};
+
+		// 2-opt, candidates from nearest end points
+		constexpr unsigned nNeighbor = 8;
+		constexpr double eps = 1.e-9;
+		// neighbor list of each end point (value). end points don't move, only the directions (reversed) change.
+		std::vector<size_t> neighbors(nPath * 2 * nNeighbor, (size_t)-1);
+		{
+			std::vector<xEndPointIndex::value_t> values;
+			for (size_t value{}; value < nPath*2; value++) {
+				values.clear();
+				index.rtree.query(bgi::nearest(xEndPointIndex::ToRPoint(index.EndPoint(value)), nNeighbor), std::back_inserter(values));
+				std::ranges::transform(values, neighbors.begin() + value * nNeighbor, [](auto const& v) { return v.second; });
+			}
+		}
+		auto Neighbors = [&](size_t id, bool bEnd) {
+			size_t value = id*2 + (bEnd != (bool)reversed[id] ? 1 : 0);
+			return std::span{neighbors.data() + value * nNeighbor, nNeighbor};
+		};
+		for (int iPass{}; iPass < nMaxPass; iPass++) {
+			bool bImproved{};
+			for (size_t p{}; p < nPath; p++) {
+				// new jump : End(a-1) -> End(b), (a = p+1)
+				for (auto value : Neighbors(order[p], true)) {
+					if (value == (size_t)-1)
+						break;
+					auto const id = value/2;
+					bool bEnd = (value & 1) != reversed[id];
+					auto b = pos[id];
+					if (!bEnd or b <= p)
+						continue;
+					if (Gain(p+1, b) > eps) {
+						Reverse(p+1, b);
+						bImproved = true;
+						break;
+					}
+				}
+				// new jump : Start(a) -> Start(b+1), (b = p-1)
+				if (p == 0)
+					continue;
+				for (auto value : Neighbors(order[p], false)) {
+					if (value == (size_t)-1)
+						break;
+					auto const id = value/2;
+					bool bStart = (value & 1) == reversed[id];
+					auto a = pos[id];
+					if (!bStart or a >= p)
+						continue;
+					if (Gain(a, p-1) > eps) {
+						Reverse(a, p-1);
+						bImproved = true;
+						break;
 					}
 				}
 			}
-			if (jMin < m_shapes.size()) {
-				std::swap(m_shapes.base().at(i1), m_shapes.base().at(jMin));
-				if (bReverse)
-					m_shapes[i1].Reverse();
+			if (!bImproved)
+				break;
+		}
+
+		for (size_t id{}; id < shapes.size(); id++) {
+			if (reversed[id])
+				shapes[id]->Reverse();
+		}
+		PermuteShapes(m_shapes, order);
+
+		InvalidateSpatialIndex();
+
+		return GetJumpLength(dMinJumpLength);
+	}
+
+	double xLayer::GetJumpLength(double dMinJumpLength) const {
+		double dLength{};
+		std::optional<point_t> ptLast;
+		for (auto const& shape : m_shapes) {
+			auto r = shape.GetStartEndPoint();
+			if (!r)
+				continue;
+			if (ptLast) {
+				if (auto d = ptLast->Distance(r->first); d >= dMinJumpLength)
+					dLength += d;
 			}
+			ptLast = r->second;
 		}
+		return dLength;
 	}
 
 	bool xLayer::IsLoop(double dMinGap) const {
@@ -460,27 +783,28 @@ namespace gtl::shape {
 
 	void xPolyline::Draw(ICanvas& canvas) const {
 		xShape::Draw(canvas);
-		if (m_pts.empty())
+		DrawPolyPoints(canvas, m_pts, m_bLoop);
+	}
+
+	void xPolyline::DrawPolyPoints(ICanvas& canvas, std::span<polypoint_t const> pts, bool bLoop) {
+		if (pts.empty())
 			return;
 
-		canvas.MoveTo(m_pts[0]);
+		canvas.MoveTo(pts[0]);
 
-		auto nPt = m_pts.size();
-		if (!m_bLoop)
+		auto nPt = pts.size();
+		if (!bLoop)
 			nPt--;
 		for (int iPt = 0; iPt < nPt; iPt++) {
-			auto iPt2 = (iPt+1) % m_pts.size();
-			auto pt0 = m_pts[iPt];
-			auto pt1 = m_pts[iPt2];
+			auto iPt2 = (iPt+1) % pts.size();
+			auto pt0 = pts[iPt];
+			auto pt1 = pts[iPt2];
 			if (pt0.Bulge() == 0.0) {
 				canvas.LineTo(pt1);
 			} else {
 				canvas.LineTo(pt0);
 				xArc arc = xArc::GetFromBulge(pt0.Bulge(), pt0, pt1);
-				(xShape&)arc = *(xShape*)this;
-
-				arc.Draw(canvas);
-
+				canvas.Arc(arc.m_ptCenter, arc.m_radius, arc.m_angle_start, arc.m_angle_length);
 				canvas.LineTo(pt1);
 			}
 		}
@@ -511,11 +835,385 @@ namespace gtl::shape {
 		return shapes;
 	}
 
-	bool xDrawing::LoadFromCADJson(json_t& _j) {
+	//-------------------------------------------------------------------------
+	// xBlockRef
+	namespace {
+
+		/// @brief local CT of canvas becomes (local CT) * ct while alive. (block -> drawing -> canvas)
+		/// canvas chain (m_ct) is not touched. no allocation, no matrix inverse. (nested block : one 3x3 product)
+		class xCanvasLocalCTGuard {
+			ICanvas& m_canvas;
+			std::optional<xCoordTrans3d> m_ctLocal, m_ctLocalI;
+		public:
+			xCanvasLocalCTGuard(ICanvas& canvas, xCoordTrans3d const& ct, std::optional<xCoordTrans3d> const& ctI)
+				: m_canvas(canvas), m_ctLocal(canvas.m_ctLocal), m_ctLocalI(canvas.m_ctLocalI)
+			{
+				if (m_ctLocal) {
+					canvas.m_ctLocal = *m_ctLocal * ct;
+					if (ctI and m_ctLocalI)
+						canvas.m_ctLocalI = *ctI * *m_ctLocalI;
+					else
+						canvas.m_ctLocalI.reset();
+				}
+				else {
+					canvas.m_ctLocal = ct;
+					canvas.m_ctLocalI = ctI;
+				}
+			}
+			~xCanvasLocalCTGuard() {
+				m_canvas.m_ctLocal = m_ctLocal;
+				m_canvas.m_ctLocalI = m_ctLocalI;
+			}
+		};
+
+		/// @brief bounding box of transformed rect (8 corners)
+		bool UpdateBoundaryTransformed(rect_t& rectBoundary, rect_t const& rect, xCoordTrans3d const& ct) {
+			bool bModified{};
+			for (int i{}; i < 8; i++) {
+				point_t pt{ (i & 1) ? rect.right : rect.left, (i & 2) ? rect.bottom : rect.top, (i & 4) ? rect.back : rect.front };
+				bModified |= rectBoundary.UpdateBoundary(ct(pt));
+			}
+			return bModified;
+		}
+
+	}
+
+	bool xBlockRef::UpdateBoundary(rect_t& rectBoundary) const {
+		if (!m_block)
+			return false;
+		if (!m_rectLocal)
+			m_rectLocal = m_block->GetBoundary();
+		auto const& rect = *m_rectLocal;
+		if (!rect.IsNormalized())	// empty block
+			return false;
+		return UpdateBoundaryTransformed(rectBoundary, rect, m_ct);
+	}
+
+	void xBlockRef::Draw(ICanvas& canvas) const {
+		if (!m_block)
+			return;
+		xShape::Draw(canvas);
+		xCanvasLocalCTGuard guard(canvas, m_ct, m_ctI);
+		for (auto const& shape : m_block->m_shapes)
+			shape.Draw(canvas);
+	}
+
+	bool xBlockRef::DrawROI(ICanvas& canvas, rect_t const& rectROI) const {
+		if (!m_block)
+			return false;
+		rect_t rectBoundary;
+		rectBoundary.SetRectEmptyForMinMax2d();
+		if (!UpdateBoundary(rectBoundary) or !rectBoundary.IntersectRect(rectROI).IsNormalized())
+			return false;
+
+		// ROI in block coordinate
+		if (!m_ctI) {
+			Draw(canvas);
+			return true;
+		}
+		rect_t roi(rectROI);
+		roi.NormalizeRect();
+		rect_t rectLocal;
+		rectLocal.SetRectEmptyForMinMax();
+		UpdateBoundaryTransformed(rectLocal, roi, *m_ctI);
+
+		xShape::Draw(canvas);
+		xCanvasLocalCTGuard guard(canvas, m_ct, m_ctI);
+		return m_block->DrawROI(canvas, rectLocal);
+	}
+
+	boost::ptr_deque<xShape> xBlockRef::Explode() const {
+		boost::ptr_deque<xShape> shapes;
+		if (!m_block)
+			return shapes;
+		bool const bRightHanded = m_ct.IsRightHanded();
+		for (auto const& shape : m_block->m_shapes) {
+			if (auto const* pRef = dynamic_cast<xBlockRef const*>(&shape); pRef) {
+				xBlockRef ref(*pRef);
+				ref.Transform(m_ct, bRightHanded);
+				auto sub = ref.Explode();
+				shapes.transfer(shapes.end(), sub);
+			} else {
+				auto rShape = shape.NewClone();
+				rShape->Transform(m_ct, bRightHanded);
+				shapes.push_back(std::move(rShape));
+			}
+		}
+		return shapes;
+	}
+
+	//-------------------------------------------------------------------------
+	// xDrawing
+	namespace {
+
+		/// @brief creates shape from an entity of CAD json. nullptr if not supported (or broken).
+		std::unique_ptr<xShape> CreateShapeFromCADJsonEntity(json_t& jEntity) {
+			std::unique_ptr<xShape> rShape;
+			try {
+				bjson<json_t> j(jEntity);
+				std::string strEntityName = j["entityName"];
+
+				rShape = xShape::CreateShapeFromEntityName(strEntityName);
+				if (!rShape)
+					return {};
+
+				rShape->LoadFromCADJson(jEntity);
+			} catch ([[maybe_unused]] std::exception& e) {
+				DEBUG_PRINT("{}\n", e.what());
+				return {};
+			} catch (...) {
+				DEBUG_PRINT("unknown\n");
+				return {};
+			}
+			return rShape;
+		}
+
+		/// @brief finds boundaries of json values in text, without building DOM.
+		class xJsonTextScanner {
+			std::string_view m_str;
+			size_t m_pos{};
+		public:
+			xJsonTextScanner(std::string_view str) : m_str(str) {}
+
+			void SkipWhiteSpace() {
+				while (m_pos < m_str.size() and (m_str[m_pos] == ' ' or m_str[m_pos] == '\t' or m_str[m_pos] == '\r' or m_str[m_pos] == '\n'))
+					m_pos++;
+			}
+			bool Consume(char c) {
+				SkipWhiteSpace();
+				if (m_pos >= m_str.size() or m_str[m_pos] != c)
+					return false;
+				m_pos++;
+				return true;
+			}
+			/// @brief raw text of string (w/o quotes, escape sequences not decoded)
+			std::optional<std::string_view> String() {
+				SkipWhiteSpace();
+				if (m_pos >= m_str.size() or m_str[m_pos] != '"')
+					return {};
+				auto const pos0 = ++m_pos;
+				if (!SkipStringBody())
+					return {};
+				return m_str.substr(pos0, m_pos-1-pos0);
+			}
+			/// @brief raw text of next value (object, array, string, number, ...)
+			std::optional<std::string_view> Value() {
+				SkipWhiteSpace();
+				if (m_pos >= m_str.size())
+					return {};
+				auto const pos0 = m_pos;
+				switch (m_str[m_pos]) {
+				case '"' :
+					m_pos++;
+					if (!SkipStringBody())
+						return {};
+					break;
+				case '{' :
+				case '[' :
+					{
+						int depth{};
+						while (m_pos < m_str.size()) {
+							auto c = m_str[m_pos++];
+							if (c == '"') {
+								if (!SkipStringBody())
+									return {};
+							}
+							else if (c == '{' or c == '[')
+								depth++;
+							else if ( (c == '}' or c == ']') and (--depth == 0) )
+								break;
+						}
+						if (depth)
+							return {};
+					}
+					break;
+				default :
+					while (m_pos < m_str.size() and ",}] \t\r\n"sv.find(m_str[m_pos]) == std::string_view::npos)
+						m_pos++;
+					break;
+				}
+				return m_str.substr(pos0, m_pos-pos0);
+			}
+
+		protected:
+			bool SkipStringBody() {
+				while (m_pos < m_str.size()) {
+					auto c = m_str[m_pos++];
+					if (c == '\\')
+						m_pos++;
+					else if (c == '"')
+						return m_pos <= m_str.size();
+				}
+				return false;
+			}
+		};
+
+	}
+
+	struct xDrawing::sLoadContext {
+		bool bInstanceBlocks{};
+		std::map<string_t, xLayer*> mapLayers;
+		boost::ptr_deque<xBlock> blocks;
+		std::map<string_t, xBlock*> mapBlocks;
+		std::map<string_t, std::shared_ptr<xBlock>> mapSharedBlocks;
+	};
+
+	bool xDrawing::LoadFromCADJson(json_t& _j, bool bInstanceBlocks) {
 		//xShape::LoadFromCADJson(_j);
 
 		gtl::bjson<json_t> jTOP(_j);
 
+		sLoadContext context{ .bInstanceBlocks = bInstanceBlocks };
+		LoadCADJsonTables(_j, context);
+
+		// Entities
+		{
+			auto jEntities = jTOP["mainBlock"].json().as_array();
+			m_rectBoundary.SetRectEmptyForMinMax2d();
+			for (auto& jEntity : jEntities) {
+				if (auto rShape = CreateShapeFromCADJsonEntity(jEntity))
+					AddEntity(std::move(rShape), context);
+			}
+		}
+
+		return true;
+	}
+
+	bool xDrawing::LoadFromCADJsonFile(std::filesystem::path const& path, bool bInstanceBlocks, int nThread) {
+		auto str = gtl::FileToContainer<std::string>(path);
+		if (!str)
+			return false;
+		std::string_view sv(*str);
+		if (sv.starts_with("\xEF\xBB\xBF"sv))
+			sv.remove_prefix(3);
+
+		// top level. tables are parsed into DOM, entities are kept as text.
+		boost::json::object jTables;
+		std::string_view svEntities;
+		{
+			xJsonTextScanner scanner(sv);
+			if (!scanner.Consume('{'))
+				return false;
+			if (!scanner.Consume('}')) {
+				do {
+					auto key = scanner.String();
+					if (!key or !scanner.Consume(':'))
+						return false;
+					auto value = scanner.Value();
+					if (!value)
+						return false;
+					if (*key == "mainBlock"sv) {
+						svEntities = *value;
+					} else if (*key == "header"sv or *key == "lineTypes"sv or *key == "layers"sv or *key == "blocks"sv) {
+						boost::system::error_code ec;
+						auto jv = boost::json::parse(*value, ec);
+						if (ec)
+							return false;
+						jTables[*key] = std::move(jv);
+					}
+				} while (scanner.Consume(','));
+				if (!scanner.Consume('}'))
+					return false;
+			}
+		}
+
+		sLoadContext context{ .bInstanceBlocks = bInstanceBlocks };
+		json_t jvTables(std::move(jTables));
+		LoadCADJsonTables(jvTables, context);
+
+		// entities (text)
+		std::vector<std::string_view> entities;
+		{
+			xJsonTextScanner scanner(svEntities);
+			if (!scanner.Consume('['))
+				return false;
+			if (!scanner.Consume(']')) {
+				do {
+					auto value = scanner.Value();
+					if (!value)
+						return false;
+					entities.push_back(*value);
+				} while (scanner.Consume(','));
+				if (!scanner.Consume(']'))
+					return false;
+			}
+		}
+
+		// parse entities and create shapes in parallel, add them in order.
+		constexpr size_t nEntityPerBatch = 256;
+		size_t const nBatch = (entities.size() + nEntityPerBatch - 1) / nEntityPerBatch;
+		std::vector<std::vector<std::unique_ptr<xShape>>> results(nBatch);
+		std::vector<std::atomic<bool>> done(nBatch);
+		std::atomic<size_t> iNextBatch{};
+		std::atomic<bool> bAbort{};
+		std::exception_ptr eptr;	// first exception from workers. rethrown on this thread
+		std::mutex mtxError;
+		auto Worker = [&]() {
+			for (size_t iBatch{}; (iBatch = iNextBatch++) < nBatch; ) {
+				auto& shapes = results[iBatch];
+				try {
+					if (!bAbort) {
+						boost::json::monotonic_resource mr;
+						size_t const i0 = iBatch * nEntityPerBatch;
+						size_t const i1 = std::min(i0 + nEntityPerBatch, entities.size());
+						shapes.reserve(i1-i0);
+						for (size_t i = i0; i < i1; i++) {
+							boost::system::error_code ec;
+							auto jEntity = boost::json::parse(entities[i], ec, &mr);
+							if (ec) {
+								DEBUG_PRINT("{}\n", ec.message());
+								continue;
+							}
+							shapes.push_back(CreateShapeFromCADJsonEntity(jEntity));
+						}
+					}
+				}
+				catch (...) {	// ex, bad_alloc. an exception must not leave the worker thread (std::terminate)
+					std::unique_lock lock(mtxError);
+					if (!eptr)
+						eptr = std::current_exception();
+					bAbort = true;
+				}
+				done[iBatch] = true;
+				done[iBatch].notify_one();
+			}
+		};
+
+		if (nThread <= 0)
+			nThread = std::max(1, (int)std::thread::hardware_concurrency());
+		nThread = (int)std::min<size_t>(nThread, nBatch);
+
+		m_rectBoundary.SetRectEmptyForMinMax2d();
+		{
+			std::vector<std::jthread> threads;
+			if (nThread > 1) {
+				for (int i{}; i < nThread; i++)
+					threads.emplace_back(Worker);
+			} else {
+				Worker();
+			}
+
+			for (size_t iBatch{}; iBatch < nBatch; iBatch++) {
+				done[iBatch].wait(false);
+				if (bAbort)
+					continue;
+				for (auto& rShape : results[iBatch]) {
+					if (rShape)
+						AddEntity(std::move(rShape), context);
+				}
+				results[iBatch].clear();
+				results[iBatch].shrink_to_fit();
+			}
+		}
+		if (eptr)
+			std::rethrow_exception(eptr);
+
+		return true;
+	}
+
+	bool xDrawing::LoadCADJsonTables(json_t& _j, sLoadContext& context) {
+		gtl::bjson<json_t> jTOP(_j);
+
 		// header
 		{
 			auto jHeader = jTOP["header"];
@@ -555,7 +1253,7 @@ namespace gtl::shape {
 		}
 
 		// layers
-		std::map<string_t, xLayer*> mapLayers;	// cache
+		auto& mapLayers = context.mapLayers;	// cache
 		{
 			m_layers.clear();
 			//layers.push_back(std::make_unique<xLayer>(L"0"));
@@ -579,8 +1277,8 @@ namespace gtl::shape {
 		}
 
 		// block
-		boost::ptr_deque<xBlock> blocks;
-		std::map<string_t, xBlock*> mapBlocks;
+		auto& blocks = context.blocks;
+		auto& mapBlocks = context.mapBlocks;
 		{
 			blocks.clear();
 			auto jBlocks = jTOP["blocks"].json().as_array();
@@ -607,23 +1305,10 @@ namespace gtl::shape {
 
 				// block entities
 				for (auto& jEntity : j["entities"].json().as_array()) {
-					bjson<json_t> j(jEntity);
-					std::string strEntityName = j["entityName"];
-
-					std::unique_ptr<xShape> rShape = CreateShapeFromEntityName(strEntityName);
+					auto rShape = CreateShapeFromCADJsonEntity(jEntity);
 					if (!rShape)
 						continue;
 
-					try {
-						rShape->LoadFromCADJson(jEntity);
-					} catch ([[maybe_unused]] std::exception& e) {
-						DEBUG_PRINT("{}\n", e.what());
-						continue;
-					} catch (...) {
-						DEBUG_PRINT("unknown\n");
-						continue;
-					}
-
 					switch (rShape->GetShapeType()) {
 					case eSHAPE::insert :
 						break;
@@ -635,40 +1320,30 @@ namespace gtl::shape {
 				mapBlocks[rBlock->m_name] = rBlock.get();
 				blocks.push_back(std::move(rBlock));
 			}
+			RemoveCyclicInserts(mapBlocks);
 		}
 
-
-		// Entities
-		{
-			auto jEntities = jTOP["mainBlock"].json().as_array();
-			m_rectBoundary.SetRectEmptyForMinMax2d();
-			// block entities
-			for (auto& jEntity : jEntities) {
-				bjson<json_t> j(jEntity);
-				std::string strEntityName = j["entityName"];
-
-				std::unique_ptr<xShape> rShape = CreateShapeFromEntityName(strEntityName);
-				if (!rShape)
-					continue;
-
-				try {
-					rShape->LoadFromCADJson(jEntity);
-					//rShape->UpdateBoundary(rectBoundary);
-				} catch ([[maybe_unused]] std::exception& e) {
-					DEBUG_PRINT("{}\n", e.what());
-					continue;
-				} catch (...) {
-					DEBUG_PRINT("unknown\n");
-					continue;
-				}
-
-				AddEntity(std::move(rShape), mapLayers, mapBlocks, m_rectBoundary);
+		// blocks to be shared by instances (xBlockRef)
+		if (context.bInstanceBlocks) {
+			auto& mapSharedBlocks = context.mapSharedBlocks;
+			while (!blocks.empty()) {
+				std::shared_ptr<xBlock> block(blocks.pop_front().release());
+				mapSharedBlocks[block->m_name] = block;
 			}
+			mapBlocks.clear();
+			for (auto& [name, block] : mapSharedBlocks)
+				PrepareInstanceBlock(*block, mapLayers, mapSharedBlocks);
 		}
 
 		return true;
 	}
 
+	bool xDrawing::AddEntity(std::unique_ptr<xShape> rShape, sLoadContext& context) {
+		if (context.bInstanceBlocks)
+			return AddEntity(std::move(rShape), context.mapLayers, context.mapSharedBlocks, m_rectBoundary);
+		return AddEntity(std::move(rShape), context.mapLayers, context.mapBlocks, m_rectBoundary);
+	}
+
 	bool xDrawing::AddEntity(std::unique_ptr<xShape> rShape, std::map<string_t, xLayer*> const& mapLayers, std::map<string_t, xBlock*> const& mapBlocks, rect_t& rectB) {
 		if (!rShape)
 			return false;
@@ -688,30 +1363,6 @@ namespace gtl::shape {
 					return false;
 				}
 
-				xCoordTrans3d ct;
-				// todo : 순서 확인 (scale->rotate ? or rotate->scale ?)
-				if (pInsert->m_xscale != 1.0) {
-					ct.m_mat(0, 0) *= pInsert->m_xscale;
-					ct.m_mat(0, 1) *= pInsert->m_xscale;
-					ct.m_mat(0, 2) *= pInsert->m_xscale;
-				}
-				if (pInsert->m_yscale != 1.0) {
-					ct.m_mat(1, 0) *= pInsert->m_yscale;
-					ct.m_mat(1, 1) *= pInsert->m_yscale;
-					ct.m_mat(1, 2) *= pInsert->m_yscale;
-				}
-				if (pInsert->m_zscale != 1.0) {
-					ct.m_mat(2, 0) *= pInsert->m_zscale;
-					ct.m_mat(2, 1) *= pInsert->m_zscale;
-					ct.m_mat(2, 2) *= pInsert->m_zscale;
-				}
-
-				if (pInsert->m_angle != 0.0_rad) {
-					ct.m_mat = ct.GetRotatingMatrixXY(pInsert->m_angle) * ct.m_mat;
-				}
-
-				ct.m_origin = pBlock->m_pt;
-
 				for (int y = 0; y < pInsert->m_nRow; y++) {
 					for (int x = 0; x < pInsert->m_nCol; x++) {
 
@@ -719,8 +1370,7 @@ namespace gtl::shape {
 						if (!rBlockNew)
 							continue;
 
-						ct.m_offset.x = x*pInsert->m_spacingCol + pInsert->m_pt.x;
-						ct.m_offset.y = y*pInsert->m_spacingRow + pInsert->m_pt.y;
+						auto const ct = pInsert->GetBlockCT(pBlock->m_pt, x, y);
 						bool const bIsRightHanded = ct.IsRightHanded();
 
 						for (auto const& rShape : rBlockNew->m_shapes) {
@@ -752,23 +1402,7 @@ namespace gtl::shape {
 					return false;
 				}
 
-				// color
-				if (rShape->m_color.cr == -1) {
-					int m_crIndex = rShape->m_crIndex;
-					if (m_crIndex == 256) {
-						m_crIndex = pLayer->m_crIndex;
-						rShape->m_color = pLayer->m_color;
-					}
-					if (rShape->m_color.cr == -1) {
-						if ( (m_crIndex > 0) and (m_crIndex < colorTable_s.size()) )
-							rShape->m_color = colorTable_s[m_crIndex];
-					}
-				}
-
-				// line Width
-				if (rShape->m_lineWeight == (int)eLINE_WIDTH::ByLayer) {
-					rShape->m_lineWeight = pLayer->m_lineWeight;
-				}
+				ResolveLayerAttributes(*rShape, *pLayer);
 
 				rShape->UpdateBoundary(rectB);
 				pLayer->m_shapes.push_back(std::move(rShape));
@@ -785,4 +1419,157 @@ namespace gtl::shape {
 	}
 
 
+	bool xDrawing::AddEntity(std::unique_ptr<xShape> rShape, std::map<string_t, xLayer*> const& mapLayers, std::map<string_t, std::shared_ptr<xBlock>> const& mapBlocks, rect_t& rectB) {
+		if (!rShape)
+			return false;
+
+		if (rShape->GetShapeType() != eSHAPE::insert)
+			return AddEntity(std::move(rShape), mapLayers, std::map<string_t, xBlock*>{}, rectB);
+
+		auto const* pInsert = dynamic_cast<xInsert const*>(rShape.get());
+		if (!pInsert)
+			return false;
+		auto iter = mapBlocks.find(pInsert->m_name);
+		if (iter == mapBlocks.end() or !iter->second) {
+			DEBUG_PRINT(L"No Block : {}\n", pInsert->m_name);
+			return false;
+		}
+		auto const& block = iter->second;
+
+		for (int y = 0; y < pInsert->m_nRow; y++) {
+			for (int x = 0; x < pInsert->m_nCol; x++) {
+				auto rRef = std::make_unique<xBlockRef>(block, pInsert->GetBlockCT(block->m_pt, x, y));
+				(xShape&)*rRef = (xShape const&)*pInsert;
+				if (!AddEntity(std::move(rRef), mapLayers, std::map<string_t, xBlock*>{}, rectB)) {
+					DEBUG_PRINT("CANNOT Add Shape\n");
+				}
+			}
+		}
+
+		return true;
+	}
+
+	size_t xDrawing::ExplodeBlockRefs() {
+		std::map<string_t, xLayer*> mapLayers;
+		for (auto& layer : m_layers)
+			mapLayers[layer.m_name] = &layer;
+
+		size_t nExploded{};
+		for (auto& layer : m_layers) {
+			boost::ptr_deque<xShape> shapes;
+			while (!layer.m_shapes.empty()) {
+				auto rShape = layer.m_shapes.pop_front();
+				if (rShape->GetShapeType() != eSHAPE::block_ref) {
+					shapes.push_back(rShape.release());
+					continue;
+				}
+				nExploded++;
+				// flattened shapes go to their own layers (as loaded w/o instancing)
+				auto exploded = ((xBlockRef const&)*rShape).Explode();
+				while (!exploded.empty()) {
+					auto r = exploded.pop_front();
+					auto iter = mapLayers.find(r->m_strLayer);
+					if (iter == mapLayers.end() or iter->second == &layer)
+						shapes.push_back(r.release());
+					else
+						iter->second->m_shapes.push_back(r.release());
+				}
+			}
+			layer.m_shapes.swap(shapes);
+			layer.InvalidateSpatialIndex();
+		}
+		return nExploded;
+	}
+
+	void xDrawing::ResolveLayerAttributes(xShape& shape, xLayer const& layer) {
+		// color
+		if (shape.m_color.cr == -1) {
+			int m_crIndex = shape.m_crIndex;
+			if (m_crIndex == 256) {
+				m_crIndex = layer.m_crIndex;
+				shape.m_color = layer.m_color;
+			}
+			if (shape.m_color.cr == -1) {
+				if ( (m_crIndex > 0) and (m_crIndex < colorTable_s.size()) )
+					shape.m_color = colorTable_s[m_crIndex];
+			}
+		}
+
+		// line Width
+		if (shape.m_lineWeight == (int)eLINE_WIDTH::ByLayer) {
+			shape.m_lineWeight = layer.m_lineWeight;
+		}
+	}
+
+	void xDrawing::RemoveCyclicInserts(std::map<string_t, xBlock*> const& mapBlocks) {
+		// DFS over insert names
+		enum class eVISIT { none, in_progress, done };
+		std::map<xBlock const*, eVISIT> visits;
+		std::function<void(xBlock&)> Visit = [&](xBlock& block) {
+			visits[&block] = eVISIT::in_progress;
+			for (auto iter = block.m_shapes.begin(); iter != block.m_shapes.end(); ) {
+				if (auto const* pInsert = dynamic_cast<xInsert const*>(&*iter); pInsert) {
+					if (auto iterBlock = mapBlocks.find(pInsert->m_name); iterBlock != mapBlocks.end() and iterBlock->second) {
+						auto const eVisit = visits[iterBlock->second];
+						if (eVisit == eVISIT::in_progress) {
+							DEBUG_PRINT(L"Cyclic Block : {} -> {}\n", block.m_name, pInsert->m_name);
+							iter = block.m_shapes.erase(iter);
+							continue;
+						}
+						if (eVisit == eVISIT::none)
+							Visit(*iterBlock->second);
+					}
+				}
+				iter++;
+			}
+			visits[&block] = eVISIT::done;
+		};
+		for (auto const& [name, pBlock] : mapBlocks) {
+			if (pBlock and (visits[pBlock] == eVISIT::none))
+				Visit(*pBlock);
+		}
+	}
+
+	void xDrawing::PrepareInstanceBlock(xBlock& block, std::map<string_t, xLayer*> const& mapLayers, std::map<string_t, std::shared_ptr<xBlock>> const& mapBlocks) {
+		boost::ptr_deque<xShape> shapes;
+		while (!block.m_shapes.empty()) {
+			auto rShape = block.m_shapes.pop_front();
+
+			// nested insert -> block reference(s)
+			if (auto const* pInsert = dynamic_cast<xInsert const*>(rShape.get()); pInsert) {
+				auto iter = mapBlocks.find(pInsert->m_name);
+				if (iter == mapBlocks.end() or !iter->second) {
+					DEBUG_PRINT(L"No Block : {}\n", pInsert->m_name);
+					continue;
+				}
+				for (int y = 0; y < pInsert->m_nRow; y++) {
+					for (int x = 0; x < pInsert->m_nCol; x++) {
+						auto rRef = std::make_unique<xBlockRef>(iter->second, pInsert->GetBlockCT(iter->second->m_pt, x, y));
+						(xShape&)*rRef = (xShape const&)*pInsert;
+						shapes.push_back(std::move(rRef));
+					}
+				}
+				continue;
+			}
+			shapes.push_back(rShape.release());
+		}
+
+		// same as flattened inserts (AddEntity())
+		for (auto& shape : shapes) {
+			// color
+			if (shape.m_crIndex == 0) {
+				shape.m_crIndex = block.m_crIndex;
+			}
+			// line Width
+			if (shape.m_lineWeight == (int)eLINE_WIDTH::ByBlock) {
+				shape.m_lineWeight = block.m_lineWeight;
+			}
+			if (auto iter = mapLayers.find(shape.m_strLayer); iter != mapLayers.end() and iter->second)
+				ResolveLayerAttributes(shape, *iter->second);
+		}
+
+		block.m_shapes.swap(shapes);
+		block.InvalidateSpatialIndex();
+	}
+
 };
@@ -0,0 +1,641 @@
+﻿#include "pch.h"
+#include <sstream>
+#include "gtl/shape/shape.h"
+
+#include "boost/geometry.hpp"
+#include "boost/geometry/index/rtree.hpp"
+
+namespace gtl::shape {
+
+	using namespace binary;
+	using char_t = string_t::value_type;
+
+	namespace {
+
+		/// @brief shape of exactly type T (not derived)
+		template < typename T >
+		T const* ExactCast(xShape const& shape) {
+			return typeid(shape) == typeid(T) ? static_cast<T const*>(&shape) : nullptr;
+		}
+
+		template < typename T >
+		std::span<char const> AsBytes(std::vector<T> const& v) {
+			return { (char const*)v.data(), v.size() * sizeof(T) };
+		}
+
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool xDrawingBinaryView::Save(xDrawing const& drawing, std::filesystem::path const& path) {
+		std::vector<char_t> strings;
+		std::vector<sRange> string_ranges;
+		std::map<string_t, uint32_t> mapStrings;
+		auto AddString = [&](string_t const& str) -> uint32_t {
+			auto [iter, bNew] = mapStrings.try_emplace(str, (uint32_t)string_ranges.size());
+			if (bNew) {
+				string_ranges.push_back({ strings.size(), str.size() });
+				strings.insert(strings.end(), str.begin(), str.end());
+			}
+			return iter->second;
+		};
+		AddString({});	// 0 : empty string
+
+		auto Attributes = [&](xShape const& shape) -> sShape {
+			sShape s;
+			s.eType = shape.GetShapeType();
+			s.flags = (shape.m_bVisible ? fSHAPE::visible : 0) | (shape.m_bTransparent ? fSHAPE::transparent : 0);
+			s.crIndex = shape.m_crIndex;
+			s.color = shape.m_color.cr;
+			s.eLineType = shape.m_eLineType;
+			s.lineWeight = shape.m_lineWeight;
+			s.iLayer = AddString(shape.m_strLayer);
+			s.iLineType = AddString(shape.m_strLineType);
+			return s;
+		};
+
+		std::vector<sLayer> layers;
+		std::vector<sShape> shapes;
+		std::vector<point_t> dots, line_pt0, line_pt1;
+		std::vector<sArc> arcs;
+		std::vector<sRange> poly_ranges;
+		std::vector<polypoint_t> poly_points;
+		boost::ptr_deque<xShape> extras;
+
+		for (auto const& layer : drawing.m_layers) {
+			auto& l = layers.emplace_back();
+			l.attr = Attributes(layer);
+			l.iName = AddString(layer.m_name);
+			l.flags = layer.m_flags;
+			l.bUse = layer.m_bUse;
+			l.shapes.first = shapes.size();
+			for (auto const& shape : layer.m_shapes) {
+				auto& s = shapes.emplace_back(Attributes(shape));
+				if (!shape.m_cookie) {
+					if (auto const* p = ExactCast<xDot>(shape)) {
+						s.index = dots.size();
+						dots.push_back(p->m_pt);
+						continue;
+					}
+					if (auto const* p = ExactCast<xLine>(shape)) {
+						s.index = line_pt0.size();
+						line_pt0.push_back(p->m_pt0);
+						line_pt1.push_back(p->m_pt1);
+						continue;
+					}
+					if (auto const* p = ExactCast<xCircle>(shape)) {
+						s.index = arcs.size();
+						arcs.push_back({ .ptCenter = p->m_ptCenter, .radius = p->m_radius, .angle_length = (double)(deg_t)p->m_angle_length });
+						continue;
+					}
+					if (auto const* p = ExactCast<xArc>(shape)) {
+						s.index = arcs.size();
+						arcs.push_back({ .ptCenter = p->m_ptCenter, .radius = p->m_radius,
+							.angle_start = (double)(deg_t)p->m_angle_start, .angle_length = (double)(deg_t)p->m_angle_length });
+						continue;
+					}
+					if (auto const* p = ExactCast<xEllipse>(shape)) {
+						s.index = arcs.size();
+						arcs.push_back({ .ptCenter = p->m_ptCenter, .radius = p->m_radius, .radiusH = p->m_radiusH,
+							.angle_start = (double)(deg_t)p->m_angle_start, .angle_length = (double)(deg_t)p->m_angle_length,
+							.angle_first_axis = (double)(deg_t)p->m_angle_first_axis });
+						continue;
+					}
+					xPolyline const* pPolyline = ExactCast<xPolyline>(shape);
+					if (!pPolyline)
+						pPolyline = ExactCast<xPolylineLW>(shape);
+					if (pPolyline) {
+						s.index = poly_ranges.size();
+						if (pPolyline->m_bLoop)
+							s.flags |= fSHAPE::loop;
+						poly_ranges.push_back({ poly_points.size(), pPolyline->m_pts.size() });
+						poly_points.insert(poly_points.end(), pPolyline->m_pts.begin(), pPolyline->m_pts.end());
+						continue;
+					}
+				}
+				s.flags |= fSHAPE::extra;
+				s.index = extras.size();
+				extras.push_back(shape.NewClone());
+			}
+			l.shapes.count = shapes.size() - l.shapes.first;
+		}
+
+		// boost archives
+		std::string meta, extra;
+		{
+			auto vars = drawing.m_vars;
+			auto line_types = drawing.m_line_types;
+			auto rectBoundary = drawing.m_rectBoundary;
+			std::ostringstream os;
+			boost::archive::text_oarchive oa(os);
+			oa & vars & line_types & rectBoundary;
+			meta = std::move(os).str();
+		}
+		{
+			std::ostringstream os;
+			boost::archive::text_oarchive oa(os);
+			oa & extras;
+			extra = std::move(os).str();
+		}
+
+		std::vector<std::pair<eSECTION, std::span<char const>>> sections{
+			{ eSECTION::meta, meta },
+			{ eSECTION::strings, AsBytes(strings) },
+			{ eSECTION::string_ranges, AsBytes(string_ranges) },
+			{ eSECTION::layers, AsBytes(layers) },
+			{ eSECTION::shapes, AsBytes(shapes) },
+			{ eSECTION::dots, AsBytes(dots) },
+			{ eSECTION::line_pt0, AsBytes(line_pt0) },
+			{ eSECTION::line_pt1, AsBytes(line_pt1) },
+			{ eSECTION::arcs, AsBytes(arcs) },
+			{ eSECTION::poly_ranges, AsBytes(poly_ranges) },
+			{ eSECTION::poly_points, AsBytes(poly_points) },
+			{ eSECTION::extra, extra },
+		};
+
+		auto Align = [](uint64_t pos) { return (pos + 7) / 8 * 8; };
+		sHeader header;
+		header.nSection = sections.size();
+		std::vector<sSection> table;
+		uint64_t pos = Align(sizeof(header) + sizeof(sSection) * sections.size());
+		for (auto const& [eID, data] : sections) {
+			table.push_back({ .eID = eID, .offset = pos, .size = data.size() });
+			pos = Align(pos + data.size());
+		}
+
+		std::ofstream f(path, std::ios_base::binary);
+		if (!f)
+			return false;
+		f.write((char const*)&header, sizeof(header));
+		f.write((char const*)table.data(), table.size() * sizeof(sSection));
+		for (size_t i{}; i < sections.size(); i++) {
+			f.seekp(table[i].offset);
+			f.write(sections[i].second.data(), sections[i].second.size());
+		}
+		// pad to aligned size
+		if (auto posEnd = (uint64_t)f.tellp(); posEnd < pos) {
+			char const zeros[8]{};
+			f.write(zeros, pos - posEnd);
+		}
+		return (bool)f;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool xDrawingBinaryView::Open(std::filesystem::path const& path) {
+		Close();
+		try {
+			m_file.open(path.native());
+		} catch ([[maybe_unused]] std::exception& e) {
+			return false;
+		}
+		if (!m_file.is_open())
+			return false;
+
+		bool bOK = [&]() -> bool {
+			auto const* data = m_file.data();
+			auto const size = (uint64_t)m_file.size();
+			if (size < sizeof(sHeader))
+				return false;
+			sHeader header;
+			memcpy(&header, data, sizeof(header));
+			if ( (header.magic != s_magic) or (header.version != s_version) or (header.sizeof_char != sizeof(char_t)) )
+				return false;
+			if (header.nSection > (size - sizeof(sHeader)) / sizeof(sSection))
+				return false;
+			std::span<sSection const> table{ (sSection const*)(data + sizeof(sHeader)), (size_t)header.nSection };
+
+			auto Section = [&](eSECTION eID) -> std::optional<std::span<char const>> {
+				for (auto const& section : table) {
+					if (section.eID != eID)
+						continue;
+					if ( (section.offset % 8) or (section.offset > size) or (section.size > size - section.offset) )
+						return {};
+					return std::span<char const>{ data + section.offset, (size_t)section.size };
+				}
+				return {};
+			};
+			auto Map = [&]<typename T>(std::span<T const>& span, eSECTION eID) -> bool {
+				auto section = Section(eID);
+				if (!section or (section->size() % sizeof(T)))
+					return false;
+				span = { (T const*)section->data(), section->size() / sizeof(T) };
+				return true;
+			};
+			if (!Map(m_strings, eSECTION::strings)
+				or !Map(m_string_ranges, eSECTION::string_ranges)
+				or !Map(m_layers, eSECTION::layers)
+				or !Map(m_shapes, eSECTION::shapes)
+				or !Map(m_dots, eSECTION::dots)
+				or !Map(m_line_pt0, eSECTION::line_pt0)
+				or !Map(m_line_pt1, eSECTION::line_pt1)
+				or !Map(m_arcs, eSECTION::arcs)
+				or !Map(m_poly_ranges, eSECTION::poly_ranges)
+				or !Map(m_poly_points, eSECTION::poly_points)
+				)
+				return false;
+
+			// boost archives
+			auto meta = Section(eSECTION::meta);
+			auto extra = Section(eSECTION::extra);
+			if (!meta or !extra)
+				return false;
+			try {
+				{
+					std::istringstream is(std::string(meta->data(), meta->size()));
+					boost::archive::text_iarchive ia(is);
+					ia & m_vars & m_line_types & m_rectBoundary;
+				}
+				{
+					std::istringstream is(std::string(extra->data(), extra->size()));
+					boost::archive::text_iarchive ia(is);
+					ia & m_extras;
+				}
+			} catch ([[maybe_unused]] std::exception& e) {
+				return false;
+			}
+
+			// validate indices once, so Draw() needs no check.
+			auto IsInRange = [](sRange const& r, size_t size) { return r.first <= size and r.count <= size - r.first; };
+			for (auto const& r : m_string_ranges) {
+				if (!IsInRange(r, m_strings.size()))
+					return false;
+			}
+			for (auto const& r : m_poly_ranges) {
+				if (!IsInRange(r, m_poly_points.size()))
+					return false;
+			}
+			if (m_line_pt0.size() != m_line_pt1.size())
+				return false;
+			auto IsValid = [&](sShape const& s) {
+				if ( (s.iLayer >= m_string_ranges.size()) or (s.iLineType >= m_string_ranges.size()) )
+					return false;
+				if (s.flags & fSHAPE::extra)
+					return s.index < m_extras.size();
+				switch (s.eType) {
+				case eSHAPE::dot :			return s.index < m_dots.size();
+				case eSHAPE::line :			return s.index < m_line_pt0.size();
+				case eSHAPE::circle_xy :
+				case eSHAPE::arc_xy :
+				case eSHAPE::ellipse_xy :	return s.index < m_arcs.size();
+				case eSHAPE::polyline :
+				case eSHAPE::lwpolyline :	return s.index < m_poly_ranges.size();
+				}
+				return false;
+			};
+			for (auto const& layer : m_layers) {
+				if (layer.iName >= m_string_ranges.size() or !IsInRange(layer.shapes, m_shapes.size()))
+					return false;
+			}
+			for (auto const& shape : m_shapes) {
+				if (!IsValid(shape))
+					return false;
+			}
+			return true;
+		}();
+
+		if (!bOK)
+			Close();
+		return bOK;
+	}
+
+	void xDrawingBinaryView::Close() {
+		if (m_file.is_open())
+			m_file.close();
+		m_vars.clear();
+		m_line_types.clear();
+		m_rectBoundary = {};
+		m_extras.clear();
+		m_strings = {};
+		m_string_ranges = {};
+		m_layers = {};
+		m_shapes = {};
+		m_dots = {};
+		m_line_pt0 = {};
+		m_line_pt1 = {};
+		m_arcs = {};
+		m_poly_ranges = {};
+		m_poly_points = {};
+		std::scoped_lock lock(m_mtxSpatialIndex);
+		m_spatial_index.reset();
+	}
+
+	std::basic_string_view<char_t> xDrawingBinaryView::GetString(uint32_t index) const {
+		if (index >= m_string_ranges.size())
+			return {};
+		auto const& r = m_string_ranges[index];
+		return { m_strings.data() + r.first, (size_t)r.count };
+	}
+
+	void xDrawingBinaryView::SetAttributes(xShape& shape, sShape const& s) const {
+		shape.m_crIndex = s.crIndex;
+		shape.m_strLayer = GetString(s.iLayer);
+		shape.m_color.cr = s.color;
+		shape.m_eLineType = s.eLineType;
+		shape.m_strLineType = GetString(s.iLineType);
+		shape.m_lineWeight = s.lineWeight;
+		shape.m_bVisible = (s.flags & fSHAPE::visible) != 0;
+		shape.m_bTransparent = (s.flags & fSHAPE::transparent) != 0;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool xDrawingBinaryView::ToDrawing(xDrawing& drawing) const {
+		if (!IsOpen())
+			return false;
+
+		drawing.clear();
+		drawing.m_vars = m_vars;
+		drawing.m_line_types = m_line_types;
+		drawing.m_rectBoundary = m_rectBoundary;
+
+		for (auto const& l : m_layers) {
+			auto rLayer = std::make_unique<xLayer>(string_t(GetString(l.iName)));
+			SetAttributes(*rLayer, l.attr);
+			rLayer->m_flags = l.flags;
+			rLayer->m_bUse = l.bUse != 0;
+			if (auto iter = std::find_if(drawing.m_line_types.begin(), drawing.m_line_types.end(), [&](auto const& lt) { return lt.name == rLayer->m_strLineType; });
+				iter != drawing.m_line_types.end()) {
+				rLayer->pLineType = &(*iter);
+			}
+
+			for (auto const& s : m_shapes.subspan(l.shapes.first, l.shapes.count)) {
+				if (s.flags & fSHAPE::extra) {
+					rLayer->m_shapes.push_back(m_extras[s.index].NewClone());
+					continue;
+				}
+				std::unique_ptr<xShape> rShape;
+				switch (s.eType) {
+				case eSHAPE::dot :
+					{
+						auto r = std::make_unique<xDot>();
+						r->m_pt = m_dots[s.index];
+						rShape = std::move(r);
+					}
+					break;
+				case eSHAPE::line :
+					{
+						auto r = std::make_unique<xLine>();
+						r->m_pt0 = m_line_pt0[s.index];
+						r->m_pt1 = m_line_pt1[s.index];
+						rShape = std::move(r);
+					}
+					break;
+				case eSHAPE::circle_xy :
+					{
+						auto const& arc = m_arcs[s.index];
+						auto r = std::make_unique<xCircle>();
+						r->m_ptCenter = arc.ptCenter;
+						r->m_radius = arc.radius;
+						r->m_angle_length = deg_t(arc.angle_length);
+						rShape = std::move(r);
+					}
+					break;
+				case eSHAPE::arc_xy :
+					{
+						auto const& arc = m_arcs[s.index];
+						auto r = std::make_unique<xArc>();
+						r->m_ptCenter = arc.ptCenter;
+						r->m_radius = arc.radius;
+						r->m_angle_start = deg_t(arc.angle_start);
+						r->m_angle_length = deg_t(arc.angle_length);
+						rShape = std::move(r);
+					}
+					break;
+				case eSHAPE::ellipse_xy :
+					{
+						auto const& arc = m_arcs[s.index];
+						auto r = std::make_unique<xEllipse>();
+						r->m_ptCenter = arc.ptCenter;
+						r->m_radius = arc.radius;
+						r->m_radiusH = arc.radiusH;
+						r->m_angle_start = deg_t(arc.angle_start);
+						r->m_angle_length = deg_t(arc.angle_length);
+						r->m_angle_first_axis = deg_t(arc.angle_first_axis);
+						rShape = std::move(r);
+					}
+					break;
+				case eSHAPE::polyline :
+				case eSHAPE::lwpolyline :
+					{
+						std::unique_ptr<xPolyline> r;
+						if (s.eType == eSHAPE::polyline)
+							r = std::make_unique<xPolyline>();
+						else
+							r = std::make_unique<xPolylineLW>();
+						auto const& range = m_poly_ranges[s.index];
+						auto pts = m_poly_points.subspan(range.first, range.count);
+						r->m_pts.assign(pts.begin(), pts.end());
+						r->m_bLoop = (s.flags & fSHAPE::loop) != 0;
+						rShape = std::move(r);
+					}
+					break;
+				default :
+					return false;
+				}
+				SetAttributes(*rShape, s);
+				rLayer->m_shapes.push_back(std::move(rShape));
+			}
+			drawing.m_layers.push_back(std::move(rLayer));
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void xDrawingBinaryView::SetAttributes(sDrawAttr& attr, sShape const& s) const {
+		auto& shape = attr.shape;
+		shape.m_crIndex = s.crIndex;
+		shape.m_color.cr = s.color;
+		shape.m_eLineType = s.eLineType;
+		shape.m_lineWeight = s.lineWeight;
+		shape.m_bVisible = (s.flags & fSHAPE::visible) != 0;
+		shape.m_bTransparent = (s.flags & fSHAPE::transparent) != 0;
+		if (attr.iLayer != s.iLayer) {
+			attr.iLayer = s.iLayer;
+			shape.m_strLayer = GetString(s.iLayer);
+		}
+		if (attr.iLineType != s.iLineType) {
+			attr.iLineType = s.iLineType;
+			shape.m_strLineType = GetString(s.iLineType);
+		}
+	}
+
+	rect_t xDrawingBinaryView::GetShapeBoundary(sShape const& s) const {
+		rect_t rect;
+		rect.SetRectEmptyForMinMax2d();
+		if (s.flags & fSHAPE::extra) {
+			m_extras[s.index].UpdateBoundary(rect);
+			return rect;
+		}
+		switch (s.eType) {
+		case eSHAPE::dot :
+			rect.UpdateBoundary(m_dots[s.index]);
+			break;
+		case eSHAPE::line :
+			rect.UpdateBoundary(m_line_pt0[s.index]);
+			rect.UpdateBoundary(m_line_pt1[s.index]);
+			break;
+		case eSHAPE::circle_xy :
+		case eSHAPE::arc_xy :
+		case eSHAPE::ellipse_xy :
+			{
+				auto const& arc = m_arcs[s.index];
+				auto r = std::max(arc.radius, arc.radiusH);
+				rect.UpdateBoundary(arc.ptCenter - point_t(r, r, 0.));
+				rect.UpdateBoundary(arc.ptCenter + point_t(r, r, 0.));
+			}
+			break;
+		case eSHAPE::polyline :
+		case eSHAPE::lwpolyline :
+			{
+				auto const& range = m_poly_ranges[s.index];
+				auto pts = m_poly_points.subspan(range.first, range.count);
+				for (size_t i{}; i < pts.size(); i++) {
+					rect.UpdateBoundary(pts[i]);
+					if (pts[i].Bulge() != 0.0) {
+						xArc arc = xArc::GetFromBulge(pts[i].Bulge(), pts[i], pts[(i+1) % pts.size()]);
+						rect.UpdateBoundary(arc.m_ptCenter - point_t(arc.m_radius, arc.m_radius, 0.));
+						rect.UpdateBoundary(arc.m_ptCenter + point_t(arc.m_radius, arc.m_radius, 0.));
+					}
+				}
+			}
+			break;
+		}
+		return rect;
+	}
+
+	bool xDrawingBinaryView::DrawShape(ICanvas& canvas, sDrawAttr& attr, sShape const& s, rect_t const* pRectROI) const {
+		if (s.flags & fSHAPE::extra) {
+			auto const& shape = m_extras[s.index];
+			if (pRectROI)
+				return shape.DrawROI(canvas, *pRectROI);
+			shape.Draw(canvas);
+			return true;
+		}
+
+		switch (s.eType) {
+		case eSHAPE::dot :
+			{
+				auto const& pt = m_dots[s.index];
+				SetAttributes(attr, s);
+				canvas.PreDraw(attr.shape);
+				canvas.MoveTo(pt);
+				canvas.LineTo(pt);
+			}
+			break;
+		case eSHAPE::line :
+			SetAttributes(attr, s);
+			canvas.PreDraw(attr.shape);
+			canvas.Line(m_line_pt0[s.index], m_line_pt1[s.index]);
+			break;
+		case eSHAPE::circle_xy :
+		case eSHAPE::arc_xy :
+		case eSHAPE::ellipse_xy :
+			{
+				auto const& arc = m_arcs[s.index];
+				SetAttributes(attr, s);
+				canvas.PreDraw(attr.shape);
+				if (s.eType == eSHAPE::ellipse_xy)
+					canvas.Ellipse(arc.ptCenter, arc.radius, arc.radiusH, deg_t(arc.angle_first_axis), deg_t(arc.angle_start), deg_t(arc.angle_length));
+				else
+					canvas.Arc(arc.ptCenter, arc.radius, deg_t(arc.angle_start), deg_t(arc.angle_length));
+			}
+			break;
+		case eSHAPE::polyline :
+		case eSHAPE::lwpolyline :
+			{
+				auto const& range = m_poly_ranges[s.index];
+				SetAttributes(attr, s);
+				canvas.PreDraw(attr.shape);
+				xPolyline::DrawPolyPoints(canvas, m_poly_points.subspan(range.first, range.count), (s.flags & fSHAPE::loop) != 0);
+			}
+			break;
+		default :
+			return false;
+		}
+		return true;
+	}
+
+	void xDrawingBinaryView::Draw(ICanvas& canvas) const {
+		sDrawAttr attr;
+		for (auto const& layer : m_layers) {
+			SetAttributes(attr, layer.attr);
+			canvas.PreDraw(attr.shape);
+			for (auto const& shape : m_shapes.subspan(layer.shapes.first, layer.shapes.count))
+				DrawShape(canvas, attr, shape, nullptr);
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// spatial index
+	namespace bg = boost::geometry;
+	namespace bgi = boost::geometry::index;
+
+	struct xDrawingBinaryView::sSpatialIndex {
+		using box_t = bg::model::box<bg::model::d2::point_xy<double>>;
+		using value_t = std::pair<box_t, size_t>;
+
+		std::vector<rect_t> boundaries;	// boundary of each shape (m_shapes). not normalized if shape has no extent (not indexed)
+		std::vector<size_t> unbounded;	// shapes with infinite boundary. tested one by one.
+		bgi::rtree<value_t, bgi::quadratic<16>> rtree;
+	};
+
+	xDrawingBinaryView::xDrawingBinaryView() = default;
+	xDrawingBinaryView::~xDrawingBinaryView() {
+		Close();
+	}
+
+	xDrawingBinaryView::sSpatialIndex const& xDrawingBinaryView::GetSpatialIndex() const {
+		std::scoped_lock lock(m_mtxSpatialIndex);
+		if (m_spatial_index)
+			return *m_spatial_index;
+
+		auto rIndex = std::make_unique<sSpatialIndex>();
+		auto& index = *rIndex;
+		index.boundaries.resize(m_shapes.size());
+		std::vector<sSpatialIndex::value_t> values;
+		values.reserve(m_shapes.size());
+		for (auto const& layer : m_layers) {
+			for (size_t i = layer.shapes.first; i < layer.shapes.first + layer.shapes.count; i++) {
+				auto rect = GetShapeBoundary(m_shapes[i]);
+				index.boundaries[i] = rect;
+				if (!rect.IsNormalized())	// no extent (empty polyline, ...). never intersects ROI
+					continue;
+				if (std::isfinite(rect.right - rect.left) and std::isfinite(rect.bottom - rect.top))
+					values.emplace_back(sSpatialIndex::box_t{{rect.left, rect.top}, {rect.right, rect.bottom}}, i);
+				else
+					index.unbounded.push_back(i);
+			}
+		}
+		index.rtree = decltype(index.rtree)(values.begin(), values.end());	// packing (bulk loading)
+
+		m_spatial_index = std::move(rIndex);
+		return *m_spatial_index;
+	}
+
+	bool xDrawingBinaryView::DrawROI(ICanvas& canvas, rect_t const& rectROI) const {
+		if (!IsOpen())
+			return false;
+		rect_t roi(rectROI);
+		roi.NormalizeRect();
+
+		auto const& index = GetSpatialIndex();
+		auto IsIntersecting = [&](size_t i) { return rect_t(index.boundaries[i]).IntersectRect(roi).IsNormalized(); };
+		std::vector<size_t> indices;
+		sSpatialIndex::box_t box{{roi.left, roi.top}, {roi.right, roi.bottom}};
+		for (auto iter = index.rtree.qbegin(bgi::intersects(box)); iter != index.rtree.qend(); iter++) {
+			if (IsIntersecting(iter->second))
+				indices.push_back(iter->second);
+		}
+		for (auto i : index.unbounded) {
+			if (IsIntersecting(i))
+				indices.push_back(i);
+		}
+		std::ranges::sort(indices);	// keep drawing order
+
+		sDrawAttr attr;
+		bool result{};
+		for (auto i : indices)
+			result |= DrawShape(canvas, attr, m_shapes[i], &rectROI);
+		return result;
+	}
+
+}
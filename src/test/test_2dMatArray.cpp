@@ -0,0 +1,186 @@
+﻿#include "pch.h"
+
+#include "gtl/gtl.h"
+#include "gtl/2dMatArray.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+TEST(gtl_2dMatArray, pyramid) {
+	cv::Mat img(1024, 1280, CV_8UC1);
+	cv::randu(img, 0, 256);
+
+	gtl::C2dMatArray mats;
+	ASSERT_TRUE(mats.SetPyramid(4, 0));
+	ASSERT_TRUE(mats.Create(img, {320, 256}, {4, 4}));
+	mats.UpdateThumbnail(false);
+	auto const nMemory = mats.GetThumbnailMemory();
+	EXPECT_GT(nMemory, 0u);
+
+	// 1/4 : served from level 2 (made from level 1)
+	auto Check = [&](double dScale) {
+		cv::Rect rc(0, 0, img.cols, img.rows);
+		auto imgResized = mats.GetResizedImage(rc, dScale);
+		cv::Mat imgRef;
+		cv::resize(img, imgRef, {}, dScale, dScale, cv::INTER_AREA);
+		ASSERT_EQ(imgResized.size(), imgRef.size());
+		EXPECT_LE(cv::norm(imgResized, imgRef, cv::NORM_INF), 2.0);
+	};
+	Check(0.25);
+	Check(1./16);
+
+	// LRU eviction. evicted levels are made again on demand.
+	size_t const nBudget = nMemory / 4;
+	mats.SetThumbnailMemoryBudget(nBudget);
+	EXPECT_LE(mats.GetThumbnailMemory(), nBudget);
+	Check(0.5);
+	EXPECT_LE(mats.GetThumbnailMemory(), nBudget);
+	Check(1./16);
+	EXPECT_LE(mats.GetThumbnailMemory(), nBudget);
+
+	mats.Destroy();
+	EXPECT_EQ(mats.GetThumbnailMemory(), 0u);
+}
+
+TEST(gtl_2dMatArray, tiled_roi) {
+	cv::Mat img(700, 1100, CV_8UC3);
+	cv::randu(img, 0, 256);
+
+	// separate tiles (not a view of one image), last column/row smaller
+	gtl::xSize2i const sizePiece(250, 200);
+	gtl::xSize2i const sizeArray(5, 4);
+	gtl::C2dMatArray mats;
+	ASSERT_TRUE(mats.Create(sizeArray));
+	for (int y = 0; y < sizeArray.cy; y++) {
+		for (int x = 0; x < sizeArray.cx; x++) {
+			cv::Rect rc(x*sizePiece.cx, y*sizePiece.cy, sizePiece.cx, sizePiece.cy);
+			rc &= cv::Rect(0, 0, img.cols, img.rows);
+			ASSERT_TRUE(mats.SetPartialImage({x, y}, img(rc), true, false));
+		}
+	}
+	EXPECT_EQ(mats.size(), img.size());
+
+	for (cv::Rect rc : { cv::Rect(0, 0, 1100, 700), cv::Rect(10, 20, 30, 40), cv::Rect(240, 190, 20, 20), cv::Rect(249, 0, 502, 601), cv::Rect(999, 599, 101, 101) }) {
+		auto roi = mats.GetROI(rc);
+		ASSERT_EQ(roi.size(), rc.size());
+		EXPECT_EQ(cv::norm(roi, img(rc), cv::NORM_INF), 0.0);
+	}
+
+	// clipped to the image
+	cv::Rect rc(1000, 600, 200, 200);
+	auto roi = mats.GetROI(rc);
+	EXPECT_EQ(rc, cv::Rect(1000, 600, 100, 100));
+	EXPECT_EQ(cv::norm(roi, img(rc), cv::NORM_INF), 0.0);
+
+	// out of image
+	rc = cv::Rect(1100, 0, 10, 10);
+	EXPECT_TRUE(mats.GetROI(rc).empty());
+}
+
+TEST(gtl_2dMatArray, thumbnail_worker_pool) {
+	// priority and cancellation. (one worker, blocked by the first job)
+	{
+		gtl::CThumbnailWorkerPool pool(1);
+		std::atomic<bool> bStarted{}, bGate{};
+		std::mutex mtx;
+		std::vector<int> order;
+		int owner1{}, owner2{};
+		pool.Submit(&owner1, 0, [&] { bStarted = true; while (!bGate) std::this_thread::yield(); });
+		while (!bStarted)
+			std::this_thread::yield();
+		std::vector<gtl::CThumbnailWorkerPool::P_JOB> jobs;
+		for (int i = 0; i < 6; i++)
+			jobs.push_back(pool.Submit(&owner1, i % 3, [&, i] { std::lock_guard lock(mtx); order.push_back(i); }));
+		auto job = pool.Submit(&owner1, 10, [&] { std::lock_guard lock(mtx); order.push_back(-1); });
+		EXPECT_TRUE(job->Cancel());
+		EXPECT_FALSE(pool.SetPriority(job, 20));
+		// re-keyed while queued
+		EXPECT_TRUE(pool.SetPriority(jobs[3], 3));
+		EXPECT_TRUE(pool.SetPriority(jobs[2], 0));
+		for (int i = 0; i < 3; i++)
+			pool.Submit(&owner2, 0, [&] { std::lock_guard lock(mtx); order.push_back(-2); });
+		EXPECT_EQ(pool.Cancel(&owner2), 3u);
+		EXPECT_EQ(pool.GetPending(&owner2), 0u);
+
+		bGate = true;
+		pool.Wait(&owner1);
+		EXPECT_EQ(order, (std::vector<int>{ 3, 5, 1, 4, 0, 2 }));
+		auto metrics = pool.GetMetrics();
+		EXPECT_EQ(metrics.nDone, 7u);
+		EXPECT_EQ(metrics.nCancelled, 4u);
+		EXPECT_EQ(metrics.nQueued, 0u);
+	}
+
+	// thumbnails in background, by the shared pool
+	cv::Mat img(1024, 1280, CV_8UC1);
+	cv::randu(img, 0, 256);
+	gtl::C2dMatArray mats;
+	ASSERT_TRUE(mats.SetThumbnailMaker({ {1, 4} }, 1));
+	ASSERT_TRUE(mats.Create(img, {320, 256}, {4, 4}));
+	std::atomic<int> nNotified{}, nNotifiedEarly{};
+	std::atomic<bool> bQueued{};
+	mats.SetNotifier([&](gtl::xPoint2i&, gtl::C2dMatArray::T_ITEM const&) { nNotified++; if (!bQueued) nNotifiedEarly++; return true; });
+	mats.SetThumbnailPriority(1, cv::Rect(0, 0, 320, 256));
+
+	// hold all workers of the shared pool while the batch is queued
+	{
+		auto& pool = gtl::CThumbnailWorkerPool::GetInstance();
+		int const nWorker = pool.GetMetrics().nWorker;
+		std::atomic<int> nHeld{};
+		std::atomic<bool> bGate{};
+		int owner{};
+		for (int i = 0; i < nWorker; i++)
+			pool.Submit(&owner, 100, [&] { nHeld++; while (!bGate) std::this_thread::yield(); });
+		while (nHeld < nWorker)
+			std::this_thread::yield();
+		mats.UpdateThumbnail(true);
+		EXPECT_TRUE(mats.IsThumbnailMakerRunning());
+		EXPECT_EQ(nNotified, 0);
+		bQueued = true;
+		bGate = true;
+		pool.Wait(&owner);
+	}
+	mats.WaitThumbnailMaker();
+	EXPECT_EQ(nNotified, 4);	// every 4 of 16 tiles. (the 16th is also 'all done')
+	EXPECT_EQ(nNotifiedEarly, 0);
+	EXPECT_GT(mats.GetThumbnailMemory(), 0u);
+
+	// replaced tile : queued again
+	cv::Mat tile(256, 320, CV_8UC1, cv::Scalar(0));
+	ASSERT_TRUE(mats.SetPartialImage({1, 1}, tile));
+	mats.WaitThumbnailMaker();
+	EXPECT_EQ(nNotified, 5);	// all done
+	cv::Rect rc(320, 256, 320, 256);
+	auto imgResized = mats.GetResizedImage(rc, 0.25);
+	EXPECT_EQ(imgResized.size(), cv::Size(80, 64));
+	EXPECT_EQ(cv::countNonZero(imgResized), 0);
+
+	mats.StopThumbnailMaker();
+	EXPECT_FALSE(mats.IsThumbnailMakerRunning());
+}
+
+TEST(gtl_2dMatArray, zero_copy_view) {
+	// external buffer (as if memory-mapped), kept alive by tiles only
+	auto buffer = std::make_shared<std::vector<uint8_t>>(1100*700);
+	cv::Mat img(700, 1100, CV_8UC1, buffer->data());
+	cv::randu(img, 0, 256);
+	uint8_t const* data = buffer->data();
+	std::weak_ptr<std::vector<uint8_t>> wbuffer = buffer;
+
+	cv::Mat roi;
+	{
+		gtl::C2dMatArray mats;
+		ASSERT_TRUE(mats.Create(img, {250, 200}, {5, 4}, std::move(buffer)));
+		EXPECT_EQ(mats.GetMergedImage().data, data);
+		EXPECT_EQ(mats.GetItem({1, 1}).img.data, data + 200*1100 + 250);
+
+		// multi tile ROI at scale 1 : no copy
+		cv::Rect rc(240, 190, 300, 300);
+		roi = mats.GetROI(rc);
+		EXPECT_EQ(roi.data, data + 190*1100 + 240);
+		EXPECT_FALSE(wbuffer.expired());
+	}
+	EXPECT_FALSE(wbuffer.expired());
+	roi.release();
+	EXPECT_TRUE(wbuffer.expired());
+}
@@ -0,0 +1,58 @@
+﻿#include "pch.h"
+
+#include "gtl/gtl.h"
+#include "gtl/bit_pack.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+TEST(gtl_bit_pack, simd_vs_scalar) {
+	std::mt19937 engine(1);
+	std::uniform_int_distribution<int> dist(0, 255);
+
+	// lengths not aligned to SIMD blocks (tail by scalar)
+	for (int nBPP : { 1, 2, 4, 8 }) {
+		for (size_t nPixel : { 0, 1, 7, 15, 16, 17, 33, 63, 64, 65, 129, 1001, 4999 }) {
+			std::vector<uint8_t> src(nPixel), lut(256), palette(1 << nBPP);
+			for (auto& v : src) v = (uint8_t)dist(engine);
+			for (auto& v : lut) v = (uint8_t)dist(engine);
+			for (auto& v : palette) v = (uint8_t)dist(engine);
+			size_t const nByte = (nPixel * nBPP + 7) / 8;
+
+			// guard byte at the end must be left untouched
+			std::vector<uint8_t> packed0(nByte + 1, 0xcc), packed1(nByte + 1, 0xcc);
+			ASSERT_TRUE(gtl::PackBits(nBPP, src.data(), nPixel, packed0.data(), false));
+			ASSERT_TRUE(gtl::PackBits(nBPP, src.data(), nPixel, packed1.data(), true));
+			EXPECT_EQ(packed0, packed1);
+			EXPECT_EQ(packed1.back(), 0xcc);
+
+			std::vector<uint8_t> indices(nPixel + 1, 0xcc), values0(nPixel + 1, 0xcc), values1(nPixel + 1, 0xcc);
+			ASSERT_TRUE(gtl::UnpackBits(nBPP, packed1.data(), nPixel, indices.data()));
+			for (size_t i{}; i < nPixel; i++)
+				ASSERT_EQ(indices[i], src[i] & ((1 << nBPP) - 1));
+			EXPECT_EQ(indices.back(), 0xcc);
+
+			ASSERT_TRUE(gtl::UnpackBitsLUT(nBPP, packed1.data(), nPixel, palette.data(), values0.data(), false));
+			ASSERT_TRUE(gtl::UnpackBitsLUT(nBPP, packed1.data(), nPixel, palette.data(), values1.data(), true));
+			EXPECT_EQ(values0, values1);
+			for (size_t i{}; i < nPixel; i++)
+				ASSERT_EQ(values1[i], palette[indices[i]]);
+
+			ASSERT_TRUE(gtl::PackBitsLUT(nBPP, src.data(), nPixel, lut.data(), packed0.data(), false));
+			ASSERT_TRUE(gtl::PackBitsLUT(nBPP, src.data(), nPixel, lut.data(), packed1.data(), true));
+			EXPECT_EQ(packed0, packed1);
+
+			if (nBPP == 1) {
+				gtl::PackBitsThreshold(src.data(), nPixel, 128, packed0.data(), false);
+				gtl::PackBitsThreshold(src.data(), nPixel, 128, packed1.data(), true);
+				EXPECT_EQ(packed0, packed1);
+				gtl::UnpackBits(1, packed1.data(), nPixel, indices.data());
+				for (size_t i{}; i < nPixel; i++)
+					ASSERT_EQ(indices[i], src[i] >= 128 ? 1 : 0);
+			}
+		}
+	}
+
+	EXPECT_FALSE(gtl::PackBits(3, nullptr, 0, nullptr));
+	EXPECT_FALSE(gtl::UnpackBits(16, nullptr, 0, nullptr));
+}
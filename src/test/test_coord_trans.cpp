@@ -3,6 +3,7 @@
 #include "gtl/gtl.h"
 #include "gtl/coord/coord_trans.h"
 #include "gtl/coord/coord_trans_perspective.h"
+#include "gtl/mat_helper.h"
 
 
 using namespace std::literals;
@@ -223,3 +224,208 @@ TEST(gtl_coord_trans_perspective, ctP44_2) {
 	EXPECT_EQ(ct.TransI(pts1[3]), pts0[3]);
 
 }
+
+TEST(gtl_coord_trans, batch) {
+	using namespace gtl;
+
+	xCoordTrans2d ct0(1.5, xCoordTrans2d::GetRotatingMatrix(deg_t(30.)), {1., 2.}, {-3., 4.});
+	xCoordTrans3d ct1(0.5, xCoordTrans3d::GetRotatingMatrixYZ(deg_t(10.)), {1., 2., 3.}, {4., 5., 6.});
+	xCoordTransP33 ct2(cv::Matx33d{1., 0.1, 2., /**/ 0.2, 1., 3., /**/ 1.e-3, 2.e-3, 1.});
+	xCoordTransP44 ct3(xCoordTransP44::mat_t{1., 0., 0.1, 1., /**/ 0., 1., 0., 2., /**/ 0.1, 0., 1., 3., /**/ 1.e-3, 0., 0., 1.});
+	xCoordTransChain chain;
+	chain *= ct0;
+	chain *= ct2;
+	chain *= ct1;
+
+	std::vector<xPoint2d> pts2;
+	std::vector<xPoint3d> pts3;
+	for (int y{}; y < 10; y++) {
+		for (int x{}; x < 10; x++) {
+			pts2.emplace_back(x * 10., y * 7.);
+			pts3.emplace_back(x * 10., y * 7., x - y * 2.);
+		}
+	}
+
+	for (ICoordTrans const* ct : std::initializer_list<ICoordTrans const*>{ &ct0, &ct1, &ct2, &ct3, &chain }) {
+		std::vector<xPoint2d> ptsT2(pts2.size());
+		std::vector<xPoint3d> ptsT3(pts3.size());
+		ct->Trans(pts2, ptsT2);
+		ct->Trans(pts3, ptsT3);
+		for (size_t i{}; i < pts2.size(); i++) {
+			EXPECT_TRUE(ptsT2[i].Distance((*ct)(pts2[i])) < 1.e-9);
+			EXPECT_TRUE(ptsT3[i].Distance((*ct)(pts3[i])) < 1.e-9);
+		}
+
+		// in-place
+		auto ptsI2 = pts2;
+		ct->Trans(std::span<xPoint2d>(ptsI2));
+		EXPECT_EQ(ptsI2, ptsT2);
+	}
+
+	std::vector<xPoint2d> ptsWrongSize(3);
+	EXPECT_THROW(chain.Trans(pts2, ptsWrongSize), std::invalid_argument);
+}
+
+TEST(gtl_coord_trans, chain_flatten) {
+	using namespace gtl;
+
+	xCoordTrans2d ct0(1.5, xCoordTrans2d::GetRotatingMatrix(deg_t(30.)), {1., 2.}, {-3., 4.});
+	xCoordTrans3d ct1(0.5, xCoordTrans3d::GetRotatingMatrixYZ(deg_t(10.)), {1., 2., 3.}, {4., 5., 6.});
+	xCoordTransP33 ct2(cv::Matx33d{1., 0.1, 2., /**/ 0.2, 1., 3., /**/ 1.e-3, 2.e-3, 1.});
+	xCoordTransP44 ct3(xCoordTransP44::mat_t{1., 0., 0.1, 1., /**/ 0., 1., 0., 2., /**/ 0.1, 0., 1., 3., /**/ 1.e-3, 0., 0., 1.});
+
+	xCoordTransChain chain;
+	chain *= ct0;
+	chain *= ct3;
+	chain *= ct2;
+	chain *= ct1;
+	EXPECT_EQ(chain.GetCompiledSize(), 1);
+
+	for (int y{}; y < 10; y++) {
+		for (int x{}; x < 10; x++) {
+			xPoint2d pt2(x * 10., y * 7.);
+			xPoint3d pt3(x * 10., y * 7., x - y * 2.);
+			EXPECT_TRUE(chain(pt2).Distance(ct0(ct3(ct2(ct1(pt2))))) < 1.e-6);
+			EXPECT_TRUE(chain(pt3).Distance(ct0(ct3(ct2(ct1(pt3))))) < 1.e-6);
+		}
+	}
+
+	// inverse is flattened, too. (same as inverse of each link)
+	for (int y{}; y < 10; y++) {
+		for (int x{}; x < 10; x++) {
+			xPoint2d pt2(x * 10., y * 7.);
+			auto r = chain.TransInverse(pt2);
+			auto r0 = ct0.TransInverse(pt2);
+			auto r3 = ct3.TransInverse(*r0);
+			auto r2 = ct2.TransInverse(*r3);
+			auto r1 = ct1.TransInverse(*r2);
+			ASSERT_TRUE(r and r1);
+			EXPECT_TRUE(r->Distance(*r1) < 1.e-6);
+		}
+	}
+	xCoordTransChain chain3d;
+	chain3d *= ct3;
+	chain3d *= ct1;
+	xPoint3d pt3d(10., 20., 30.);
+	auto r3d = chain3d.TransInverse(pt3d);
+	ASSERT_TRUE(r3d);
+	EXPECT_TRUE(r3d->Distance(*ct1.TransInverse(*ct3.TransInverse(pt3d))) < 1.e-6);
+	EXPECT_TRUE(chain3d(*r3d).Distance(pt3d) < 1.e-6);
+
+	// nested chain is not flattened.
+	xCoordTransChain chain2;
+	chain2 *= ct0;
+	chain2 *= (ICoordTrans const&)chain;
+	chain2 *= ct1;
+	EXPECT_EQ(chain2.GetCompiledSize(), 3);
+	xPoint3d pt3(1., 2., 3.);
+	EXPECT_TRUE(chain2(pt3).Distance(ct0(chain(ct1(pt3)))) < 1.e-6);
+
+	// links of chain are appended
+	xCoordTransChain chain3;
+	chain3 *= ct0;
+	chain3 *= chain;
+	EXPECT_EQ(chain3.GetCompiledSize(), 1);
+	EXPECT_TRUE(chain3(pt3).Distance(ct0(chain(pt3))) < 1.e-6);
+
+	chain.clear();
+	EXPECT_EQ(chain.GetCompiledSize(), 0);
+	EXPECT_EQ(chain(pt3), pt3);
+}
+
+TEST(gtl_coord_trans, SetFromNPoints) {
+	using namespace gtl;
+
+	xCoordTrans2d ctRef(1.2, xCoordTrans2d::GetRotatingMatrix(deg_t(20.)), {10., 20.}, {-30., 40.});
+	xCoordTransP33 ctRefP(cv::Matx33d{1.1, 0.1, 2., /**/ -0.2, 0.9, 3., /**/ 1.e-4, 2.e-4, 1.});
+
+	std::vector<xPoint2d> ptsS, ptsT, ptsTP;
+	for (int y{}; y < 30; y++) {
+		for (int x{}; x < 30; x++) {
+			xPoint2d pt(x * 10., y * 10.);
+			ptsS.push_back(pt);
+			ptsT.push_back(ctRef(pt));
+			ptsTP.push_back(ctRefP(pt));
+		}
+	}
+
+	// least square
+	{
+		xCoordTrans2d ct;
+		sCoordTransFitResult result;
+		EXPECT_TRUE(ct.SetFromNPoints(ptsS, ptsT, true, &result));
+		EXPECT_EQ(result.nInlier, ptsS.size());
+		EXPECT_TRUE(result.dMaxResidual < 1.e-6);
+		EXPECT_TRUE(ct(xPoint2d(123., 456.)).Distance(ctRef(xPoint2d(123., 456.))) < 1.e-6);
+
+		xCoordTransP33 ctP;
+		EXPECT_TRUE(ctP.SetFromNPoints(ptsS, ptsTP, &result));
+		EXPECT_TRUE(result.dMaxResidual < 1.e-6);
+	}
+
+	// outliers
+	for (size_t i{}; i < ptsT.size(); i += 7) {
+		ptsT[i] += xPoint2d(50., -20.);
+		ptsTP[i] += xPoint2d(-40., 30.);
+	}
+	{
+		sCoordTransRANSAC ransac{ .dInlierThreshold = 0.1 };
+		sCoordTransFitResult result;
+
+		xCoordTrans2d ct;
+		EXPECT_TRUE(ct.SetFromNPoints(ptsS, ptsT, true, &result));
+		EXPECT_TRUE(result.dMaxResidual > 1.);
+
+		EXPECT_TRUE(ct.SetFromNPoints(ptsS, ptsT, true, &result, &ransac));
+		EXPECT_EQ(result.nInlier, ptsS.size() - (ptsS.size()+6)/7);
+		EXPECT_TRUE(result.dMaxResidual < 1.e-6);
+		EXPECT_FALSE(result.inliers[0]);
+		EXPECT_TRUE(result.inliers[1]);
+		EXPECT_TRUE(ct(xPoint2d(123., 456.)).Distance(ctRef(xPoint2d(123., 456.))) < 1.e-6);
+
+		xCoordTransP33 ctP;
+		EXPECT_TRUE(ctP.SetFromNPoints(ptsS, ptsTP, &result, &ransac));
+		EXPECT_EQ(result.nInlier, ptsS.size() - (ptsS.size()+6)/7);
+		EXPECT_TRUE(result.dMaxResidual < 1.e-6);
+	}
+}
+
+TEST(gtl_coord_trans, MakeRemapMaps) {
+	using namespace gtl;
+
+	xCoordTransP33 ctP(cv::Matx33d{1., 0.01, 3., /**/ -0.02, 1.1, -5., /**/ 1.e-5, 2.e-5, 1.});
+	xCoordTrans2d ct2(1.2, xCoordTrans2d::GetRotatingMatrix(deg_t(10.0)), {50., 40.}, {60., 30.});
+	xCoordTransChain chain;
+	chain *= ct2;
+	chain *= ctP;
+
+	cv::Size size(201, 123);
+	for (ICoordTrans const* pCT : { (ICoordTrans const*)&ctP, (ICoordTrans const*)&chain }) {
+		auto const& ct = *pCT;
+		auto [mapX, mapY] = MakeRemapMaps(ct, size, 0, 3);
+		ASSERT_EQ(mapX.size(), size);
+		ASSERT_EQ(mapX.type(), CV_32FC1);
+		ASSERT_EQ(mapY.size(), size);
+		for (int y{}; y < size.height; y += 7) {
+			for (int x{}; x < size.width; x += 5) {
+				auto pt = ct(xPoint2d(x, y));
+				EXPECT_NEAR(mapX.at<float>(y, x), pt.x, 1.e-3);
+				EXPECT_NEAR(mapY.at<float>(y, x), pt.y, 1.e-3);
+			}
+		}
+
+		// coarse grid : exact at grid nodes and near elsewhere
+		auto [mapXG, mapYG] = MakeRemapMaps(ct, size, 16);
+		ASSERT_EQ(mapXG.size(), size);
+		for (int y{}; y < size.height; y++) {
+			for (int x{}; x < size.width; x++) {
+				double tol = (x % 16 == 0 and y % 16 == 0) ? 1.e-3 : 0.5;
+				EXPECT_NEAR(mapXG.at<float>(y, x), mapX.at<float>(y, x), tol);
+				EXPECT_NEAR(mapYG.at<float>(y, x), mapY.at<float>(y, x), tol);
+			}
+		}
+	}
+
+	cv::Mat mapX, mapY;
+	EXPECT_FALSE(MakeRemapMaps(ctP, cv::Size(0, 10), mapX, mapY));
+}
@@ -0,0 +1,120 @@
+﻿#include "pch.h"
+
+#include "gtl/gtl.h"
+#include "gtl/mat_container.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+namespace {
+	/// @brief binary mask with some noise
+	cv::Mat MakeMask(cv::Size size) {
+		cv::Mat img(size, CV_8UC1);
+		img.forEach<uint8_t>([](uint8_t& v, int const* pos) { v = ((pos[0] / 13 + pos[1] / 37) % 3) ? 255 : 0; });
+		return img;
+	}
+}
+
+TEST(gtl_mat_container, block) {
+	for (auto codec : { gtl::eMAT_CODEC::none, gtl::eMAT_CODEC::rle, gtl::eMAT_CODEC::lz }) {
+		for (cv::Size size : { cv::Size(1, 1), cv::Size(1001, 301), cv::Size(3000, 2000) }) {
+			cv::Mat img(size, CV_16UC3);
+			cv::randu(img, 0, 4);	// compressible
+			cv::Mat mask = MakeMask(size);
+
+			for (cv::Mat const& src : { img, mask, cv::Mat(mask, cv::Rect(0, 0, size.width/2+1, size.height)) }) {	// non continuous also
+				gtl::sMatCodecOption option{ .codec = codec, .bChecksum = true, .nChunkSize = 64*1024 };
+				std::stringstream ss;
+				ASSERT_TRUE(gtl::SaveMat(ss, src, option));
+				cv::Mat dst;
+				ASSERT_TRUE(gtl::ReadMat(ss, dst));
+				EXPECT_TRUE(gtl::IsMatEqual(src, dst));
+			}
+		}
+	}
+
+	// broken data is detected
+	cv::Mat mask = MakeMask({1001, 301});
+	std::stringstream ss;
+	ASSERT_TRUE(gtl::SaveMat(ss, mask, { .codec = gtl::eMAT_CODEC::none }));
+	auto str = ss.str();
+	str[str.size()/2] ^= 0x10;
+	std::stringstream ss2(str);
+	cv::Mat dst;
+	EXPECT_FALSE(gtl::ReadMat(ss2, dst));
+
+	// unknown type
+	for (int32_t type : { -1, CV_MAT_TYPE_MASK + 1, CV_8UC1 | CV_MAT_CONT_FLAG }) {
+		auto str2 = ss.str();
+		std::memcpy(str2.data() + offsetof(gtl::sMatBlockHeader, type), &type, sizeof(type));
+		std::stringstream ss3(str2);
+		EXPECT_FALSE(gtl::ReadMat(ss3, dst));
+	}
+}
+
+TEST(gtl_mat_container, legacy) {
+	cv::Mat img(301, 1001, CV_8UC3);
+	cv::randu(img, 0, 255);
+	std::stringstream ss;
+	ASSERT_TRUE(gtl::SaveMatLegacy(ss, img));
+	ASSERT_TRUE(gtl::SaveMat(ss, img));
+	cv::Mat dst;
+	ASSERT_TRUE(gtl::ReadMat(ss, dst));
+	EXPECT_TRUE(gtl::IsMatEqual(img, dst));
+	dst.release();
+	ASSERT_TRUE(gtl::ReadMat(ss, dst));
+	EXPECT_TRUE(gtl::IsMatEqual(img, dst));
+}
+
+TEST(gtl_mat_container, file) {
+	auto path = std::filesystem::temp_directory_path() / L"gtl_test_mat_container.gmat";
+	std::vector<cv::Mat> mats;
+	for (int i{}; i < 100; i++)
+		mats.push_back(MakeMask({ 100 + i * 7, 50 + i * 3 }));
+
+	{
+		gtl::CMatContainerFile file;
+		ASSERT_TRUE(file.Create(path, { .codec = gtl::eMAT_CODEC::rle }));
+		for (int i{}; i < 50; i++)
+			ASSERT_TRUE(file.Add(mats[i]));
+	}
+	{
+		// appends, from several threads
+		gtl::CMatContainerFile file;
+		ASSERT_TRUE(file.Open(path, false));
+		EXPECT_EQ(file.size(), 50u);
+		std::vector<std::jthread> threads;
+		for (int t{}; t < 2; t++) {
+			threads.emplace_back([&, t] {
+				for (int i = 50 + t; i < 100; i += 2)
+					file.Add(mats[i]);
+			});
+		}
+	}
+
+	gtl::CMatContainerFile file;
+	ASSERT_TRUE(file.Open(path));
+	ASSERT_EQ(file.size(), 100u);
+	EXPECT_FALSE(file.Add(mats[0]));	// read only
+	for (int i{}; i < 50; i++)
+		EXPECT_TRUE(gtl::IsMatEqual(file.Get(i), mats[i]));
+	// appended in any order
+	int nFound{};
+	for (int i = 50; i < 100; i++) {
+		auto img = file.Get(i);
+		nFound += (int)std::ranges::any_of(mats, [&](auto const& m) { return gtl::IsMatEqual(m, img); });
+	}
+	EXPECT_EQ(nFound, 50);
+	file.Close();
+
+	// index count beyond the file
+	{
+		std::fstream f(path, std::ios_base::in|std::ios_base::out|std::ios_base::binary);
+		uint64_t nMat = 1ull << 60;
+		f.seekp(offsetof(gtl::CMatContainerFile::sHeader, nMat));
+		f.write((char const*)&nMat, sizeof(nMat));
+	}
+	EXPECT_FALSE(file.Open(path));
+
+	std::filesystem::remove(path);
+}
@@ -0,0 +1,86 @@
+﻿#include "pch.h"
+
+#include "gtl/gtl.h"
+#include "gtl/mat_helper.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+TEST(gtl_mat_helper, bitmap) {
+	auto path = std::filesystem::temp_directory_path() / L"gtl_test_mat_helper.bmp";
+
+	for (int nBPP : { 1, 4, 8 }) {
+		std::vector<gtl::color_bgra_t> palette(1 << nBPP);
+		for (int i{}; i < palette.size(); i++) {
+			auto v = (uint8_t)(i * 255 / (palette.size()-1));
+			palette[i].b = palette[i].g = palette[i].r = v;
+		}
+
+		// width not aligned to byte. (large one : several bands of rows for workers)
+		for (cv::Size size : { cv::Size(1001, 301), cv::Size(4999, 2000) }) {
+			cv::Mat index(size, CV_8UC1);
+			cv::randu(index, 0, (int)palette.size());
+			cv::Mat img(index.size(), CV_8UC1);
+			for (int y{}; y < img.rows; y++)
+				for (int x{}; x < img.cols; x++)
+					img.at<uint8_t>(y, x) = palette[index.at<uint8_t>(y, x)].r;
+
+			// progress : increasing percents up to 100, then done
+			std::vector<std::pair<int, bool>> progress;
+			auto OnProgress = [&](int iPercent, bool bDone, bool bError) { EXPECT_FALSE(bError); progress.emplace_back(iPercent, bDone); return true; };
+			auto CheckProgress = [&] {
+				ASSERT_GT(progress.size(), 1u);
+				EXPECT_EQ(progress.back(), std::pair(-1, true));
+				EXPECT_EQ(progress[progress.size()-2], std::pair(100, false));
+				for (size_t i = 1; i+1 < progress.size(); i++)
+					EXPECT_LT(progress[i-1].first, progress[i].first);
+				progress.clear();
+			};
+
+			for (bool bBottom2Top : { false, true }) {
+				ASSERT_TRUE(gtl::SaveBitmapMat(path, img, nBPP, {1000, 1000}, palette, false, bBottom2Top, OnProgress));
+				CheckProgress();
+
+				auto [img2, pelsPerMeter] = gtl::LoadBitmapMat(path, OnProgress);
+				ASSERT_EQ(img2.size(), img.size());
+				EXPECT_EQ(cv::norm(img2, img, cv::NORM_INF), 0.0);
+				EXPECT_EQ(pelsPerMeter, gtl::xSize2i(1000, 1000));
+				CheckProgress();
+
+				auto result = gtl::LoadBitmapMatPixelArray(path);
+				ASSERT_EQ(result.img.size(), index.size());
+				EXPECT_EQ(cv::norm(result.img, index, cv::NORM_INF), 0.0);
+				EXPECT_EQ(result.palette, palette);
+			}
+		}
+	}
+
+	std::filesystem::remove(path);
+}
+
+TEST(gtl_mat_helper, DrawPixelValue) {
+	cv::Mat img(30, 40, CV_16UC3);
+	cv::randu(img, 0, 65535);
+	cv::Rect roi(3, 2, 20, 15);
+	gtl::xCoordTrans2d ct(40.5, gtl::xCoordTrans2d::mat_t::eye(), { roi.x, roi.y }, { -7.3, 5.6 });
+
+	// grid : direct row writes (8 bit canvas) == cv::line (16 bit canvas, generic)
+	for (int type : { CV_8UC1, CV_8UC3, CV_8UC4 }) {
+		cv::Mat canvas = cv::Mat::zeros(600, 800, type);
+		cv::Mat canvas16 = cv::Mat::zeros(canvas.size(), CV_MAKETYPE(CV_16U, canvas.channels()));
+		EXPECT_FALSE(gtl::DrawPixelValue(canvas, img, roi, ct, 1'000));	// no text
+		EXPECT_FALSE(gtl::DrawPixelValue(canvas16, img, roi, ct, 1'000));
+		canvas16.convertTo(canvas16, CV_8U);
+		EXPECT_TRUE(gtl::IsMatEqual(canvas, canvas16));
+	}
+
+	// text
+	cv::Mat canvas(600, 800, CV_8UC3, cv::Scalar::all(64));
+	EXPECT_TRUE(gtl::DrawPixelValue(canvas, img, roi, ct));
+	auto pt = ct(gtl::xPoint2d(roi.x + 1, roi.y + 1));
+	cv::Rect rcCell(gtl::xPoint2i(pt).x + 1, gtl::xPoint2i(pt).y + 1, 38, 38);
+	EXPECT_GT(cv::countNonZero(canvas(rcCell).reshape(1) != 64), 0);
+
+	// too small
+	EXPECT_FALSE(gtl::DrawPixelValue(canvas, img, roi, gtl::xCoordTrans2d(3.0)));
+}
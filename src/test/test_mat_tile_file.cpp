@@ -0,0 +1,93 @@
+﻿#include "pch.h"
+
+#include "gtl/gtl.h"
+#include "gtl/mat_tile_file.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+TEST(gtl_mat_tile_file, create_open) {
+	auto path = std::filesystem::temp_directory_path() / L"gtl_test_tile_file.tiles";
+	cv::Mat img(2000, 3000, CV_8UC1);
+	img.forEach<uint8_t>([](uint8_t& v, int const* pos) { v = cv::saturate_cast<uint8_t>(128 + 100 * sin(pos[1] / 100.) * cos(pos[0] / 80.)); });
+	cv::Size const sizeTile(512, 512);
+
+	{
+		gtl::CMatTileFile file;
+		ASSERT_TRUE(file.Create(path, img.size(), img.type(), sizeTile, 4));
+		EXPECT_EQ(file.GetTileCount(0), cv::Size(6, 4));
+		EXPECT_EQ(file.GetTileCount(3), cv::Size(1, 1));
+
+		// incrementally, as from line scan camera. (first row of tiles only)
+		for (int x = 0; x < 6; x++) {
+			cv::Rect rc(x*sizeTile.width, 0, sizeTile.width, sizeTile.height);
+			rc &= cv::Rect(0, 0, img.cols, img.rows);
+			ASSERT_TRUE(file.SetTile({x, 0}, img(rc)));
+		}
+		EXPECT_TRUE(file.IsTileReady(0, {5, 0}));
+		EXPECT_FALSE(file.IsTileReady(0, {0, 1}));
+		EXPECT_FALSE(file.IsTileReady(1, {0, 0}));	// lower half not yet
+
+		cv::Rect rc(500, 500, 30, 30);	// not written part is zero
+		auto roi = file.GetROI(rc);
+		EXPECT_EQ(cv::norm(roi(cv::Rect(0, 0, 30, 12)), img(cv::Rect(500, 500, 30, 12)), cv::NORM_INF), 0.0);
+		EXPECT_EQ(cv::countNonZero(roi(cv::Rect(0, 12, 30, 18))), 0);
+
+		for (int y = 1; y < 4; y++) {
+			for (int x = 0; x < 6; x++) {
+				cv::Rect rc(x*sizeTile.width, y*sizeTile.height, sizeTile.width, sizeTile.height);
+				rc &= cv::Rect(0, 0, img.cols, img.rows);
+				ASSERT_TRUE(file.SetTile({x, y}, img(rc)));
+			}
+		}
+		EXPECT_TRUE(file.IsTileReady(3, {0, 0}));
+		EXPECT_TRUE(file.Flush());
+	}
+
+	gtl::CMatTileFile file;
+	ASSERT_TRUE(file.Open(path));
+	EXPECT_EQ(file.size(), img.size());
+
+	// ROI over tiles
+	for (cv::Rect rc : { cv::Rect(0, 0, 3000, 2000), cv::Rect(10, 20, 30, 40), cv::Rect(500, 500, 30, 30), cv::Rect(2900, 1900, 200, 200) }) {
+		auto roi = file.GetROI(rc);
+		ASSERT_EQ(roi.size(), rc.size());
+		EXPECT_EQ(cv::norm(roi, img(rc), cv::NORM_INF), 0.0);
+	}
+
+	// single tile ROI on the mapped file, alive after Close()
+	cv::Rect rc(10, 20, 30, 40);
+	auto roi = file.GetROI(rc);
+	auto tile = file.GetTile(0, {0, 0});
+	ASSERT_EQ(tile.size(), sizeTile);
+	tile.setTo(0);	// a copy
+	EXPECT_EQ(cv::norm(file.GetTileView(0, {0, 0}), img(cv::Rect({}, sizeTile)), cv::NORM_INF), 0.0);
+	file.Close();
+	EXPECT_EQ(cv::norm(roi, img(rc), cv::NORM_INF), 0.0);
+	roi.release();
+
+	// unknown type
+	auto WriteType = [&](int32_t type) {
+		std::fstream f(path, std::ios_base::in|std::ios_base::out|std::ios_base::binary);
+		f.seekp(offsetof(gtl::CMatTileFile::sHeader, type));
+		f.write((char const*)&type, sizeof(type));
+	};
+	WriteType(-1);
+	EXPECT_FALSE(file.Open(path));
+	WriteType(CV_MAT_TYPE_MASK + 1);
+	EXPECT_FALSE(file.Open(path));
+	WriteType(CV_8UC1);
+
+	// from pyramid
+	ASSERT_TRUE(file.Open(path));
+	for (double dScale : { 0.5, 0.25, 0.1 }) {
+		cv::Rect rc(0, 0, img.cols, img.rows);
+		auto imgResized = file.GetResizedImage(rc, dScale);
+		cv::Mat imgRef;
+		cv::resize(img, imgRef, imgResized.size(), 0., 0., cv::INTER_AREA);
+		EXPECT_LE(cv::norm(imgResized, imgRef, cv::NORM_L1) / imgRef.total(), 1.0);
+	}
+	file.Close();
+
+	std::filesystem::remove(path);
+}
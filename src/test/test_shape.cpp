@@ -80,3 +80,367 @@ TEST(gtl_shape, basic) {
 	}
 }
 
+TEST(gtl_shape, spatial_index) {
+	using namespace gtl::shape;
+
+	xLayer layer(L"0");
+	for (int y{}; y < 40; y++) {
+		for (int x{}; x < 40; x++) {
+			auto rLine = std::make_unique<xLine>();
+			rLine->m_pt0 = {x * 10., y * 10.};
+			rLine->m_pt1 = {x * 10. + 5., y * 10. + 5.};
+			layer.m_shapes.push_back(std::move(rLine));
+		}
+	}
+
+	auto BruteForce = [&](rect_t const& roi) {
+		std::vector<size_t> indices;
+		for (size_t i{}; i < layer.m_shapes.size(); i++) {
+			if (layer.m_shapes[i].GetBoundary().IntersectRect(roi).IsNormalized())
+				indices.push_back(i);
+		}
+		return indices;
+	};
+
+	std::vector<size_t> indices;
+	rect_t roi(12., 12., 0., 33., 47., 0.);
+	EXPECT_TRUE(layer.QueryROI(roi, indices));
+	EXPECT_EQ(indices, BruteForce(roi));
+	EXPECT_EQ(indices.size(), 3u*4u);
+
+	EXPECT_FALSE(layer.QueryROI(rect_t(-10., -10., 0., -1., -1., 0.), indices));
+
+	// rebuilt after Transform
+	gtl::xCoordTrans3d ct;
+	ct.m_offset = {1000., 0., 0.};
+	layer.Transform(ct, true);
+	EXPECT_FALSE(layer.QueryROI(roi, indices));
+	roi += xPoint3d(1000., 0., 0.);
+	EXPECT_TRUE(layer.QueryROI(roi, indices));
+	EXPECT_EQ(indices, BruteForce(roi));
+
+	// rebuilt after adding shape
+	auto rLine = std::make_unique<xLine>();
+	rLine->m_pt0 = roi.CenterPoint();
+	rLine->m_pt1 = roi.CenterPoint();
+	layer.m_shapes.push_back(std::move(rLine));
+	EXPECT_TRUE(layer.QueryROI(roi, indices));
+	EXPECT_EQ(indices, BruteForce(roi));
+	EXPECT_EQ(indices.back(), layer.m_shapes.size()-1);
+
+	// shape without extent (empty polyline) : in no ROI
+	layer.m_shapes.push_back(std::make_unique<xPolyline>());
+	EXPECT_FALSE(layer.m_shapes.back().GetBoundary().IsNormalized());
+	EXPECT_TRUE(layer.QueryROI(roi, indices));
+	EXPECT_EQ(indices, BruteForce(roi));
+	EXPECT_NE(indices.back(), layer.m_shapes.size()-1);
+	EXPECT_FALSE(layer.QueryROI(rect_t(-10., -10., 0., -1., -1., 0.), indices));
+
+	// copy
+	xLayer layer2(layer);
+	EXPECT_EQ(layer, layer2);
+	EXPECT_TRUE(layer2.QueryROI(roi, indices));
+	EXPECT_EQ(indices, BruteForce(roi));
+}
+
+TEST(gtl_shape, sort_loop) {
+	using namespace gtl::shape;
+
+	// polygon (1000 segments), shuffled and partly reversed
+	xLayer layer(L"0");
+	constexpr int n = 1000;
+	for (int i{}; i < n; i++) {
+		auto rLine = std::make_unique<xLine>();
+		double t0 = 2*std::numbers::pi*i/n, t1 = 2*std::numbers::pi*(i+1)/n;
+		rLine->m_pt0 = {100*cos(t0), 100*sin(t0)};
+		rLine->m_pt1 = {100*cos(t1), 100*sin(t1)};
+		if (i % 3 == 0)
+			rLine->Reverse();
+		layer.m_shapes.push_back(std::move(rLine));
+	}
+	std::mt19937 engine(0);
+	std::ranges::shuffle(layer.m_shapes.base(), engine);
+	EXPECT_FALSE(layer.IsLoop());
+
+	layer.Sort_Loop();
+	EXPECT_EQ(layer.m_shapes.size(), n);
+	EXPECT_TRUE(layer.IsLoop());
+	EXPECT_NEAR(layer.GetJumpLength(), 0.0, 1.e-6);
+
+	// random segments : Sort_Path() does not make it worse than Sort_Loop()
+	xLayer layer2(L"1");
+	std::uniform_real_distribution<double> dist(0., 1000.);
+	for (int i{}; i < n; i++) {
+		auto rLine = std::make_unique<xLine>();
+		rLine->m_pt0 = {dist(engine), dist(engine)};
+		rLine->m_pt1 = {dist(engine), dist(engine)};
+		layer2.m_shapes.push_back(std::move(rLine));
+	}
+	xLayer layer3(layer2);
+	layer3.Sort_Loop();
+	auto dJumpLoop = layer3.GetJumpLength();
+	auto dJumpPath = layer2.Sort_Path();
+	EXPECT_LE(dJumpPath, dJumpLoop);
+	EXPECT_NEAR(dJumpPath, layer2.GetJumpLength(), 1.e-6);
+	EXPECT_EQ(layer2.m_shapes.size(), n);
+}
+
+namespace {
+	/// @brief records target points
+	class xCanvasRecorder : public gtl::shape::ICanvas {
+	public:
+		std::vector<gtl::shape::point_t> m_pts;
+		virtual void PreDraw(gtl::shape::xShape const&) override {}
+		virtual void MoveTo_Target(gtl::shape::point_t const& pt) override { m_pts.push_back(pt); }
+		virtual void LineTo_Target(gtl::shape::point_t const& pt) override { m_pts.push_back(pt); }
+	};
+}
+
+TEST(gtl_shape, block_ref) {
+	using namespace gtl::shape;
+
+	auto block = std::make_shared<xBlock>();
+	block->m_name = L"B";
+	for (int i{}; i < 3; i++) {
+		auto rLine = std::make_unique<xLine>();
+		rLine->m_pt0 = {i * 10., 0.};
+		rLine->m_pt1 = {i * 10. + 5., 20.};
+		rLine->m_strLayer = L"0";
+		block->m_shapes.push_back(std::move(rLine));
+	}
+
+	gtl::xCoordTrans3d ct;
+	ct.m_mat = ct.GetRotatingMatrixXY(30_deg);
+	ct.m_offset = {100., 50., 0.};
+	xBlockRef ref(block, ct);
+	EXPECT_EQ(ref.m_name, L"B");
+
+	// exploded shapes
+	auto shapes = ref.Explode();
+	ASSERT_EQ(shapes.size(), block->m_shapes.size());
+	for (size_t i{}; i < shapes.size(); i++) {
+		auto const& line = dynamic_cast<xLine const&>(shapes[i]);
+		auto const& line0 = dynamic_cast<xLine const&>(block->m_shapes[i]);
+		EXPECT_NEAR(line.m_pt0.Distance(ct(line0.m_pt0)), 0.0, 1.e-9);
+		EXPECT_NEAR(line.m_pt1.Distance(ct(line0.m_pt1)), 0.0, 1.e-9);
+	}
+
+	// boundary contains all exploded shapes
+	auto rect = ref.GetBoundary();
+	for (auto const& shape : shapes) {
+		auto r = shape.GetBoundary();
+		EXPECT_EQ(rect.IntersectRect(r), r);
+	}
+
+	// nested, in drawing
+	auto block2 = std::make_shared<xBlock>();
+	block2->m_name = L"B2";
+	gtl::xCoordTrans3d ct2;
+	ct2.m_offset = {0., 100., 0.};
+	block2->m_shapes.push_back(std::make_unique<xBlockRef>(block, ct2));
+
+	xDrawing drawing;
+	drawing.m_layers.push_back(std::make_unique<xLayer>(L"0"));
+	for (int i{}; i < 4; i++) {
+		gtl::xCoordTrans3d ct3;
+		ct3.m_offset = {i * 1000., 0., 0.};
+		drawing.m_layers.front().m_shapes.push_back(std::make_unique<xBlockRef>(block2, ct3));
+	}
+	auto const rectDrawing = drawing.GetBoundary();
+	EXPECT_EQ(drawing.QueryROI(rect_t(-10., -10., 0., 10., 200., 0.)).size(), 1u);
+
+	// instances are drawn by local CT of canvas. canvas CT (chain) is not modified
+	gtl::xCoordTrans3d ctCanvas;
+	ctCanvas.m_scale = 2.;
+	ctCanvas.m_offset = {10., 20., 0.};
+	xCanvasRecorder canvasRef, canvasExploded;
+	canvasRef.SetCT(ctCanvas);
+	canvasExploded.SetCT(ctCanvas);
+	drawing.Draw(canvasRef);
+	EXPECT_FALSE(canvasRef.m_ctLocal);
+	EXPECT_EQ(canvasRef.m_ct.GetCompiledSize(), 1u);
+
+	EXPECT_EQ(drawing.ExplodeBlockRefs(), 4u);
+	EXPECT_EQ(drawing.m_layers.front().m_shapes.size(), 4u * 3u);
+	EXPECT_EQ(drawing.GetBoundary(), rectDrawing);
+
+	drawing.Draw(canvasExploded);
+	ASSERT_EQ(canvasRef.m_pts.size(), canvasExploded.m_pts.size());
+	for (size_t i{}; i < canvasRef.m_pts.size(); i++)
+		EXPECT_NEAR(canvasRef.m_pts[i].Distance(canvasExploded.m_pts[i]), 0.0, 1.e-9);
+}
+
+TEST(gtl_shape, cad_json_file) {
+	std::filesystem::path paths[] = {
+		LR"xx(shape_test/bridge.dxf.json)xx",
+		LR"xx(shape_test/cube.dxf.json)xx",
+		LR"xx(shape_test/diamond.dxf.json)xx",
+	};
+
+	for (auto const& path : paths) {
+		gtl::bjson jDXF;
+		jDXF.read(path);
+		gtl::shape::xDrawing cad;
+		cad.LoadFromCADJson(jDXF.json());
+
+		for (int nThread : {1, 4}) {
+			gtl::shape::xDrawing cad2;
+			EXPECT_TRUE(cad2.LoadFromCADJsonFile(path, false, nThread));
+			EXPECT_EQ(cad, cad2);
+		}
+	}
+
+	// broken entities (no or wrong entityName) are skipped, on worker threads, too.
+	gtl::bjson jDXF;
+	jDXF.read(paths[0]);
+	auto& jEntities = jDXF.json().as_object()["mainBlock"].as_array();
+	ASSERT_GE(jEntities.size(), 2u);
+	jEntities[0].as_object().erase("entityName");
+	jEntities[1].as_object()["entityName"] = 1;
+	gtl::shape::xDrawing cad;
+	cad.LoadFromCADJson(jDXF.json());
+	auto pathBroken = std::filesystem::temp_directory_path() / L"test_broken.dxf.json";
+	{
+		std::ofstream f(pathBroken, std::ios_base::binary);
+		f << boost::json::serialize(jDXF.json());
+	}
+	for (int nThread : {1, 4}) {
+		gtl::shape::xDrawing cad2;
+		EXPECT_TRUE(cad2.LoadFromCADJsonFile(pathBroken, false, nThread));
+		EXPECT_EQ(cad, cad2);
+	}
+	std::filesystem::remove(pathBroken);
+}
+
+TEST(gtl_shape, cad_json_instance_blocks) {
+	using namespace gtl::shape;
+	std::filesystem::path paths[] = {
+		LR"xx(shape_test/bridge.dxf.json)xx",
+		LR"xx(shape_test/cube.dxf.json)xx",
+		LR"xx(shape_test/diamond.dxf.json)xx",
+	};
+
+	auto Block = [](char const* name, int color, int lWeight, boost::json::array entities) -> boost::json::value {
+		return boost::json::object{ {"entityName", "BLOCK"}, {"layer", "0"}, {"lineType", "ByLayer"}, {"color", color}, {"lWeight", lWeight},
+			{"basePoint", boost::json::array{1., 2., 0.}}, {"name", name}, {"flags", 0}, {"entities", std::move(entities)} };
+	};
+	auto Insert = [](char const* name, boost::json::array basePoint, double scale, int nCol, int nRow) -> boost::json::value {
+		return boost::json::object{ {"entityName", "INSERT"}, {"layer", "0"}, {"lineType", "ByLayer"}, {"color", 256}, {"lWeight", 29},
+			{"basePoint", std::move(basePoint)}, {"name", name}, {"xscale", scale}, {"yscale", scale}, {"zscale", 1.}, {"angle", 0.},
+			{"colcount", nCol}, {"rowcount", nRow}, {"colspace", 10.}, {"rowspace", 20.} };
+	};
+
+	// same boundary, same path drawn
+	auto Compare = [](xDrawing const& cad, xDrawing const& cadRef) {
+		EXPECT_NEAR(cad.m_rectBoundary.pt0().Distance(cadRef.m_rectBoundary.pt0()), 0.0, 1.e-9);
+		EXPECT_NEAR(cad.m_rectBoundary.pt1().Distance(cadRef.m_rectBoundary.pt1()), 0.0, 1.e-9);
+		xCanvasRecorder canvas, canvasRef;
+		cad.Draw(canvas);
+		cadRef.Draw(canvasRef);
+		ASSERT_EQ(canvas.m_pts.size(), canvasRef.m_pts.size());
+		for (size_t i{}; i < canvas.m_pts.size(); i++)
+			EXPECT_NEAR(canvas.m_pts[i].Distance(canvasRef.m_pts[i]), 0.0, 1.e-9);
+	};
+
+	for (auto const& path : paths) {
+		// block "B" of lines (half of them ByBlock), inserted as array. cyclic blocks "C1" -> "C2" -> "C1" (nested insert dropped)
+		gtl::bjson jDXF;
+		jDXF.read(path);
+		auto& jTop = jDXF.json().as_object();
+		auto& jMain = jTop["mainBlock"].as_array();
+		boost::json::array jLines;
+		for (auto const& jEntity : jMain) {
+			if (jLines.size() >= 8)
+				break;
+			auto jLine = jEntity;
+			if (jLines.size() % 2) {
+				jLine.as_object()["color"] = 0;
+				jLine.as_object()["lWeight"] = (int)xShape::eLINE_WIDTH::ByBlock;
+			}
+			jLines.push_back(std::move(jLine));
+		}
+		ASSERT_FALSE(jLines.empty());
+		auto& jBlocks = jTop["blocks"].as_array();
+		jBlocks.push_back(Block("B", 1, 50, jLines));
+		jBlocks.push_back(Block("C1", 256, 29, { jLines[0], Insert("C2", {1., 2., 0.}, 1., 1, 1) }));
+		jBlocks.push_back(Block("C2", 256, 29, { jLines[0], Insert("C1", {1., 2., 0.}, 1., 1, 1) }));
+		jMain.push_back(Insert("B", {100., 50., 0.}, 2., 2, 3));
+		jMain.push_back(Insert("C1", {1., 2., 0.}, 1., 1, 1));
+
+		auto pathBlocks = std::filesystem::temp_directory_path() / L"test_blocks.dxf.json";
+		{
+			std::ofstream f(pathBlocks, std::ios_base::binary);
+			f << boost::json::serialize(jDXF.json());
+		}
+
+		xDrawing cad;
+		cad.LoadFromCADJson(jDXF.json());
+
+		xDrawing cad2, cad3;
+		cad2.LoadFromCADJson(jDXF.json(), true);
+		EXPECT_TRUE(cad3.LoadFromCADJsonFile(pathBlocks, true));
+		std::filesystem::remove(pathBlocks);
+
+		for (auto* pCad : { &cad2, &cad3 }) {
+			auto& cadInstanced = *pCad;
+			Compare(cadInstanced, cad);
+
+			// ByBlock / ByLayer attributes resolved as flattened
+			EXPECT_EQ(cadInstanced.ExplodeBlockRefs(), 2u*3u + 1u);
+			Compare(cadInstanced, cad);
+			ASSERT_EQ(cadInstanced.m_layers.size(), cad.m_layers.size());
+			for (size_t iLayer{}; iLayer < cad.m_layers.size(); iLayer++) {
+				auto const& shapes = cadInstanced.m_layers[iLayer].m_shapes;
+				auto const& shapesRef = cad.m_layers[iLayer].m_shapes;
+				ASSERT_EQ(shapes.size(), shapesRef.size());
+				for (size_t i{}; i < shapes.size(); i++) {
+					EXPECT_EQ(shapes[i].m_crIndex, shapesRef[i].m_crIndex);
+					EXPECT_EQ(shapes[i].m_color.cr, shapesRef[i].m_color.cr);
+					EXPECT_EQ(shapes[i].m_lineWeight, shapesRef[i].m_lineWeight);
+				}
+			}
+		}
+	}
+}
+
+TEST(gtl_shape, binary) {
+	std::filesystem::path paths[] = {
+		LR"xx(shape_test/bridge.dxf.json)xx",
+		LR"xx(shape_test/cube.dxf.json)xx",
+		LR"xx(shape_test/diamond.dxf.json)xx",
+	};
+
+	for (auto const& path : paths) {
+		gtl::shape::xDrawing cad;
+		cad.LoadFromCADJsonFile(path);
+
+		auto pathBinary = std::filesystem::path{path}+=L".shapeb";
+		EXPECT_TRUE(gtl::shape::xDrawingBinaryView::Save(cad, pathBinary));
+
+		gtl::shape::xDrawingBinaryView view;
+		ASSERT_TRUE(view.Open(pathBinary));
+		EXPECT_EQ(view.GetLayerCount(), cad.m_layers.size());
+		EXPECT_EQ(view.GetBoundary(), cad.m_rectBoundary);
+
+		gtl::shape::xDrawing cad2;
+		EXPECT_TRUE(view.ToDrawing(cad2));
+		EXPECT_EQ(cad, cad2);
+
+		// same path drawn
+		xCanvasRecorder canvas1, canvas2;
+		cad.Draw(canvas1);
+		view.Draw(canvas2);
+		EXPECT_EQ(canvas1.m_pts, canvas2.m_pts);
+
+		// ROI (spatial index) : whole area draws the same path. part of it, less.
+		xCanvasRecorder canvas3, canvas4;
+		EXPECT_TRUE(view.DrawROI(canvas3, gtl::shape::rect_t(-1.e9, -1.e9, 0., 1.e9, 1.e9, 0.)));
+		EXPECT_EQ(canvas3.m_pts, canvas2.m_pts);
+		auto const& rc = view.GetBoundary();
+		view.DrawROI(canvas4, gtl::shape::rect_t(rc.left, rc.top, 0., (rc.left + rc.right) / 2, (rc.top + rc.bottom) / 2, 0.));
+		EXPECT_LE(canvas4.m_pts.size(), canvas3.m_pts.size());
+	}
+
+	gtl::shape::xDrawingBinaryView view;
+	EXPECT_FALSE(view.Open(LR"xx(shape_test/cube.dxf.json)xx"));
+}
@@ -146,3 +146,314 @@ TEST(gtl_string_codepage_Test, iconv_wrapper) {
 
 
 }
+
+TEST(gtl_string_codepage_Test, utf_transcode) {
+	// long strings (SIMD blocks), every length around block / chunk boundaries
+	std::u8string stru8;
+	std::u16string stru16;
+	std::u32string stru32;
+	for (int i{}; i < 40; i++) {
+		stru8 += TEXT_u8(TEST_STRING);
+		stru16 += TEXT_u(TEST_STRING);
+		stru32 += TEXT_U(TEST_STRING);
+		stru8 += u8"0123456789abcdefghijklmnopqrstuvwxyz";	// ascii run
+		stru16 += u"0123456789abcdefghijklmnopqrstuvwxyz";
+		stru32 += U"0123456789abcdefghijklmnopqrstuvwxyz";
+	}
+	std::u8string_view sv8(stru8);
+	std::u16string_view sv16(stru16);
+	std::u32string_view sv32(stru32);
+	for (size_t n32{}, n8{}, n16{}; n32 <= sv32.size(); n32++) {
+		if (n32 % 7 == 0) {
+			auto s8 = sv8.substr(0, n8);
+			auto s16 = sv16.substr(0, n16);
+			auto s32 = sv32.substr(0, n32);
+			EXPECT_TRUE(gtl::ToStringU8(s16) == s8);
+			EXPECT_TRUE(gtl::ToStringU8(s32) == s8);
+			EXPECT_TRUE(gtl::ToStringU16(s8) == s16);
+			EXPECT_TRUE(gtl::ToStringU16<false>(s8) == s16);
+			EXPECT_TRUE(gtl::ToStringU16(s32) == s16);
+			EXPECT_TRUE(gtl::ToStringU32(s8) == s32);
+			EXPECT_TRUE(gtl::ToStringU32(s16) == s32);
+		}
+		if (n32 < sv32.size()) {
+			auto c = sv32[n32];
+			n8 += (c < 0x80) ? 1 : (c < 0x800) ? 2 : (c < 0x1'0000) ? 3 : 4;
+			n16 += (c < 0x1'0000) ? 1 : 2;
+		}
+	}
+
+	// stops at invalid sequence
+	std::u8string strBad = stru8;
+	auto posBad = strBad.find(u8'a', 1000);
+	strBad[posBad] = 0xff;
+	std::u16string strConv(strBad.size(), 0);
+	auto r = gtl::internal::TranscodeUTF(strBad.data(), strBad.size(), strConv.data(), strConv.size());
+	EXPECT_EQ(r.nRead, posBad);
+	EXPECT_TRUE(std::u16string_view(strConv.data(), r.nWritten) == gtl::ToStringU16(sv8.substr(0, posBad)));
+	EXPECT_THROW(gtl::ToStringU16(strBad), std::invalid_argument);
+	std::u16string strBad16 = stru16;
+	strBad16[strBad16.find(u'a', 500)] = 0xdc00;	// unpaired surrogate
+	EXPECT_THROW(gtl::ToStringU8(strBad16), std::invalid_argument);
+
+	// not strict (overlong) : per char converter
+	std::u8string strOverlong = stru8 + u8"\xc1\x81" + stru8;	// 'A'
+	EXPECT_TRUE(gtl::ToStringU32(strOverlong) == stru32 + U"A" + stru32);
+
+	// many not strict chars (NUL as C0 80 : modified utf-8, CESU-8 surrogate pair) in a long string
+	std::u8string strModified;
+	std::u16string strModified16;
+	for (int i{}; i < 10'000; i++) {
+		strModified += (i % 3) ? u8"\xc0\x80"sv : u8"\xc0\x80\xc0\x80" u8"abc가"sv;
+		strModified16 += (i % 3) ? std::u16string_view(u"\0", 1) : std::u16string_view(u"\0\0" u"abc가", 6);
+		if (i % 100 == 0) {
+			strModified += u8"\xed\xa0\xbd\xed\xb8\x80";	// CESU-8 U+1F600
+			strModified16 += u"\U0001F600";
+		}
+	}
+	EXPECT_TRUE(gtl::ToStringU16(strModified) == strModified16);
+	// same as per char converter only
+	std::u32string strModified32;
+	for (auto const* pos = strModified.data(), *end = pos + strModified.size(); pos < end; )
+		gtl::internal::UTFCharConverter<char32_t, char8_t, true, true, true>(pos, end, strModified32);
+	EXPECT_TRUE(gtl::ToStringU32(strModified) == strModified32);
+}
+
+TEST(gtl_string_codepage_Test, ValidateUTF8String) {
+	std::u8string str;
+	while (str.size() < 1000) {
+		str += TEXT_u8(TEST_STRING);
+		str += u8"0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz";	// ascii blocks
+	}
+	std::u8string_view sv(str);
+
+	auto r = gtl::ValidateUTF8String(sv);
+	EXPECT_TRUE(r.bValid);
+	EXPECT_TRUE(r.bMSBSet);
+	EXPECT_EQ(r.posError, str.size());
+	EXPECT_EQ(r.nUTF16, gtl::ToStringU16(sv).size());
+	EXPECT_EQ(r.nUTF32, gtl::ToStringU32(sv).size());
+
+	size_t nCount{};
+	bool bMSB{};
+	EXPECT_TRUE(gtl::IsUTF8String("0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz"sv, &nCount, &bMSB));
+	EXPECT_EQ(nCount, 144u);
+	EXPECT_FALSE(bMSB);
+	EXPECT_TRUE(gtl::IsUTF8String({(char const*)str.data(), str.size()}, &nCount, &bMSB));
+	EXPECT_EQ(nCount, r.nUTF32);
+	EXPECT_TRUE(bMSB);
+
+	// first invalid sequence, on every position
+	for (size_t pos{}; pos < str.size(); pos++) {
+		if ((str[pos] & 0xc0) == 0x80)
+			continue;
+		for (std::u8string_view bad : { u8"\xff"sv, u8"\x80"sv, u8"\xc0\x80"sv, u8"\xed\xa0\x80"sv, u8"\xf4\x90\x80\x80"sv, u8"\xe4\xb8"sv }) {
+			std::u8string strBad = str.substr(0, pos);
+			strBad += bad;
+			strBad += u8"abc";
+			strBad += str.substr(pos);
+			auto rBad = gtl::ValidateUTF8String(strBad);
+			EXPECT_FALSE(rBad.bValid);
+			EXPECT_EQ(rBad.posError, pos);
+			EXPECT_EQ(rBad.nUTF16, gtl::ToStringU16(sv.substr(0, pos)).size());
+			EXPECT_EQ(rBad.nUTF32, gtl::ToStringU32(sv.substr(0, pos)).size());
+		}
+	}
+	// truncated at the end
+	std::u8string strTruncated = str + u8"\xf0\x9f\x98";
+	EXPECT_EQ(gtl::ValidateUTF8String(strTruncated).posError, str.size());
+}
+
+TEST(gtl_string_codepage_Test, table_codepage) {
+	using enum gtl::eCODEPAGE;
+
+	// cp949 : table vs iconv
+	std::u16string strU;
+	while (strU.size() < 1000)
+		strU += u"가나다라마바사아자차카타파하긎긣꿳뎓뫓멙뻍 漢字 ①②③ ㄱㄴㄷ 0123456789abcdefghijklmnopqrstuvwxyz";
+	auto const strA = gtl::ToString_iconv<char>(std::u16string_view(strU), "CP949").value();
+	EXPECT_TRUE(gtl::internal::IsTableCodepage((int)KO_KR_949));
+	EXPECT_EQ(gtl::internal::IsTableCodepage((int)DEFAULT), gtl::internal::IsTableCodepage((int)GetACP()));	// active ANSI codepage
+	EXPECT_TRUE(gtl::ToStringA(strU, {.to = KO_KR_949}) == strA);
+	EXPECT_TRUE(gtl::ToStringA(gtl::ToStringU8(strU), {.to = KO_KR_949}) == strA);
+	EXPECT_TRUE(gtl::ToStringA(gtl::ToStringU32(strU), {.to = KO_KR_949}) == strA);
+	EXPECT_EQ(gtl::ToStringU16(strA, {.from = KO_KR_949}), strU);
+	EXPECT_TRUE(gtl::ToStringU8(strA, {.from = KO_KR_949}) == gtl::ToStringU8(strU));
+	EXPECT_EQ(gtl::ToStringU32(strA, {.from = KO_KR_949}), gtl::ToStringU32(strU));
+	EXPECT_EQ(gtl::ToStringW(strA, {.from = KO_KR_949}), gtl::ToStringW(strU));
+
+	// caller's buffer
+	std::vector<char16_t> bufU(strA.size());
+	auto n = gtl::ConvMBCS2UTF<char16_t>(strA, bufU, {.from = KO_KR_949});
+	ASSERT_TRUE(n);
+	EXPECT_EQ(std::u16string_view(bufU.data(), *n), strU);
+	EXPECT_FALSE(gtl::ConvMBCS2UTF<char16_t>(strA, std::span(bufU).first(10), {.from = KO_KR_949}));	// too small
+	std::vector<char> bufA(strU.size() * 2);
+	auto m = gtl::ConvUTF2MBCS<char16_t>(strU, bufA, {.to = KO_KR_949});
+	ASSERT_TRUE(m);
+	EXPECT_TRUE(std::string_view(bufA.data(), *m) == strA);
+
+	// cp1252
+	EXPECT_TRUE(gtl::ToStringA(u"€ café"sv, {.to = ANSI_WINDOWS}) == "\x80 caf\xe9"sv);
+	EXPECT_EQ(gtl::ToStringU16("\x80 caf\xe9"sv, {.from = ANSI_WINDOWS}), u"€ café");
+
+	// not in table : nullopt from buffer api. (ToStringXX falls back to system / iconv conversion)
+	EXPECT_FALSE(gtl::ConvUTF2MBCS<char16_t>(u"abc😊"sv, bufA, {.to = KO_KR_949}));
+	EXPECT_FALSE(gtl::ConvMBCS2UTF<char16_t>("abc\xc7"sv, bufU, {.from = KO_KR_949}));	// truncated
+	EXPECT_FALSE(gtl::ConvMBCS2UTF<char16_t>("abc"sv, bufU, {.from = UTF8}));
+}
+
+TEST(gtl_string_codepage_Test, iconv_pool) {
+	std::u8string str8;
+	std::u16string str16;
+	while (str8.size() < 1000) {
+		str8 += TEXT_u8(TEST_STRING);
+		str16 += TEXT_u(TEST_STRING);
+	}
+
+	// descriptor is reused
+	auto cd = gtl::xIconvPool::Checkout("UTF-16LE", "UTF-8");
+	ASSERT_NE(cd, (iconv_t)-1);
+	gtl::xIconvPool::Return("UTF-16LE", "UTF-8", cd);
+	auto cd2 = gtl::xIconvPool::Checkout("UTF-16LE", "UTF-8");
+	EXPECT_EQ(cd, cd2);
+	gtl::xIconvPool::Return("UTF-16LE", "UTF-8", cd2);
+
+	// caller's buffer
+	gtl::Ticonv<char16_t, char8_t> conv;
+	std::u16string out;
+	out.reserve(str16.size() * 2);
+	auto const* p = out.data();
+	ASSERT_TRUE(conv.Convert(str8, out));
+	EXPECT_EQ(out, str16);
+	EXPECT_EQ(out.data(), p);
+	EXPECT_FALSE(conv.Convert(u8"abc\xff"sv, out));
+	EXPECT_TRUE(conv.Convert(u8"abc"sv, out));
+	EXPECT_EQ(out, u"abc");
+
+	// streaming. multibyte chars, surrogate pairs split across chunks
+	for (size_t nChunk : { 1, 2, 3, 5, 7, 64 }) {
+		gtl::Ticonv<char16_t, char8_t> conv8;
+		std::u16string out16;
+		for (size_t i{}; i < str8.size(); i += nChunk)
+			ASSERT_TRUE(conv8.ConvertChunk(std::u8string_view(str8).substr(i, nChunk), out16));
+		ASSERT_TRUE(conv8.Finish(out16));
+		EXPECT_EQ(out16, str16);
+
+		gtl::Ticonv<char8_t, char16_t> conv16;
+		std::u8string out8;
+		for (size_t i{}; i < str16.size(); i += nChunk)
+			ASSERT_TRUE(conv16.ConvertChunk(std::u16string_view(str16).substr(i, nChunk), out8));
+		ASSERT_TRUE(conv16.Finish(out8));
+		EXPECT_TRUE(out8 == str8);
+	}
+	gtl::Ticonv<char16_t, char8_t> convIncomplete;
+	EXPECT_TRUE(convIncomplete.ConvertChunk(u8"abc\xea\xb0"sv, out));
+	EXPECT_FALSE(convIncomplete.Finish(out));
+
+	// stateful encoding. shift state carried across chunks
+	std::u16string strJP;
+	for (int i{}; i < 100; i++)
+		strJP += u"日本語abcかなカナ";
+	auto const strISO = gtl::Ticonv<char, char16_t>("ISO-2022-JP", nullptr).Convert(std::u16string_view(strJP)).value();
+	for (size_t nChunk : { 1, 2, 3, 5, 64 }) {
+		gtl::Ticonv<char16_t, char> decoder(nullptr, "ISO-2022-JP");
+		std::u16string strDecoded;
+		for (size_t i{}; i < strISO.size(); i += nChunk)
+			ASSERT_TRUE(decoder.ConvertChunk(std::string_view(strISO).substr(i, nChunk), strDecoded));
+		ASSERT_TRUE(decoder.Finish(strDecoded));
+		EXPECT_EQ(strDecoded, strJP);
+
+		gtl::Ticonv<char, char16_t> encoder("ISO-2022-JP", nullptr);
+		std::string strEncoded;
+		for (size_t i{}; i < strJP.size(); i += nChunk)
+			ASSERT_TRUE(encoder.ConvertChunk(std::u16string_view(strJP).substr(i, nChunk), strEncoded));
+		ASSERT_TRUE(encoder.Finish(strEncoded));
+		EXPECT_EQ(strEncoded, strISO);
+	}
+
+	// converters from many threads
+	std::atomic<int> nError{};
+	{
+		std::vector<std::jthread> threads;
+		for (int t{}; t < 8; t++) {
+			threads.emplace_back([&] {
+				for (int i{}; i < 100; i++) {
+					gtl::Ticonv<char16_t, char8_t> c;
+					if (c.Convert(std::u8string_view(str8)) != str16)
+						nError++;
+				}
+			});
+		}
+	}
+	EXPECT_EQ(nError.load(), 0);
+}
+
+TEST(gtl_string_codepage_Test, stream_transcoder) {
+	using enum gtl::eCODEPAGE;
+
+	std::u16string strU;
+	while (strU.size() < 1000)
+		strU += TEXT_u(TEST_STRING);
+	auto const str8 = gtl::ToStringU8(strU);
+	auto const str32 = gtl::ToStringU32(strU);
+
+	// bytes of stream, with BOM
+	auto Encode = [](gtl::eCODEPAGE eCodepage, auto const& str) {
+		std::string bytes(gtl::GetCodepageBOM(eCodepage));
+		bool const bSwap = (eCodepage == UTF16BE) or (eCodepage == UTF32BE);
+		for (auto c : str) {
+			decltype(c) v = bSwap ? gtl::GetByteSwap(c) : c;
+			bytes.append((char const*)&v, sizeof(v));
+		}
+		return bytes;
+	};
+	std::vector<std::pair<gtl::eCODEPAGE, std::string>> const streams{
+		{ UTF8, Encode(UTF8, str8) },
+		{ UTF16LE, Encode(UTF16LE, strU) },
+		{ UTF16BE, Encode(UTF16BE, strU) },
+		{ UTF32LE, Encode(UTF32LE, str32) },
+		{ UTF32BE, Encode(UTF32BE, str32) },
+	};
+
+	// chunks split anywhere (in the middle of multibyte chars, surrogate pairs, BOM)
+	for (auto const& [eCodepage, bytes] : streams) {
+		for (size_t nChunk : { 1, 2, 3, 5, 7, 4096 }) {
+			gtl::TStreamTranscoder<char16_t> transcoder(KO_KR_949);
+			std::u16string str;
+			for (size_t i{}; i < bytes.size(); i += nChunk)
+				ASSERT_TRUE(transcoder.Feed(std::string_view(bytes).substr(i, nChunk), str));
+			ASSERT_TRUE(transcoder.Finish(str));
+			EXPECT_EQ(transcoder.GetCodepage(), eCodepage);
+			EXPECT_EQ(transcoder.GetErrorCount(), 0u);
+			EXPECT_EQ(str, strU);
+		}
+		EXPECT_TRUE(gtl::TStreamTranscoder<char8_t>().Convert(bytes) == str8);
+		EXPECT_EQ(gtl::TStreamTranscoder<char32_t>().Convert(bytes), str32);
+		EXPECT_EQ(gtl::TStreamTranscoder<wchar_t>().Convert(bytes), gtl::ToStringW(strU));
+	}
+
+	// MBCS (no BOM)
+	auto const strA = gtl::ToString_iconv<char>(std::u16string_view(u"가나다라마바사 漢字 abc"), "CP949").value();
+	for (size_t nChunk : { 1, 2, 3 }) {
+		gtl::TStreamTranscoder<char8_t> transcoder(KO_KR_949);
+		std::u8string str;
+		for (size_t i{}; i < strA.size(); i += nChunk)
+			ASSERT_TRUE(transcoder.Feed(std::string_view(strA).substr(i, nChunk), str));
+		ASSERT_TRUE(transcoder.Finish(str));
+		EXPECT_TRUE(str == u8"가나다라마바사 漢字 abc"sv);
+	}
+
+	// invalid sequences -> U+FFFD
+	gtl::TStreamTranscoder<char16_t> transcoder(UTF8, false);
+	EXPECT_EQ(transcoder.Convert("a\xff""b\xe0\x80\x80""c"sv), u"a�b���c");
+	EXPECT_EQ(transcoder.GetErrorCount(), 4u);
+	std::u16string str;
+	ASSERT_TRUE(transcoder.Feed("a\xea"sv, str));
+	ASSERT_TRUE(transcoder.Feed("\xb0"sv, str));
+	EXPECT_EQ(str, u"a");	// incomplete, carried
+	ASSERT_TRUE(transcoder.Finish(str));
+	EXPECT_EQ(str, u"a�");	// truncated at the end of stream
+	EXPECT_EQ(gtl::TStreamTranscoder<char16_t>(UTF16LE, false).Convert("a\0\0\xd8"sv), u"a�");	// unpaired surrogate
+	EXPECT_EQ(gtl::TStreamTranscoder<char16_t>(KO_KR_949).Convert("a\xc7"sv), u"a�");
+}
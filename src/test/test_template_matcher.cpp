@@ -0,0 +1,88 @@
+﻿#include "pch.h"
+
+#include "gtl/gtl.h"
+#include "gtl/mat_template_matcher.h"
+
+using namespace std::literals;
+using namespace gtl::literals;
+
+namespace {
+	cv::Mat MakeImage(cv::Size size) {
+		cv::Mat img(size, CV_8UC1);
+		cv::theRNG().state = 1234;
+		cv::randu(img, 0, 256);
+		cv::GaussianBlur(img, img, cv::Size(0, 0), 2.0);
+		cv::normalize(img, img, 0, 255, cv::NORM_MINMAX);
+		return img;
+	}
+}
+
+TEST(gtl_template_matcher, position) {
+	cv::Mat img = MakeImage({1'200, 900});
+	gtl::CTemplateMatcher matcher(img);
+	EXPECT_EQ(matcher.GetMaxLevel(), 4);
+
+	for (cv::Rect rc : { cv::Rect(100, 200, 96, 96), cv::Rect(701, 333, 128, 64), cv::Rect(0, 0, 64, 64), cv::Rect(1'200-80, 900-80, 80, 80) }) {
+		cv::Mat templ = img(rc).clone();
+		gtl::xPoint2d ptCenter(rc.x + rc.width/2, rc.y + rc.height/2);
+
+		auto results = matcher.Match(templ);
+		ASSERT_EQ(results.size(), 1u);
+		EXPECT_NEAR(results[0].pt.x, ptCenter.x, 0.5);
+		EXPECT_NEAR(results[0].pt.y, ptCenter.y, 0.5);
+		EXPECT_GT(results[0].dScore, 0.99);
+
+		// same as MatchTemplate()
+		gtl::xPoint2d pt;
+		double dMinMax{}, dRate{};
+		ASSERT_TRUE(gtl::MatchTemplate(img, templ, cv::TM_CCOEFF_NORMED, pt, dMinMax, dRate));
+		EXPECT_NEAR(results[0].pt.x, pt.x, 0.5);
+		EXPECT_NEAR(results[0].pt.y, pt.y, 0.5);
+
+		// SQDIFF, whole image (no pyramid)
+		results = matcher.Match(templ, { .method = cv::TM_SQDIFF_NORMED, .nLevel = 0, .bSubPixel = false });
+		ASSERT_EQ(results.size(), 1u);
+		EXPECT_EQ(results[0].pt, ptCenter);
+	}
+}
+
+TEST(gtl_template_matcher, peaks) {
+	cv::Mat img = MakeImage({800, 600});
+	cv::Mat templ = img(cv::Rect(10, 10, 64, 64)).clone();
+	std::vector<cv::Point> pts{ {10, 10}, {300, 400}, {600, 100} };
+	for (auto const& pt : pts)
+		templ.copyTo(img(cv::Rect(pt, templ.size())));
+
+	gtl::CTemplateMatcher matcher(img);
+	auto results = matcher.Match(templ, { .nMaxPeak = 5, .dMinScore = 0.9 });
+	ASSERT_EQ(results.size(), pts.size());
+	for (auto const& pt : pts) {
+		EXPECT_TRUE(std::ranges::any_of(results, [&](auto const& res) {
+			return (std::abs(res.pt.x - (pt.x + 32)) < 0.5) and (std::abs(res.pt.y - (pt.y + 32)) < 0.5);
+		}));
+	}
+	EXPECT_TRUE(std::ranges::is_sorted(results, [](auto const& a, auto const& b) { return a.dScore > b.dScore; }));
+
+	// empty / too large / type mismatch
+	EXPECT_TRUE(matcher.Match(cv::Mat{}).empty());
+	EXPECT_TRUE(matcher.Match(cv::Mat(1'000, 10, CV_8UC1)).empty());
+	EXPECT_TRUE(matcher.Match(cv::Mat(10, 10, CV_8UC3)).empty());
+}
+
+TEST(gtl_template_matcher, batch) {
+	cv::Mat img = MakeImage({1'000, 800});
+	gtl::CTemplateMatcher matcher(img);
+	std::vector<cv::Mat> templs;
+	std::vector<cv::Rect> rects;
+	for (int i{}; i < 16; i++) {
+		rects.emplace_back(30 + i * 53, 20 + i * 41, 64 + (i % 3) * 16, 64);
+		templs.push_back(img(rects.back()).clone());
+	}
+	auto results = matcher.Match(templs);
+	ASSERT_EQ(results.size(), templs.size());
+	for (size_t i{}; i < templs.size(); i++) {
+		ASSERT_EQ(results[i].size(), 1u);
+		EXPECT_NEAR(results[i][0].pt.x, rects[i].x + rects[i].width/2, 0.5);
+		EXPECT_NEAR(results[i][0].pt.y, rects[i].y + rects[i].height/2, 0.5);
+	}
+}